@@ -0,0 +1,608 @@
+/**
+Lightweight profiler library for c++
+Copyright(C) 2016-2019  Sergey Yagovtsev, Victor Zarubkin
+
+Licensed under either of
+	* MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+    * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+at your option.
+
+The MIT License
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+	of the Software, and to permit persons to whom the Software is furnished
+	to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+	INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+	PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+	LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+	TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+	USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+The Apache License, Version 2.0 (the "License");
+	You may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+**/
+
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <limits>
+#include <sstream>
+#include <thread>
+
+#include <easy/easy_net.h>
+#include <easy/profiler.h>
+#include <easy/writer.h>
+
+#include "aggregator.h"
+
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+# include <sys/mman.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+
+EASY_CONSTEXPR int MAX_TIMEOUTS = 30; ///< Max number of receive timeouts (1 second each) while waiting for a reply
+EASY_CONSTEXPR int CLOCK_REQUESTS = 8; ///< Number of time requests sent to a process to estimate its clock offset
+
+/** Current time of the aggregator clock in nanoseconds.
+*/
+static int64_t aggregatorTime()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** Read-only stream buffer over received capture (the capture is read in place without copying).
+*/
+class MemoryStreamBuffer EASY_FINAL : public std::streambuf
+{
+    char* const  m_data; ///< Capture data (never written: std::streambuf requires non-const pointers only)
+    const size_t m_size; ///< Size of capture data
+
+public:
+
+    MemoryStreamBuffer(const char* _data, size_t _size) : m_data(const_cast<char*>(_data)), m_size(_size)
+    {
+        setg(m_data, m_data, m_data + m_size);
+    }
+
+protected:
+
+    pos_type seekoff(off_type _offset, std::ios_base::seekdir _dir, std::ios_base::openmode _which) override
+    {
+        if ((_which & std::ios_base::in) == 0)
+            return pos_type(off_type(-1));
+
+        off_type position = _offset;
+        if (_dir == std::ios_base::cur)
+            position += static_cast<off_type>(gptr() - eback());
+        else if (_dir == std::ios_base::end)
+            position += static_cast<off_type>(m_size);
+
+        if (position < 0 || position > static_cast<off_type>(m_size))
+            return pos_type(off_type(-1));
+
+        setg(m_data, m_data + position, m_data + m_size);
+        return pos_type(position);
+    }
+
+    pos_type seekpos(pos_type _position, std::ios_base::openmode _which) override
+    {
+        return seekoff(off_type(_position), std::ios_base::beg, _which);
+    }
+
+}; // END of class MemoryStreamBuffer.
+
+//////////////////////////////////////////////////////////////////////////
+
+RemoteProcess::RemoteProcess(const std::string& _address, uint16_t _port)
+    : m_address(_address)
+    , m_name(_address + ":" + std::to_string(_port))
+    , m_sharedData(nullptr)
+    , m_sharedSize(0)
+    , m_clockOffset(0)
+    , m_clockAccuracy(0)
+    , m_pid(0)
+    , m_blocks(0)
+    , m_threads(0)
+    , m_port(_port)
+{
+}
+
+const std::string& RemoteProcess::name() const
+{
+    return m_name;
+}
+
+RemoteProcess::~RemoteProcess()
+{
+    releaseSharedData();
+}
+
+const char* RemoteProcess::captureData() const
+{
+    return m_sharedData != nullptr ? m_sharedData : m_capture.data();
+}
+
+size_t RemoteProcess::captureSize() const
+{
+    return m_sharedData != nullptr ? m_sharedSize : m_capture.size();
+}
+
+const std::string& RemoteProcess::error() const
+{
+    return m_error;
+}
+
+profiler::processid_t RemoteProcess::pid() const
+{
+    return m_pid;
+}
+
+profiler::block_index_t RemoteProcess::blocksNumber() const
+{
+    return m_blocks;
+}
+
+uint32_t RemoteProcess::threadsNumber() const
+{
+    return m_threads;
+}
+
+int64_t RemoteProcess::clockOffset() const
+{
+    return m_clockOffset;
+}
+
+int64_t RemoteProcess::clockAccuracy() const
+{
+    return m_clockAccuracy;
+}
+
+bool RemoteProcess::isLocal() const
+{
+    return m_address == "127.0.0.1" || m_address == "localhost";
+}
+
+bool RemoteProcess::connect()
+{
+    int res = -1;
+
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+    // Processes on the same host are connected by Unix domain socket: their blocks are passed by shared memory
+    if (isLocal())
+        res = m_socket.connectLocal(m_port);
+
+    if (res != 0)
+#endif
+    {
+        if (!m_socket.setAddress(m_address.c_str(), m_port))
+            return fail("can not resolve address");
+        res = m_socket.connect();
+    }
+
+    if (res != 0)
+        return fail("can not connect");
+
+    profiler::net::EasyProfilerStatus status(false, false, false);
+    if (!receiveAll(&status, sizeof(status)) || !status.isEasyNetMessage()
+        || status.type != profiler::net::MessageType::Connection_Accepted)
+    {
+        return fail("connection has not been accepted");
+    }
+
+    return true;
+}
+
+bool RemoteProcess::synchronizeClock()
+{
+    int64_t minRoundTrip = std::numeric_limits<int64_t>::max();
+
+    for (int i = 0; i < CLOCK_REQUESTS; ++i)
+    {
+        const profiler::net::Message request(profiler::net::MessageType::Request_Current_Time);
+
+        const auto sendTime = aggregatorTime();
+        if (m_socket.send(&request, sizeof(request)) != static_cast<int>(sizeof(request)))
+            return fail("can not send time request");
+
+        profiler::net::ClockMessage reply;
+        if (!receiveMessage(reply))
+            return false;
+
+        if (reply.type != profiler::net::MessageType::Reply_Current_Time)
+            return fail("unexpected reply to time request");
+
+        const auto payloadSize = sizeof(profiler::net::ClockMessage) - sizeof(profiler::net::Message);
+        if (!receiveAll(reinterpret_cast<char*>(&reply) + sizeof(profiler::net::Message), payloadSize))
+            return false;
+
+        const auto roundTrip = aggregatorTime() - sendTime;
+        if (roundTrip >= minRoundTrip)
+            continue;
+
+        // Process time is converted to nanoseconds the same way as timestamps of its capture are converted by reader
+        const double factor = reply.frequency != 0 ? 1e9 / static_cast<double>(reply.frequency) : 1.;
+        const auto processTime = static_cast<int64_t>(static_cast<double>(reply.time) * factor);
+
+        minRoundTrip = roundTrip;
+        m_clockOffset = sendTime + roundTrip / 2 - processTime;
+    }
+
+    m_clockAccuracy = minRoundTrip / 2;
+
+    return true;
+}
+
+bool RemoteProcess::requestStart()
+{
+    const profiler::net::Message request(profiler::net::MessageType::Request_Start_Capture);
+    return m_socket.send(&request, sizeof(request)) == static_cast<int>(sizeof(request)) || fail("can not send start request");
+}
+
+bool RemoteProcess::waitStarted()
+{
+    profiler::net::Message reply;
+    while (receiveMessage(reply))
+    {
+        if (reply.type == profiler::net::MessageType::Reply_Capturing_Started)
+            return true;
+    }
+
+    return false;
+}
+
+bool RemoteProcess::requestStop()
+{
+    const profiler::net::Message request(profiler::net::MessageType::Request_Stop_Capture);
+    return m_socket.send(&request, sizeof(request)) == static_cast<int>(sizeof(request)) || fail("can not send stop request");
+}
+
+bool RemoteProcess::receiveCapture()
+{
+    m_capture.clear();
+    releaseSharedData();
+
+    profiler::net::Message message;
+    while (receiveMessage(message))
+    {
+        switch (message.type)
+        {
+            case profiler::net::MessageType::Reply_Blocks_End:
+            {
+                if (captureSize() == 0)
+                    return fail("there are no blocks");
+
+                // Read the capture to check it and to get process id
+                MemoryStreamBuffer buffer(captureData(), captureSize());
+                std::istream stream(&buffer);
+                std::ostringstream log;
+                profiler::SerializedData serialized_blocks, serialized_descriptors;
+                profiler::descriptors_list_t descriptors;
+                profiler::blocks_t blocks;
+                profiler::thread_blocks_tree_t trees;
+                profiler::bookmarks_t bookmarks;
+                profiler::BeginEndTime beginEndTime;
+                uint32_t descriptorsCount = 0, version = 0;
+
+                std::atomic<int> progress(0);
+                m_blocks = fillTreesFromStream(progress, stream, beginEndTime, serialized_blocks, serialized_descriptors,
+                                               descriptors, blocks, trees, bookmarks, descriptorsCount, version, m_pid,
+                                               false, log);
+
+                if (m_blocks == 0)
+                    return fail("can not read blocks: " + log.str());
+
+                m_threads = static_cast<uint32_t>(trees.size());
+
+                return true;
+            }
+
+            case profiler::net::MessageType::Reply_Blocks:
+            {
+                uint64_t size = 0;
+                if (!receiveAll(&size, sizeof(size)))
+                    return false;
+
+                const auto offset = m_capture.size();
+                m_capture.resize(offset + static_cast<size_t>(size));
+                if (!receiveAll(&m_capture[offset], static_cast<size_t>(size)))
+                    return false;
+
+                break;
+            }
+
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+            case profiler::net::MessageType::Reply_Blocks_Shared:
+            {
+                uint64_t size = 0;
+                if (!receiveAll(&size, sizeof(size)))
+                    return false;
+
+                const int fd = m_socket.takeReceivedFile();
+                if (fd < 0)
+                    return fail("shared memory descriptor has not been received");
+
+                // The whole capture is passed by one shared memory: it is kept mapped and read in place
+                auto memory = size != 0 && m_sharedData == nullptr && m_capture.empty()
+                    ? mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+                ::close(fd);
+
+                if (memory == MAP_FAILED)
+                {
+                    if (size == 0)
+                        break;
+                    return fail("can not map shared memory");
+                }
+
+                m_sharedData = static_cast<const char*>(memory);
+                m_sharedSize = static_cast<size_t>(size);
+
+                break;
+            }
+#endif
+
+            default:
+                break;
+        }
+    }
+
+    return false;
+}
+
+bool RemoteProcess::receiveAll(void* _buffer, size_t _size)
+{
+    auto data = static_cast<char*>(_buffer);
+    int timeouts = 0;
+
+    while (_size != 0)
+    {
+        const int bytes = m_socket.receive(data, _size);
+        if (bytes > 0)
+        {
+            data += bytes;
+            _size -= static_cast<size_t>(bytes);
+            timeouts = 0;
+            continue;
+        }
+
+        if (m_socket.isDisconnected() || bytes == 0)
+            return fail("connection has been closed");
+
+        // Receive timeout: big captures may take time to be dumped
+        if (++timeouts > MAX_TIMEOUTS)
+            return fail("timeout");
+    }
+
+    return true;
+}
+
+bool RemoteProcess::receiveMessage(profiler::net::Message& _message)
+{
+    if (!receiveAll(&_message, sizeof(_message)))
+        return false;
+
+    if (!_message.isEasyNetMessage())
+        return fail("wrong message received");
+
+    return true;
+}
+
+bool RemoteProcess::fail(const std::string& _error)
+{
+    m_error = _error;
+    return false;
+}
+
+void RemoteProcess::releaseSharedData()
+{
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+    if (m_sharedData != nullptr)
+        munmap(const_cast<char*>(m_sharedData), m_sharedSize);
+#endif
+
+    m_sharedData = nullptr;
+    m_sharedSize = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+bool CaptureAggregator::addEndpoint(const std::string& _endpoint)
+{
+    std::string address = "127.0.0.1";
+    int port = profiler::DEFAULT_PORT;
+
+    const auto colon = _endpoint.rfind(':');
+    if (colon != std::string::npos)
+    {
+        address = _endpoint.substr(0, colon);
+        port = atoi(_endpoint.c_str() + colon + 1);
+    }
+    else if (_endpoint.find_first_not_of("0123456789") == std::string::npos)
+    {
+        port = atoi(_endpoint.c_str());
+    }
+    else
+    {
+        address = _endpoint;
+    }
+
+    if (address.empty() || port <= 0 || port > 65535)
+        return false;
+
+    m_processes.emplace_back(new RemoteProcess(address, static_cast<uint16_t>(port)));
+
+    return true;
+}
+
+bool CaptureAggregator::connect(std::ostream& _log)
+{
+    std::vector<std::thread> threads;
+    threads.reserve(m_processes.size());
+
+    std::vector<char> connected(m_processes.size(), 0);
+    for (size_t i = 0; i < m_processes.size(); ++i)
+    {
+        threads.emplace_back([this, &connected, i] {
+            connected[i] = m_processes[i]->connect() && m_processes[i]->synchronizeClock() ? 1 : 0;
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    size_t i = 0;
+    for (auto it = m_processes.begin(); it != m_processes.end(); ++i)
+    {
+        if (connected[i] == 0)
+        {
+            _log << "Can not connect to " << (*it)->name() << ": " << (*it)->error() << "\n";
+            it = m_processes.erase(it);
+        }
+        else
+        {
+            if (!(*it)->isLocal())
+            {
+                _log << (*it)->name() << ": clock offset " << (*it)->clockOffset() / 1000 << " us (+/- "
+                     << (*it)->clockAccuracy() / 1000 << " us)\n";
+            }
+
+            ++it;
+        }
+    }
+
+    return !m_processes.empty();
+}
+
+bool CaptureAggregator::startCapture(std::ostream& _log)
+{
+    // All requests are sent first to make start as synchronous as possible
+    bool result = true;
+    for (auto& process : m_processes)
+    {
+        if (!process->requestStart())
+        {
+            _log << "Can not start capturing in " << process->name() << ": " << process->error() << "\n";
+            result = false;
+        }
+    }
+
+    for (auto& process : m_processes)
+    {
+        if (!process->waitStarted())
+        {
+            _log << "Capturing has not been started in " << process->name() << ": " << process->error() << "\n";
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+bool CaptureAggregator::stopCapture(std::ostream& _log)
+{
+    for (auto& process : m_processes)
+    {
+        if (!process->requestStop())
+            _log << "Can not stop capturing in " << process->name() << ": " << process->error() << "\n";
+    }
+
+    // Processes dump their blocks at the same time, so all captures are received concurrently
+    std::vector<std::thread> threads;
+    threads.reserve(m_processes.size());
+
+    std::vector<char> received(m_processes.size(), 0);
+    for (size_t i = 0; i < m_processes.size(); ++i)
+    {
+        threads.emplace_back([this, &received, i] {
+            received[i] = m_processes[i]->receiveCapture() ? 1 : 0;
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    bool result = false;
+    for (size_t i = 0; i < m_processes.size(); ++i)
+    {
+        const auto& process = *m_processes[i];
+        if (received[i] == 0)
+        {
+            _log << "Can not receive blocks from " << process.name() << ": " << process.error() << "\n";
+            continue;
+        }
+
+        _log << process.name() << ": pid " << process.pid() << ", " << process.threadsNumber() << " threads, "
+             << process.blocksNumber() << " blocks\n";
+
+        result = true;
+    }
+
+    return result;
+}
+
+bool CaptureAggregator::write(const std::string& _filename, std::ostream& _log) const
+{
+    std::vector<profiler::ProcessCapture> captures;
+    captures.reserve(m_processes.size());
+
+    // Timestamps are converted to the clock of the first local process (or of the first process if all are remote)
+    const RemoteProcess* reference = nullptr;
+    for (const auto& process : m_processes)
+    {
+        if (process->captureSize() == 0 || process->blocksNumber() == 0)
+            continue;
+
+        if (reference == nullptr || (!reference->isLocal() && process->isLocal()))
+            reference = process.get();
+    }
+
+    for (const auto& process : m_processes)
+    {
+        if (process->captureSize() == 0 || process->blocksNumber() == 0)
+            continue;
+
+        profiler::ProcessCapture capture;
+        capture.name = process->name().c_str();
+        capture.data = process->captureData();
+        capture.size = process->captureSize();
+        capture.pid = process->pid();
+        // Local processes use exactly the same clock: estimated offsets are used for remote processes only
+        const bool sameClock = process->isLocal() && reference->isLocal();
+        capture.clock_offset = sameClock ? 0 : process->clockOffset() - reference->clockOffset();
+
+        captures.push_back(capture);
+    }
+
+    if (captures.empty())
+    {
+        _log << "There are no captures to write\n";
+        return false;
+    }
+
+    return writeProcessCapturesToFile(_filename.c_str(), captures.data(), static_cast<uint32_t>(captures.size()), _log);
+}
+
+const std::vector<std::unique_ptr<RemoteProcess> >& CaptureAggregator::processes() const
+{
+    return m_processes;
+}
+
+//////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,166 @@
+/**
+Lightweight profiler library for c++
+Copyright(C) 2016-2019  Sergey Yagovtsev, Victor Zarubkin
+
+Licensed under either of
+	* MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+    * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+at your option.
+
+The MIT License
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+	of the Software, and to permit persons to whom the Software is furnished
+	to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+	INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+	PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+	LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+	TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+	USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+The Apache License, Version 2.0 (the "License");
+	You may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+**/
+
+#ifndef EASY_PROFILER_AGGREGATOR_H
+#define EASY_PROFILER_AGGREGATOR_H
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <easy/easy_socket.h>
+#include <easy/reader.h>
+
+namespace profiler { namespace net { struct Message; } }
+
+//////////////////////////////////////////////////////////////////////////
+
+/** Connection to one profiled process (to its profiler::startListen() endpoint).
+*/
+class RemoteProcess EASY_FINAL
+{
+    EasySocket               m_socket; ///< Connection to the process
+    std::string             m_address; ///< Host name or IP address
+    std::string                m_name; ///< "address:port" of the process
+    std::string             m_capture; ///< Received capture (the same as .prof file contents)
+    const char*          m_sharedData; ///< Received capture in mapped shared memory (local connection only, used instead of m_capture)
+    size_t               m_sharedSize; ///< Size of m_sharedData
+    std::string               m_error; ///< Description of the last error
+    int64_t             m_clockOffset; ///< Time of aggregator clock minus time of process clock (nanoseconds)
+    int64_t           m_clockAccuracy; ///< Max error of m_clockOffset (half of round trip time, nanoseconds)
+    profiler::processid_t       m_pid; ///< Process id from the capture header
+    profiler::block_index_t  m_blocks; ///< Number of blocks in the capture
+    uint32_t                m_threads; ///< Number of threads in the capture
+    uint16_t                   m_port; ///< Listening port of the process
+
+public:
+
+    RemoteProcess(const std::string& _address, uint16_t _port);
+    ~RemoteProcess();
+
+    RemoteProcess(const RemoteProcess&) = delete;
+    RemoteProcess& operator = (const RemoteProcess&) = delete;
+
+    const std::string& name() const;
+
+    /** Received capture (the same as .prof file contents). Shared memory capture is not copied. */
+    const char* captureData() const;
+    size_t captureSize() const;
+
+    const std::string& error() const;
+    profiler::processid_t pid() const;
+    profiler::block_index_t blocksNumber() const;
+    uint32_t threadsNumber() const;
+    int64_t clockOffset() const;
+    int64_t clockAccuracy() const;
+
+    /** Returns true if the process is running on the same host as the aggregator (they use the same clock).
+    */
+    bool isLocal() const;
+
+    bool connect();
+
+    /** Estimate clockOffset() NTP-style: current time of the process is requested several times
+    and the reply with the shortest round trip is used (process time is assumed to be in the middle of the round trip).
+    */
+    bool synchronizeClock();
+
+    bool requestStart();
+    bool waitStarted();
+    bool requestStop();
+
+    /** Receive all blocks after requestStop() and check the capture by reading it.
+    */
+    bool receiveCapture();
+
+private:
+
+    bool receiveAll(void* _buffer, size_t _size);
+    bool receiveMessage(profiler::net::Message& _message);
+    bool fail(const std::string& _error);
+    void releaseSharedData();
+
+}; // END of class RemoteProcess.
+
+//////////////////////////////////////////////////////////////////////////
+
+/** Captures blocks from many processes at once and merges them into one multi-process container.
+
+Capturing is started and stopped in all processes as synchronously as possible:
+requests are sent to all processes first and only then replies are awaited.
+Captures are received concurrently (one thread per process).
+
+Processes on other hosts use their own clocks: clock offset of each process is estimated on connection
+and timestamps of all processes are converted to the clock of the first local process (or of the first process
+if there are no local processes).
+*/
+class CaptureAggregator EASY_FINAL
+{
+    std::vector<std::unique_ptr<RemoteProcess> > m_processes; ///< All processes which are connected
+
+public:
+
+    CaptureAggregator() = default;
+
+    /** Add endpoint of a process: "host:port", "host" (default port) or "port" (localhost).
+    */
+    bool addEndpoint(const std::string& _endpoint);
+
+    /** Connect to all endpoints. Processes which can not be connected are excluded with a message to _log.
+    */
+    bool connect(std::ostream& _log);
+
+    bool startCapture(std::ostream& _log);
+    bool stopCapture(std::ostream& _log);
+
+    /** Write all received captures into one multi-process container (see profiler::ProcessCapture).
+    */
+    bool write(const std::string& _filename, std::ostream& _log) const;
+
+    const std::vector<std::unique_ptr<RemoteProcess> >& processes() const;
+
+}; // END of class CaptureAggregator.
+
+//////////////////////////////////////////////////////////////////////////
+
+#endif // EASY_PROFILER_AGGREGATOR_H
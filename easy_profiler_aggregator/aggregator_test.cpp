@@ -0,0 +1,225 @@
+/**
+Lightweight profiler library for c++
+Copyright(C) 2016-2019  Sergey Yagovtsev, Victor Zarubkin
+
+Licensed under either of
+	* MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+    * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+at your option.
+
+The MIT License
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+	of the Software, and to permit persons to whom the Software is furnished
+	to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+	INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+	PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+	LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+	TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+	USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+The Apache License, Version 2.0 (the "License");
+	You may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+**/
+
+/* Aggregation check: starts several profiler_sample processes on distinct ports, captures them all
+by profiler_aggregator and reads the multi-process container back.
+
+Usage: profiler_aggregator_test PROFILER_SAMPLE PROFILER_AGGREGATOR OUTPUT_FILE
+*/
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <easy/reader.h>
+
+//////////////////////////////////////////////////////////////////////////
+
+EASY_CONSTEXPR int PROCESSES_NUMBER = 2; ///< Number of profiled processes
+EASY_CONSTEXPR int FIRST_PORT = 28177; ///< Listening port of the first process (the next ones use the next ports)
+EASY_CONSTEXPR int CAPTURE_DURATION = 300; ///< Capture duration in milliseconds
+EASY_CONSTEXPR int ATTEMPTS = 10; ///< Processes are started asynchronously: aggregator is restarted until it connects to all of them
+
+static int fail(const std::string& _message)
+{
+    std::cerr << "FAILED: " << _message << "\n";
+    return 1;
+}
+
+static pid_t startSample(const char* _sample, int _port)
+{
+    const auto pid = fork();
+    if (pid == 0)
+    {
+        // Objects, modelling steps, render steps, resource loading count, port:
+        // steps are enough to keep the process running longer than the test
+        const auto port = std::to_string(_port);
+        execl(_sample, _sample, "10", "100000", "100000", "10", port.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    return pid;
+}
+
+/** Run the aggregator and get "pid -> blocks number" of all captured processes from its output. */
+static bool runAggregator(const std::string& _command, std::map<profiler::processid_t, profiler::block_index_t>& _blocks,
+                          std::string& _output)
+{
+    _blocks.clear();
+    _output.clear();
+
+    auto pipe = popen(_command.c_str(), "r");
+    if (pipe == nullptr)
+        return false;
+
+    char line[512];
+    while (fgets(line, sizeof(line), pipe) != nullptr)
+    {
+        _output += line;
+
+        // "address:port: pid 123, 4 threads, 5678 blocks"
+        const char* position = strstr(line, ": pid ");
+        unsigned long long pid = 0, blocks = 0;
+        unsigned threads = 0;
+        if (position != nullptr && sscanf(position, ": pid %llu, %u threads, %llu blocks", &pid, &threads, &blocks) == 3)
+            _blocks[static_cast<profiler::processid_t>(pid)] = static_cast<profiler::block_index_t>(blocks);
+    }
+
+    return pclose(pipe) == 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4)
+    {
+        std::cout << "Usage: " << argv[0] << " PROFILER_SAMPLE PROFILER_AGGREGATOR OUTPUT_FILE\n";
+        return 1;
+    }
+
+    const char* sample = argv[1];
+    const char* aggregator = argv[2];
+    const std::string filename = argv[3];
+
+    std::ostringstream command;
+    command << aggregator << " -o " << filename << " -t " << CAPTURE_DURATION;
+    for (int i = 0; i < PROCESSES_NUMBER; ++i)
+    {
+#if defined(__linux__)
+        // The first process is connected by Unix domain socket (shared memory), the others by TCP
+        command << (i == 0 ? " 127.0.0.1:" : " 127.0.0.2:") << (FIRST_PORT + i);
+#else
+        command << " 127.0.0.1:" << (FIRST_PORT + i);
+#endif
+    }
+    command << " 2>&1";
+
+    std::vector<pid_t> processes;
+    for (int i = 0; i < PROCESSES_NUMBER; ++i)
+    {
+        const auto pid = startSample(sample, FIRST_PORT + i);
+        if (pid < 0)
+            return fail("can not start " + std::string(sample));
+        processes.push_back(pid);
+    }
+
+    std::map<profiler::processid_t, profiler::block_index_t> captured;
+    std::string output;
+    bool aggregated = false;
+    for (int attempt = 0; attempt < ATTEMPTS && !aggregated; ++attempt)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        aggregated = runAggregator(command.str(), captured, output) && captured.size() == PROCESSES_NUMBER;
+    }
+
+    for (auto pid : processes)
+    {
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+    }
+
+    std::cout << output;
+
+    if (!aggregated)
+        return fail("profiler_aggregator has not captured all processes");
+
+    profiler::SerializedData serialized_blocks, serialized_descriptors;
+    profiler::descriptors_list_t descriptors;
+    profiler::blocks_t blocks;
+    profiler::thread_blocks_tree_t trees;
+    profiler::bookmarks_t bookmarks;
+    profiler::BeginEndTime beginEndTime;
+    uint32_t descriptorsCount = 0, version = 0;
+    profiler::processid_t pid = 0;
+    std::ostringstream log;
+
+    const auto total = fillTreesFromFile(filename.c_str(), beginEndTime, serialized_blocks, serialized_descriptors,
+                                         descriptors, blocks, trees, bookmarks, descriptorsCount, version, pid,
+                                         false, log);
+    if (total == 0)
+        return fail("can not read " + filename + ": " + log.str());
+
+    // Each thread root must belong to one of captured processes
+    std::map<profiler::processid_t, profiler::block_index_t> read;
+    for (const auto& tree : trees)
+    {
+        const auto& root = tree.second;
+        if (!root.got_process())
+            return fail("thread " + std::to_string(root.thread_id) + " has no process id");
+
+        if (captured.find(root.process_id) == captured.end())
+            return fail("thread " + std::to_string(root.thread_id) + " has unknown process id " + std::to_string(root.process_id));
+
+        read[root.process_id] += root.blocks_number + static_cast<profiler::block_index_t>(root.sync.size());
+    }
+
+    if (read.size() != captured.size())
+        return fail("threads of " + std::to_string(read.size()) + " processes have been read instead of " + std::to_string(captured.size()));
+
+    profiler::block_index_t capturedTotal = 0;
+    for (const auto& process : captured)
+    {
+        capturedTotal += process.second;
+        if (read[process.first] != process.second)
+        {
+            return fail("process " + std::to_string(process.first) + ": " + std::to_string(read[process.first])
+                        + " blocks have been read instead of " + std::to_string(process.second));
+        }
+    }
+
+    if (total != capturedTotal)
+        return fail(std::to_string(total) + " blocks have been read instead of " + std::to_string(capturedTotal));
+
+    std::cout << "OK: " << read.size() << " processes, " << trees.size() << " threads, " << total << " blocks\n";
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+/**
+Lightweight profiler library for c++
+Copyright(C) 2016-2019  Sergey Yagovtsev, Victor Zarubkin
+
+Licensed under either of
+	* MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+    * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+at your option.
+
+The MIT License
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+	of the Software, and to permit persons to whom the Software is furnished
+	to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+	INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+	PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+	LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+	TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+	USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+The Apache License, Version 2.0 (the "License");
+	You may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+**/
+
+#include <stdlib.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "aggregator.h"
+
+int main(int argc, char* argv[])
+{
+    std::string output_filename = "aggregated.prof";
+    int duration_ms = 0;
+
+    CaptureAggregator aggregator;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc)
+        {
+            output_filename = argv[++i];
+        }
+        else if (arg == "-t" && i + 1 < argc)
+        {
+            duration_ms = atoi(argv[++i]);
+        }
+        else if (!aggregator.addEndpoint(arg))
+        {
+            std::cerr << "Wrong endpoint " << arg << "\n";
+            return 1;
+        }
+    }
+
+    if (argc < 2 || aggregator.processes().empty())
+    {
+        std::cout << "Usage: " << argv[0] << " [-o OUTPUT_FILE] [-t MILLISECONDS] ENDPOINT [ENDPOINT...]\n"
+                                             "where:\n"
+                                             "ENDPOINT is HOST:PORT, HOST (default port) or PORT (localhost) of profiled process // Required\n"
+                                             "OUTPUT_FILE is multi-process capture file (aggregated.prof by default) // Optional\n"
+                                             "MILLISECONDS is capture duration (if not specified capture is stopped by Enter) // Optional\n";
+        return 1;
+    }
+
+    if (!aggregator.connect(std::cerr))
+    {
+        std::cerr << "There are no connected processes\n";
+        return 1;
+    }
+
+    std::cout << "Connected to " << aggregator.processes().size() << " processes\n";
+
+    if (!aggregator.startCapture(std::cerr))
+        std::cerr << "Capturing has not been started in some processes\n";
+
+    if (duration_ms > 0)
+    {
+        std::cout << "Capturing for " << duration_ms << " ms...\n";
+        std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    }
+    else
+    {
+        std::cout << "Capturing... Press Enter to stop\n";
+        std::string line;
+        std::getline(std::cin, line);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    if (!aggregator.stopCapture(std::cout))
+    {
+        std::cerr << "There are no received captures\n";
+        return 1;
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    std::cout << "Received in " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms\n";
+
+    if (!aggregator.write(output_filename, std::cerr))
+    {
+        std::cerr << "\n";
+        return 1;
+    }
+
+    std::cout << "Written to " << output_filename << "\n";
+
+    return 0;
+}
@@ -82,12 +82,26 @@ EASY_CONSTEXPR auto EASY_ALIGN_SIZE = EASY_ALIGNMENT_SIZE;
 # endif
 #endif
 
+#include "numa_arena.h"
+
+#if EASY_OPTION_NUMA_AWARE_CHUNKS != 0 && defined(__linux__)
+// Chunks are allocated on the NUMA node of the thread which owns them (see numa_allocate)
+# define EASY_CHUNK_MALLOC(MEMSIZE, A) numa_allocate(MEMSIZE, A)
+# define EASY_CHUNK_FREE(MEMPTR) numa_free(MEMPTR)
+#else
+# define EASY_CHUNK_MALLOC(MEMSIZE, A) EASY_MALLOC(MEMSIZE, A)
+# define EASY_CHUNK_FREE(MEMPTR) EASY_FREE(MEMPTR)
+#endif
+
 //////////////////////////////////////////////////////////////////////////
 
+EASY_CONSTEXPR uint16_t CHUNK_ELEMENT_FLAGS = 0x8000; ///< Upper bit of element size which is reserved for user flags (see allocate())
+
 template <const uint16_t N>
 class chunk_allocator
 {
     static_assert(N != 0, "chunk_allocator<N> N must be a positive value");
+    static_assert(N <= CHUNK_ELEMENT_FLAGS, "chunk_allocator<N> N must leave upper bit of element size for flags");
 
     struct chunk { EASY_ALIGNED(char, data[N], EASY_ALIGNMENT_SIZE); chunk* prev = nullptr; };
 
@@ -119,11 +133,29 @@ class chunk_allocator
         void emplace_back()
         {
             auto prev = last;
-            last = ::new (EASY_MALLOC(sizeof(chunk), EASY_ALIGNMENT_SIZE)) chunk();
+            last = ::new (EASY_CHUNK_MALLOC(sizeof(chunk), EASY_ALIGNMENT_SIZE)) chunk();
             last->prev = prev;
             zero_last_chunk_size();
         }
 
+        /** Free all chunks which have been added after the chunk c. */
+        void free_after(const chunk* c)
+        {
+            while (last != c)
+                free_last();
+        }
+
+        /** Take all chunks out of the list leaving one new empty chunk in it.
+
+        \return The last taken chunk (taken chunks are still linked by prev pointers). */
+        chunk* release()
+        {
+            auto p = last;
+            last = nullptr;
+            emplace_back();
+            return p;
+        }
+
         /** Invert current chunks list to enable to iterate over chunks list in direct order.
 
         This method is used by serialize().
@@ -148,7 +180,7 @@ class chunk_allocator
         {
             auto p = last;
             last = last->prev;
-            EASY_FREE(p);
+            EASY_CHUNK_FREE(p);
         }
 
         void zero_last_chunk_size()
@@ -166,6 +198,93 @@ class chunk_allocator
     EASY_STATIC_CONSTEXPR int_fast32_t MaxChunkOffset = N - sizeof(uint16_t);
     EASY_STATIC_CONSTEXPR uint16_t OneBeforeN = static_cast<uint16_t>(N - 1);
 
+public:
+
+    /** Chunks taken out of chunk_allocator by take().
+
+    Elements are not copied while being taken, so taken chunks could be serialized (and freed) later by another thread.
+    */
+    class taken_chunks
+    {
+        friend class chunk_allocator;
+
+        chunk* m_last; ///< The most recently taken chunk (chunks are linked by prev pointers like in chunk_list)
+
+    public:
+
+        taken_chunks(const taken_chunks&) = delete;
+        taken_chunks& operator = (const taken_chunks&) = delete;
+
+        taken_chunks() : m_last(nullptr)
+        {
+        }
+
+        taken_chunks(taken_chunks&& _other) EASY_NOEXCEPT : m_last(_other.m_last)
+        {
+            _other.m_last = nullptr;
+        }
+
+        taken_chunks& operator = (taken_chunks&& _other) EASY_NOEXCEPT
+        {
+            clear();
+            m_last = _other.m_last;
+            _other.m_last = nullptr;
+            return *this;
+        }
+
+        ~taken_chunks()
+        {
+            clear();
+        }
+
+        bool empty() const
+        {
+            return m_last == nullptr;
+        }
+
+        void clear()
+        {
+            while (m_last != nullptr)
+            {
+                auto p = m_last;
+                m_last = m_last->prev;
+                EASY_CHUNK_FREE(p);
+            }
+        }
+
+        /** Serialize data to stream in order of allocation.
+
+        \warning Chunks will be freed after serialization.
+        */
+        void serialize(std::ostream& _outputStream)
+        {
+            // Invert chunks list to iterate it in direct order
+            chunk* current = nullptr;
+            while (m_last != nullptr)
+            {
+                auto p = m_last->prev;
+                m_last->prev = current;
+                current = m_last;
+                m_last = p;
+            }
+
+            while (current != nullptr)
+            {
+                // Every taken chunk ends with an element of zero size or it is full (see take())
+                const auto usedSize = used_size(current->data, MaxChunkOffset);
+                if (usedSize != 0)
+                    _outputStream.write(current->data, static_cast<std::streamsize>(usedSize));
+
+                auto p = current;
+                current = current->prev;
+                EASY_CHUNK_FREE(p);
+            }
+        }
+
+    }; // END of class taken_chunks.
+
+private:
+
     chunk_list          m_chunks; ///< List of chunks.
     chunk*         m_markedChunk; ///< Chunk marked by last closed frame
     uint32_t              m_size; ///< Number of elements stored(# of times allocate() has been called.)
@@ -186,8 +305,10 @@ public:
 
     Automatically checks if there is enough preserved memory to store additional n bytes
     and allocates additional buffer if needed.
+    flags (a subset of CHUNK_ELEMENT_FLAGS) are stored together with the element size, so the reader
+    of serialized data can tell different kinds of elements apart.
     */
-    void* allocate(uint16_t n)
+    void* allocate(uint16_t n, uint16_t flags = 0)
     {
         ++m_size;
 
@@ -199,7 +320,7 @@ public:
             chunkOffset += n + sizeof(uint16_t);
             m_chunkOffset = chunkOffset;
 
-            unaligned_store16(data, n);
+            unaligned_store16(data, static_cast<uint16_t>(n | flags));
             data += sizeof(uint16_t);
 
             // If there is enough space for at least another payload size,
@@ -214,7 +335,7 @@ public:
         m_chunks.emplace_back();
 
         char* data = m_chunks.last->data;
-        unaligned_store16(data, n);
+        unaligned_store16(data, static_cast<uint16_t>(n | flags));
         data += sizeof(uint16_t);
         
         // We assume here that it takes more than one element to fill a chunk.
@@ -284,20 +405,14 @@ public:
         do {
 
             isMarked = (current == m_markedChunk);
-            const char* data = current->data;
 
             const int_fast32_t maxOffset = isMarked ? m_markedChunkOffset : MaxChunkOffset;
-            int_fast32_t chunkOffset = 0; // signed int so overflow is not checked.
-            auto payloadSize = unaligned_load16<uint16_t>(data);
+            const int_fast32_t chunkOffset = used_size(current->data, maxOffset);
 
-            while (chunkOffset < maxOffset && payloadSize != 0)
-            {
-                const uint16_t chunkSize = sizeof(uint16_t) + payloadSize;
-                _outputStream.write(data, chunkSize);
-                data += chunkSize;
-                chunkOffset += chunkSize;
-                unaligned_load16(data, &payloadSize);
-            }
+            // Elements are stored contiguously, so the whole used part of the chunk
+            // is written at once (this lets network streams send it without extra copying).
+            if (chunkOffset != 0)
+                _outputStream.write(current->data, static_cast<std::streamsize>(chunkOffset));
 
             current = current->prev;
 
@@ -306,6 +421,39 @@ public:
         clear();
     }
 
+    /** Move marked elements into _taken after elements which are already there. Elements are not copied.
+
+    Elements allocated after the last put_mark() are dropped.
+
+    \warning Allocator will be empty after this call.
+    */
+    void take(taken_chunks& _taken)
+    {
+        if (m_markedSize == 0)
+        {
+            clear();
+            return;
+        }
+
+        // Cut off elements which are not marked: serialization stops at the element of zero size
+        m_chunks.free_after(m_markedChunk);
+        if (m_markedChunkOffset < OneBeforeN)
+            unaligned_zero16(m_markedChunk->data + m_markedChunkOffset);
+
+        chunk* last = m_chunks.release();
+        chunk* first = last;
+        while (first->prev != nullptr)
+            first = first->prev;
+
+        first->prev = _taken.m_last;
+        _taken.m_last = last;
+
+        m_size = 0;
+        m_markedSize = 0;
+        m_chunkOffset = 0;
+        m_markedChunk = nullptr;
+    }
+
     void put_mark()
     {
         m_markedChunk = m_chunks.last;
@@ -374,6 +522,25 @@ public:
         return data;
     }
 
+private:
+
+    /** Returns size of the used part of chunk data (elements are stored contiguously until an element of zero size). */
+    static int_fast32_t used_size(const char* data, int_fast32_t maxOffset)
+    {
+        int_fast32_t chunkOffset = 0; // signed int so overflow is not checked.
+        auto payloadSize = unaligned_load16<uint16_t>(data);
+
+        while (chunkOffset < maxOffset && payloadSize != 0)
+        {
+            const uint16_t chunkSize = sizeof(uint16_t) + (payloadSize & ~CHUNK_ELEMENT_FLAGS);
+            data += chunkSize;
+            chunkOffset += chunkSize;
+            unaligned_load16(data, &payloadSize);
+        }
+
+        return chunkOffset;
+    }
+
 }; // END of class chunk_allocator.
 
 //////////////////////////////////////////////////////////////////////////
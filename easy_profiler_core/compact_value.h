@@ -0,0 +1,303 @@
+/**
+Lightweight profiler library for c++
+Copyright(C) 2016-2019  Sergey Yagovtsev, Victor Zarubkin
+
+Licensed under either of
+    * MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+    * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+at your option.
+
+The MIT License
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights 
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+    of the Software, and to permit persons to whom the Software is furnished 
+    to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all 
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+    LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+    TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE 
+    USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+The Apache License, Version 2.0 (the "License");
+    You may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+**/
+
+#ifndef EASY_PROFILER_COMPACT_VALUE_H
+#define EASY_PROFILER_COMPACT_VALUE_H
+
+#include <unordered_map>
+#include <easy/serialized_block.h>
+#include "alignment_helpers.h"
+
+//////////////////////////////////////////////////////////////////////////
+
+EASY_CONSTEXPR uint16_t COMPACT_VALUE_FLAG = 0x8000; ///< Set in the size of a compact value record
+EASY_CONSTEXPR uint16_t RECORD_SIZE_MASK = 0x7fff; ///< Mask for the size of a record without flags
+
+/** Compact records for scalar arbitrary values.
+
+Scalar numeric values (not arrays and not strings) are stored by ThreadStorage in a compact
+form instead of a full profiler::ArbitraryValue with a copy of the value. Such records are marked by
+COMPACT_VALUE_FLAG in the record size and they are expanded into ArbitraryValue by the reader,
+so values look the same for the reader users.
+
+Record layout:
+    uint8_t header: DataType in lower 4 bits and DeltaBit
+    block id (varint)
+    absolute record: timestamp (8 bytes), vin (8 bytes), value (dataSize(type) bytes)
+    delta record: timestamp delta (zigzag varint), value delta (zigzag varint of the difference for
+                  integer types and varint of xor of bits for floating point types)
+
+Delta record continues the series of the previous record with the same block id within one thread
+(the series has the same vin and the same data type). So consecutive samples of one counter
+usually take several bytes instead of a full ArbitraryValue.
+*/
+class CompactValue EASY_FINAL
+{
+    EASY_STATIC_CONSTEXPR uint8_t DeltaBit = 0x80;
+    EASY_STATIC_CONSTEXPR uint8_t TypeMask = 0x0f;
+
+public:
+
+    struct Series EASY_FINAL
+    {
+        profiler::timestamp_t time = 0; ///< Timestamp of the last sample
+        uint64_t             value = 0; ///< Last value extended to 64 bits (see load())
+        profiler::vin_t        vin = 0; ///< Value id of the series
+        uint32_t             epoch = 0; ///< Used by ThreadStorage to drop all series at once
+        profiler::DataType    type = profiler::DataType::TypesCount;
+    };
+
+    using SeriesMap = std::unordered_map<profiler::block_id_t, Series>;
+
+    static bool isCompact(profiler::DataType type, bool isArray, uint16_t size)
+    {
+        return !isArray && type < profiler::DataType::String && size == dataSize(type);
+    }
+
+    static uint16_t dataSize(profiler::DataType type)
+    {
+        switch (type)
+        {
+            case profiler::DataType::Bool:
+            case profiler::DataType::Char:
+            case profiler::DataType::Int8:
+            case profiler::DataType::Uint8:
+                return 1;
+
+            case profiler::DataType::Int16:
+            case profiler::DataType::Uint16:
+                return 2;
+
+            case profiler::DataType::Int32:
+            case profiler::DataType::Uint32:
+            case profiler::DataType::Float:
+                return 4;
+
+            case profiler::DataType::Int64:
+            case profiler::DataType::Uint64:
+            case profiler::DataType::Double:
+                return 8;
+
+            default:
+                return 0;
+        }
+    }
+
+    ///< Size of ArbitraryValue which is made by the reader from compact record
+    static uint16_t expandedSize(profiler::DataType type)
+    {
+        return static_cast<uint16_t>(sizeof(profiler::ArbitraryValue) + dataSize(type));
+    }
+
+    ///< Load scalar value extending it to 64 bits (signed integers are sign-extended to keep deltas small)
+    static uint64_t load(const void* data, profiler::DataType type)
+    {
+        switch (type)
+        {
+            case profiler::DataType::Int8:
+                return static_cast<uint64_t>(static_cast<int64_t>(*static_cast<const int8_t*>(data)));
+
+            case profiler::DataType::Int16:
+                return static_cast<uint64_t>(static_cast<int64_t>(unaligned_load16<int16_t>(data)));
+
+            case profiler::DataType::Int32:
+                return static_cast<uint64_t>(static_cast<int64_t>(unaligned_load32<int32_t>(data)));
+
+            default:
+                switch (dataSize(type))
+                {
+                    case 1: return *static_cast<const uint8_t*>(data);
+                    case 2: return unaligned_load16<uint16_t>(data);
+                    case 4: return unaligned_load32<uint32_t>(data);
+                    default: return unaligned_load64<uint64_t>(data);
+                }
+        }
+    }
+
+    ///< Size of compact record. Delta record is made if previous sample of the series is provided.
+    static uint16_t recordSize(profiler::block_id_t id, profiler::timestamp_t time, uint64_t value,
+                               profiler::DataType type, const Series* previous)
+    {
+        const auto size = 1 + varintSize(id);
+        if (previous == nullptr)
+            return static_cast<uint16_t>(size + sizeof(profiler::timestamp_t) + sizeof(profiler::vin_t) + dataSize(type));
+        return static_cast<uint16_t>(size + varintSize(zigzag(time - previous->time)) + varintSize(valueDelta(value, previous->value, type)));
+    }
+
+    static void write(char* data, profiler::block_id_t id, profiler::timestamp_t time, profiler::vin_t vin,
+                      uint64_t value, profiler::DataType type, const Series* previous)
+    {
+        *data++ = static_cast<char>(static_cast<uint8_t>(type) | (previous != nullptr ? DeltaBit : 0));
+        data = writeVarint(data, id);
+
+        if (previous != nullptr)
+        {
+            data = writeVarint(data, zigzag(time - previous->time));
+            writeVarint(data, valueDelta(value, previous->value, type));
+            return;
+        }
+
+        unaligned_store64(data, time);
+        unaligned_store64(data + sizeof(profiler::timestamp_t), vin);
+        store(data + sizeof(profiler::timestamp_t) + sizeof(profiler::vin_t), value, type);
+    }
+
+    /** Expand compact record into ArbitraryValue.
+
+    \param series Series of the current thread (updated by the record)
+    \param available Memory size available at expanded
+
+    \return size of expanded value or 0 if the record is corrupted or there is not enough memory */
+    static uint16_t expand(const char* record, uint16_t size, SeriesMap& series, char* expanded, uint64_t available)
+    {
+        const char* end = record + size;
+        if (size < 2)
+            return 0;
+
+        const auto header = static_cast<uint8_t>(*record);
+        const auto type = static_cast<profiler::DataType>(header & TypeMask);
+        const auto valueSize = expandedSize(type);
+        if (type >= profiler::DataType::String || valueSize > available)
+            return 0;
+
+        uint64_t id = 0;
+        record = readVarint(record + 1, end, id);
+        if (record == nullptr || id > static_cast<profiler::block_id_t>(-1))
+            return 0;
+
+        auto& current = series[static_cast<profiler::block_id_t>(id)];
+        if ((header & DeltaBit) != 0)
+        {
+            uint64_t timeDelta = 0, delta = 0;
+            record = readVarint(record, end, timeDelta);
+            if (record == nullptr || current.type != type || readVarint(record, end, delta) == nullptr)
+                return 0;
+
+            current.time += unzigzag(timeDelta);
+            current.value = isFloatingPoint(type) ? current.value ^ delta : current.value + unzigzag(delta);
+        }
+        else
+        {
+            if (end - record < static_cast<ptrdiff_t>(sizeof(profiler::timestamp_t) + sizeof(profiler::vin_t) + dataSize(type)))
+                return 0;
+
+            current.time = unaligned_load64<profiler::timestamp_t>(record);
+            current.vin = unaligned_load64<profiler::vin_t>(record + sizeof(profiler::timestamp_t));
+            current.value = load(record + sizeof(profiler::timestamp_t) + sizeof(profiler::vin_t), type);
+            current.type = type;
+        }
+
+        ::new (expanded) profiler::ArbitraryValue(current.time, current.vin, static_cast<profiler::block_id_t>(id),
+                                                  dataSize(type), type, false);
+        store(expanded + sizeof(profiler::ArbitraryValue), current.value, type);
+
+        return valueSize;
+    }
+
+private:
+
+    static bool isFloatingPoint(profiler::DataType type)
+    {
+        return type == profiler::DataType::Float || type == profiler::DataType::Double;
+    }
+
+    static void store(char* data, uint64_t value, profiler::DataType type)
+    {
+        switch (dataSize(type))
+        {
+            case 1: *data = static_cast<char>(value); break;
+            case 2: unaligned_store16(data, static_cast<uint16_t>(value)); break;
+            case 4: unaligned_store32(data, static_cast<uint32_t>(value)); break;
+            default: unaligned_store64(data, value); break;
+        }
+    }
+
+    static uint64_t zigzag(uint64_t value)
+    {
+        return (value << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(value) >> 63);
+    }
+
+    static uint64_t unzigzag(uint64_t value)
+    {
+        return (value >> 1) ^ (0 - (value & 1));
+    }
+
+    static uint64_t valueDelta(uint64_t value, uint64_t previous, profiler::DataType type)
+    {
+        return isFloatingPoint(type) ? value ^ previous : zigzag(value - previous);
+    }
+
+    static uint16_t varintSize(uint64_t value)
+    {
+        uint16_t size = 1;
+        for (; value >= 0x80; value >>= 7)
+            ++size;
+        return size;
+    }
+
+    static char* writeVarint(char* data, uint64_t value)
+    {
+        for (; value >= 0x80; value >>= 7)
+            *data++ = static_cast<char>(value | 0x80);
+        *data++ = static_cast<char>(value);
+        return data;
+    }
+
+    static const char* readVarint(const char* data, const char* end, uint64_t& value)
+    {
+        value = 0;
+        for (unsigned shift = 0; data != end && shift < 64; shift += 7)
+        {
+            const auto byte = static_cast<uint8_t>(*data++);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                return data;
+        }
+
+        return nullptr;
+    }
+
+}; // END of class CompactValue.
+
+//////////////////////////////////////////////////////////////////////////
+
+#endif // EASY_PROFILER_COMPACT_VALUE_H
@@ -59,6 +59,10 @@ limitations under the License.
 # include <sys/ioctl.h>
 #endif
 
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+# include <stddef.h>
+#endif
+
 /////////////////////////////////////////////////////////////////
 
 #if defined(_WIN32)
@@ -128,6 +132,16 @@ void EasySocket::flush()
         closeSocket(m_replySocket);
     }
 
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+    if (m_receivedFile >= 0)
+    {
+        ::close(m_receivedFile);
+        m_receivedFile = -1;
+    }
+
+    m_isLocal = false;
+#endif
+
 #if defined(_WIN32)
     m_socket = 0;
     m_replySocket = 0;
@@ -291,6 +305,41 @@ int EasySocket::receive(void* buffer, size_t nbytes)
 
 #if defined(_WIN32)
     const int res = ::recv(m_replySocket, (char*)buffer, (int)nbytes, 0);
+#elif EASY_LOCAL_SOCKET_ENABLED != 0
+    int res = 0;
+    if (m_isLocal)
+    {
+        // Shared memory file descriptors are passed as ancillary data
+        struct iovec iov;
+        iov.iov_base = buffer;
+        iov.iov_len = nbytes;
+
+        char control[CMSG_SPACE(sizeof(int))];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        res = (int)::recvmsg(m_replySocket, &msg, MSG_CMSG_CLOEXEC);
+        if (res > 0)
+        {
+            for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+            {
+                if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+                    continue;
+
+                if (m_receivedFile >= 0)
+                    ::close(m_receivedFile);
+                memcpy(&m_receivedFile, CMSG_DATA(cmsg), sizeof(int));
+            }
+        }
+    }
+    else
+    {
+        res = (int)::read(m_replySocket, buffer, nbytes);
+    }
 #else
     const int res = (int)::read(m_replySocket, buffer, nbytes);
 #endif
@@ -436,3 +485,65 @@ int EasySocket::connect()
 
     return res;
 }
+
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+
+socklen_t EasySocket::localAddress(struct sockaddr_un& _address, uint16_t _port)
+{
+    memset(&_address, 0, sizeof(_address));
+    _address.sun_family = AF_UNIX;
+
+    // Abstract namespace: the name begins with zero byte and it is removed automatically with the socket
+    const int length = snprintf(_address.sun_path + 1, sizeof(_address.sun_path) - 1, "easy_profiler.%u", static_cast<unsigned>(_port));
+
+    return static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + 1 + length);
+}
+
+int EasySocket::connectLocal(uint16_t port)
+{
+    const socket_t s = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (!checkSocket(s))
+        return -1;
+
+    struct sockaddr_un address;
+    const auto size = localAddress(address, port);
+
+    const int res = ::connect(s, (struct sockaddr*)&address, size);
+    if (res != 0)
+    {
+        closeSocket(s);
+        return res;
+    }
+
+    struct timeval tv;
+    tv.tv_sec = 1;
+    tv.tv_usec = 0;
+    ::setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (char*)&tv, sizeof(struct timeval));
+
+    // Replace TCP socket
+    if (m_replySocket != m_socket && checkSocket(m_replySocket))
+        closeSocket(m_replySocket);
+    if (checkSocket(m_socket))
+        closeSocket(m_socket);
+
+    m_socket = s;
+    m_replySocket = s;
+    m_isLocal = true;
+    m_state = ConnectionState::Connected;
+
+    return 0;
+}
+
+bool EasySocket::isLocal() const
+{
+    return m_isLocal;
+}
+
+int EasySocket::takeReceivedFile()
+{
+    const int fd = m_receivedFile;
+    m_receivedFile = -1;
+    return fd;
+}
+
+#endif // EASY_LOCAL_SOCKET_ENABLED
@@ -0,0 +1,259 @@
+/**
+Lightweight profiler library for c++
+Copyright(C) 2016-2019  Sergey Yagovtsev, Victor Zarubkin
+
+Licensed under either of
+    * MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+    * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+at your option.
+
+The MIT License
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights 
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+    of the Software, and to permit persons to whom the Software is furnished 
+    to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all 
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+    LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+    TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE 
+    USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+The Apache License, Version 2.0 (the "License");
+    You may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+**/
+
+#ifndef EASY_PROFILER_COROUTINE_H
+#define EASY_PROFILER_COROUTINE_H
+
+#include <easy/profiler.h>
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+# if __has_include(<coroutine>)
+#  define EASY_COROUTINES_AVAILABLE
+# endif
+#endif
+
+#ifdef EASY_COROUTINES_AVAILABLE
+
+#include <coroutine>
+#include <type_traits>
+#include <utility>
+
+#ifdef BUILD_WITH_EASY_PROFILER
+
+/** Macro for beginning of an asynchronous block (e.g. the body of a coroutine) with custom name and color.
+
+Unlike EASY_BLOCK this block never stays on the stack of opened blocks of a thread while coroutine is suspended.
+Every suspension (co_await of span.await(...)) closes current segment of the block and every resumption opens
+a new one, possibly on another thread. Reader links all segments together (see collectAsyncSpans in easy/reader.h).
+Last segment is closed when the span goes out of scope.
+
+\code
+    #include <easy/coroutine.h>
+    task<void> handleRequest(connection& c)
+    {
+        EASY_ASYNC_BLOCK(span, "handleRequest", profiler::colors::Green);
+        auto request = co_await span.await(c.read());
+        EASY_BLOCK("Parse"); // Ordinary blocks are allowed between suspension points
+        parse(request);
+        EASY_END_BLOCK;
+        co_await span.await(c.write(reply(request)));
+    }
+\endcode
+
+\note Do not co_await while an ordinary block (EASY_BLOCK) is opened: such block would stay on the stack of the thread
+which has suspended the coroutine.
+
+\ingroup profiler
+*/
+# define EASY_ASYNC_BLOCK(span, name, ...)\
+    EASY_LOCAL_STATIC_PTR(const ::profiler::BaseBlockDescriptor*, EASY_UNIQUE_DESC(__LINE__), ::profiler::registerDescription(::profiler::extract_enable_flag(__VA_ARGS__),\
+        EASY_UNIQUE_LINE_ID, EASY_COMPILETIME_NAME(name), __FILE__, __LINE__, ::profiler::BlockType::Block, ::profiler::extract_color(__VA_ARGS__),\
+        ::std::is_base_of<::profiler::ForceConstStr, decltype(name)>::value));\
+    ::profiler::async_span span(EASY_UNIQUE_DESC(__LINE__), EASY_RUNTIME_NAME(name))
+
+#else // #ifdef BUILD_WITH_EASY_PROFILER
+
+# define EASY_ASYNC_BLOCK(span, ...) ::profiler::async_span span(nullptr)
+
+#endif // #ifdef BUILD_WITH_EASY_PROFILER
+
+namespace profiler {
+
+    template <class TAwaiter>
+    class async_span_awaiter;
+
+    namespace async_detail {
+
+        template <class T, class = void>
+        struct has_member_co_await : std::false_type {};
+
+        template <class T>
+        struct has_member_co_await<T, std::void_t<decltype(std::declval<T>().operator co_await())> > : std::true_type {};
+
+        template <class T, class = void>
+        struct has_free_co_await : std::false_type {};
+
+        template <class T>
+        struct has_free_co_await<T, std::void_t<decltype(operator co_await(std::declval<T>()))> > : std::true_type {};
+
+        /** Returns awaiter of the awaitable the same way as co_await does (except for await_transform). */
+        template <class T>
+        decltype(auto) get_awaiter(T&& _awaitable)
+        {
+            if constexpr (has_member_co_await<T>::value)
+                return std::forward<T>(_awaitable).operator co_await();
+            else if constexpr (has_free_co_await<T>::value)
+                return operator co_await(std::forward<T>(_awaitable));
+            else
+                return std::forward<T>(_awaitable);
+        }
+
+    } // END of namespace async_detail.
+
+    //////////////////////////////////////////////////////////////////////////
+
+    /** Asynchronous block consisting of segments which could be stored by different threads.
+
+    \note There is no need to create async_span explicitly - use EASY_ASYNC_BLOCK instead.
+
+    \sa EASY_ASYNC_BLOCK, ASYNC_SPAN_VALUE_NAME
+
+    \ingroup profiler
+    */
+    class async_span EASY_FINAL
+    {
+        const BaseBlockDescriptor* m_descriptor; ///< Descriptor of the block (nullptr if profiler is not used)
+        const char*                      m_name; ///< Runtime name of the block
+        uint64_t                           m_id; ///< Unique id of the span (0 until first segment is opened)
+        timestamp_t              m_segmentBegin; ///< Begin time of current segment (0 if there is no opened segment)
+
+    public:
+
+        async_span(const async_span&) = delete;
+        async_span& operator = (const async_span&) = delete;
+
+        explicit async_span(const BaseBlockDescriptor* _descriptor, const char* _runtimeName = "")
+            : m_descriptor(_descriptor)
+            , m_name(_runtimeName)
+            , m_id(0)
+            , m_segmentBegin(0)
+        {
+            resume();
+        }
+
+        ~async_span()
+        {
+            suspend();
+        }
+
+        uint64_t id() const
+        {
+            return m_id;
+        }
+
+        /** Closes current segment. Invoked automatically by awaiter returned from await(). */
+        void suspend()
+        {
+            const auto begin = m_segmentBegin;
+            if (begin == 0)
+                return;
+
+            m_segmentBegin = 0;
+            storeAsyncSegment(m_descriptor, m_name, m_id, begin, now());
+        }
+
+        /** Opens a new segment. Invoked automatically by awaiter returned from await(). */
+        void resume()
+        {
+            if (m_descriptor == nullptr || !isEnabled())
+                return;
+
+            if (m_id == 0)
+                m_id = newAsyncSpanId();
+
+            m_segmentBegin = now();
+        }
+
+        /** Wraps an awaitable to split this span into segments at the suspension point.
+
+        \code
+            auto result = co_await span.await(socket.read());
+        \endcode
+        */
+        template <class TAwaitable>
+        auto await(TAwaitable&& _awaitable)
+        {
+            using awaiter_t = decltype(async_detail::get_awaiter(std::forward<TAwaitable>(_awaitable)));
+            return async_span_awaiter<awaiter_t>(*this, async_detail::get_awaiter(std::forward<TAwaitable>(_awaitable)));
+        }
+
+    }; // END of class async_span.
+
+    //////////////////////////////////////////////////////////////////////////
+
+    /** Awaiter wrapper closing current segment of async_span on suspend and opening a new one on resume.
+
+    \sa async_span::await
+
+    \ingroup profiler
+    */
+    template <class TAwaiter>
+    class async_span_awaiter EASY_FINAL
+    {
+        async_span&    m_span; ///< Span of the awaiting coroutine
+        TAwaiter    m_awaiter; ///< Wrapped awaiter (a reference if awaiter is not a temporary)
+
+    public:
+
+        async_span_awaiter(async_span& _span, TAwaiter&& _awaiter)
+            : m_span(_span)
+            , m_awaiter(std::forward<TAwaiter>(_awaiter))
+        {
+        }
+
+        bool await_ready()
+        {
+            return m_awaiter.await_ready();
+        }
+
+        template <class TPromise>
+        decltype(auto) await_suspend(std::coroutine_handle<TPromise> _handle)
+        {
+            // Coroutine could be resumed (and even destroyed) by another thread before wrapped await_suspend returns,
+            // so current segment must be closed beforehand
+            m_span.suspend();
+            return m_awaiter.await_suspend(_handle);
+        }
+
+        decltype(auto) await_resume()
+        {
+            m_span.resume();
+            return m_awaiter.await_resume();
+        }
+
+    }; // END of class async_span_awaiter.
+
+} // END of namespace profiler.
+
+#endif // EASY_COROUTINES_AVAILABLE
+
+#endif // EASY_PROFILER_COROUTINE_H
@@ -71,6 +71,58 @@ namespace profiler {
         MICROSECONDS ///< Microseconds
     };
 
+    /** Performance counters which could be captured for every block (see setPerfCounters()).
+
+    Hardware counters are not available on many virtual machines and containers. In such case
+    software counters are captured instead (PERF_TASK_CLOCK and PERF_PAGE_FAULTS if none of software
+    counters were requested).
+
+    \note Supported on Linux only (perf_event_open).
+
+    \ingroup profiler
+    */
+    enum PerfCounter : uint8_t
+    {
+        PERF_CYCLES = 0,       ///< CPU cycles (hardware)
+        PERF_INSTRUCTIONS,     ///< Retired instructions (hardware)
+        PERF_CACHE_MISSES,     ///< Last level cache misses (hardware)
+        PERF_BRANCH_MISSES,    ///< Mispredicted branches (hardware)
+        PERF_TASK_CLOCK,       ///< Thread CPU time in nanoseconds (software)
+        PERF_PAGE_FAULTS,      ///< Page faults (software)
+        PERF_CONTEXT_SWITCHES, ///< Context switches (software)
+
+        PERF_COUNTERS_NUMBER
+    };
+
+    EASY_CONSTEXPR uint8_t MAX_PERF_COUNTERS = 4; ///< Maximum number of performance counters captured at once
+
+    /** Default set of performance counters: IPC, cache misses and branch misses could be calculated. */
+    EASY_CONSTEXPR uint32_t PERF_DEFAULT_COUNTERS = (1U << PERF_CYCLES) | (1U << PERF_INSTRUCTIONS) |
+        (1U << PERF_CACHE_MISSES) | (1U << PERF_BRANCH_MISSES);
+
+    /** Names of arbitrary values storing memory allocations and deallocations.
+
+    Value is the size of memory block in bytes (0 if unknown) and value id is the address of memory block.
+
+    \sa storeAllocation, storeDeallocation, EASY_ALLOC, EASY_DEALLOC */
+    EASY_CONSTEXPR char ALLOCATION_VALUE_NAME[] = "EasyProfiler.Alloc";
+    EASY_CONSTEXPR char DEALLOCATION_VALUE_NAME[] = "EasyProfiler.Free";
+
+    /** Names of blocks storing lock contention: waiting for a lock and holding a lock.
+
+    Runtime name of such block is the name of the lock.
+
+    \sa profiler::mutex, storeLockWait, storeLockHold */
+    EASY_CONSTEXPR char LOCK_WAIT_BLOCK_NAME[] = "EasyProfiler.LockWait";
+    EASY_CONSTEXPR char LOCK_HOLD_BLOCK_NAME[] = "EasyProfiler.LockHold";
+
+    /** Name of arbitrary value linking segments of an asynchronous span (e.g. a coroutine) together.
+
+    Every segment block of the span has such value as a child. Value and value id are the id of the span.
+
+    \sa profiler::async_span, storeAsyncSegment */
+    EASY_CONSTEXPR char ASYNC_SPAN_VALUE_NAME[] = "EasyProfiler.AsyncSpan";
+
     //***********************************************
 
 #pragma pack(push,1)
@@ -48,7 +48,10 @@ The Apache License, Version 2.0 (the "License");
 
 namespace profiler { namespace net {
 
-EASY_CONSTEXPR uint32_t EASY_MESSAGE_SIGN = 20160909;
+// Signature is changed with incompatible changes of the protocol, so peers of different versions reject messages
+// of each other instead of misparsing them.
+// v2.2.0: DataMessage::size is 64-bit (it was 32-bit with signature 20160909).
+EASY_CONSTEXPR uint32_t EASY_MESSAGE_SIGN = 20261019;
 
 #pragma pack(push,1)
 
@@ -77,6 +80,15 @@ enum class MessageType : uint8_t
 
     Request_MainThread_FPS,
     Reply_MainThread_FPS,
+
+    Request_Start_Live_Capture,
+    Reply_Live_Blocks,
+    Reply_Live_Blocks_End,
+
+    Reply_Blocks_Shared, // DataMessage without payload: blocks are in shared memory which file descriptor is passed with the message
+
+    Request_Current_Time,
+    Reply_Current_Time, // ClockMessage: current time of the profiler clock (used to synchronize clocks of different hosts)
 };
 
 struct Message
@@ -95,10 +107,10 @@ struct Message
 
 struct DataMessage : public Message
 {
-    uint32_t size = 0; // bytes
+    uint64_t size = 0; // bytes (one message is one frame; big data is split into several frames of the same type)
 
     explicit DataMessage(MessageType _t = MessageType::Reply_Blocks) : Message(_t) {}
-    explicit DataMessage(uint32_t _s, MessageType _t = MessageType::Reply_Blocks) : Message(_t), size(_s) {}
+    explicit DataMessage(uint64_t _s, MessageType _t = MessageType::Reply_Blocks) : Message(_t), size(_s) {}
 
     const char* data() const { return reinterpret_cast<const char*>(this) + sizeof(DataMessage); }
 };
@@ -152,6 +164,27 @@ struct TimestampMessage : public Message
     TimestampMessage() = default;
 };
 
+struct ClockMessage : public Message
+{
+    uint64_t      time = 0; // current time of the profiler clock (ticks, the same as block timestamps)
+    int64_t  frequency = 0; // clock frequency in Hz (the same as in the capture header); 0 means that time is in nanoseconds
+
+    explicit ClockMessage(uint64_t _time, int64_t _frequency)
+        : Message(MessageType::Reply_Current_Time), time(_time), frequency(_frequency) { }
+
+    ClockMessage() = default;
+};
+
+struct LiveCaptureMessage : public Message
+{
+    uint32_t interval = 0; // milliseconds between two portions of live blocks
+
+    explicit LiveCaptureMessage(uint32_t _interval)
+        : Message(MessageType::Request_Start_Live_Capture), interval(_interval) { }
+
+    LiveCaptureMessage() = default;
+};
+
 #pragma pack(pop)
 
 }//net
@@ -56,6 +56,12 @@ The Apache License, Version 2.0 (the "License");
 # include <fcntl.h>
 # include <netinet/in.h> //for android-build
 
+# if defined(__linux__)
+// Clients on the same host can connect by Unix domain socket and receive blocks by shared memory (memfd)
+#  include <sys/un.h>
+#  define EASY_LOCAL_SOCKET_ENABLED 1
+# endif
+
 #else
 
 // Windows
@@ -67,6 +73,16 @@ The Apache License, Version 2.0 (the "License");
 
 #endif
 
+#ifndef EASY_LOCAL_SOCKET_ENABLED
+# define EASY_LOCAL_SOCKET_ENABLED 0
+#endif
+
+/** Blocking socket used by profiler clients (GUI, aggregator) to connect to the profiled application.
+
+\note ABI break in v2.2.0: members for local (Unix domain socket) connections have been added on Linux,
+so the size of EasySocket differs from previous versions. Applications which use EasySocket directly
+must be rebuilt with v2.2.0 headers (the library is source compatible).
+*/
 class PROFILER_API EasySocket EASY_FINAL
 {
 public:
@@ -96,6 +112,11 @@ private:
 
     ConnectionState m_state = ConnectionState::Unknown;
 
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+    int m_receivedFile = -1; ///< File descriptor received with data by local socket
+    bool m_isLocal = false; ///< True if connected by Unix domain socket
+#endif
+
 public:
 
     EasySocket();
@@ -119,6 +140,26 @@ public:
     bool isDisconnected() const;
     bool isConnected() const;
 
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+    /** Fill abstract Unix domain socket address of the profiler listening the port.
+
+    \retval Size of the address.
+    */
+    static socklen_t localAddress(struct sockaddr_un& _address, uint16_t _port);
+
+    /** Connect to the profiler on the same host by Unix domain socket.
+
+    On success the socket is used instead of TCP socket until flush().
+    */
+    int connectLocal(uint16_t port);
+
+    bool isLocal() const;
+
+    /** Take ownership of the file descriptor which has been received with data (or -1 if there is no one).
+    */
+    int takeReceivedFile();
+#endif
+
 private:
 
     void checkResult(int result);
@@ -0,0 +1,219 @@
+/**
+Lightweight profiler library for c++
+Copyright(C) 2016-2019  Sergey Yagovtsev, Victor Zarubkin
+
+Licensed under either of
+    * MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+    * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+at your option.
+
+The MIT License
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights 
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+    of the Software, and to permit persons to whom the Software is furnished 
+    to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all 
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+    LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+    TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE 
+    USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+The Apache License, Version 2.0 (the "License");
+    You may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+**/
+
+#ifndef EASY_PROFILER_MUTEX_H
+#define EASY_PROFILER_MUTEX_H
+
+#include <easy/profiler.h>
+#include <mutex>
+#include <stdio.h>
+
+#if __cplusplus >= 201402L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L)
+# include <shared_mutex>
+#endif
+
+namespace profiler {
+
+    /** Mutex wrapper storing lock contention: "waiting for lock" and "holding lock" blocks.
+
+    Blocks are stored with the name of the lock as runtime name, so reader could rank locks
+    by wait time (see collectLockStatistics in easy/reader.h) and GUI could show which lock a thread was waiting for.
+    Waiting block is stored only if the lock was contended (could not be acquired immediately).
+
+    \code
+    #include <easy/mutex.h>
+    profiler::mutex queueMutex("Queue"); // drop-in replacement of std::mutex
+    void push(int value) {
+        std::lock_guard<profiler::mutex> lock(queueMutex);
+        ...
+    }
+    \endcode
+
+    \note Name must be a string literal or another string which outlives the mutex.
+    Mutex without a name is named by its address.
+
+    \note If profiler is disabled (or not used at all) this is just a thin wrapper of TMutex.
+
+    \sa LOCK_WAIT_BLOCK_NAME, LOCK_HOLD_BLOCK_NAME
+
+    \ingroup profiler
+    */
+    template <class TMutex>
+    class profiled_mutex
+    {
+    protected:
+
+        TMutex              m_mutex; ///< Wrapped mutex
+        timestamp_t     m_holdBegin; ///< Time when exclusive lock has been acquired (0 if profiler was disabled)
+        const char*          m_name; ///< Name of the lock
+        char          m_nameBuf[32]; ///< Storage for the default name
+
+    public:
+
+        profiled_mutex(const profiled_mutex&) = delete;
+        profiled_mutex& operator = (const profiled_mutex&) = delete;
+
+        profiled_mutex() : m_holdBegin(0), m_name(m_nameBuf)
+        {
+            snprintf(m_nameBuf, sizeof(m_nameBuf), "mutex %p", static_cast<const void*>(this));
+        }
+
+        explicit profiled_mutex(const char* _name) : m_holdBegin(0), m_name(_name)
+        {
+        }
+
+        const char* name() const
+        {
+            return m_name;
+        }
+
+        void lock()
+        {
+            if (!isEnabled())
+            {
+                m_mutex.lock();
+                m_holdBegin = 0;
+                return;
+            }
+
+            const auto begin = now();
+            if (m_mutex.try_lock())
+            {
+                m_holdBegin = begin;
+                return;
+            }
+
+            m_mutex.lock();
+            m_holdBegin = now();
+            storeLockWait(m_name, begin, m_holdBegin);
+        }
+
+        bool try_lock()
+        {
+            if (!m_mutex.try_lock())
+                return false;
+            m_holdBegin = isEnabled() ? now() : 0;
+            return true;
+        }
+
+        void unlock()
+        {
+            const auto begin = m_holdBegin;
+            if (begin == 0)
+            {
+                m_mutex.unlock();
+                return;
+            }
+
+            m_holdBegin = 0;
+            const auto end = now();
+            m_mutex.unlock();
+            storeLockHold(m_name, begin, end);
+        }
+
+    }; // END of class profiled_mutex.
+
+    //////////////////////////////////////////////////////////////////////////
+
+    /** Shared mutex wrapper storing lock contention (see profiled_mutex).
+
+    Exclusive locks store both waiting and holding blocks. Shared locks store only waiting blocks because
+    there could be many owners of a shared lock at once.
+
+    \ingroup profiler
+    */
+    template <class TSharedMutex>
+    class profiled_shared_mutex : public profiled_mutex<TSharedMutex>
+    {
+        using Parent = profiled_mutex<TSharedMutex>;
+
+    public:
+
+        profiled_shared_mutex() : Parent()
+        {
+        }
+
+        explicit profiled_shared_mutex(const char* _name) : Parent(_name)
+        {
+        }
+
+        void lock_shared()
+        {
+            if (!isEnabled())
+            {
+                this->m_mutex.lock_shared();
+                return;
+            }
+
+            const auto begin = now();
+            if (this->m_mutex.try_lock_shared())
+                return;
+
+            this->m_mutex.lock_shared();
+            storeLockWait(this->m_name, begin, now());
+        }
+
+        bool try_lock_shared()
+        {
+            return this->m_mutex.try_lock_shared();
+        }
+
+        void unlock_shared()
+        {
+            this->m_mutex.unlock_shared();
+        }
+
+    }; // END of class profiled_shared_mutex.
+
+    //////////////////////////////////////////////////////////////////////////
+
+    using mutex = profiled_mutex<std::mutex>;
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+    using shared_mutex = profiled_shared_mutex<std::shared_mutex>;
+#elif __cplusplus >= 201402L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L)
+    using shared_mutex = profiled_shared_mutex<std::shared_timed_mutex>;
+#endif
+
+} // END of namespace profiler.
+
+#endif // EASY_PROFILER_MUTEX_H
@@ -273,6 +273,54 @@ This is just for user's comfort. There is no difference for EasyProfiler GUI bet
 */
 # define EASY_SET_EVENT_TRACING_ENABLED(isEnabled) ::profiler::setEventTracingEnabled(isEnabled);
 
+/** Set performance counters captured for every block (0 turns counters off).
+
+\code
+#include <easy/profiler.h>
+void main() {
+    EASY_SET_PERF_COUNTERS(profiler::PERF_DEFAULT_COUNTERS);
+    EASY_PROFILER_ENABLE;
+    ...
+}
+\endcode
+
+\sa profiler::setPerfCounters, profiler::PerfCounter
+
+\ingroup profiler
+*/
+# define EASY_SET_PERF_COUNTERS(counters) ::profiler::setPerfCounters(counters);
+
+/** Macro for storing memory allocation of size bytes at address.
+
+Allocations are stored only by threads which are already registered (have stored at least one block or
+have been registered explicitly). The reader accounts them to the enclosing blocks (see BlocksTreeRoot::allocations).
+
+\code
+#include <easy/profiler.h>
+void* myAlloc(size_t size) {
+    void* address = malloc(size);
+    EASY_ALLOC(address, size);
+    return address;
+}
+\endcode
+
+\note Use easy_profiler_malloc library (EASY_OPTION_MALLOC_INTERPOSER) to trace all allocations
+of an application without changing its code: LD_PRELOAD=libeasy_profiler_malloc.so ./app
+
+\sa EASY_DEALLOC, profiler::storeAllocation
+
+\ingroup profiler
+*/
+# define EASY_ALLOC(address, size) ::profiler::storeAllocation(address, size);
+
+/** Macro for storing memory deallocation of size bytes at address (pass 0 if size is unknown).
+
+\sa EASY_ALLOC, profiler::storeDeallocation
+
+\ingroup profiler
+*/
+# define EASY_DEALLOC(address, size) ::profiler::storeDeallocation(address, size);
+
 /** Set event tracing thread priority (low or normal).
 
 Event tracing with low priority will affect your application performance much more less, but
@@ -388,6 +436,9 @@ Otherwise, no log messages will be printed.
 # define EASY_THREAD_SCOPE(...)
 # define EASY_MAIN_THREAD 
 # define EASY_SET_EVENT_TRACING_ENABLED(isEnabled) 
+# define EASY_SET_PERF_COUNTERS(counters) 
+# define EASY_ALLOC(address, size) 
+# define EASY_DEALLOC(address, size) 
 # define EASY_SET_LOW_PRIORITY_EVENT_TRACING(isLowPriority) 
 
 # ifndef _WIN32
@@ -616,6 +667,69 @@ namespace profiler {
         PROFILER_API void setEventTracingEnabled(bool _isEnable);
         PROFILER_API bool isEventTracingEnabled();
 
+        /** Set performance counters captured for every block (mask of 1 << PerfCounter, 0 turns counters off).
+
+        Counters are captured by each thread for the blocks opened after this call. Their values
+        are stored with the blocks and are shown in the GUI (IPC, cache misses, page faults).
+
+        \note Turned off by default. Use PERF_DEFAULT_COUNTERS to capture IPC, cache misses and branch misses.
+
+        \note If hardware counters are unavailable then software counters are captured instead (see PerfCounter).
+
+        \sa PerfCounter, EASY_SET_PERF_COUNTERS
+
+        \ingroup profiler
+        */
+        PROFILER_API void setPerfCounters(uint32_t _counters);
+        PROFILER_API uint32_t perfCounters();
+
+        /** Stores memory allocation (or deallocation) of _size bytes at _address.
+
+        \note There is no need to invoke this function explicitly - use EASY_ALLOC and EASY_DEALLOC macros instead.
+
+        \note Nothing is stored for threads which have not been registered yet (see EASY_ALLOC).
+
+        \sa ALLOCATION_VALUE_NAME, DEALLOCATION_VALUE_NAME
+
+        \ingroup profiler
+        */
+        PROFILER_API void storeAllocation(const void* _address, size_t _size);
+        PROFILER_API void storeDeallocation(const void* _address, size_t _size);
+
+        /** Stores a block of waiting for (or holding) the lock named _lockName.
+
+        \note There is no need to invoke this function explicitly - use profiler::mutex (see easy/mutex.h) instead.
+
+        \sa LOCK_WAIT_BLOCK_NAME, LOCK_HOLD_BLOCK_NAME
+
+        \ingroup profiler
+        */
+        PROFILER_API void storeLockWait(const char* _lockName, timestamp_t _beginTime, timestamp_t _endTime);
+        PROFILER_API void storeLockHold(const char* _lockName, timestamp_t _beginTime, timestamp_t _endTime);
+
+        /** Returns new unique id of an asynchronous span.
+
+        \sa storeAsyncSegment
+
+        \ingroup profiler
+        */
+        PROFILER_API uint64_t newAsyncSpanId();
+
+        /** Stores one segment of an asynchronous span (e.g. coroutine between resume and suspend).
+
+        Segment is stored as a block with explicit begin and end times, so it never touches the stack of opened blocks
+        of current thread. Segments with the same _spanId are linked together by reader (see collectAsyncSpans)
+        even if they were stored by different threads.
+
+        \note There is no need to invoke this function explicitly - use profiler::async_span (see easy/coroutine.h) instead.
+
+        \sa ASYNC_SPAN_VALUE_NAME, newAsyncSpanId
+
+        \ingroup profiler
+        */
+        PROFILER_API void storeAsyncSegment(const BaseBlockDescriptor* _desc, const char* _runtimeName, uint64_t _spanId,
+                                            timestamp_t _beginTime, timestamp_t _endTime);
+
         /** Set event tracing thread priority (low or normal).
 
         \note This change will take effect on the next call of setEnabled(true);
@@ -783,6 +897,14 @@ namespace profiler {
     inline const char* registerThread(const char*) { return ""; }
     inline void setEventTracingEnabled(bool) { }
     inline EASY_CONSTEXPR_FCN bool isEventTracingEnabled() { return false; }
+    inline void setPerfCounters(uint32_t) { }
+    inline EASY_CONSTEXPR_FCN uint32_t perfCounters() { return 0; }
+    inline void storeAllocation(const void*, size_t) { }
+    inline void storeDeallocation(const void*, size_t) { }
+    inline void storeLockWait(const char*, timestamp_t, timestamp_t) { }
+    inline void storeLockHold(const char*, timestamp_t, timestamp_t) { }
+    inline EASY_CONSTEXPR_FCN uint64_t newAsyncSpanId() { return 0; }
+    inline void storeAsyncSegment(const BaseBlockDescriptor*, const char*, uint64_t, timestamp_t, timestamp_t) { }
     inline void setLowPriorityEventTracing(bool) { }
     inline EASY_CONSTEXPR_FCN bool isLowPriorityEventTracing() { return false; }
     inline void setContextSwitchLogFilename(const char*) { }
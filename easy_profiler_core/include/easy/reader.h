@@ -46,8 +46,10 @@ The Apache License, Version 2.0 (the "License");
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include <atomic>
+#include <cstring>
 #include <functional>
 #include <iostream>
+#include <map>
 #include <unordered_map>
 #include <string>
 #include <vector>
@@ -120,7 +122,9 @@ namespace profiler {
         profiler::BlockStatistics* per_parent_stats; ///< Pointer to statistics for this block within the parent (may be nullptr for top-level blocks)
         profiler::BlockStatistics*  per_frame_stats; ///< Pointer to statistics for this block within the frame (may be nullptr for top-level blocks)
         profiler::BlockStatistics* per_thread_stats; ///< Pointer to statistics for this block within the bounds of all frames per current thread
+        profiler::block_index_t              parent; ///< Index of the innermost enclosing block (~0U for top-level blocks)
         uint8_t                               depth; ///< Maximum number of sublevels (maximum children depth)
+        uint8_t                       perf_counters; ///< Number of performance counters stored right after the block name (see perfCounter())
 
         BlocksTree(const This&) = delete;
         This& operator = (const This&) = delete;
@@ -130,7 +134,9 @@ namespace profiler {
             , per_parent_stats(nullptr)
             , per_frame_stats(nullptr)
             , per_thread_stats(nullptr)
+            , parent(~0U)
             , depth(0)
+            , perf_counters(0)
         {
 
         }
@@ -161,6 +167,30 @@ namespace profiler {
             return node->begin() < other.node->begin();
         }
 
+        /** Returns value of performance counter captured for this block (see setPerfCounters()).
+
+        \retval false if the counter was not captured. */
+        bool perfCounter(profiler::PerfCounter counter, uint64_t& value) const EASY_NOEXCEPT
+        {
+            if (perf_counters == 0)
+                return false;
+
+            // Skip name, it's terminating zero and number of counters
+            const char* ids = node->name();
+            ids += strlen(ids) + 2;
+
+            for (uint8_t i = 0; i < perf_counters; ++i)
+            {
+                if (static_cast<uint8_t>(ids[i]) == counter)
+                {
+                    memcpy(&value, ids + perf_counters + i * sizeof(uint64_t), sizeof(uint64_t));
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
         void shrink_to_fit() EASY_NOEXCEPT
         {
             //for (auto& child : children)
@@ -194,7 +224,9 @@ namespace profiler {
             per_parent_stats = that.per_parent_stats;
             per_frame_stats = that.per_frame_stats;
             per_thread_stats = that.per_thread_stats;
+            parent = that.parent;
             depth = that.depth;
+            perf_counters = that.perf_counters;
 
             that.node = nullptr;
             that.per_parent_stats = nullptr;
@@ -220,6 +252,76 @@ namespace profiler {
 
     //////////////////////////////////////////////////////////////////////////
 
+    struct AllocationStats EASY_FINAL
+    {
+        uint64_t  bytes = 0; ///< Total size of allocated memory in bytes
+        uint32_t allocs = 0; ///< Number of allocations
+        uint32_t  frees = 0; ///< Number of deallocations
+    };
+
+    /** Allocations of one thread by index of enclosing block (including allocations of all block's children).
+
+    Allocations outside of any block are stored by index ~0U. */
+    using allocations_t = std::map<profiler::block_index_t, AllocationStats>;
+
+    //////////////////////////////////////////////////////////////////////////
+
+    struct LockWaiter EASY_FINAL
+    {
+        profiler::timestamp_t wait_time; ///< Total time this block was waiting for the lock
+        profiler::block_id_t         id; ///< Descriptor id of the block (~0U for waits outside of any block)
+        uint32_t                  waits; ///< Number of waits
+    };
+
+    struct LockStatistics EASY_FINAL
+    {
+        std::string                name; ///< Name of the lock (see profiler::mutex)
+        std::vector<LockWaiter> waiters; ///< Blocks which were waiting for the lock sorted by wait time (descending)
+        profiler::timestamp_t wait_time; ///< Total wait time
+        profiler::timestamp_t  max_wait; ///< The longest wait
+        profiler::timestamp_t hold_time; ///< Total hold time
+        uint32_t                  waits; ///< Number of waits (contended lock acquisitions)
+        uint32_t                  holds; ///< Number of holds
+    };
+
+    /** Locks sorted by total wait time (descending). */
+    using lock_statistics_t = std::vector<LockStatistics>;
+
+    //////////////////////////////////////////////////////////////////////////
+
+    struct AsyncSegment EASY_FINAL
+    {
+        profiler::block_index_t     block; ///< Index of the segment block in blocks_t
+        profiler::thread_id_t   thread_id; ///< Id of the thread which has stored the segment
+    };
+
+    struct AsyncSpan EASY_FINAL
+    {
+        std::vector<AsyncSegment> segments; ///< Segments of the span sorted by begin time
+        uint64_t                        id; ///< Unique id of the span
+        profiler::timestamp_t        begin; ///< Begin time of the first segment
+        profiler::timestamp_t          end; ///< End time of the last segment
+        profiler::timestamp_t  active_time; ///< Total duration of all segments (the span was not suspended)
+    };
+
+    /** Asynchronous spans (see profiler::async_span in easy/coroutine.h) sorted by begin time. */
+    using async_spans_t = std::vector<AsyncSpan>;
+
+    //////////////////////////////////////////////////////////////////////////
+
+    struct ValueIndexEntry EASY_FINAL
+    {
+        profiler::timestamp_t    time; ///< Timestamp of the value
+        profiler::block_index_t block; ///< Index of the value in blocks_t
+    };
+
+    /** List of values of one thread sorted by time (values of one thread are recorded in time order).
+
+    Use std::lower_bound/upper_bound by ValueIndexEntry::time to get values of a time interval. */
+    using value_index_t = std::vector<ValueIndexEntry>;
+
+    //////////////////////////////////////////////////////////////////////////
+
     class BlocksTreeRoot EASY_FINAL
     {
         using This = BlocksTreeRoot;
@@ -229,10 +331,17 @@ namespace profiler {
         BlocksTree::children_t       children; ///< List of children indexes
         BlocksTree::children_t           sync; ///< List of context-switch events
         BlocksTree::children_t         events; ///< List of events indexes
+        std::unordered_map<profiler::vin_t, value_index_t> values_by_id; ///< Values of this thread grouped by value id (see ValueId)
+        std::unordered_map<std::string, value_index_t>   values_by_name; ///< Values of this thread grouped by value name
+        std::unordered_map<profiler::block_index_t, value_index_t> values_by_block; ///< Values of this thread grouped by innermost enclosing block (see BlocksTree::parent)
+        allocations_t                 allocations; ///< Memory allocations of this thread grouped by enclosing block
         std::string               thread_name; ///< Name of this thread
+        std::string              process_name; ///< Name of the process of this thread (multi-process captures only)
         profiler::timestamp_t   profiled_time; ///< Profiled time of this thread (sum of all children duration)
         profiler::timestamp_t       wait_time; ///< Wait time of this thread (sum of all context switches)
-        profiler::thread_id_t       thread_id; ///< System Id of this thread
+        profiler::thread_id_t       thread_id; ///< Id of this thread in thread_blocks_tree_t (see system_thread_id())
+        profiler::thread_id_t        system_id; ///< System Id of this thread (multi-process captures only, see system_thread_id())
+        profiler::processid_t      process_id; ///< System Id of the process of this thread (0 for single process captures)
         profiler::block_index_t frames_number; ///< Total frames number (top-level blocks)
         profiler::block_index_t blocks_number; ///< Total blocks number including their children
         uint8_t                         depth; ///< Maximum stack depth (number of levels)
@@ -241,7 +350,7 @@ namespace profiler {
         This& operator = (const This&) = delete;
 
         BlocksTreeRoot() EASY_NOEXCEPT
-            : profiled_time(0), wait_time(0), thread_id(0), frames_number(0), blocks_number(0), depth(0)
+            : profiled_time(0), wait_time(0), thread_id(0), system_id(0), process_id(0), frames_number(0), blocks_number(0), depth(0)
         {
         }
 
@@ -249,10 +358,17 @@ namespace profiler {
             : children(std::move(that.children))
             , sync(std::move(that.sync))
             , events(std::move(that.events))
+            , values_by_id(std::move(that.values_by_id))
+            , values_by_name(std::move(that.values_by_name))
+            , values_by_block(std::move(that.values_by_block))
+            , allocations(std::move(that.allocations))
             , thread_name(std::move(that.thread_name))
+            , process_name(std::move(that.process_name))
             , profiled_time(that.profiled_time)
             , wait_time(that.wait_time)
             , thread_id(that.thread_id)
+            , system_id(that.system_id)
+            , process_id(that.process_id)
             , frames_number(that.frames_number)
             , blocks_number(that.blocks_number)
             , depth(that.depth)
@@ -264,10 +380,17 @@ namespace profiler {
             children = std::move(that.children);
             sync = std::move(that.sync);
             events = std::move(that.events);
+            values_by_id = std::move(that.values_by_id);
+            values_by_name = std::move(that.values_by_name);
+            values_by_block = std::move(that.values_by_block);
+            allocations = std::move(that.allocations);
             thread_name = std::move(that.thread_name);
+            process_name = std::move(that.process_name);
             profiled_time = that.profiled_time;
             wait_time = that.wait_time;
             thread_id = that.thread_id;
+            system_id = that.system_id;
+            process_id = that.process_id;
             frames_number = that.frames_number;
             blocks_number = that.blocks_number;
             depth = that.depth;
@@ -284,6 +407,17 @@ namespace profiler {
             return thread_name.c_str();
         }
 
+        inline bool got_process() const EASY_NOEXCEPT
+        {
+            return process_id != 0;
+        }
+
+        ///< System Id of this thread (thread_id is a key made by processThreadKey() for multi-process captures)
+        inline profiler::thread_id_t system_thread_id() const EASY_NOEXCEPT
+        {
+            return process_id != 0 ? system_id : thread_id;
+        }
+
         bool operator < (const This& other) const EASY_NOEXCEPT
         {
             return thread_id < other.thread_id;
@@ -291,6 +425,18 @@ namespace profiler {
 
     }; // END of class BlocksTreeRoot.
 
+    /** Key of a thread in thread_blocks_tree_t for captures of several processes.
+
+    System thread ids are unique only within one process, so process id is mixed into upper bits.
+    Thread ids wider than 32 bits could collide with keys of another process: the reader takes the next free key
+    for such threads, so a key is unique but (pid, tid) must be taken from BlocksTreeRoot::process_id and
+    BlocksTreeRoot::system_thread_id().
+    Single process captures use system thread ids as keys (the same as processThreadKey(0, tid)). */
+    inline profiler::thread_id_t processThreadKey(profiler::processid_t pid, profiler::thread_id_t tid) EASY_NOEXCEPT
+    {
+        return (pid << 32) ^ tid;
+    }
+
     struct BeginEndTime
     {
         profiler::timestamp_t beginTime;
@@ -301,6 +447,26 @@ namespace profiler {
     using thread_blocks_tree_t = std::unordered_map<profiler::thread_id_t, profiler::BlocksTreeRoot, ::estd::hash<profiler::thread_id_t> >;
     using block_getter_fn = std::function<const profiler::BlocksTree&(profiler::block_index_t)>;
 
+    /** Key of identification table: blocks with the same runtime name and the same descriptor get the same new id. */
+    using runtime_name_t = std::pair<std::string, profiler::block_id_t>;
+
+    struct runtime_name_hash EASY_FINAL
+    {
+        size_t operator () (const runtime_name_t& key) const
+        {
+            return ::std::hash<::std::string>()(key.first) * 31 + static_cast<size_t>(key.second);
+        }
+    };
+
+    using runtime_ids_t = std::unordered_map<profiler::runtime_name_t, profiler::block_id_t, profiler::runtime_name_hash>;
+
+    /** Identification table of a live capture which is kept between appendTreesFromStream() calls. */
+    struct LiveRuntimeIds
+    {
+        profiler::runtime_ids_t        table; ///< (runtime name, descriptor id) -> id of a copy of the descriptor
+        uint32_t       descriptors_count = 0; ///< Number of descriptors of profiled application, copies are stored after them
+    };
+
     //////////////////////////////////////////////////////////////////////////
 
     class PROFILER_API SerializedData EASY_FINAL
@@ -369,6 +535,12 @@ extern "C" {
                                                            bool gather_statistics,
                                                            std::ostream& _log);
 
+    /** Read a .prof stream or a multi-process container (see profiler::ProcessCapture in writer.h).
+
+    Processes of a container are read in parallel and merged into one timeline:
+    threads are keyed by processThreadKey(pid, tid), descriptors of all processes are joined
+    (descriptors_count of them are real descriptors) and clock offset of every process is applied to its timestamps.
+    pid is the pid of the first process of a container. */
     PROFILER_API profiler::block_index_t fillTreesFromStream(std::atomic<int>& progress, std::istream& str,
                                                              profiler::BeginEndTime& begin_end_time,
                                                              profiler::SerializedData& serialized_blocks,
@@ -383,11 +555,49 @@ extern "C" {
                                                              bool gather_statistics,
                                                              std::ostream& _log);
 
+    /** Append one live capture portion to already loaded blocks.
+
+    Portion memory is stored in serialized_portion which must be kept alive as long as appended blocks are used.
+    New blocks are appended to _blocks, blocks_offset is the global index of _blocks[0].
+    Only blocks of the current portion are accessed, so _blocks may contain only new blocks.
+    Blocks with runtime names get ids of descriptor copies (the same as in fillTreesFromStream) using runtime_ids.
+    Copies are stored after descriptors of profiled application, so when new descriptors arrive the copies
+    are moved up together with ids of blocks in _blocks: blocks which were appended before _blocks[0]
+    with ids >= old runtime_ids.descriptors_count must be moved up by the caller.
+    No statistics are gathered.
+
+    \return false if the portion is corrupted (see _log) */
+    PROFILER_API bool appendTreesFromStream(std::istream& str,
+                                            profiler::BeginEndTime& begin_end_time,
+                                            profiler::SerializedData& serialized_portion,
+                                            profiler::descriptors_list_t& descriptors,
+                                            profiler::blocks_t& _blocks,
+                                            profiler::block_index_t blocks_offset,
+                                            profiler::thread_blocks_tree_t& threaded_trees,
+                                            profiler::LiveRuntimeIds& runtime_ids,
+                                            uint32_t& version,
+                                            profiler::processid_t& pid,
+                                            std::ostream& _log);
+
     PROFILER_API bool readDescriptionsFromStream(std::atomic<int>& progress, std::istream& str,
                                                  profiler::SerializedData& serialized_descriptors,
                                                  profiler::descriptors_list_t& descriptors,
                                                  std::ostream& _log);
 
+    /** Rank locks (see profiler::mutex in easy/mutex.h) by total wait time and by blocks which were waiting for them.
+
+    Waiting block is the innermost block enclosing the wait which is not a lock block itself. */
+    PROFILER_API void collectLockStatistics(const profiler::blocks_t& _blocks,
+                                            const profiler::thread_blocks_tree_t& threaded_trees,
+                                            const profiler::descriptors_list_t& descriptors,
+                                            profiler::lock_statistics_t& lock_statistics);
+
+    /** Link segments of asynchronous spans (see profiler::async_span in easy/coroutine.h) stored by all threads. */
+    PROFILER_API void collectAsyncSpans(const profiler::blocks_t& _blocks,
+                                        const profiler::thread_blocks_tree_t& threaded_trees,
+                                        const profiler::descriptors_list_t& descriptors,
+                                        profiler::async_spans_t& async_spans);
+
 }
 
 inline profiler::block_index_t fillTreesFromFile(const char* filename, profiler::BeginEndTime& begin_end_time,
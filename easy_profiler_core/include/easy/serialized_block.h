@@ -47,6 +47,7 @@ The Apache License, Version 2.0 (the "License");
 #include <easy/details/arbitrary_value_public_types.h>
 
 class CSwitchBlock;
+class CompactValue;
 
 namespace profiler {
 
@@ -82,6 +83,15 @@ namespace profiler {
 
     }; // END of SerializedBlock.
 
+    /** Size of performance counters data which may be stored right after the name of SerializedBlock.
+
+    Layout: uint8_t number, uint8_t counter[number] (see PerfCounter), uint64_t value[number] (not aligned).
+
+    \sa BlocksTree::perfCounter, setPerfCounters */
+    inline EASY_CONSTEXPR_FCN uint16_t perfCountersDataSize(uint8_t _number) {
+        return static_cast<uint16_t>(1 + _number * (1 + sizeof(uint64_t)));
+    }
+
     //////////////////////////////////////////////////////////////////////////
 
 #pragma pack(push, 1)
@@ -169,6 +179,7 @@ namespace profiler {
     class PROFILER_API ArbitraryValue : protected BaseBlockData
     {
         friend ::ThreadStorage;
+        friend ::CompactValue;
 
     protected:
 
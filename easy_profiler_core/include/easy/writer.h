@@ -45,6 +45,28 @@ The Apache License, Version 2.0 (the "License");
 
 #include <easy/reader.h>
 
+namespace profiler {
+
+    /** Capture of one process inside a multi-process container.
+
+    Container layout:
+        uint32_t signature ("Easm"), uint32_t version, uint32_t processes count
+        for each process:
+            uint64_t pid, int64_t clock offset, uint16_t name size, name (zero-terminated), uint64_t capture size,
+            capture (the same as contents of .prof file of this process)
+    */
+    struct ProcessCapture
+    {
+        const char*      name; ///< Zero-terminated name of the process (for example, host:port of remote process)
+        const char*      data; ///< Serialized capture of the process (the same as .prof file contents)
+        uint64_t         size; ///< Size of data in bytes
+        processid_t       pid; ///< Process id (all threads of this capture belong to it)
+        int64_t  clock_offset; ///< Offset in nanoseconds which should be added to all timestamps of the process
+
+    }; // END of struct ProcessCapture.
+
+} // END of namespace profiler.
+
 extern "C" {
 
     PROFILER_API profiler::block_index_t writeTreesToFile(std::atomic<int>& progress, const char* filename,
@@ -70,6 +92,12 @@ extern "C" {
                                                             profiler::timestamp_t end_time,
                                                             profiler::processid_t pid,
                                                             std::ostream& log);
+
+    PROFILER_API bool writeProcessCapturesToStream(std::ostream& str, const profiler::ProcessCapture* captures,
+                                                   uint32_t captures_count, std::ostream& log);
+
+    PROFILER_API bool writeProcessCapturesToFile(const char* filename, const profiler::ProcessCapture* captures,
+                                                 uint32_t captures_count, std::ostream& log);
 }
 
 inline profiler::block_index_t writeTreesToFile(const char* filename,
@@ -0,0 +1,289 @@
+/**
+Lightweight profiler library for c++
+Copyright(C) 2016-2019  Sergey Yagovtsev, Victor Zarubkin
+
+Licensed under either of
+    * MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+    * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+at your option.
+
+The MIT License
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights 
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+    of the Software, and to permit persons to whom the Software is furnished 
+    to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all 
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+    LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+    TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE 
+    USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+The Apache License, Version 2.0 (the "License");
+    You may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+**/
+
+/*
+Memory allocations interposer: replaces malloc/free family functions and stores every allocation and
+deallocation into the profiler (see EASY_ALLOC, EASY_DEALLOC). Usage:
+
+    LD_PRELOAD=libeasy_profiler_malloc.so ./application
+
+Allocations are stored only while profiler is enabled and only by threads already registered in profiler.
+*/
+
+#include <atomic>
+#include <dlfcn.h>
+#include <malloc.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <easy/profiler.h>
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+using malloc_t = void* (*)(size_t);
+using calloc_t = void* (*)(size_t, size_t);
+using realloc_t = void* (*)(void*, size_t);
+using free_t = void (*)(void*);
+using memalign_t = void* (*)(size_t, size_t);
+using posix_memalign_t = int (*)(void**, size_t, size_t);
+
+malloc_t real_malloc = nullptr;
+calloc_t real_calloc = nullptr;
+realloc_t real_realloc = nullptr;
+free_t real_free = nullptr;
+memalign_t real_memalign = nullptr;
+memalign_t real_aligned_alloc = nullptr;
+posix_memalign_t real_posix_memalign = nullptr;
+
+// Allocations are stored only after ProfileManager has been constructed (otherwise the first allocation made
+// by its constructor would construct it recursively) and until it is destroyed.
+std::atomic<bool> g_ready(false);
+
+// dlsym could allocate memory itself: such allocations are served from this buffer and are never freed
+alignas(16) char g_bootstrapBuffer[4096];
+std::atomic<size_t> g_bootstrapUsed(0);
+
+// Prevents recursion: profiler allocates memory itself while storing an allocation
+__thread bool g_inside __attribute__((tls_model("initial-exec"))) = false;
+
+//////////////////////////////////////////////////////////////////////////
+
+void* bootstrapAlloc(size_t size)
+{
+    size = (size + 15) & ~static_cast<size_t>(15);
+    const auto offset = g_bootstrapUsed.fetch_add(size, std::memory_order_relaxed);
+    return offset + size <= sizeof(g_bootstrapBuffer) ? g_bootstrapBuffer + offset : nullptr;
+}
+
+bool isBootstrap(const void* ptr)
+{
+    return ptr >= g_bootstrapBuffer && ptr < g_bootstrapBuffer + sizeof(g_bootstrapBuffer);
+}
+
+void resolve()
+{
+    static __thread bool resolving __attribute__((tls_model("initial-exec"))) = false;
+    if (resolving)
+        return;
+
+    resolving = true;
+    real_calloc = reinterpret_cast<calloc_t>(dlsym(RTLD_NEXT, "calloc"));
+    real_malloc = reinterpret_cast<malloc_t>(dlsym(RTLD_NEXT, "malloc"));
+    real_realloc = reinterpret_cast<realloc_t>(dlsym(RTLD_NEXT, "realloc"));
+    real_free = reinterpret_cast<free_t>(dlsym(RTLD_NEXT, "free"));
+    real_memalign = reinterpret_cast<memalign_t>(dlsym(RTLD_NEXT, "memalign"));
+    real_aligned_alloc = reinterpret_cast<memalign_t>(dlsym(RTLD_NEXT, "aligned_alloc"));
+    real_posix_memalign = reinterpret_cast<posix_memalign_t>(dlsym(RTLD_NEXT, "posix_memalign"));
+    resolving = false;
+}
+
+class Recorder
+{
+    const bool m_enabled;
+
+public:
+
+    Recorder() : m_enabled(!g_inside && g_ready.load(std::memory_order_relaxed))
+    {
+        if (m_enabled)
+            g_inside = true;
+    }
+
+    ~Recorder()
+    {
+        if (m_enabled)
+            g_inside = false;
+    }
+
+    void alloc(const void* ptr, size_t size) const
+    {
+        if (m_enabled && ptr != nullptr)
+            profiler::storeAllocation(ptr, size);
+    }
+
+    size_t usableSize(void* ptr) const
+    {
+        return m_enabled && ptr != nullptr ? malloc_usable_size(ptr) : 0;
+    }
+
+    void dealloc(const void* ptr, size_t size) const
+    {
+        if (m_enabled && ptr != nullptr)
+            profiler::storeDeallocation(ptr, size);
+    }
+}; // END of class Recorder.
+
+void onExit()
+{
+    g_ready.store(false, std::memory_order_release);
+}
+
+__attribute__((constructor)) void onLoad()
+{
+    if (real_malloc == nullptr)
+        resolve();
+
+    // Construct ProfileManager now. Exit handlers are called in reverse order, so onExit is called before
+    // ProfileManager destructor.
+    profiler::isEnabled();
+    atexit(onExit);
+
+    g_ready.store(true, std::memory_order_release);
+}
+
+} // END of namespace <noname>.
+
+//////////////////////////////////////////////////////////////////////////
+
+extern "C" {
+
+void* malloc(size_t size)
+{
+    if (real_malloc == nullptr)
+    {
+        resolve();
+        if (real_malloc == nullptr)
+            return bootstrapAlloc(size);
+    }
+
+    const Recorder recorder;
+    auto ptr = real_malloc(size);
+    recorder.alloc(ptr, size);
+    return ptr;
+}
+
+void* calloc(size_t count, size_t size)
+{
+    if (real_calloc == nullptr)
+    {
+        resolve();
+        if (real_calloc == nullptr)
+        {
+            // bootstrap buffer is zero-initialized and never reused
+            size_t total = 0;
+            if (__builtin_mul_overflow(count, size, &total))
+                return nullptr;
+            return bootstrapAlloc(total);
+        }
+    }
+
+    const Recorder recorder;
+    auto ptr = real_calloc(count, size);
+    recorder.alloc(ptr, count * size);
+    return ptr;
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    if (real_realloc == nullptr)
+        resolve();
+
+    if (isBootstrap(ptr))
+    {
+        const auto available = static_cast<size_t>(g_bootstrapBuffer + sizeof(g_bootstrapBuffer) - static_cast<char*>(ptr));
+        auto newPtr = malloc(size);
+        if (newPtr != nullptr)
+            memcpy(newPtr, ptr, size < available ? size : available);
+        return newPtr;
+    }
+
+    // Old block is still valid if realloc fails, so it is recorded as freed only after success
+    // (realloc(ptr, 0) frees the block and returns nullptr).
+    const Recorder recorder;
+    const auto oldSize = recorder.usableSize(ptr);
+    auto newPtr = real_realloc(ptr, size);
+    if (newPtr != nullptr || size == 0)
+        recorder.dealloc(ptr, oldSize);
+    recorder.alloc(newPtr, size);
+    return newPtr;
+}
+
+void free(void* ptr)
+{
+    if (ptr == nullptr || isBootstrap(ptr))
+        return;
+
+    if (real_free == nullptr)
+        resolve();
+
+    const Recorder recorder;
+    recorder.dealloc(ptr, recorder.usableSize(ptr));
+    real_free(ptr);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    if (real_memalign == nullptr)
+        resolve();
+
+    const Recorder recorder;
+    auto ptr = real_memalign(alignment, size);
+    recorder.alloc(ptr, size);
+    return ptr;
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    if (real_aligned_alloc == nullptr)
+        resolve();
+
+    const Recorder recorder;
+    auto ptr = real_aligned_alloc(alignment, size);
+    recorder.alloc(ptr, size);
+    return ptr;
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    if (real_posix_memalign == nullptr)
+        resolve();
+
+    const Recorder recorder;
+    const int result = real_posix_memalign(ptr, alignment, size);
+    if (result == 0)
+        recorder.alloc(*ptr, size);
+    return result;
+}
+
+} // extern "C"
@@ -0,0 +1,884 @@
+/**
+Lightweight profiler library for c++
+Copyright(C) 2016-2019  Sergey Yagovtsev, Victor Zarubkin
+
+Licensed under either of
+    * MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+    * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+at your option.
+
+The MIT License
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights 
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+    of the Software, and to permit persons to whom the Software is furnished 
+    to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all 
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+    LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+    TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE 
+    USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+The Apache License, Version 2.0 (the "License");
+    You may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+**/
+
+#include <string.h>
+#include <algorithm>
+#include <limits>
+#include <easy/easy_net.h>
+#include "net_server.h"
+
+#if defined(_WIN32)
+# ifdef max
+#  undef max
+# endif
+#else
+# include <errno.h>
+# include <sys/ioctl.h>
+# if EASY_NET_EPOLL != 0
+#  include <sys/epoll.h>
+# else
+#  include <sys/select.h>
+# endif
+#endif
+
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# ifndef MFD_CLOEXEC
+#  define MFD_CLOEXEC 0x0001U
+# endif
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+
+EASY_CONSTEXPR size_t RECEIVE_BUFFER_SIZE = 4096; ///< Size of buffer for one recv() call
+EASY_CONSTEXPR size_t MAX_INCOMING_SIZE = 64 * 1024; ///< Max size of received but not parsed data (clients send only small messages)
+EASY_CONSTEXPR size_t MAX_SEND_SIZE = 1 << 30; ///< Max size for one send() call (it returns int on Windows)
+EASY_CONSTEXPR size_t MAX_QUEUED_SIZE = 256 * 1024 * 1024; ///< Max size of queued data (producers wait for clients long before this)
+EASY_CONSTEXPR int MAX_EVENTS = 64; ///< Max number of events returned by one epoll_wait() call
+EASY_CONSTEXPR int SEND_BUFFER_SIZE = 64 * 1024 * 1024;
+EASY_CONSTEXPR size_t SHARED_MEMORY_INITIAL_SIZE = 64 * 1024 * 1024; ///< Initial size of shared memory for dumping
+
+#if defined(_WIN32)
+EASY_CONSTEXPR NetServer::socket_t INVALID_SOCKET_VALUE = INVALID_SOCKET;
+#else
+EASY_CONSTEXPR NetServer::socket_t INVALID_SOCKET_VALUE = -1;
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool isValidSocket(EasySocket::socket_t s)
+{
+#if defined(_WIN32)
+    return s != INVALID_SOCKET;
+#else
+    return s >= 0;
+#endif
+}
+
+static int closeSocket(EasySocket::socket_t s)
+{
+#if defined(_WIN32)
+    return ::closesocket(s);
+#else
+    return ::close(s);
+#endif
+}
+
+static void setNonBlocking(EasySocket::socket_t s)
+{
+#if defined(_WIN32)
+    u_long iMode = 1;
+    ::ioctlsocket(s, FIONBIO, &iMode);
+#else
+    int iMode = 1;
+    ::ioctl(s, FIONBIO, (char*)&iMode);
+#endif
+}
+
+static int lastError()
+{
+#if defined(_WIN32)
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+}
+
+static bool isWouldBlock(int error_code)
+{
+#if defined(_WIN32)
+    return error_code == WSAEWOULDBLOCK;
+#else
+    return error_code == EAGAIN || error_code == EWOULDBLOCK;
+#endif
+}
+
+static bool isInterrupted(int error_code)
+{
+#if defined(_WIN32)
+    return error_code == WSAEINTR;
+#else
+    return error_code == EINTR;
+#endif
+}
+
+/** Size of a message which can be sent by a client to the profiler (by type of the message).
+*/
+static size_t incomingMessageSize(profiler::net::MessageType _type)
+{
+    switch (_type)
+    {
+        case profiler::net::MessageType::Change_Block_Status:
+            return sizeof(profiler::net::BlockStatusMessage);
+
+        case profiler::net::MessageType::Change_Event_Tracing_Status:
+        case profiler::net::MessageType::Change_Event_Tracing_Priority:
+            return sizeof(profiler::net::BoolMessage);
+
+        case profiler::net::MessageType::Request_Start_Live_Capture:
+            return sizeof(profiler::net::LiveCaptureMessage);
+
+        default:
+            return sizeof(profiler::net::Message);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+
+static int sendWithFile(EasySocket::socket_t s, const char* _data, size_t _size, int _fd)
+{
+    struct iovec iov;
+    iov.iov_base = const_cast<char*>(_data);
+    iov.iov_len = _size;
+
+    char control[CMSG_SPACE(sizeof(int))];
+    memset(control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    auto cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &_fd, sizeof(int));
+
+    return static_cast<int>(::sendmsg(s, &msg, MSG_NOSIGNAL));
+}
+
+SharedMemory::SharedMemory(int _fd, const char* _data, uint64_t _size)
+    : m_data(_data)
+    , m_size(_size)
+    , m_fd(_fd)
+{
+}
+
+SharedMemory::~SharedMemory()
+{
+    if (m_data != nullptr)
+        ::munmap(const_cast<char*>(m_data), static_cast<size_t>(m_size));
+    ::close(m_fd);
+}
+
+int SharedMemory::fd() const
+{
+    return m_fd;
+}
+
+const char* SharedMemory::data() const
+{
+    return m_data;
+}
+
+uint64_t SharedMemory::size() const
+{
+    return m_size;
+}
+
+SharedMemoryBuffer::SharedMemoryBuffer()
+    : m_data(nullptr)
+    , m_capacity(0)
+    , m_fd(static_cast<int>(::syscall(SYS_memfd_create, "easy_profiler", MFD_CLOEXEC)))
+{
+    if (m_fd >= 0 && !reserve(SHARED_MEMORY_INITIAL_SIZE))
+        reset();
+}
+
+SharedMemoryBuffer::~SharedMemoryBuffer()
+{
+    reset();
+}
+
+bool SharedMemoryBuffer::isValid() const
+{
+    return m_fd >= 0;
+}
+
+std::shared_ptr<const SharedMemory> SharedMemoryBuffer::release()
+{
+    if (m_fd < 0)
+        return nullptr;
+
+    const auto size = static_cast<size_t>(pptr() - pbase());
+
+    // Unused tail of the memory is cut off: clients map exactly written data
+    ::munmap(m_data, m_capacity);
+    m_data = nullptr;
+    m_capacity = 0;
+    setp(nullptr, nullptr);
+
+    const char* data = nullptr;
+    if (::ftruncate(m_fd, static_cast<off_t>(size)) != 0)
+    {
+        reset();
+        return nullptr;
+    }
+
+    if (size != 0)
+    {
+        auto memory = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, m_fd, 0);
+        if (memory != MAP_FAILED)
+            data = static_cast<const char*>(memory);
+    }
+
+    std::shared_ptr<const SharedMemory> result(new SharedMemory(m_fd, data, data != nullptr ? size : 0));
+    m_fd = -1;
+
+    return result;
+}
+
+SharedMemoryBuffer::int_type SharedMemoryBuffer::overflow(int_type _ch)
+{
+    if (!reserve(m_capacity + 1))
+        return traits_type::eof();
+
+    if (!traits_type::eq_int_type(_ch, traits_type::eof()))
+    {
+        *pptr() = traits_type::to_char_type(_ch);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(_ch);
+}
+
+std::streamsize SharedMemoryBuffer::xsputn(const char* _data, std::streamsize _size)
+{
+    const auto size = static_cast<size_t>(pptr() - pbase()) + static_cast<size_t>(_size);
+    if (size > m_capacity && !reserve(size))
+        return 0;
+
+    memcpy(pptr(), _data, static_cast<size_t>(_size));
+    pbump(static_cast<int>(_size));
+
+    return _size;
+}
+
+bool SharedMemoryBuffer::reserve(size_t _size)
+{
+    if (m_fd < 0)
+        return false;
+
+    if (_size <= m_capacity)
+        return true;
+
+    const auto size = static_cast<size_t>(pptr() - pbase());
+    const auto capacity = std::max(std::max(m_capacity << 1, _size), SHARED_MEMORY_INITIAL_SIZE);
+
+    if (::ftruncate(m_fd, static_cast<off_t>(capacity)) != 0)
+    {
+        reset();
+        return false;
+    }
+
+    void* memory = m_data == nullptr
+        ? ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0)
+        : ::mremap(m_data, m_capacity, capacity, MREMAP_MAYMOVE);
+
+    if (memory == MAP_FAILED)
+    {
+        reset();
+        return false;
+    }
+
+    m_data = static_cast<char*>(memory);
+    m_capacity = capacity;
+
+    // pbump() takes int, so the position is restored by parts
+    setp(m_data, m_data + m_capacity);
+    for (auto rest = size; rest != 0;)
+    {
+        const auto n = std::min(rest, static_cast<size_t>(std::numeric_limits<int>::max()));
+        pbump(static_cast<int>(n));
+        rest -= n;
+    }
+
+    return true;
+}
+
+void SharedMemoryBuffer::reset()
+{
+    if (m_data != nullptr)
+        ::munmap(m_data, m_capacity);
+
+    if (m_fd >= 0)
+        ::close(m_fd);
+
+    m_data = nullptr;
+    m_capacity = 0;
+    m_fd = -1;
+    setp(nullptr, nullptr);
+}
+
+#endif // EASY_LOCAL_SOCKET_ENABLED
+
+//////////////////////////////////////////////////////////////////////////
+
+NetClient::NetClient(socket_t _socket, uint32_t _id, bool _isLocal)
+    : m_queuedSize(0)
+    , m_sentSize(0)
+    , m_socket(_socket)
+    , m_id(_id)
+    , m_isClosed(false)
+    , m_isLocal(_isLocal)
+    , m_isWaitingOut(false)
+{
+}
+
+NetClient::~NetClient()
+{
+    close();
+    closeSocket(m_socket);
+}
+
+uint32_t NetClient::id() const
+{
+    return m_id;
+}
+
+bool NetClient::isClosed() const
+{
+    return m_isClosed;
+}
+
+bool NetClient::isLocal() const
+{
+    return m_isLocal;
+}
+
+size_t NetClient::queuedSize() const
+{
+    return m_queuedSize;
+}
+
+void NetClient::send(const void* _data, size_t _size)
+{
+    if (_size != 0)
+        send(std::make_shared<const std::string>(static_cast<const char*>(_data), _size));
+}
+
+void NetClient::send(chunk_t _chunk)
+{
+    if (m_isClosed || _chunk == nullptr || _chunk->empty())
+        return;
+
+    if (m_queuedSize + _chunk->size() > MAX_QUEUED_SIZE)
+    {
+        // Client does not read our replies
+        close();
+        return;
+    }
+
+    m_queuedSize += _chunk->size();
+
+    Outgoing outgoing;
+    outgoing.data = std::move(_chunk);
+    m_outgoing.push_back(std::move(outgoing));
+}
+
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+void NetClient::send(const std::shared_ptr<const SharedMemory>& _memory, profiler::net::MessageType _type)
+{
+    if (m_isClosed || !m_isLocal || _memory == nullptr)
+        return;
+
+    const profiler::net::DataMessage message(_memory->size(), _type);
+
+    Outgoing outgoing;
+    outgoing.data = std::make_shared<const std::string>(reinterpret_cast<const char*>(&message), sizeof(message));
+    outgoing.memory = _memory;
+
+    m_queuedSize += outgoing.data->size();
+    m_outgoing.push_back(std::move(outgoing));
+}
+#endif
+
+bool NetClient::peekMessage(profiler::net::MessageType& _type)
+{
+    if (m_incoming.size() < sizeof(profiler::net::Message))
+        return false;
+
+    auto message = reinterpret_cast<const profiler::net::Message*>(m_incoming.data());
+    if (!message->isEasyNetMessage())
+    {
+        // Unknown data: there is no way to find the beginning of the next message
+        m_incoming.clear();
+        return false;
+    }
+
+    if (m_incoming.size() < incomingMessageSize(message->type))
+        return false;
+
+    _type = message->type;
+    return true;
+}
+
+bool NetClient::nextMessage(std::string& _message)
+{
+    profiler::net::MessageType type;
+    if (!peekMessage(type))
+        return false;
+
+    const auto size = incomingMessageSize(type);
+    _message.assign(m_incoming.data(), size);
+    m_incoming.erase(0, size);
+
+    return true;
+}
+
+void NetClient::close()
+{
+    if (m_isClosed)
+        return;
+
+    m_isClosed = true;
+    m_outgoing.clear();
+    m_incoming.clear();
+    m_queuedSize = 0;
+    m_sentSize = 0;
+}
+
+bool NetClient::receive()
+{
+    char buffer[RECEIVE_BUFFER_SIZE];
+
+    while (!m_isClosed)
+    {
+#if defined(_WIN32)
+        const int bytes = ::recv(m_socket, buffer, static_cast<int>(sizeof(buffer)), 0);
+#else
+        const int bytes = static_cast<int>(::recv(m_socket, buffer, sizeof(buffer), 0));
+#endif
+
+        if (bytes > 0)
+        {
+            m_incoming.append(buffer, static_cast<size_t>(bytes));
+            if (m_incoming.size() > MAX_INCOMING_SIZE)
+                break; // Client does not read our replies or sends garbage
+
+            continue;
+        }
+
+        if (bytes < 0)
+        {
+            const int error_code = lastError();
+            if (isWouldBlock(error_code))
+                return true;
+            if (isInterrupted(error_code))
+                continue;
+        }
+
+        break; // Connection has been closed by the client or has failed
+    }
+
+    close();
+    return false;
+}
+
+bool NetClient::flush()
+{
+    while (!m_isClosed && !m_outgoing.empty())
+    {
+        auto& outgoing = m_outgoing.front();
+        const auto& chunk = *outgoing.data;
+        const size_t size = std::min(chunk.size() - m_sentSize, MAX_SEND_SIZE);
+
+#if defined(_WIN32) || defined(__APPLE__)
+        const int bytes = ::send(m_socket, chunk.data() + m_sentSize, static_cast<int>(size), 0);
+#elif EASY_LOCAL_SOCKET_ENABLED != 0
+        int bytes = 0;
+        if (outgoing.memory != nullptr)
+        {
+            // Descriptor is passed with the first sent byte
+            bytes = sendWithFile(m_socket, chunk.data() + m_sentSize, size, outgoing.memory->fd());
+            if (bytes > 0)
+                outgoing.memory.reset();
+        }
+        else
+        {
+            bytes = static_cast<int>(::send(m_socket, chunk.data() + m_sentSize, size, MSG_NOSIGNAL));
+        }
+#else
+        const int bytes = static_cast<int>(::send(m_socket, chunk.data() + m_sentSize, size, MSG_NOSIGNAL));
+#endif
+
+        if (bytes < 0)
+        {
+            const int error_code = lastError();
+            if (isWouldBlock(error_code))
+                return true; // Socket buffer is full: the rest would be sent when the socket becomes writable
+            if (isInterrupted(error_code))
+                continue;
+
+            close();
+            return false;
+        }
+
+        m_sentSize += static_cast<size_t>(bytes);
+        m_queuedSize -= static_cast<size_t>(bytes);
+
+        if (m_sentSize == chunk.size())
+        {
+            m_sentSize = 0;
+            m_outgoing.pop_front();
+        }
+    }
+
+    return !m_isClosed;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+NetServer::NetServer()
+    : m_socket(INVALID_SOCKET_VALUE)
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+    , m_localSocket(INVALID_SOCKET_VALUE)
+#endif
+#if EASY_NET_EPOLL != 0
+    , m_epoll(-1)
+#endif
+    , m_nextClientId(0)
+    , m_isOpened(false)
+{
+#if defined(_WIN32)
+    WSADATA wsaData;
+    m_wsaret = WSAStartup(0x101, &wsaData);
+#endif
+}
+
+NetServer::~NetServer()
+{
+    close();
+
+#if defined(_WIN32)
+    if (m_wsaret == 0)
+        WSACleanup();
+#endif
+}
+
+bool NetServer::open(uint16_t _port)
+{
+    close();
+
+#if !defined(_WIN32)
+    const int protocol = 0;
+#else
+    const int protocol = IPPROTO_TCP;
+#endif
+
+    m_socket = ::socket(AF_INET, SOCK_STREAM, protocol);
+    if (!isValidSocket(m_socket))
+        return false;
+
+    const int opt = 1;
+    ::setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, (const char*)&opt, sizeof(int));
+
+    struct sockaddr_in server_address;
+    memset(&server_address, 0, sizeof(server_address));
+    server_address.sin_family = AF_INET;
+    server_address.sin_addr.s_addr = INADDR_ANY;
+    server_address.sin_port = htons(_port);
+
+    if (::bind(m_socket, (struct sockaddr*)&server_address, sizeof(server_address)) != 0 || ::listen(m_socket, 5) != 0)
+    {
+        close();
+        return false;
+    }
+
+    setNonBlocking(m_socket);
+
+#if EASY_NET_EPOLL != 0
+    m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll < 0)
+    {
+        close();
+        return false;
+    }
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.ptr = &m_socket; // listening sockets are marked by pointers to their members
+    if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_socket, &event) != 0)
+    {
+        close();
+        return false;
+    }
+#endif
+
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+    // Local socket is optional: clients can still connect by TCP if it has failed
+    m_localSocket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (isValidSocket(m_localSocket))
+    {
+        struct sockaddr_un local_address;
+        const auto size = EasySocket::localAddress(local_address, _port);
+
+        bool isListening = ::bind(m_localSocket, (struct sockaddr*)&local_address, size) == 0 && ::listen(m_localSocket, 5) == 0;
+        if (isListening)
+        {
+            setNonBlocking(m_localSocket);
+            event.data.ptr = &m_localSocket;
+            isListening = ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_localSocket, &event) == 0;
+        }
+
+        if (!isListening)
+        {
+            closeSocket(m_localSocket);
+            m_localSocket = INVALID_SOCKET_VALUE;
+        }
+    }
+#endif
+
+    m_isOpened = true;
+
+    return true;
+}
+
+void NetServer::close()
+{
+    m_clients.clear();
+
+#if EASY_NET_EPOLL != 0
+    if (m_epoll >= 0)
+    {
+        ::close(m_epoll);
+        m_epoll = -1;
+    }
+#endif
+
+    if (isValidSocket(m_socket))
+    {
+        closeSocket(m_socket);
+        m_socket = INVALID_SOCKET_VALUE;
+    }
+
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+    if (isValidSocket(m_localSocket))
+    {
+        closeSocket(m_localSocket);
+        m_localSocket = INVALID_SOCKET_VALUE;
+    }
+#endif
+
+    m_isOpened = false;
+}
+
+bool NetServer::isOpened() const
+{
+    return m_isOpened;
+}
+
+const std::vector<NetServer::client_ptr>& NetServer::clients() const
+{
+    return m_clients;
+}
+
+size_t NetServer::poll(int _timeoutMs)
+{
+    if (!m_isOpened)
+        return 0;
+
+    const size_t clientsNumber = m_clients.size();
+
+#if EASY_NET_EPOLL != 0
+    struct epoll_event events[MAX_EVENTS];
+    const int n = ::epoll_wait(m_epoll, events, MAX_EVENTS, _timeoutMs);
+    for (int i = 0; i < n; ++i)
+    {
+        const auto& event = events[i];
+        if (event.data.ptr == &m_socket)
+        {
+            accept(m_socket, false);
+            continue;
+        }
+
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+        if (event.data.ptr == &m_localSocket)
+        {
+            accept(m_localSocket, true);
+            continue;
+        }
+#endif
+
+        auto client = static_cast<NetClient*>(event.data.ptr);
+
+        if ((event.events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0)
+            client->receive();
+
+        if ((event.events & EPOLLOUT) != 0)
+            client->flush();
+    }
+#else
+    fd_set fdread, fdwrite;
+    FD_ZERO(&fdread);
+    FD_ZERO(&fdwrite);
+
+    FD_SET(m_socket, &fdread);
+    socket_t maxSocket = m_socket;
+
+    for (const auto& client : m_clients)
+    {
+        if (client->isClosed())
+            continue;
+
+        FD_SET(client->m_socket, &fdread);
+        if (client->queuedSize() != 0)
+            FD_SET(client->m_socket, &fdwrite);
+
+        maxSocket = std::max(maxSocket, client->m_socket);
+    }
+
+    struct timeval tv;
+    tv.tv_sec = _timeoutMs / 1000;
+    tv.tv_usec = (_timeoutMs % 1000) * 1000;
+
+    const int n = ::select(static_cast<int>(maxSocket) + 1, &fdread, &fdwrite, nullptr, &tv);
+    if (n > 0)
+    {
+        for (size_t i = 0; i < clientsNumber; ++i)
+        {
+            auto& client = *m_clients[i];
+            if (client.isClosed())
+                continue;
+
+            if (FD_ISSET(client.m_socket, &fdread))
+                client.receive();
+
+            if (FD_ISSET(client.m_socket, &fdwrite))
+                client.flush();
+        }
+
+        if (FD_ISSET(m_socket, &fdread))
+            accept(m_socket, false);
+    }
+#endif
+
+    for (size_t i = 0; i < clientsNumber; ++i)
+        updateEvents(*m_clients[i]);
+
+    return m_clients.size() - clientsNumber;
+}
+
+void NetServer::flush()
+{
+    for (auto& client : m_clients)
+    {
+        client->flush();
+        updateEvents(*client);
+    }
+}
+
+void NetServer::removeClosed(const std::function<void(NetClient&)>& _onRemove)
+{
+    auto it = std::remove_if(m_clients.begin(), m_clients.end(), [&_onRemove](const client_ptr& _client)
+    {
+        if (!_client->isClosed())
+            return false;
+        _onRemove(*_client);
+        return true;
+    });
+
+    // Closing a socket automatically removes it from epoll set
+    m_clients.erase(it, m_clients.end());
+}
+
+void NetServer::accept(socket_t _socket, bool _isLocal)
+{
+    for (;;)
+    {
+        const socket_t s = ::accept(_socket, nullptr, nullptr);
+        if (!isValidSocket(s))
+        {
+            if (isInterrupted(lastError()))
+                continue;
+            break; // There are no more pending connections
+        }
+
+        setNonBlocking(s);
+        ::setsockopt(s, SOL_SOCKET, SO_SNDBUF, (const char*)&SEND_BUFFER_SIZE, sizeof(int));
+
+#if defined(__APPLE__)
+        // Apple doesn't have MSG_NOSIGNAL, work around it
+        const int value = 1;
+        ::setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &value, sizeof(value));
+#endif
+
+        client_ptr client(new NetClient(s, m_nextClientId++, _isLocal));
+
+#if EASY_NET_EPOLL != 0
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.ptr = client.get();
+        if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, s, &event) != 0)
+            continue; // client would be destroyed and its socket would be closed
+#endif
+
+        m_clients.push_back(std::move(client));
+    }
+}
+
+void NetServer::updateEvents(NetClient& _client)
+{
+    const bool waitOut = !_client.isClosed() && _client.queuedSize() != 0;
+    if (waitOut == _client.m_isWaitingOut)
+        return;
+
+    _client.m_isWaitingOut = waitOut;
+
+#if EASY_NET_EPOLL != 0
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = waitOut ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    event.data.ptr = &_client;
+    ::epoll_ctl(m_epoll, EPOLL_CTL_MOD, _client.m_socket, &event);
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,304 @@
+/**
+Lightweight profiler library for c++
+Copyright(C) 2016-2019  Sergey Yagovtsev, Victor Zarubkin
+
+Licensed under either of
+    * MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+    * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+at your option.
+
+The MIT License
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights 
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+    of the Software, and to permit persons to whom the Software is furnished 
+    to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all 
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+    LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+    TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE 
+    USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+The Apache License, Version 2.0 (the "License");
+    You may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+**/
+
+#ifndef EASY_PROFILER_NET_SERVER_H
+#define EASY_PROFILER_NET_SERVER_H
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <streambuf>
+
+#include <easy/easy_socket.h>
+#include <easy/easy_net.h>
+
+#if defined(__linux__)
+# define EASY_NET_EPOLL 1
+#else
+# define EASY_NET_EPOLL 0
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+
+/** Read-only shared memory (memfd) which can be passed to local clients by file descriptor.
+
+The memory is unmapped and the descriptor is closed when the last owner releases the object.
+*/
+class SharedMemory EASY_FINAL
+{
+    const char* const m_data; ///< Mapped memory
+    const uint64_t    m_size; ///< Size of data in bytes
+    const int           m_fd; ///< memfd file descriptor
+
+public:
+
+    SharedMemory(int _fd, const char* _data, uint64_t _size);
+    ~SharedMemory();
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator = (const SharedMemory&) = delete;
+
+    int fd() const;
+    const char* data() const;
+    uint64_t size() const;
+
+}; // END of class SharedMemory.
+
+/** Output stream buffer which writes data directly into mapped shared memory (memfd).
+
+Memory grows by doubling its size, so written data is never copied again:
+local clients map the same pages after release().
+*/
+class SharedMemoryBuffer EASY_FINAL : public std::streambuf
+{
+    char*      m_data; ///< Mapped memory
+    size_t m_capacity; ///< Size of mapped memory
+    int          m_fd; ///< memfd file descriptor or -1 if it has failed
+
+public:
+
+    SharedMemoryBuffer();
+    ~SharedMemoryBuffer() override;
+
+    bool isValid() const;
+
+    /** Finish writing and pass written data to SharedMemory object.
+
+    \retval nullptr if writing has failed.
+    */
+    std::shared_ptr<const SharedMemory> release();
+
+protected:
+
+    int_type overflow(int_type _ch) override;
+    std::streamsize xsputn(const char* _data, std::streamsize _size) override;
+
+private:
+
+    bool reserve(size_t _size);
+    void reset();
+
+}; // END of class SharedMemoryBuffer.
+
+#endif // EASY_LOCAL_SOCKET_ENABLED
+
+//////////////////////////////////////////////////////////////////////////
+
+/** Connection of one client to the profiler listener.
+
+All sends are non-blocking: data is queued and written to the socket while the socket accepts it,
+the rest is written by NetServer when the socket becomes writable again.
+So a slow client never blocks the listener. Producers of large data must check queuedSize() before sending more:
+a client which queue exceeds the hard limit is disconnected.
+*/
+class NetClient EASY_FINAL
+{
+    friend class NetServer;
+
+public:
+
+    using socket_t = EasySocket::socket_t;
+    using chunk_t = std::shared_ptr<const std::string>;
+
+private:
+
+    struct Outgoing
+    {
+        chunk_t data; ///< Data (one chunk may be shared between several clients)
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+        std::shared_ptr<const SharedMemory> memory; ///< Shared memory which descriptor is passed with the data
+#endif
+    };
+
+    std::deque<Outgoing> m_outgoing; ///< Queued data
+    std::string         m_incoming; ///< Received bytes which do not form a whole message yet
+    size_t            m_queuedSize; ///< Total size of queued data which has not been sent yet
+    size_t              m_sentSize; ///< Sent size of the first queued chunk
+    const socket_t        m_socket; ///< Connected socket (non-blocking)
+    const uint32_t            m_id; ///< Sequential number of the client (used for logging only)
+    bool                m_isClosed; ///< True if connection has been closed or has failed
+    const bool           m_isLocal; ///< True if connected by Unix domain socket
+    bool            m_isWaitingOut; ///< True if the socket is registered for "writable" events
+
+public:
+
+    // Listener session state
+    bool     isCapturing = false; ///< Client has started capturing and waits for blocks
+    bool          isLive = false; ///< Client receives live portions of blocks
+    bool   isWaitingDump = false; ///< Client waits for blocks which are being dumped
+    bool isWaitingNextDump = false; ///< Client has stopped capturing and waits for the next dump to begin
+
+    NetClient(socket_t _socket, uint32_t _id, bool _isLocal);
+    ~NetClient();
+
+    NetClient(const NetClient&) = delete;
+    NetClient& operator = (const NetClient&) = delete;
+
+    uint32_t id() const;
+    bool isClosed() const;
+    bool isLocal() const;
+    size_t queuedSize() const;
+
+    /** Queue a copy of data for sending.
+
+    \note The client is closed if its queue becomes too large (it does not read data).
+    */
+    void send(const void* _data, size_t _size);
+
+    /** Queue a chunk of data for sending without copying. */
+    void send(chunk_t _chunk);
+
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+    /** Queue DataMessage without payload and pass descriptor of the shared memory with it.
+
+    Must be used for local clients only.
+    */
+    void send(const std::shared_ptr<const SharedMemory>& _memory, profiler::net::MessageType _type);
+#endif
+
+    /** Get type of the next whole profiler::net::Message without extracting it.
+
+    \retval false if there is no whole message yet.
+    */
+    bool peekMessage(profiler::net::MessageType& _type);
+
+    /** Extract next whole profiler::net::Message from received data.
+
+    \param _message Output buffer for the message (including message-specific fields).
+
+    \retval false if there is no whole message yet.
+    */
+    bool nextMessage(std::string& _message);
+
+    /** Close the connection. Queued data is discarded. */
+    void close();
+
+private:
+
+    bool receive();
+    bool flush();
+
+}; // END of class NetClient.
+
+//////////////////////////////////////////////////////////////////////////
+
+/** Event-driven TCP server which serves several clients at once on one thread.
+
+Uses epoll on Linux and select() on other platforms.
+On Linux clients can also connect by Unix domain socket.
+*/
+class NetServer EASY_FINAL
+{
+public:
+
+    using socket_t = EasySocket::socket_t;
+    using client_ptr = std::unique_ptr<NetClient>;
+
+private:
+
+    std::vector<client_ptr> m_clients; ///< Connected clients in order of connection
+    socket_t                 m_socket; ///< Listening socket
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+    socket_t            m_localSocket; ///< Listening Unix domain socket for clients on the same host
+#endif
+#if EASY_NET_EPOLL != 0
+    int                       m_epoll; ///< epoll instance for the listening socket and all clients
+#endif
+    uint32_t           m_nextClientId; ///< Id for the next accepted client
+    bool                 m_isOpened; ///< True if the server is listening
+#ifdef _WIN32
+    int                      m_wsaret;
+#endif
+
+public:
+
+    NetServer();
+    ~NetServer();
+
+    NetServer(const NetServer&) = delete;
+    NetServer& operator = (const NetServer&) = delete;
+
+    /** Bind to the port and start listening for connections.
+
+    Local clients can connect also by Unix domain socket (see EasySocket::connectLocal()).
+    */
+    bool open(uint16_t _port);
+
+    /** Close all connections and the listening socket. */
+    void close();
+
+    bool isOpened() const;
+
+    /** Wait at most _timeoutMs milliseconds for socket events.
+
+    Accepts new clients, reads incoming data of all clients and writes their pending data.
+
+    \retval Number of newly accepted clients (they are at the end of clients()).
+    */
+    size_t poll(int _timeoutMs);
+
+    /** Write pending data of all clients without waiting. */
+    void flush();
+
+    const std::vector<client_ptr>& clients() const;
+
+    /** Remove all closed clients.
+
+    \param _onRemove Called for each client before it is removed.
+    */
+    void removeClosed(const std::function<void(NetClient&)>& _onRemove);
+
+private:
+
+    void accept(socket_t _socket, bool _isLocal);
+    void updateEvents(NetClient& _client);
+
+}; // END of class NetServer.
+
+//////////////////////////////////////////////////////////////////////////
+
+#endif // EASY_PROFILER_NET_SERVER_H
@@ -0,0 +1,282 @@
+/**
+Lightweight profiler library for c++
+Copyright(C) 2016-2019  Sergey Yagovtsev, Victor Zarubkin
+
+Licensed under either of
+    * MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+    * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+at your option.
+
+The MIT License
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights 
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+    of the Software, and to permit persons to whom the Software is furnished 
+    to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all 
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+    LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+    TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE 
+    USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+The Apache License, Version 2.0 (the "License");
+    You may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+**/
+
+#include "numa_arena.h"
+
+#if EASY_OPTION_NUMA_AWARE_CHUNKS != 0 && defined(__linux__)
+
+#include <cstdint>
+#include <cstdlib>
+#include <easy/details/easy_compiler_support.h>
+
+#include "spin_lock.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef EASY_OPTION_NUMA_HUGE_PAGES
+# define EASY_OPTION_NUMA_HUGE_PAGES 0
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+EASY_CONSTEXPR uint32_t MAX_NUMA_NODES = 64;
+EASY_CONSTEXPR uint32_t MAX_SIZE_CLASSES = 4;
+EASY_CONSTEXPR uint32_t MALLOC_NODE = ~0U; ///< Node of chunks allocated with plain malloc
+EASY_CONSTEXPR size_t SLAB_SIZE = 2U << 20; ///< 2 MiB is the size of a transparent huge page on x86-64
+
+// MPOL_PREFERRED from <linux/mempolicy.h>: mbind is invoked directly to avoid libnuma dependency
+EASY_CONSTEXPR int EASY_MPOL_PREFERRED = 1;
+
+struct ChunkHeader
+{
+    ChunkHeader*    next; ///< Next free chunk of the same size class
+    uint32_t        node; ///< NUMA node of the chunk (MALLOC_NODE if it has been allocated by malloc)
+    uint32_t   sizeClass; ///< Index of the size class in NodeArena::freeLists (offset of chunk memory for malloc chunks)
+};
+
+struct FreeList
+{
+    size_t          size; ///< Size of chunks (0 if this size class is not used yet)
+    size_t     alignment; ///< Alignment of chunks
+    ChunkHeader*    head; ///< First free chunk
+};
+
+struct NodeArena
+{
+    profiler::spin_lock              lock; ///< Protects the arena
+    FreeList freeLists[MAX_SIZE_CLASSES]; ///< Free chunks of each size class
+    char*                          cursor; ///< Free space of the current slab
+    char*                             end; ///< End of the current slab
+
+    NodeArena() : cursor(nullptr), end(nullptr)
+    {
+        for (auto& freeList : freeLists)
+            freeList = FreeList {0, 0, nullptr};
+    }
+};
+
+NodeArena& arena(uint32_t _node)
+{
+    static NodeArena arenas[MAX_NUMA_NODES];
+    return arenas[_node];
+}
+
+uint32_t current_node()
+{
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0 || node >= MAX_NUMA_NODES)
+        return 0;
+    return node;
+}
+
+char* map_slab(size_t _size, uint32_t _node)
+{
+    // Over-map by one slab and trim both ends, so the slab is aligned by SLAB_SIZE and could be backed by huge pages
+    const auto mapSize = _size + SLAB_SIZE;
+    void* memory = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+        return nullptr;
+
+    auto begin = static_cast<char*>(memory);
+    auto slab = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(begin) + SLAB_SIZE - 1) & ~(uintptr_t)(SLAB_SIZE - 1));
+    if (slab != begin)
+        munmap(begin, static_cast<size_t>(slab - begin));
+    if (slab + _size != begin + mapSize)
+        munmap(slab + _size, static_cast<size_t>(begin + mapSize - slab - _size));
+
+#if EASY_OPTION_NUMA_HUGE_PAGES != 0 && defined(MADV_HUGEPAGE)
+    madvise(slab, _size, MADV_HUGEPAGE);
+#endif
+
+    // Pages are allocated on first touch which is done by a thread of the same node anyway,
+    // so failure of mbind (no NUMA support, restricted by seccomp etc.) is not an error.
+    EASY_CONSTEXPR uint32_t Bits = 8 * sizeof(unsigned long);
+    unsigned long nodemask[MAX_NUMA_NODES / Bits] = {};
+    nodemask[_node / Bits] = 1UL << (_node % Bits);
+    syscall(SYS_mbind, slab, _size, EASY_MPOL_PREFERRED, nodemask, static_cast<unsigned long>(MAX_NUMA_NODES + 1), 0U);
+
+    return slab;
+}
+
+/** Carves a chunk of the size class from the current slab, returns nullptr if the rest of the slab is too small. */
+char* carve_chunk(NodeArena& _arena, uint32_t _node, uint32_t _sizeClass)
+{
+    if (_arena.cursor == nullptr)
+        return nullptr;
+
+    // Header is placed right before aligned chunk memory
+    const auto& freeList = _arena.freeLists[_sizeClass];
+    const auto alignment = static_cast<uintptr_t>(freeList.alignment);
+    auto data = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(_arena.cursor + sizeof(ChunkHeader)) + alignment - 1) & ~(alignment - 1));
+    if (data + freeList.size > _arena.end)
+        return nullptr;
+
+    _arena.cursor = data + freeList.size;
+
+    auto header = reinterpret_cast<ChunkHeader*>(data) - 1;
+    header->next = nullptr;
+    header->node = _node;
+    header->sizeClass = _sizeClass;
+
+    return data;
+}
+
+/** Puts the rest of the current slab into free lists as chunks of known size classes before a new slab is mapped. */
+void drain_slab(NodeArena& _arena, uint32_t _node)
+{
+    for (uint32_t sizeClass = 0; sizeClass < MAX_SIZE_CLASSES && _arena.freeLists[sizeClass].size != 0; ++sizeClass)
+    {
+        auto& freeList = _arena.freeLists[sizeClass];
+        while (auto data = carve_chunk(_arena, _node, sizeClass))
+        {
+            auto header = reinterpret_cast<ChunkHeader*>(data) - 1;
+            header->next = freeList.head;
+            freeList.head = header;
+        }
+    }
+}
+
+void* malloc_chunk(size_t _size, size_t _alignment)
+{
+    const auto offset = (sizeof(ChunkHeader) + _alignment - 1) & ~(_alignment - 1);
+
+    void* memory = nullptr;
+    if (posix_memalign(&memory, _alignment, offset + _size) != 0)
+        return nullptr;
+
+    auto data = static_cast<char*>(memory) + offset;
+    auto header = reinterpret_cast<ChunkHeader*>(data) - 1;
+    header->next = nullptr;
+    header->node = MALLOC_NODE;
+    header->sizeClass = static_cast<uint32_t>(offset);
+
+    return data;
+}
+
+} // end of namespace <noname>.
+
+//////////////////////////////////////////////////////////////////////////
+
+void* numa_allocate(size_t _size, size_t _alignment)
+{
+    if (_alignment < EASY_ALIGNOF(ChunkHeader))
+        _alignment = EASY_ALIGNOF(ChunkHeader);
+
+    const auto node = current_node();
+    auto& nodeArena = arena(node);
+    profiler::guard_lock<profiler::spin_lock> lock(nodeArena.lock);
+
+    uint32_t sizeClass = 0;
+    for (; sizeClass < MAX_SIZE_CLASSES; ++sizeClass)
+    {
+        auto& freeList = nodeArena.freeLists[sizeClass];
+        if (freeList.size == 0)
+        {
+            freeList.size = _size;
+            freeList.alignment = _alignment;
+            break;
+        }
+
+        if (freeList.size == _size && freeList.alignment == _alignment)
+            break;
+    }
+
+    if (sizeClass == MAX_SIZE_CLASSES)
+    {
+        lock.unlock();
+        return malloc_chunk(_size, _alignment);
+    }
+
+    auto& freeList = nodeArena.freeLists[sizeClass];
+    if (freeList.head != nullptr)
+    {
+        auto header = freeList.head;
+        freeList.head = header->next;
+        return header + 1;
+    }
+
+    auto data = carve_chunk(nodeArena, node, sizeClass);
+    if (data == nullptr)
+    {
+        const auto slabSize = ((_size + sizeof(ChunkHeader) + _alignment + SLAB_SIZE - 1) / SLAB_SIZE) * SLAB_SIZE;
+        auto slab = map_slab(slabSize, node);
+        if (slab == nullptr)
+        {
+            lock.unlock();
+            return malloc_chunk(_size, _alignment);
+        }
+
+        drain_slab(nodeArena, node);
+
+        nodeArena.cursor = slab;
+        nodeArena.end = slab + slabSize;
+        data = carve_chunk(nodeArena, node, sizeClass);
+    }
+
+    return data;
+}
+
+void numa_free(void* _ptr)
+{
+    if (_ptr == nullptr)
+        return;
+
+    auto header = static_cast<ChunkHeader*>(_ptr) - 1;
+    if (header->node == MALLOC_NODE)
+    {
+        free(static_cast<char*>(_ptr) - header->sizeClass);
+        return;
+    }
+
+    auto& nodeArena = arena(header->node);
+    profiler::guard_lock<profiler::spin_lock> lock(nodeArena.lock);
+
+    auto& freeList = nodeArena.freeLists[header->sizeClass];
+    header->next = freeList.head;
+    freeList.head = header;
+}
+
+#endif // EASY_OPTION_NUMA_AWARE_CHUNKS != 0 && defined(__linux__)
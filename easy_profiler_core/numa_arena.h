@@ -0,0 +1,71 @@
+/**
+Lightweight profiler library for c++
+Copyright(C) 2016-2019  Sergey Yagovtsev, Victor Zarubkin
+
+Licensed under either of
+    * MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+    * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+at your option.
+
+The MIT License
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights 
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+    of the Software, and to permit persons to whom the Software is furnished 
+    to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all 
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+    LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+    TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE 
+    USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+The Apache License, Version 2.0 (the "License");
+    You may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+**/
+
+#ifndef EASY_PROFILER_NUMA_ARENA_H
+#define EASY_PROFILER_NUMA_ARENA_H
+
+#include <cstddef>
+
+#ifndef EASY_OPTION_NUMA_AWARE_CHUNKS
+# define EASY_OPTION_NUMA_AWARE_CHUNKS 0
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+
+/** Allocates memory for a storage chunk on the NUMA node of the calling thread.
+
+Thread storage chunks are allocated by the thread which owns the storage, so blocks are always written to local memory.
+Freed chunks are kept in the free list of their node and are reused only by threads running on that node,
+even if they are freed by another thread (e.g. by the dumping thread).
+
+Arenas are filled with slabs bound to their node (see mbind(2)), which could be backed by transparent huge pages
+(EASY_OPTION_NUMA_HUGE_PAGES). Slabs are never returned to the system.
+
+\note Falls back to plain malloc if NUMA-aware allocation is unavailable. */
+void* numa_allocate(size_t _size, size_t _alignment);
+
+/** Returns memory allocated by numa_allocate() to the arena of its node. */
+void numa_free(void* _ptr);
+
+//////////////////////////////////////////////////////////////////////////
+
+#endif // EASY_PROFILER_NUMA_ARENA_H
@@ -0,0 +1,276 @@
+/**
+Lightweight profiler library for c++
+Copyright(C) 2016-2019  Sergey Yagovtsev, Victor Zarubkin
+
+Licensed under either of
+    * MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+    * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+at your option.
+
+The MIT License
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights 
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+    of the Software, and to permit persons to whom the Software is furnished 
+    to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all 
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+    LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+    TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE 
+    USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+The Apache License, Version 2.0 (the "License");
+    You may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+**/
+
+#include <string.h>
+#include "perf_counters.h"
+
+#if defined(__linux__)
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+# if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#  define EASY_PERF_COUNTERS_RDPMC 1
+# endif
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+EASY_CONSTEXPR uint32_t HARDWARE_COUNTERS = (1U << profiler::PERF_TASK_CLOCK) - 1; ///< All counters before PERF_TASK_CLOCK are hardware ones
+EASY_CONSTEXPR uint32_t FALLBACK_COUNTERS = (1U << profiler::PERF_TASK_CLOCK) | (1U << profiler::PERF_PAGE_FAULTS);
+
+#if defined(__linux__)
+
+struct CounterConfig
+{
+    uint32_t type;
+    uint64_t config;
+};
+
+const CounterConfig COUNTER_CONFIGS[profiler::PERF_COUNTERS_NUMBER] = {
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES}       // PERF_CYCLES
+    , {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS}     // PERF_INSTRUCTIONS
+    , {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}     // PERF_CACHE_MISSES
+    , {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}    // PERF_BRANCH_MISSES
+    , {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK}       // PERF_TASK_CLOCK
+    , {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}      // PERF_PAGE_FAULTS
+    , {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES} // PERF_CONTEXT_SWITCHES
+};
+
+int perfEventOpen(perf_event_attr& attr, int groupFd)
+{
+    // pid = 0, cpu = -1: the calling thread on any CPU
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, PERF_FLAG_FD_CLOEXEC));
+}
+
+#ifdef EASY_PERF_COUNTERS_RDPMC
+
+inline uint64_t rdpmc(uint32_t counter)
+{
+    uint32_t low, high;
+    __asm__ volatile("rdpmc" : "=a" (low), "=d" (high) : "c" (counter));
+    return static_cast<uint64_t>(low) | (static_cast<uint64_t>(high) << 32);
+}
+
+/** Reads counter value in user-space using a seqlock of perf_event_mmap_page.
+
+\retval false if the counter is not scheduled on the CPU at the moment (its value must be read with a syscall). */
+bool readUserSpace(const volatile perf_event_mmap_page* pc, uint64_t& value)
+{
+    uint32_t seq;
+    do {
+        seq = pc->lock;
+        __asm__ volatile("" ::: "memory");
+
+        const uint32_t index = pc->index;
+        if (index == 0)
+            return false;
+
+        const uint32_t width = pc->pmc_width;
+        const auto pmc = static_cast<int64_t>(rdpmc(index - 1) << (64 - width)) >> (64 - width);
+        value = static_cast<uint64_t>(pc->offset + pmc);
+
+        __asm__ volatile("" ::: "memory");
+    } while (pc->lock != seq);
+
+    return true;
+}
+
+#endif // EASY_PERF_COUNTERS_RDPMC
+
+#endif // defined(__linux__)
+
+} // end of namespace <noname>.
+
+//////////////////////////////////////////////////////////////////////////
+
+PerfCounters::PerfCounters() EASY_NOEXCEPT
+    : m_requested(0)
+    , m_number(0)
+    , m_userRead(false)
+{
+    for (auto& counter : m_counters)
+    {
+        counter.page = nullptr;
+        counter.fd = -1;
+    }
+
+    memset(m_ids, 0, sizeof(m_ids));
+}
+
+PerfCounters::~PerfCounters()
+{
+    close();
+}
+
+uint8_t PerfCounters::open(uint32_t _counters)
+{
+    close();
+
+    m_requested = _counters;
+    if (_counters == 0 || openGroup(_counters) != 0 || (_counters & HARDWARE_COUNTERS) == 0)
+        return m_number;
+
+    // Hardware counters are unavailable: use software ones
+    const auto software = _counters & ~HARDWARE_COUNTERS;
+    return openGroup(software != 0 ? software : FALLBACK_COUNTERS);
+}
+
+void PerfCounters::close()
+{
+#if defined(__linux__)
+    const auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    for (uint8_t i = 0; i < m_number; ++i)
+    {
+        auto& counter = m_counters[i];
+
+        if (counter.page != nullptr)
+            munmap(counter.page, pageSize);
+
+        if (counter.fd >= 0)
+            ::close(counter.fd);
+
+        counter.page = nullptr;
+        counter.fd = -1;
+    }
+#endif
+
+    m_number = 0;
+    m_userRead = false;
+}
+
+void PerfCounters::read(uint64_t* _values) const
+{
+#ifdef EASY_PERF_COUNTERS_RDPMC
+    if (m_userRead)
+    {
+        uint8_t i = 0;
+        for (; i < m_number; ++i)
+        {
+            if (!readUserSpace(static_cast<const volatile perf_event_mmap_page*>(m_counters[i].page), _values[i]))
+                break;
+        }
+
+        if (i == m_number)
+            return;
+    }
+#endif
+
+#if defined(__linux__)
+    // PERF_FORMAT_GROUP layout: uint64_t number, uint64_t values[number]
+    uint64_t buffer[1 + profiler::MAX_PERF_COUNTERS];
+    const auto size = sizeof(uint64_t) * (1 + m_number);
+    if (m_number != 0 && ::read(m_counters[0].fd, buffer, size) == static_cast<ssize_t>(size))
+    {
+        memcpy(_values, buffer + 1, sizeof(uint64_t) * m_number);
+        return;
+    }
+#endif
+
+    memset(_values, 0, sizeof(uint64_t) * m_number);
+}
+
+uint8_t PerfCounters::openGroup(uint32_t _counters)
+{
+#if defined(__linux__)
+    bool hardwareOnly = true;
+
+    for (uint8_t id = 0; id < profiler::PERF_COUNTERS_NUMBER && m_number < profiler::MAX_PERF_COUNTERS; ++id)
+    {
+        if ((_counters & (1U << id)) == 0)
+            continue;
+
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = COUNTER_CONFIGS[id].type;
+        attr.config = COUNTER_CONFIGS[id].config;
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.disabled = m_number == 0 ? 1 : 0; // The whole group is enabled by the leader
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        const int fd = perfEventOpen(attr, m_number == 0 ? -1 : m_counters[0].fd);
+        if (fd < 0)
+        {
+            close();
+            return 0;
+        }
+
+        auto& counter = m_counters[m_number];
+        counter.fd = fd;
+        m_ids[m_number++] = id;
+
+        if (attr.type != PERF_TYPE_HARDWARE)
+        {
+            hardwareOnly = false;
+            continue;
+        }
+
+#ifdef EASY_PERF_COUNTERS_RDPMC
+        auto page = mmap(nullptr, static_cast<size_t>(sysconf(_SC_PAGESIZE)), PROT_READ, MAP_SHARED, fd, 0);
+        counter.page = page != MAP_FAILED ? page : nullptr;
+#endif
+    }
+
+    if (m_number == 0)
+        return 0;
+
+    ioctl(m_counters[0].fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(m_counters[0].fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+    // rdpmc is used only if every counter of the group could be read in user-space
+    m_userRead = hardwareOnly;
+    for (uint8_t i = 0; i < m_number && m_userRead; ++i)
+    {
+        const auto page = static_cast<const perf_event_mmap_page*>(m_counters[i].page);
+        m_userRead = page != nullptr && page->cap_user_rdpmc != 0;
+    }
+#else
+    (void)_counters;
+#endif
+
+    return m_number;
+}
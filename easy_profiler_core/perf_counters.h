@@ -0,0 +1,108 @@
+/**
+Lightweight profiler library for c++
+Copyright(C) 2016-2019  Sergey Yagovtsev, Victor Zarubkin
+
+Licensed under either of
+    * MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+    * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+at your option.
+
+The MIT License
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights 
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+    of the Software, and to permit persons to whom the Software is furnished 
+    to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all 
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+    INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+    PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE 
+    LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+    TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE 
+    USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+The Apache License, Version 2.0 (the "License");
+    You may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+**/
+
+#ifndef EASY_PROFILER_PERF_COUNTERS_H
+#define EASY_PROFILER_PERF_COUNTERS_H
+
+#include <stdint.h>
+#include <easy/details/profiler_public_types.h>
+
+//////////////////////////////////////////////////////////////////////////
+
+/** Group of performance counters of the current thread (see profiler::setPerfCounters()).
+
+Counters are opened with perf_event_open for the calling thread only, so PerfCounters must be opened,
+read and closed by the thread which owns it. Hardware counters are read in user-space with rdpmc
+if the kernel allows it (one syscall for the whole group is used otherwise).
+
+If hardware counters could not be opened (virtual machines, containers, restricted perf_event_paranoid)
+then software counters are opened instead.
+
+\note Only Linux is supported: open() fails on other systems. */
+class PerfCounters EASY_FINAL
+{
+    struct MappedCounter
+    {
+        void*       page; ///< perf_event_mmap_page used for rdpmc reads (nullptr if not mapped)
+        int           fd; ///< Counter file descriptor
+    };
+
+    MappedCounter  m_counters[profiler::MAX_PERF_COUNTERS]; ///< Opened counters. The first one is the group leader.
+    uint8_t             m_ids[profiler::MAX_PERF_COUNTERS]; ///< profiler::PerfCounter for each opened counter
+    uint32_t                                   m_requested; ///< Mask of requested counters (opened counters may differ)
+    uint8_t                                       m_number; ///< Number of opened counters
+    bool                                        m_userRead; ///< True if all counters could be read with rdpmc
+
+public:
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator = (const PerfCounters&) = delete;
+
+    PerfCounters() EASY_NOEXCEPT;
+    ~PerfCounters();
+
+    /** Opens requested counters (mask of 1 << profiler::PerfCounter) closing previously opened ones.
+
+    If hardware counters are unavailable then software counters are opened instead.
+    Zero mask just closes counters.
+
+    \retval Number of opened counters. */
+    uint8_t open(uint32_t _counters);
+
+    void close();
+
+    /** Reads current values of all opened counters into _values (number() elements). */
+    void read(uint64_t* _values) const;
+
+    inline uint32_t requested() const EASY_NOEXCEPT { return m_requested; }
+    inline uint8_t number() const EASY_NOEXCEPT { return m_number; }
+    inline const uint8_t* ids() const EASY_NOEXCEPT { return m_ids; }
+
+private:
+
+    uint8_t openGroup(uint32_t _counters);
+
+}; // END of class PerfCounters.
+
+//////////////////////////////////////////////////////////////////////////
+
+#endif // EASY_PROFILER_PERF_COUNTERS_H
@@ -51,8 +51,10 @@
 #include <algorithm>
 #include <future>
 #include <fstream>
+#include <mutex>
 #include <ostream>
 #include <sstream>
+#include <vector>
 #include "profile_manager.h"
 
 #include <easy/profiler.h>
@@ -68,6 +70,7 @@
 #include "block_descriptor.h"
 #include "current_time.h"
 #include "current_thread.h"
+#include "net_server.h"
 
 #ifdef __APPLE__
 # include <mach/clock.h>
@@ -149,6 +152,8 @@ extern const profiler::color_t EASY_COLOR_INTERNAL_EVENT = 0xffffffff; // profil
 EASY_CONSTEXPR profiler::color_t EASY_COLOR_THREAD_END = 0xff212121; // profiler::colors::Dark
 EASY_CONSTEXPR profiler::color_t EASY_COLOR_START = 0xff4caf50; // profiler::colors::Green
 EASY_CONSTEXPR profiler::color_t EASY_COLOR_END = 0xfff44336; // profiler::colors::Red
+EASY_CONSTEXPR profiler::color_t EASY_COLOR_LOCK_WAIT = 0xffef5350; // profiler::colors::Red400
+EASY_CONSTEXPR profiler::color_t EASY_COLOR_LOCK_HOLD = 0xff90a4ae; // profiler::colors::BlueGrey300
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -165,11 +170,27 @@ static EASY_THREAD_LOCAL profiler::timestamp_t THIS_THREAD_FRAME_T_ACC = 0ULL;
 static EASY_THREAD_LOCAL uint32_t THIS_THREAD_N_FRAMES = 0;
 static EASY_THREAD_LOCAL bool THIS_THREAD_FRAME_T_RESET_MAX = false;
 static EASY_THREAD_LOCAL bool THIS_THREAD_FRAME_T_RESET_AVG = false;
+static EASY_THREAD_LOCAL bool THIS_THREAD_INSIDE_PROFILER = false;
 
 #ifdef EASY_CXX11_TLS_AVAILABLE
 thread_local static profiler::ThreadGuard THIS_THREAD_GUARD; // thread guard for monitoring thread life time
 #endif
 
+/** Marks current thread as executing profiler code.
+
+Memory allocated by profiler itself is not stored (see ProfileManager::storeAllocation): thread storage
+could be in the middle of modification and profiler locks could be already acquired by current thread. */
+class InternalCodeGuard EASY_FINAL
+{
+    const bool m_inside;
+
+public:
+
+    InternalCodeGuard() : m_inside(THIS_THREAD_INSIDE_PROFILER) { THIS_THREAD_INSIDE_PROFILER = true; }
+    ~InternalCodeGuard() { THIS_THREAD_INSIDE_PROFILER = m_inside; }
+
+}; // END of class InternalCodeGuard.
+
 //////////////////////////////////////////////////////////////////////////
 
 #ifdef BUILD_WITH_EASY_PROFILER
@@ -221,22 +242,172 @@ static void write(std::ostream& _outstream, const T& _data)
     _outstream.write((const char*)&_data, sizeof(T));
 }
 
-static void clear_sstream(std::stringstream& _outstream)
+//////////////////////////////////////////////////////////////////////////
+
+EASY_CONSTEXPR size_t NET_FRAME_SIZE = 4 * 1024 * 1024; ///< Max size of one DataMessage frame payload
+EASY_CONSTEXPR size_t LIVE_MAX_QUEUED_SIZE = 2 * NET_FRAME_SIZE; ///< Live portions are postponed while any live client has more data queued
+EASY_CONSTEXPR size_t DUMP_MAX_QUEUED_SIZE = 2 * NET_FRAME_SIZE; ///< Dumped frames are postponed while a receiver has more data queued
+EASY_CONSTEXPR int DUMP_STALL_TIMEOUT = 30000; ///< Receiver of dumped blocks which has not read anything for this time (milliseconds) is disconnected
+EASY_CONSTEXPR uint32_t LIVE_MIN_INTERVAL = 10; ///< Min interval between two live portions in milliseconds
+EASY_CONSTEXPR int LISTEN_POLL_TIMEOUT = 500; ///< Max time to wait for socket events in milliseconds
+EASY_CONSTEXPR int DUMP_POLL_TIMEOUT = 10; ///< Max time to wait for socket events while blocks are being dumped
+
+/** Thread-safe queue of DataMessage frames which are ready for sending.
+
+The dumping thread pushes frames while the listener thread takes them and passes them to clients.
+push() never waits: the dumping thread must not depend on clients while it holds profiler locks.
+*/
+class FrameQueue EASY_FINAL
 {
-#if defined(__GNUC__) && __GNUC__ < 5
-    // gcc 4 has a known bug which has been solved in gcc 5:
-    // std::stringstream has no swap() method :(
-    _outstream.str(std::string());
-#else
-    std::stringstream().swap(_outstream);
+    std::vector<NetClient::chunk_t> m_frames; ///< Frames which have not been taken yet
+    std::mutex                       m_mutex;
+
+public:
+
+    void push(NetClient::chunk_t _frame)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_frames.push_back(std::move(_frame));
+    }
+
+    std::vector<NetClient::chunk_t> take()
+    {
+        std::vector<NetClient::chunk_t> frames;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        frames.swap(m_frames);
+        return frames;
+    }
+
+}; // END of class FrameQueue.
+
+/** Output stream buffer which splits written data into frames and pushes them to the FrameQueue.
+
+Each frame is a profiler::net::DataMessage header followed by at most NET_FRAME_SIZE bytes of payload.
+The header is reserved in front of the payload, so a full frame is queued without additional copying.
+
+Frames are never sent from the writing thread and FrameQueue is not limited, so the dumping thread releases
+m_dumpSpin and m_storedSpin as soon as blocks are serialized, no matter how fast clients read.
+Frames are passed to each client at its own pace by the listener thread (see DumpedBlocks).
+*/
+class FrameStreamBuffer EASY_FINAL : public std::streambuf
+{
+    EASY_STATIC_CONSTEXPR size_t HeaderSize = sizeof(profiler::net::DataMessage);
+
+    std::string                      m_frame; ///< DataMessage header + frame payload
+    FrameQueue&                      m_queue; ///< Destination queue
+    const profiler::net::MessageType  m_type; ///< Type of DataMessage for all frames
+
+public:
+
+    FrameStreamBuffer(FrameQueue& _queue, profiler::net::MessageType _type)
+        : m_queue(_queue)
+        , m_type(_type)
+    {
+        resetFrame();
+    }
+
+    ~FrameStreamBuffer() override
+    {
+        pushFrame();
+    }
+
+protected:
+
+    int_type overflow(int_type _ch) override
+    {
+        pushFrame();
+
+        if (!traits_type::eq_int_type(_ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(_ch);
+            pbump(1);
+        }
+
+        return traits_type::not_eof(_ch);
+    }
+
+    std::streamsize xsputn(const char* _data, std::streamsize _size) override
+    {
+        std::streamsize written = 0;
+        while (written < _size)
+        {
+            auto space = static_cast<std::streamsize>(epptr() - pptr());
+            if (space == 0)
+            {
+                pushFrame();
+                space = static_cast<std::streamsize>(epptr() - pptr());
+            }
+
+            const auto n = std::min(space, _size - written);
+            memcpy(pptr(), _data + written, static_cast<size_t>(n));
+            pbump(static_cast<int>(n));
+            written += n;
+        }
+
+        return written;
+    }
+
+    int sync() override
+    {
+        pushFrame();
+        return 0;
+    }
+
+private:
+
+    void resetFrame()
+    {
+        m_frame.resize(HeaderSize + NET_FRAME_SIZE);
+        char* payload = &m_frame[HeaderSize];
+        setp(payload, payload + NET_FRAME_SIZE);
+    }
+
+    void pushFrame()
+    {
+        const auto size = static_cast<uint64_t>(pptr() - pbase());
+        if (size == 0)
+            return;
+
+        ::new (&m_frame[0]) profiler::net::DataMessage(size, m_type);
+        m_frame.resize(HeaderSize + static_cast<size_t>(size));
+        m_queue.push(std::make_shared<const std::string>(std::move(m_frame)));
+
+        m_frame.clear();
+        resetFrame();
+    }
+
+}; // END of class FrameStreamBuffer.
+
+/** Blocks of one dump which are being passed to clients.
+
+Frames are appended by the listener thread while the dumping thread writes them.
+A frame is released as soon as all receivers of the dump have got it.
+*/
+struct DumpedBlocks
+{
+    std::vector<NetClient::chunk_t>  frames; ///< All frames of the dump (released frames are nullptr)
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+    std::shared_ptr<const SharedMemory> memory; ///< Blocks written directly into shared memory (there are no frames then)
 #endif
-}
+    size_t          released = 0; ///< Number of frames which have been released
+    bool        isFinished = false; ///< Dumping thread has finished writing
+};
+
+/** Progress of one client which receives dumped blocks. */
+struct DumpReceiver
+{
+    std::shared_ptr<DumpedBlocks>        blocks; ///< The dump which is being received
+    std::chrono::steady_clock::time_point readTime; ///< Last time when the client has read something
+    uint64_t        position = 0; ///< Number of sent frames (or sent bytes of shared memory for remote clients)
+    size_t        queuedSize = 0; ///< Queued size of the client after the last sending
+};
 
 //////////////////////////////////////////////////////////////////////////
 
 profiler::ThreadGuard::~ThreadGuard()
 {
 #ifndef EASY_PROFILER_API_DISABLED
+    const InternalCodeGuard internalCodeGuard;
     if (m_id != 0 && THIS_THREAD != nullptr && THIS_THREAD->id == m_id)
     {
         bool isMarked = false;
@@ -244,6 +415,7 @@ profiler::ThreadGuard::~ThreadGuard()
         //THIS_THREAD->markProfilingFrameEnded();
         THIS_THREAD->putMark();
         THIS_THREAD->expired.store(isMarked ? 2 : 1, std::memory_order_release);
+        ProfileManager::instance().recycleThreadStorage(*THIS_THREAD);
         THIS_THREAD = nullptr;
     }
 #endif
@@ -338,6 +510,8 @@ ProfileManager::ProfileManager() :
     m_stopListen = false;
 
     m_mainThreadId = 0;
+    m_perfCounters = 0;
+    m_asyncSpanId = 0;
     m_frameMax = 0;
     m_frameAvg = 0;
     m_frameCur = 0;
@@ -392,15 +566,36 @@ ProfileManager& ProfileManager::instance()
 
 //////////////////////////////////////////////////////////////////////////
 
-ThreadStorage& ProfileManager::_threadStorage(profiler::thread_id_t _thread_id)
+ThreadStorage& ProfileManager::threadStorage(profiler::thread_id_t _thread_id)
 {
-    return m_threads[_thread_id];
+    // Storage could be already created for context switch events of this thread (see endContextSwitch)
+    return m_threads.acquire(_thread_id);
 }
 
-ThreadStorage* ProfileManager::_findThreadStorage(profiler::thread_id_t _thread_id)
+void ProfileManager::releaseThreadStorage(ThreadStorage& _storage, bool& _mainThreadExpired)
 {
-    auto it = m_threads.find(_thread_id);
-    return it != m_threads.end() ? &it->second : nullptr;
+    profiler::thread_id_t id = _storage.id;
+    if (!_mainThreadExpired && m_mainThreadId.compare_exchange_weak(id, 0, std::memory_order_release, std::memory_order_acquire))
+        _mainThreadExpired = true;
+    m_threads.release(_storage);
+}
+
+void ProfileManager::recycleThreadStorage(ThreadStorage& _storage)
+{
+    // Storages are iterated by dumping threads under m_spin. Never wait for them:
+    // storage of expired thread would be recycled by the dump itself.
+    if (isEnabled() || !m_spin.try_lock())
+        return;
+
+    if (_storage.blocks.closedList.empty() && _storage.sync.closedList.empty() && _storage.sync.openedList.empty() &&
+        _storage.liveBlocksNumber == 0)
+    {
+        // Nothing to dump: recycle storage at once
+        bool mainThreadExpired = false;
+        releaseThreadStorage(_storage, mainThreadExpired);
+    }
+
+    m_spin.unlock();
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -409,6 +604,7 @@ const profiler::BaseBlockDescriptor* ProfileManager::addBlockDescriptor(profiler
     , const char* _autogenUniqueId, const char* _name, const char* _filename, int _line
     , profiler::block_type_t _block_type, profiler::color_t _color, bool _copyName)
 {
+    const InternalCodeGuard internalCodeGuard;
     guard_lock_t lock(m_storedSpin);
 
     const descriptors_map_t::key_type key(_autogenUniqueId);
@@ -453,12 +649,14 @@ const profiler::BaseBlockDescriptor* ProfileManager::addBlockDescriptor(profiler
 void ProfileManager::storeValue(const profiler::BaseBlockDescriptor* _desc, profiler::DataType _type, const void* _data,
                                 uint16_t _size, bool _isArray, profiler::ValueId _vin)
 {
+    const InternalCodeGuard internalCodeGuard;
     if (!isEnabled() || (_desc->m_status & profiler::ON) == 0)
         return;
 
     if (THIS_THREAD == nullptr)
         registerThread();
 
+    // The reader attaches every value to the innermost block enclosing it (see BlocksTree::parent).
 #if EASY_ENABLE_BLOCK_STATUS != 0
     if (THIS_THREAD->stackSize > 0 || (!THIS_THREAD->allowChildren && (_desc->m_status & FORCE_ON_FLAG) == 0))
         return;
@@ -473,8 +671,103 @@ void ProfileManager::storeValue(const profiler::BaseBlockDescriptor* _desc, prof
 
 //////////////////////////////////////////////////////////////////////////
 
+void ProfileManager::storeAllocation(bool _free, const void* _address, uint64_t _size)
+{
+    // Allocator is called during thread creation and destruction, so allocations never register a thread:
+    // only alive threads which are already known to profiler are traced.
+    // Allocations made by profiler itself are skipped (see InternalCodeGuard).
+    if (!isEnabled() || THIS_THREAD_INSIDE_PROFILER || THIS_THREAD == nullptr ||
+        THIS_THREAD->expired.load(std::memory_order_relaxed) != 0)
+    {
+        return;
+    }
+
+    const InternalCodeGuard internalCodeGuard;
+
+    EASY_LOCAL_STATIC_PTR(const profiler::BaseBlockDescriptor*, allocDesc, addBlockDescriptor(profiler::ON,
+        EASY_UNIQUE_LINE_ID, profiler::ALLOCATION_VALUE_NAME, __FILE__, __LINE__, profiler::BlockType::Value,
+        EASY_COLOR_INTERNAL_EVENT));
+
+    EASY_LOCAL_STATIC_PTR(const profiler::BaseBlockDescriptor*, freeDesc, addBlockDescriptor(profiler::ON,
+        EASY_UNIQUE_LINE_ID, profiler::DEALLOCATION_VALUE_NAME, __FILE__, __LINE__, profiler::BlockType::Value,
+        EASY_COLOR_INTERNAL_EVENT));
+
+    const auto desc = _free ? freeDesc : allocDesc;
+    if ((desc->m_status & profiler::ON) == 0)
+        return;
+
+#if EASY_ENABLE_BLOCK_STATUS != 0
+    if (!THIS_THREAD->allowChildren && (desc->m_status & FORCE_ON_FLAG) == 0)
+        return;
+#endif
+
+    // Stored as compact value records: size is the value and address is the value id
+    THIS_THREAD->storeCompactValue(profiler::clock::now(), desc->id(), profiler::DataType::Uint64, _size,
+                                   reinterpret_cast<profiler::vin_t>(_address));
+}
+
+void ProfileManager::storeLock(bool _hold, const char* _lockName, profiler::timestamp_t _beginTime,
+                               profiler::timestamp_t _endTime)
+{
+    EASY_LOCAL_STATIC_PTR(const profiler::BaseBlockDescriptor*, waitDesc, addBlockDescriptor(profiler::ON,
+        EASY_UNIQUE_LINE_ID, profiler::LOCK_WAIT_BLOCK_NAME, __FILE__, __LINE__, profiler::BlockType::Block,
+        EASY_COLOR_LOCK_WAIT));
+
+    EASY_LOCAL_STATIC_PTR(const profiler::BaseBlockDescriptor*, holdDesc, addBlockDescriptor(profiler::ON,
+        EASY_UNIQUE_LINE_ID, profiler::LOCK_HOLD_BLOCK_NAME, __FILE__, __LINE__, profiler::BlockType::Block,
+        EASY_COLOR_LOCK_HOLD));
+
+    // Stored with explicit begin and end times, so these blocks never touch the stack of opened blocks
+    // (locks could be released in any order)
+    storeBlock(_hold ? holdDesc : waitDesc, _lockName, _beginTime, _endTime);
+}
+
+void ProfileManager::storeAsyncSegment(const profiler::BaseBlockDescriptor* _desc, const char* _runtimeName,
+                                       uint64_t _spanId, profiler::timestamp_t _beginTime,
+                                       profiler::timestamp_t _endTime)
+{
+    const InternalCodeGuard internalCodeGuard;
+    if (!isEnabled() || (_desc->m_status & profiler::ON) == 0)
+        return;
+
+    if (THIS_THREAD == nullptr)
+        registerThread();
+
+#if EASY_ENABLE_BLOCK_STATUS != 0
+    if (THIS_THREAD->stackSize > 0 || (!THIS_THREAD->allowChildren && (_desc->m_status & FORCE_ON_FLAG) == 0))
+        return;
+#else
+    if (THIS_THREAD->stackSize > 0)
+        // Prevent from store block until frame, which has been opened when profiler was disabled, finish
+        return;
+#endif
+
+    EASY_LOCAL_STATIC_PTR(const profiler::BaseBlockDescriptor*, spanDesc, addBlockDescriptor(profiler::ON,
+        EASY_UNIQUE_LINE_ID, profiler::ASYNC_SPAN_VALUE_NAME, __FILE__, __LINE__, profiler::BlockType::Value,
+        EASY_COLOR_INTERNAL_EVENT));
+
+    // Reader links blocks to the block which ends later and begins earlier than them,
+    // so the segment must be at least 1 tick long to become the parent of its span id value.
+    if (_endTime <= _beginTime)
+        _endTime = _beginTime + 1;
+
+    // Span id value is stored at the end of the segment, so the reader attaches it to the segment block
+    // (see BlocksTree::parent and collectAsyncSpans)
+    THIS_THREAD->storeCompactValue(_endTime, spanDesc->id(), profiler::DataType::Uint64, _spanId, _spanId);
+    THIS_THREAD->storeBlock(profiler::Block(_beginTime, _endTime, _desc->id(), _runtimeName));
+    THIS_THREAD->putMarkIfEmpty();
+}
+
+uint64_t ProfileManager::newAsyncSpanId()
+{
+    return m_asyncSpanId.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 bool ProfileManager::storeBlock(const profiler::BaseBlockDescriptor* _desc, const char* _runtimeName)
 {
+    const InternalCodeGuard internalCodeGuard;
     if (!isEnabled() || (_desc->m_status & profiler::ON) == 0)
         return false;
 
@@ -500,6 +793,7 @@ bool ProfileManager::storeBlock(const profiler::BaseBlockDescriptor* _desc, cons
 bool ProfileManager::storeBlock(const profiler::BaseBlockDescriptor* _desc, const char* _runtimeName,
                                 profiler::timestamp_t _beginTime, profiler::timestamp_t _endTime)
 {
+    const InternalCodeGuard internalCodeGuard;
     if (!isEnabled() || (_desc->m_status & profiler::ON) == 0)
         return false;
 
@@ -529,6 +823,7 @@ bool ProfileManager::storeBlock(const profiler::BaseBlockDescriptor* _desc, cons
 void ProfileManager::storeBlockForce(const profiler::BaseBlockDescriptor* _desc, const char* _runtimeName,
                                      profiler::timestamp_t& _timestamp)
 {
+    const InternalCodeGuard internalCodeGuard;
     if ((_desc->m_status & profiler::ON) == 0)
         return;
 
@@ -548,6 +843,7 @@ void ProfileManager::storeBlockForce(const profiler::BaseBlockDescriptor* _desc,
 void ProfileManager::storeBlockForce2(const profiler::BaseBlockDescriptor* _desc, const char* _runtimeName,
                                       profiler::timestamp_t _timestamp)
 {
+    const InternalCodeGuard internalCodeGuard;
     if ((_desc->m_status & profiler::ON) == 0)
         return;
 
@@ -567,6 +863,7 @@ void ProfileManager::storeBlockForce2(const profiler::BaseBlockDescriptor* _desc
 
 void ProfileManager::beginBlock(profiler::Block& _block)
 {
+    const InternalCodeGuard internalCodeGuard;
     if (THIS_THREAD == nullptr)
         registerThread();
 
@@ -618,10 +915,19 @@ void ProfileManager::beginBlock(profiler::Block& _block)
         beginFrame(); // FPS counter
 
     THIS_THREAD->blocks.openedList.emplace_back(_block);
+
+    if (_block.m_status & profiler::ON)
+    {
+        // Counters are also closed on the first block after they were turned off
+        const auto counters = m_perfCounters.load(std::memory_order_relaxed);
+        if (counters != 0 || THIS_THREAD->perfCounters.requested() != 0)
+            THIS_THREAD->beginPerfCounters(counters);
+    }
 }
 
 void ProfileManager::beginNonScopedBlock(const profiler::BaseBlockDescriptor* _desc, const char* _runtimeName)
 {
+    const InternalCodeGuard internalCodeGuard;
     if (THIS_THREAD == nullptr)
         registerThread();
 
@@ -631,10 +937,9 @@ void ProfileManager::beginNonScopedBlock(const profiler::BaseBlockDescriptor* _d
 }
 
 void ProfileManager::beginContextSwitch(profiler::thread_id_t _thread_id, profiler::timestamp_t _time,
-                                        profiler::thread_id_t _target_thread_id, const char* _target_process,
-                                        bool _lockSpin)
+                                        profiler::thread_id_t _target_thread_id, const char* _target_process)
 {
-    auto ts = _lockSpin ? findThreadStorage(_thread_id) : _findThreadStorage(_thread_id);
+    auto ts = m_threads.find(_thread_id);
     if (ts != nullptr)
         // Dirty hack: _target_thread_id will be written to the field "block_id_t m_id"
         // and will be available calling method id().
@@ -645,6 +950,7 @@ void ProfileManager::beginContextSwitch(profiler::thread_id_t _thread_id, profil
 
 void ProfileManager::endBlock()
 {
+    const InternalCodeGuard internalCodeGuard;
     if (--THIS_THREAD->stackSize > 0)
     {
         // Just pop child blocks from stack until frame, which
@@ -670,7 +976,10 @@ void ProfileManager::endBlock()
     {
         if (!top.finished())
             top.finish();
-        THIS_THREAD->storeBlock(top);
+
+        uint64_t perfCounters[profiler::MAX_PERF_COUNTERS];
+        const bool measured = !THIS_THREAD->perfCountersStack.empty() && THIS_THREAD->endPerfCounters(perfCounters);
+        THIS_THREAD->storeBlock(top, measured ? perfCounters : nullptr);
     }
     else
     {
@@ -685,6 +994,7 @@ void ProfileManager::endBlock()
     if (currentThreadStack.empty())
     {
         THIS_THREAD->putMark();
+        THIS_THREAD->putLive();
         endFrame(); // FPS counter
 #if EASY_ENABLE_BLOCK_STATUS != 0
         THIS_THREAD->allowChildren = true;
@@ -697,7 +1007,7 @@ void ProfileManager::endBlock()
 }
 
 void ProfileManager::endContextSwitch(profiler::thread_id_t _thread_id, processid_t _process_id,
-                                      profiler::timestamp_t _endtime, bool _lockSpin)
+                                      profiler::timestamp_t _endtime)
 {
     ThreadStorage* ts = nullptr;
     if (_process_id == m_processId)
@@ -705,7 +1015,7 @@ void ProfileManager::endContextSwitch(profiler::thread_id_t _thread_id, processi
         // Implicit thread registration.
         // If thread owned by current process then create new ThreadStorage if there is no one
 #if EASY_OPTION_IMPLICIT_THREAD_REGISTRATION != 0
-        ts = _lockSpin ? &threadStorage(_thread_id) : &_threadStorage(_thread_id);
+        ts = &threadStorage(_thread_id);
 # if !defined(_WIN32) && !defined(EASY_CXX11_TLS_AVAILABLE)
 #  if EASY_OPTION_REMOVE_EMPTY_UNGUARDED_THREADS != 0
 #   pragma message "Warning: Implicit thread registration together with removing empty unguarded threads may cause application crash because there is no possibility to check thread state (dead or alive) for pthreads and removed ThreadStorage may be reused if thread is still alive."
@@ -718,7 +1028,7 @@ void ProfileManager::endContextSwitch(profiler::thread_id_t _thread_id, processi
     else
     {
         // If thread owned by another process OR _process_id IS UNKNOWN then do not create ThreadStorage for this
-        ts = _lockSpin ? findThreadStorage(_thread_id) : _findThreadStorage(_thread_id);
+        ts = m_threads.find(_thread_id);
     }
 
     if (ts == nullptr || ts->sync.openedList.empty())
@@ -855,6 +1165,16 @@ bool ProfileManager::isEventTracingEnabled() const
     return m_isEventTracingEnabled.load(std::memory_order_acquire);
 }
 
+void ProfileManager::setPerfCounters(uint32_t _counters)
+{
+    m_perfCounters.store(_counters & ((1U << profiler::PERF_COUNTERS_NUMBER) - 1), std::memory_order_release);
+}
+
+uint32_t ProfileManager::perfCounters() const
+{
+    return m_perfCounters.load(std::memory_order_acquire);
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 char ProfileManager::checkThreadExpired(ThreadStorage& _registeredThread)
@@ -904,6 +1224,7 @@ char ProfileManager::checkThreadExpired(ThreadStorage& _registeredThread)
 
 uint32_t ProfileManager::dumpBlocksToStream(std::ostream& _outputStream, bool _lockSpin, bool _async)
 {
+    const InternalCodeGuard internalCodeGuard;
     EASY_LOGMSG("dumpBlocksToStream(_lockSpin = " << _lockSpin << ")...\n");
 
     if (_lockSpin)
@@ -933,8 +1254,8 @@ uint32_t ProfileManager::dumpBlocksToStream(std::ostream& _outputStream, bool _l
     // Note: this means - wait for all ThreadStorage::storeBlock() to finish.
     std::this_thread::sleep_for(std::chrono::milliseconds(20));
 
-    // This is to make sure that no new descriptors or new threads will be
-    // added until we finish sending data.
+    // This is to make sure that no new descriptors will be added and no thread storages will be recycled
+    // until we finish sending data. New threads are registered without locks: they are just not dumped this time.
     m_spin.lock();
     m_storedSpin.lock();
     // This is the only place using both spins, so no dead-lock will occur
@@ -979,8 +1300,8 @@ uint32_t ProfileManager::dumpBlocksToStream(std::ostream& _outputStream, bool _l
                     return 0;
                 }
 
-                beginContextSwitch(thread_from, timestamp, thread_to, next_task_name.c_str(), false);
-                endContextSwitch(thread_to, (processid_t)process_to, timestamp, false);
+                beginContextSwitch(thread_from, timestamp, thread_to, next_task_name.c_str());
+                endContextSwitch(thread_to, (processid_t)process_to, timestamp);
                 EASY_LOG_ONLY(++num);
             }
 
@@ -996,10 +1317,15 @@ uint32_t ProfileManager::dumpBlocksToStream(std::ostream& _outputStream, bool _l
 
     bool mainThreadExpired = false;
 
+    // Threads to be dumped: storages of new threads could be published at any moment,
+    // so both passes below must iterate over the same threads
+    std::vector<ThreadStorage*> threads;
+    std::vector<ThreadStorage*> expiredThreads;
+
     // Calculate used memory total size and total blocks number
     uint64_t usedMemorySize = 0;
     uint32_t blocks_number = 0;
-    for (auto thread_it = m_threads.begin(), end = m_threads.end(); thread_it != end;)
+    for (auto storage = m_threads.head(); storage != nullptr; storage = storage->next)
     {
         if (_async && m_stopDumping.load(std::memory_order_acquire))
         {
@@ -1010,7 +1336,10 @@ uint32_t ProfileManager::dumpBlocksToStream(std::ostream& _outputStream, bool _l
             return 0;
         }
 
-        auto& thread = thread_it->second;
+        if (storage->state.load(std::memory_order_acquire) != THREAD_STORAGE_ACTIVE)
+            continue;
+
+        auto& thread = *storage;
         uint32_t num = thread.blocks.closedList.markedSize() + thread.sync.closedList.size();
         const char expired = ProfileManager::checkThreadExpired(thread);
 
@@ -1030,10 +1359,7 @@ uint32_t ProfileManager::dumpBlocksToStream(std::ostream& _outputStream, bool _l
 #endif
         {
             // Remove thread if it contains no profiled information and has been finished (or is not guarded --deprecated).
-            profiler::thread_id_t id = thread_it->first;
-            if (!mainThreadExpired && m_mainThreadId.compare_exchange_weak(id, 0, std::memory_order_release, std::memory_order_acquire))
-                mainThreadExpired = true;
-            m_threads.erase(thread_it++);
+            expiredThreads.push_back(storage);
             continue;
         }
 
@@ -1045,7 +1371,7 @@ uint32_t ProfileManager::dumpBlocksToStream(std::ostream& _outputStream, bool _l
 
         usedMemorySize += thread.blocks.usedMemorySize + thread.sync.usedMemorySize;
         blocks_number += num;
-        ++thread_it;
+        threads.push_back(storage);
     }
 
     // Write profiler signature and version
@@ -1074,7 +1400,7 @@ uint32_t ProfileManager::dumpBlocksToStream(std::ostream& _outputStream, bool _l
     write(_outputStream, m_descriptorsMemorySize);
     write(_outputStream, blocks_number);
     write(_outputStream, static_cast<uint32_t>(m_descriptors.size()));
-    write(_outputStream, static_cast<uint32_t>(m_threads.size()));
+    write(_outputStream, static_cast<uint32_t>(threads.size()));
     write(_outputStream, static_cast<uint16_t>(0)); // Bookmarks count (they can be created by user in the UI)
     write(_outputStream, static_cast<uint16_t>(0)); // padding
 
@@ -1093,7 +1419,7 @@ uint32_t ProfileManager::dumpBlocksToStream(std::ostream& _outputStream, bool _l
     }
 
     // Write blocks and context switch events for each thread
-    for (auto thread_it = m_threads.begin(), end = m_threads.end(); thread_it != end;)
+    for (auto storage : threads)
     {
         if (_async && m_stopDumping.load(std::memory_order_acquire))
         {
@@ -1104,9 +1430,9 @@ uint32_t ProfileManager::dumpBlocksToStream(std::ostream& _outputStream, bool _l
             return 0;
         }
 
-        auto& thread = thread_it->second;
+        auto& thread = *storage;
 
-        write(_outputStream, thread_it->first);
+        write(_outputStream, thread.id);
 
         const auto name_size = static_cast<uint16_t>(thread.name.size() + 1);
         write(_outputStream, name_size);
@@ -1127,20 +1453,16 @@ uint32_t ProfileManager::dumpBlocksToStream(std::ostream& _outputStream, bool _l
         if (thread.expired.load(std::memory_order_acquire) != 0)
         {
             // Remove expired thread after writing all profiled information
-            profiler::thread_id_t id = thread_it->first;
-            if (!mainThreadExpired && m_mainThreadId.compare_exchange_weak(id, 0, std::memory_order_release, std::memory_order_acquire))
-                mainThreadExpired = true;
-            m_threads.erase(thread_it++);
-        }
-        else
-        {
-            ++thread_it;
+            expiredThreads.push_back(storage);
         }
     }
 
     // End of threads section
     write(_outputStream, EASY_PROFILER_SIGNATURE);
 
+    for (auto storage : expiredThreads)
+        releaseThreadStorage(*storage, mainThreadExpired);
+
     m_storedSpin.unlock();
     m_spin.unlock();
 
@@ -1171,8 +1493,153 @@ uint32_t ProfileManager::dumpBlocksToFile(const char* _filename)
     return blocksNumber;
 }
 
+/** Write blocks which have been closed since the previous live portion.
+
+Portion has the same layout as a file written by dumpBlocksToStream() except that
+it contains only new block descriptors (starting from _sentDescriptors),
+context switch events are not written and there are no bookmarks:
+signature, version, pid, cpu frequency, begin time, current time,
+blocks memory size, descriptors memory size, blocks number,
+first descriptor index, descriptors number, threads number, descriptors,
+threads (id, name, blocks number, blocks) and a signature as the end mark.
+
+If _final is true then profiler is expected to be already disabled: all remaining
+closed blocks are taken directly from threads and live state of all threads is reset.
+*/
+uint32_t ProfileManager::writeLiveBlocks(std::ostream& _outputStream, uint32_t& _sentDescriptors, bool _final)
+{
+    const InternalCodeGuard internalCodeGuard;
+    struct LiveThread
+    {
+        std::string                      name;
+        ThreadStorage::LiveChunks      chunks;
+        profiler::thread_id_t              id;
+        uint32_t                 blocksNumber;
+    };
+
+    std::vector<LiveThread> portion;
+    uint64_t usedMemorySize = 0;
+    uint32_t blocksNumber = 0;
+    bool mainThreadExpired = false;
+
+    m_spin.lock();
+    for (auto storage = m_threads.head(); storage != nullptr; storage = storage->next)
+    {
+        if (storage->state.load(std::memory_order_acquire) != THREAD_STORAGE_ACTIVE)
+            continue;
+
+        auto& thread = *storage;
+
+        if (_final)
+            thread.storeLive();
+
+        {
+            profiler::guard_lock<profiler::spin_lock> lock(thread.liveSpin);
+            if (thread.liveBlocksNumber != 0)
+            {
+                portion.emplace_back();
+                auto& liveThread = portion.back();
+                liveThread.name = thread.name;
+                liveThread.chunks = std::move(thread.liveChunks);
+                liveThread.id = thread.id;
+                liveThread.blocksNumber = thread.liveBlocksNumber;
+
+                usedMemorySize += thread.liveMemorySize;
+                blocksNumber += thread.liveBlocksNumber;
+
+                thread.liveMemorySize = 0;
+                thread.liveBlocksNumber = 0;
+            }
+        }
+
+        if (!_final)
+        {
+            thread.liveRequested.store(true, std::memory_order_release);
+            continue;
+        }
+
+        // Blocks of unfinished frames and context switch events are not sent by live capture
+        thread.liveRequested.store(false, std::memory_order_release);
+        thread.blocks.closedList.clear();
+        thread.sync.closedList.clear();
+        thread.sync.openedList.clear();
+        thread.clearClosed();
+
+        if (thread.expired.load(std::memory_order_acquire) != 0)
+            releaseThreadStorage(thread, mainThreadExpired);
+    }
+    m_spin.unlock();
+
+    // Descriptors are written after taking threads data, so all blocks ids are guaranteed to be known
+    m_storedSpin.lock();
+
+    const auto descriptorsNumber = static_cast<uint32_t>(m_descriptors.size());
+    const auto firstDescriptor = std::min(_sentDescriptors, descriptorsNumber);
+
+    uint64_t descriptorsMemorySize = 0;
+    for (auto i = firstDescriptor; i < descriptorsNumber; ++i)
+    {
+        const auto descriptor = m_descriptors[i];
+        descriptorsMemorySize += sizeof(profiler::SerializedBlockDescriptor) + descriptor->nameSize() + descriptor->filenameSize();
+    }
+
+    write(_outputStream, EASY_PROFILER_SIGNATURE);
+    write(_outputStream, EASY_PROFILER_VERSION);
+    write(_outputStream, m_processId);
+
+#if defined(EASY_CHRONO_CLOCK) || defined(_WIN32)
+    write(_outputStream, m_cpuFrequency);
+#else
+    write(_outputStream, m_cpuFrequency.load(std::memory_order_acquire) * 1000LL);
+#endif
+
+    write(_outputStream, m_beginTime);
+    write(_outputStream, _final ? m_endTime : profiler::clock::now());
+
+    write(_outputStream, usedMemorySize);
+    write(_outputStream, descriptorsMemorySize);
+    write(_outputStream, blocksNumber);
+    write(_outputStream, firstDescriptor);
+    write(_outputStream, descriptorsNumber - firstDescriptor);
+    write(_outputStream, static_cast<uint32_t>(portion.size()));
+
+    for (auto i = firstDescriptor; i < descriptorsNumber; ++i)
+    {
+        const auto descriptor = m_descriptors[i];
+        const auto name_size = descriptor->nameSize();
+        const auto filename_size = descriptor->filenameSize();
+        const auto size = static_cast<uint16_t>(sizeof(profiler::SerializedBlockDescriptor) + name_size + filename_size);
+
+        write(_outputStream, size);
+        write<profiler::BaseBlockDescriptor>(_outputStream, *descriptor);
+        write(_outputStream, name_size);
+        write(_outputStream, descriptor->name(), name_size);
+        write(_outputStream, descriptor->filename(), filename_size);
+    }
+
+    _sentDescriptors = descriptorsNumber;
+    m_storedSpin.unlock();
+
+    for (auto& liveThread : portion)
+    {
+        write(_outputStream, liveThread.id);
+
+        const auto name_size = static_cast<uint16_t>(liveThread.name.size() + 1);
+        write(_outputStream, name_size);
+        write(_outputStream, liveThread.name.c_str(), name_size);
+
+        write(_outputStream, liveThread.blocksNumber);
+        liveThread.chunks.serialize(_outputStream);
+    }
+
+    write(_outputStream, EASY_PROFILER_SIGNATURE);
+
+    return blocksNumber;
+}
+
 void ProfileManager::registerThread()
 {
+    const InternalCodeGuard internalCodeGuard;
     THIS_THREAD = &threadStorage(getCurrentThreadId());
 
 #ifdef EASY_CXX11_TLS_AVAILABLE
@@ -1183,6 +1650,7 @@ void ProfileManager::registerThread()
 
 const char* ProfileManager::registerThread(const char* name, profiler::ThreadGuard& threadGuard)
 {
+    const InternalCodeGuard internalCodeGuard;
     if (THIS_THREAD == nullptr)
         THIS_THREAD = &threadStorage(getCurrentThreadId());
 
@@ -1214,6 +1682,7 @@ const char* ProfileManager::registerThread(const char* name, profiler::ThreadGua
 
 const char* ProfileManager::registerThread(const char* name)
 {
+    const InternalCodeGuard internalCodeGuard;
     if (THIS_THREAD == nullptr)
         THIS_THREAD = &threadStorage(getCurrentThreadId());
 
@@ -1394,302 +1863,645 @@ void ProfileManager::listen(uint16_t _port)
 
     EASY_LOGMSG("Listening started\n");
 
-    std::stringstream os(std::ios_base::out | std::ios_base::binary);
+    NetServer server;
+    FrameQueue dumpingQueue; // Blocks are queued by the dumping thread while this thread passes them to clients
     std::future<uint32_t> dumpingResult;
+    std::shared_ptr<DumpedBlocks> currentDump; // Blocks which are being dumped
+    std::unordered_map<uint32_t, DumpReceiver> receivers; // Clients which receive dumped blocks (by client id)
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+    std::shared_ptr<const SharedMemory> dumpedMemory; // Dumped blocks for local clients (written by the dumping thread)
+#endif
     bool dumping = false;
+    bool openFailed = false;
+
+    // Live capture state: closed frames are pushed to live clients every liveInterval milliseconds
+    std::chrono::steady_clock::time_point nextLiveTime;
+    uint32_t liveInterval = 0;
+    uint32_t liveDescriptors = 0;
+    bool live = false;
+
+    const auto& clients = server.clients();
+
+    const auto hasClients = [&clients](bool NetClient::* _state) -> bool {
+        for (const auto& client : clients)
+            if (!client->isClosed() && (*client).*_state)
+                return true;
+        return false;
+    };
+
+    const auto reply = [](NetClient& _client, profiler::net::MessageType _type) {
+        const profiler::net::Message message(_type);
+        _client.send(&message, sizeof(message));
+    };
+
+    const auto hasCurrentDumpReceivers = [&]() -> bool {
+        for (const auto& receiver : receivers)
+            if (receiver.second.blocks == currentDump)
+                return true;
+        return false;
+    };
 
     const auto stopDumping = [&] {
         dumping = false;
         m_stopDumping.store(true, std::memory_order_release);
         join(dumpingResult);
-        clear_sstream(os);
+        dumpingQueue.take();
+        currentDump.reset();
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+        dumpedMemory.reset();
+#endif
     };
 
-    EasySocket socket;
-    profiler::net::Message replyMessage(profiler::net::MessageType::Reply_Capturing_Started);
-
-    socket.bind(_port);
-    int bytes = 0;
-    while (!m_stopListen.load(std::memory_order_acquire))
-    {
-        if (dumping)
+    // Client does not wait for blocks anymore
+    const auto cancelDump = [&](NetClient& _client) {
+        _client.isWaitingDump = false;
+        receivers.erase(_client.id());
+        if (dumping && !hasCurrentDumpReceivers())
             stopDumping();
+    };
 
-        socket.listen();
-        socket.accept();
+    // Takes frames written by the dumping thread
+    const auto collectDumpedFrames = [&] {
+        auto frames = dumpingQueue.take();
+        currentDump->frames.insert(currentDump->frames.end(), std::make_move_iterator(frames.begin()),
+                                   std::make_move_iterator(frames.end()));
 
-        bool hasConnect = true;
+        if (dumpingResult.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready)
+            return;
 
-        // Send reply
-        {
-            const bool wasLowPriorityET =
-#ifdef _WIN32
-                EasyEventTracer::instance().isLowPriority();
-#else
-                false;
+        // The last frame is pushed after dumpBlocksToStream() has finished
+        join(dumpingResult);
+        frames = dumpingQueue.take();
+        currentDump->frames.insert(currentDump->frames.end(), std::make_move_iterator(frames.begin()),
+                                   std::make_move_iterator(frames.end()));
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+        currentDump->memory = std::move(dumpedMemory);
 #endif
-            const profiler::net::EasyProfilerStatus connectionReply(isEnabled(), isEventTracingEnabled(), wasLowPriorityET);
+        currentDump->isFinished = true;
+        currentDump.reset();
+        dumping = false;
+    };
 
-            bytes = socket.send(&connectionReply, sizeof(profiler::net::EasyProfilerStatus));
-            hasConnect = bytes > 0;
-        }
+    // Passes dumped blocks to the client while it keeps up. Returns true when all blocks have been queued.
+    const auto sendDumpedBlocks = [&](NetClient& _client, DumpReceiver& _receiver) -> bool {
+        auto& dump = *_receiver.blocks;
 
-        while (hasConnect && !m_stopListen.load(std::memory_order_acquire))
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+        if (dump.memory != nullptr)
         {
-            if (dumping)
+            // Local clients map the shared memory, others get frames with a copy of it
+            if (_client.isLocal())
             {
-                if (!dumpingResult.valid())
+                _client.send(dump.memory, profiler::net::MessageType::Reply_Blocks_Shared);
+                return true;
+            }
+
+            while (_receiver.position < dump.memory->size() && _client.queuedSize() <= DUMP_MAX_QUEUED_SIZE)
+            {
+                const auto size = std::min(static_cast<uint64_t>(NET_FRAME_SIZE), dump.memory->size() - _receiver.position);
+
+                FrameQueue queue;
                 {
-                    dumping = false;
-                    socket.setReceiveTimeout(0);
-                    clear_sstream(os);
+                    FrameStreamBuffer buffer(queue, profiler::net::MessageType::Reply_Blocks);
+                    buffer.sputn(dump.memory->data() + _receiver.position, static_cast<std::streamsize>(size));
                 }
-                else if (dumpingResult.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready)
-                {
-                    dumping = false;
-                    dumpingResult.get();
 
-                    const auto size = os.tellp();
-                    static const decltype(size) badSize = -1;
-                    if (size != badSize)
-                    {
-                        const profiler::net::DataMessage dm(static_cast<uint32_t>(size),
-                                                            profiler::net::MessageType::Reply_Blocks);
+                for (const auto& frame : queue.take())
+                    _client.send(frame);
 
-                        const size_t packet_size = sizeof(dm) + dm.size;
-                        std::string sendbuf;
-                        sendbuf.reserve(packet_size + 1);
+                _receiver.position += size;
+            }
 
-                        if (sendbuf.capacity() >= packet_size) // check if there is enough memory
-                        {
-                            sendbuf.append((const char*) &dm, sizeof(dm));
-                            sendbuf += os.str(); // TODO: Avoid double-coping data from stringstream!
-                            clear_sstream(os);
-
-                            bytes = socket.send(sendbuf.c_str(), packet_size);
-                            hasConnect = bytes > 0;
-                            if (!hasConnect)
-                                break;
-                        }
-                        else
-                        {
-                            EASY_ERROR("Can not send blocks. Not enough memory for allocating " << packet_size
-                                                                                                << " bytes");
-                            clear_sstream(os);
-                        }
-                    }
-                    else
-                    {
-                        EASY_ERROR("Can not send blocks. Bad std::stringstream.tellp() == -1");
-                        clear_sstream(os);
-                    }
+            return _receiver.position == dump.memory->size();
+        }
+#endif
 
-                    replyMessage.type = profiler::net::MessageType::Reply_Blocks_End;
-                    bytes = socket.send(&replyMessage, sizeof(replyMessage));
-                    hasConnect = bytes > 0;
-                    if (!hasConnect)
-                        break;
+        while (_receiver.position < dump.frames.size() && _client.queuedSize() <= DUMP_MAX_QUEUED_SIZE)
+            _client.send(dump.frames[static_cast<size_t>(_receiver.position++)]);
 
-                    socket.setReceiveTimeout(0);
-                }
-            }
+        return dump.isFinished && _receiver.position == dump.frames.size();
+    };
 
-            char buffer[256] = {};
-            bytes = socket.receive(buffer, 255);
+    // Passes dumped blocks to all receivers and releases frames which all receivers have got
+    const auto sendDumps = [&] {
+        const auto now = std::chrono::steady_clock::now();
 
-            hasConnect = socket.isConnected();
-            if (!hasConnect || bytes < static_cast<int>(sizeof(profiler::net::Message)))
+        for (const auto& client : clients)
+        {
+            auto it = receivers.find(client->id());
+            if (client->isClosed() || it == receivers.end())
                 continue;
 
-            auto message = (const profiler::net::Message*)buffer;
-            if (!message->isEasyNetMessage())
+            auto& receiver = it->second;
+            if (client->queuedSize() < receiver.queuedSize)
+                receiver.readTime = now;
+
+            if (sendDumpedBlocks(*client, receiver))
+            {
+                client->isWaitingDump = false;
+                reply(*client, profiler::net::MessageType::Reply_Blocks_End);
+                receivers.erase(it);
                 continue;
+            }
+
+            receiver.queuedSize = client->queuedSize();
 
-            switch (message->type)
+            // Client which does not read data would keep the dump in memory forever
+            if (receiver.queuedSize != 0 && now - receiver.readTime > std::chrono::milliseconds(DUMP_STALL_TIMEOUT))
             {
-                case profiler::net::MessageType::Ping:
-                {
-                    EASY_LOGMSG("receive MessageType::Ping\n");
-                    break;
-                }
+                EASY_WARNING("Client " << client->id() << " does not read dumped blocks: disconnected\n");
+                client->close();
+                receivers.erase(it);
+            }
+        }
 
-                case profiler::net::MessageType::Request_MainThread_FPS:
-                {
-                    profiler::timestamp_t maxDuration = maxFrameDuration(), avgDuration = avgFrameDuration();
+        std::unordered_map<DumpedBlocks*, uint64_t> sent;
+        for (const auto& receiver : receivers)
+        {
+            auto& dump = *receiver.second.blocks;
+            auto result = sent.emplace(&dump, receiver.second.position);
+            if (!result.second)
+                result.first->second = std::min(result.first->second, receiver.second.position);
+        }
 
-                    maxDuration = ticks2us(maxDuration);
-                    avgDuration = ticks2us(avgDuration);
+        for (const auto& dump : sent)
+        {
+            for (auto& i = dump.first->released; i < dump.first->frames.size() && i < dump.second; ++i)
+                dump.first->frames[i].reset();
+        }
+    };
 
-                    const profiler::net::TimestampMessage reply(profiler::net::MessageType::Reply_MainThread_FPS,
-                                                                (uint32_t)maxDuration, (uint32_t)avgDuration);
+    // Sends a portion of live blocks to the _receiver or to all live clients if _receiver is nullptr
+    const auto sendLive = [&](bool _final, NetClient* _receiver) {
+        FrameQueue portion;
 
-                    bytes = socket.send(&reply, sizeof(profiler::net::TimestampMessage));
-                    hasConnect = bytes > 0;
+        {
+            FrameStreamBuffer frames(portion, profiler::net::MessageType::Reply_Live_Blocks);
+            std::ostream os(&frames);
+            writeLiveBlocks(os, liveDescriptors, _final);
+        }
 
-                    break;
-                }
+        const auto frames = portion.take();
+        const profiler::net::Message endMessage(profiler::net::MessageType::Reply_Live_Blocks_End);
+        const auto end = std::make_shared<const std::string>(reinterpret_cast<const char*>(&endMessage), sizeof(endMessage));
 
-                case profiler::net::MessageType::Request_Start_Capture:
-                {
-                    EASY_LOGMSG("receive MessageType::Request_Start_Capture\n");
+        for (const auto& client : clients)
+        {
+            if (_receiver != nullptr ? client.get() != _receiver : !client->isLive)
+                continue;
 
-                    profiler::timestamp_t t = 0;
-                    EASY_FORCE_EVENT(t, "StartCapture", EASY_COLOR_START, profiler::OFF);
+            for (const auto& frame : frames)
+                client->send(frame);
+            client->send(end);
+        }
+    };
 
-                    m_dumpSpin.lock();
-                    if (!m_profilerStatus.exchange(true, std::memory_order_acq_rel))
-                    {
-                        enableEventTracer();
-                        m_beginTime = t;
-                    }
+    // Stops live capture and sends the rest of blocks to the _receiver (they are dropped if _receiver is nullptr)
+    const auto stopLive = [&](NetClient* _receiver) {
+        live = false;
+
+        m_dumpSpin.lock();
+        if (m_profilerStatus.exchange(false, std::memory_order_acq_rel))
+        {
+            disableEventTracer();
+            m_endTime = profiler::clock::now();
+        }
+        EASY_FORCE_EVENT2(m_endTime, "StopCapture", EASY_COLOR_END, profiler::OFF);
+
+        // Wait for all operations which began before disabling profiler (the same as dumpBlocksToStream() does)
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        if (_receiver != nullptr)
+        {
+            sendLive(true, _receiver);
+        }
+        else
+        {
+            // All live clients have gone: just drop blocks which were not sent
+            std::ostream discard(nullptr);
+            writeLiveBlocks(discard, liveDescriptors, true);
+        }
+
+        m_dumpSpin.unlock();
+    };
+
+    const auto startCapture = [this] {
+        profiler::timestamp_t t = 0;
+        EASY_FORCE_EVENT(t, "StartCapture", EASY_COLOR_START, profiler::OFF);
+
+        m_dumpSpin.lock();
+        if (!m_profilerStatus.exchange(true, std::memory_order_acq_rel))
+        {
+            enableEventTracer();
+            m_beginTime = t;
+        }
+        m_dumpSpin.unlock();
+    };
+
+    // Dumps blocks once for all clients which are capturing or wait for the next dump
+    const auto startDumping = [&] {
+        m_dumpSpin.lock();
+        auto time = profiler::clock::now();
+        if (m_profilerStatus.exchange(false, std::memory_order_acq_rel))
+        {
+            disableEventTracer();
+            m_endTime = time;
+        }
+        EASY_FORCE_EVENT2(m_endTime, "StopCapture", EASY_COLOR_END, profiler::OFF);
+
+        dumping = true;
+        currentDump = std::make_shared<DumpedBlocks>();
+
+        bool sharedDump = false;
+        for (const auto& client : clients)
+        {
+            if (client->isCapturing || client->isWaitingNextDump)
+            {
+                client->isCapturing = false;
+                client->isWaitingNextDump = false;
+                client->isWaitingDump = true;
+                sharedDump |= client->isLocal();
+
+                auto& receiver = receivers[client->id()];
+                receiver.blocks = currentDump;
+                receiver.position = 0;
+                receiver.queuedSize = client->queuedSize();
+                receiver.readTime = std::chrono::steady_clock::now();
+            }
+        }
+
+        m_stopDumping.store(false, std::memory_order_release);
+
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+        // If there is a local client then blocks are written directly into shared memory
+        // which is passed to local clients without copying
+        dumpingResult = std::async(std::launch::async, [this, &dumpingQueue, &dumpedMemory, sharedDump]
+        {
+            if (sharedDump)
+            {
+                SharedMemoryBuffer memory;
+                if (memory.isValid())
+                {
+                    std::ostream os(&memory);
+
+                    auto result = dumpBlocksToStream(os, false, true);
                     m_dumpSpin.unlock();
 
-                    replyMessage.type = profiler::net::MessageType::Reply_Capturing_Started;
-                    bytes = socket.send(&replyMessage, sizeof(replyMessage));
-                    hasConnect = bytes > 0;
+                    dumpedMemory = memory.release();
+                    EASY_LOG_ONLY(if (dumpedMemory == nullptr) { EASY_ERROR("Can not write blocks to shared memory\n"); })
 
-                    break;
+                    return result;
                 }
+            }
+#else
+        (void)sharedDump;
+        dumpingResult = std::async(std::launch::async, [this, &dumpingQueue]
+        {
+#endif
+            // Blocks are queued by frames while each thread is being serialized
+            FrameStreamBuffer frames(dumpingQueue, profiler::net::MessageType::Reply_Blocks);
+            std::ostream os(&frames);
 
-                case profiler::net::MessageType::Request_Stop_Capture:
-                {
-                    EASY_LOGMSG("receive MessageType::Request_Stop_Capture\n");
+            auto result = dumpBlocksToStream(os, false, true);
+            m_dumpSpin.unlock();
 
-                    if (dumping)
-                        break;
+            os.flush();
 
-                    m_dumpSpin.lock();
-                    auto time = profiler::clock::now();
-                    if (m_profilerStatus.exchange(false, std::memory_order_acq_rel))
+            return result;
+        });
+    };
+
+    std::string buffer;
+    while (!m_stopListen.load(std::memory_order_acquire))
+    {
+        if (!server.isOpened() && !server.open(_port))
+        {
+            if (!openFailed)
+            {
+                openFailed = true;
+                EASY_ERROR("Can not listen port " << _port << "\n");
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(LISTEN_POLL_TIMEOUT));
+            continue;
+        }
+
+        openFailed = false;
+
+        int timeout = dumping || !receivers.empty() ? DUMP_POLL_TIMEOUT : LISTEN_POLL_TIMEOUT;
+        if (live)
+        {
+            // We have to wake up for sending portions
+            const int64_t untilLive = std::chrono::duration_cast<std::chrono::milliseconds>(nextLiveTime - std::chrono::steady_clock::now()).count();
+            timeout = static_cast<int>(std::max(std::min(untilLive, static_cast<int64_t>(timeout)), static_cast<int64_t>(0)));
+        }
+
+        const size_t accepted = server.poll(timeout);
+
+        // Send reply to new clients
+        if (accepted != 0)
+        {
+            const bool wasLowPriorityET =
+#ifdef _WIN32
+                EasyEventTracer::instance().isLowPriority();
+#else
+                false;
+#endif
+            const profiler::net::EasyProfilerStatus connectionReply(isEnabled(), isEventTracingEnabled(), wasLowPriorityET);
+
+            for (size_t i = clients.size() - accepted; i < clients.size(); ++i)
+            {
+                EASY_LOGMSG("Client " << clients[i]->id() << " connected\n");
+                clients[i]->send(&connectionReply, sizeof(profiler::net::EasyProfilerStatus));
+            }
+        }
+
+        for (const auto& clientPtr : clients)
+        {
+            auto& client = *clientPtr;
+            profiler::net::MessageType type;
+            while (!client.isClosed() && client.peekMessage(type))
+            {
+                if (dumping)
+                {
+                    if (type == profiler::net::MessageType::Request_Blocks_Description && client.isWaitingDump)
+                        cancelDump(client);
+
+                    // Dumping thread holds m_dumpSpin and m_storedSpin while it serializes blocks (it never waits for clients):
+                    // requests which need these locks are left in the incoming data until serialization is finished
+                    if (dumping && (type == profiler::net::MessageType::Request_Start_Capture ||
+                                    type == profiler::net::MessageType::Request_Blocks_Description ||
+                                    type == profiler::net::MessageType::Change_Block_Status))
                     {
-                        disableEventTracer();
-                        m_endTime = time;
+                        break;
                     }
-                    EASY_FORCE_EVENT2(m_endTime, "StopCapture", EASY_COLOR_END, profiler::OFF);
+                }
 
-                    dumping = true;
-                    socket.setReceiveTimeout(500); // We have to check if dumping ready or not
+                client.nextMessage(buffer);
+                auto message = reinterpret_cast<const profiler::net::Message*>(buffer.data());
+                switch (message->type)
+                {
+                    case profiler::net::MessageType::Ping:
+                    {
+                        EASY_LOGMSG("receive MessageType::Ping\n");
+                        break;
+                    }
 
-                    m_stopDumping.store(false, std::memory_order_release);
-                    dumpingResult = std::async(std::launch::async, [this, &os]
+                    case profiler::net::MessageType::Request_MainThread_FPS:
                     {
-                        auto result = dumpBlocksToStream(os, false, true);
-                        m_dumpSpin.unlock();
-                        return result;
-                    });
+                        profiler::timestamp_t maxDuration = maxFrameDuration(), avgDuration = avgFrameDuration();
 
-                    break;
-                }
+                        maxDuration = ticks2us(maxDuration);
+                        avgDuration = ticks2us(avgDuration);
 
-                case profiler::net::MessageType::Request_Blocks_Description:
-                {
-                    EASY_LOGMSG("receive MessageType::Request_Blocks_Description\n");
+                        const profiler::net::TimestampMessage fpsReply(profiler::net::MessageType::Reply_MainThread_FPS,
+                                                                       (uint32_t)maxDuration, (uint32_t)avgDuration);
+
+                        client.send(&fpsReply, sizeof(profiler::net::TimestampMessage));
+
+                        break;
+                    }
+
+                    case profiler::net::MessageType::Request_Current_Time:
+                    {
+                        EASY_LOGMSG("receive MessageType::Request_Current_Time\n");
+
+#if defined(EASY_CHRONO_CLOCK) || defined(_WIN32)
+                        const int64_t frequency = m_cpuFrequency;
+#else
+                        const int64_t frequency = m_cpuFrequency.load(std::memory_order_acquire) * 1000LL;
+#endif
 
-                    if (dumping)
-                        stopDumping();
+                        const profiler::net::ClockMessage clockReply(profiler::clock::now(), frequency);
+                        client.send(&clockReply, sizeof(profiler::net::ClockMessage));
 
-                    // Write profiler signature and version
-                    write(os, EASY_PROFILER_SIGNATURE);
-                    write(os, EASY_PROFILER_VERSION);
+                        break;
+                    }
 
-                    // Write block descriptors
-                    m_storedSpin.lock();
-                    write(os, static_cast<uint32_t>(m_descriptors.size()));
-                    write(os, m_descriptorsMemorySize);
-                    for (const auto descriptor : m_descriptors)
+                    case profiler::net::MessageType::Request_Start_Capture:
                     {
-                        const auto name_size = descriptor->nameSize();
-                        const auto filename_size = descriptor->filenameSize();
-                        const auto size = static_cast<uint16_t>(sizeof(profiler::SerializedBlockDescriptor)
-                                                                + name_size + filename_size);
-
-                        write(os, size);
-                        write<profiler::BaseBlockDescriptor>(os, *descriptor);
-                        write(os, name_size);
-                        write(os, descriptor->name(), name_size);
-                        write(os, descriptor->filename(), filename_size);
+                        EASY_LOGMSG("receive MessageType::Request_Start_Capture\n");
+
+                        startCapture();
+
+                        client.isCapturing = true;
+                        reply(client, profiler::net::MessageType::Reply_Capturing_Started);
+
+                        break;
                     }
-                    m_storedSpin.unlock();
-                    // END of Write block descriptors.
 
-                    const auto size = os.tellp();
-                    static const decltype(size) badSize = -1;
-                    if (size != badSize)
+                    case profiler::net::MessageType::Request_Start_Live_Capture:
                     {
-                        const profiler::net::DataMessage dm(static_cast<uint32_t>(size),
-                                                            profiler::net::MessageType::Reply_Blocks_Description);
+                        EASY_LOGMSG("receive MessageType::Request_Start_Live_Capture\n");
 
-                        const size_t packet_size = sizeof(dm) + dm.size;
-                        std::string sendbuf;
-                        sendbuf.reserve(packet_size + 1);
+                        if (dumping || client.isLive || client.isWaitingDump || client.isWaitingNextDump)
+                            break;
 
-                        if (sendbuf.capacity() >= packet_size) // check if there is enough memory
+                        if (!live && hasClients(&NetClient::isCapturing))
                         {
-                            sendbuf.append((const char*)&dm, sizeof(dm));
-                            sendbuf += os.str(); // TODO: Avoid double-coping data from stringstream!
-                            clear_sstream(os);
+                            // Live capture would take away blocks from clients which wait for a dump
+                            EASY_WARNING("Can not start live capture while other clients are capturing\n");
+                            break;
+                        }
+
+                        auto data = reinterpret_cast<const profiler::net::LiveCaptureMessage*>(message);
+                        const auto interval = std::max(data->interval, LIVE_MIN_INTERVAL);
 
-                            bytes = socket.send(sendbuf.c_str(), packet_size);
-                            //hasConnect = bytes > 0;
+                        if (!live)
+                        {
+                            startCapture();
+
+                            live = true;
+                            liveInterval = interval;
+                            nextLiveTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(liveInterval);
                         }
                         else
                         {
-                            EASY_ERROR("Can not send block descriptions. Not enough memory for allocating " << packet_size << " bytes");
+                            liveInterval = std::min(liveInterval, interval);
                         }
+
+                        liveDescriptors = 0; // all descriptors are sent with the next portion (new client has not got them yet)
+                        client.isLive = true;
+
+                        reply(client, profiler::net::MessageType::Reply_Capturing_Started);
+
+                        break;
                     }
-                    else
+
+                    case profiler::net::MessageType::Request_Stop_Capture:
                     {
-                        EASY_ERROR("Can not send block descriptions. Bad std::stringstream.tellp() == -1");
+                        EASY_LOGMSG("receive MessageType::Request_Stop_Capture\n");
+
+                        if (client.isWaitingDump || client.isWaitingNextDump)
+                            break;
+
+                        if (client.isLive)
+                        {
+                            // All closed frames have been already sent by live portions.
+                            // If this is the last live client then send the rest of blocks too.
+                            client.isLive = false;
+                            if (!hasClients(&NetClient::isLive))
+                                stopLive(&client);
+
+                            reply(client, profiler::net::MessageType::Reply_Blocks_End);
+
+                            break;
+                        }
+
+                        client.isCapturing = false;
+
+                        if (live)
+                        {
+                            EASY_WARNING("Can not dump blocks while live capture is active\n");
+                            reply(client, profiler::net::MessageType::Reply_Blocks_End);
+                            break;
+                        }
+
+                        if (dumping)
+                        {
+                            // Frames of the dump in progress are not retained for clients which have not been waiting for it:
+                            // this client gets blocks captured since the dump has begun by the next dump
+                            client.isWaitingNextDump = true;
+                            break;
+                        }
+
+                        // Blocks are dumped for this client and for all other clients which are capturing
+                        client.isWaitingNextDump = true;
+                        startDumping();
+
+                        break;
                     }
 
-                    replyMessage.type = profiler::net::MessageType::Reply_Blocks_Description_End;
-                    bytes = socket.send(&replyMessage, sizeof(replyMessage));
-                    hasConnect = bytes > 0;
+                    case profiler::net::MessageType::Request_Blocks_Description:
+                    {
+                        EASY_LOGMSG("receive MessageType::Request_Blocks_Description\n");
 
-                    break;
-                }
+                        if (client.isWaitingDump)
+                            cancelDump(client);
 
-                case profiler::net::MessageType::Change_Block_Status:
-                {
-                    auto data = reinterpret_cast<const profiler::net::BlockStatusMessage*>(message);
-                    EASY_LOGMSG("receive MessageType::ChangeBLock_Status id=" << data->id << " status=" << data->status << std::endl);
-                    setBlockStatus(data->id, static_cast<profiler::EasyBlockStatus>(data->status));
-                    break;
-                }
+                        client.isWaitingNextDump = false;
 
-                case profiler::net::MessageType::Change_Event_Tracing_Status:
-                {
-                    auto data = reinterpret_cast<const profiler::net::BoolMessage*>(message);
-                    EASY_LOGMSG("receive MessageType::Change_Event_Tracing_Status on=" << data->flag << std::endl);
-                    setEventTracingEnabled(data->flag);
-                    break;
-                }
+                        if (client.isLive)
+                            break;
 
-                case profiler::net::MessageType::Change_Event_Tracing_Priority:
-                {
+                        FrameQueue description;
+
+                        {
+                            FrameStreamBuffer frames(description, profiler::net::MessageType::Reply_Blocks_Description);
+                            std::ostream os(&frames);
+
+                            // Write profiler signature and version
+                            write(os, EASY_PROFILER_SIGNATURE);
+                            write(os, EASY_PROFILER_VERSION);
+
+                            // Write block descriptors
+                            m_storedSpin.lock();
+                            write(os, static_cast<uint32_t>(m_descriptors.size()));
+                            write(os, m_descriptorsMemorySize);
+                            for (const auto descriptor : m_descriptors)
+                            {
+                                const auto name_size = descriptor->nameSize();
+                                const auto filename_size = descriptor->filenameSize();
+                                const auto size = static_cast<uint16_t>(sizeof(profiler::SerializedBlockDescriptor)
+                                                                        + name_size + filename_size);
+
+                                write(os, size);
+                                write<profiler::BaseBlockDescriptor>(os, *descriptor);
+                                write(os, name_size);
+                                write(os, descriptor->name(), name_size);
+                                write(os, descriptor->filename(), filename_size);
+                            }
+                            m_storedSpin.unlock();
+                            // END of Write block descriptors.
+                        }
+
+                        for (const auto& frame : description.take())
+                            client.send(frame);
+
+                        reply(client, profiler::net::MessageType::Reply_Blocks_Description_End);
+
+                        break;
+                    }
+
+                    case profiler::net::MessageType::Change_Block_Status:
+                    {
+                        auto data = reinterpret_cast<const profiler::net::BlockStatusMessage*>(message);
+                        EASY_LOGMSG("receive MessageType::ChangeBLock_Status id=" << data->id << " status=" << data->status << std::endl);
+                        setBlockStatus(data->id, static_cast<profiler::EasyBlockStatus>(data->status));
+                        break;
+                    }
+
+                    case profiler::net::MessageType::Change_Event_Tracing_Status:
+                    {
+                        auto data = reinterpret_cast<const profiler::net::BoolMessage*>(message);
+                        EASY_LOGMSG("receive MessageType::Change_Event_Tracing_Status on=" << data->flag << std::endl);
+                        setEventTracingEnabled(data->flag);
+                        break;
+                    }
+
+                    case profiler::net::MessageType::Change_Event_Tracing_Priority:
+                    {
 #if defined(_WIN32) || EASY_OPTION_LOG_ENABLED != 0
-                    auto data = reinterpret_cast<const profiler::net::BoolMessage*>(message);
+                        auto data = reinterpret_cast<const profiler::net::BoolMessage*>(message);
 #endif
 
-                    EASY_LOGMSG("receive MessageType::Change_Event_Tracing_Priority low=" << data->flag << std::endl);
+                        EASY_LOGMSG("receive MessageType::Change_Event_Tracing_Priority low=" << data->flag << std::endl);
 
 #if defined(_WIN32)
-                    EasyEventTracer::instance().setLowPriority(data->flag);
+                        EasyEventTracer::instance().setLowPriority(data->flag);
 #endif
-                    break;
-                }
+                        break;
+                    }
 
-                default:
-                    break;
+                    default:
+                        break;
+                }
             }
         }
+
+        if (dumping)
+            collectDumpedFrames();
+
+        if (!receivers.empty())
+            sendDumps();
+
+        if (live && std::chrono::steady_clock::now() >= nextLiveTime)
+        {
+            nextLiveTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(liveInterval);
+
+            // Slow clients would not be flooded: blocks are kept in thread storages until clients read the previous portion
+            bool backlog = false;
+            for (const auto& client : clients)
+                backlog |= client->isLive && client->queuedSize() > LIVE_MAX_QUEUED_SIZE;
+
+            if (!backlog)
+                sendLive(false, nullptr);
+        }
+
+        server.flush();
+
+        server.removeClosed([&receivers](NetClient& _client) {
+            EASY_LOGMSG("Client " << _client.id() << " disconnected\n");
+            receivers.erase(_client.id());
+        });
+
+        if (live && !hasClients(&NetClient::isLive))
+            stopLive(nullptr);
+
+        if (dumping && !hasCurrentDumpReceivers())
+            stopDumping();
+
+        if (!dumping && !live && hasClients(&NetClient::isWaitingNextDump))
+            startDumping();
     }
 
+    if (live)
+        stopLive(nullptr);
+
     if (dumping)
-    {
-        m_stopDumping.store(true, std::memory_order_release);
-        join(dumpingResult);
-    }
+        stopDumping();
+
+    receivers.clear();
 
     EASY_LOGMSG("Listening stopped\n");
 }
@@ -56,7 +56,6 @@ The Apache License, Version 2.0 (the "License");
 #include "thread_storage.h"
 
 #include <atomic>
-#include <map>
 #include <ostream>
 #include <unordered_map>
 #include <thread>
@@ -83,7 +82,6 @@ class ProfileManager
 
     using atomic_timestamp_t    = std::atomic<profiler::timestamp_t>;
     using guard_lock_t          = profiler::guard_lock<profiler::spin_lock>;
-    using map_of_threads_stacks = std::map<profiler::thread_id_t, ThreadStorage>;
     using block_descriptors_t   = std::vector<BlockDescriptor*>;
     using descriptors_map_t     = std::unordered_map<profiler::string_with_hash, profiler::block_id_t>;
 
@@ -93,7 +91,7 @@ class ProfileManager
     const int64_t                      m_cpuFrequency;
 #endif
 
-    map_of_threads_stacks                   m_threads;
+    ThreadStorageList                       m_threads;
     block_descriptors_t                 m_descriptors;
     descriptors_map_t                m_descriptorsMap;
     uint64_t                  m_descriptorsMemorySize;
@@ -111,6 +109,8 @@ class ProfileManager
     profiler::spin_lock                  m_storedSpin;
     profiler::spin_lock                    m_dumpSpin;
     std::atomic<profiler::thread_id_t> m_mainThreadId;
+    std::atomic<uint32_t>              m_perfCounters;
+    std::atomic<uint64_t>               m_asyncSpanId;
     std::atomic_bool                 m_profilerStatus;
     std::atomic_bool          m_isEventTracingEnabled;
     std::atomic_bool             m_isAlreadyListening;
@@ -143,6 +143,10 @@ public:
                                                             bool _copyName = false);
 
     void storeValue(const profiler::BaseBlockDescriptor* _desc, profiler::DataType _type, const void* _data, uint16_t _size, bool _isArray, profiler::ValueId _vin);
+    void storeAllocation(bool _free, const void* _address, uint64_t _size);
+    void storeLock(bool _hold, const char* _lockName, profiler::timestamp_t _beginTime, profiler::timestamp_t _endTime);
+    void storeAsyncSegment(const profiler::BaseBlockDescriptor* _desc, const char* _runtimeName, uint64_t _spanId, profiler::timestamp_t _beginTime, profiler::timestamp_t _endTime);
+    uint64_t newAsyncSpanId();
     bool storeBlock(const profiler::BaseBlockDescriptor* _desc, const char* _runtimeName);
     bool storeBlock(const profiler::BaseBlockDescriptor* _desc, const char* _runtimeName, profiler::timestamp_t _beginTime, profiler::timestamp_t _endTime);
     void beginBlock(profiler::Block& _block);
@@ -160,6 +164,8 @@ public:
 
     void setEventTracingEnabled(bool _isEnable);
     bool isEventTracingEnabled() const;
+    void setPerfCounters(uint32_t _counters);
+    uint32_t perfCounters() const;
     uint32_t dumpBlocksToFile(const char* filename);
     const char* registerThread(const char* name, profiler::ThreadGuard& threadGuard);
     const char* registerThread(const char* name);
@@ -167,8 +173,10 @@ public:
     void setContextSwitchLogFilename(const char* name);
     const char* getContextSwitchLogFilename() const;
 
-    void beginContextSwitch(profiler::thread_id_t _thread_id, profiler::timestamp_t _time, profiler::thread_id_t _target_thread_id, const char* _target_process, bool _lockSpin = true);
-    void endContextSwitch(profiler::thread_id_t _thread_id, processid_t _process_id, profiler::timestamp_t _endtime, bool _lockSpin = true);
+    void recycleThreadStorage(ThreadStorage& _storage);
+
+    void beginContextSwitch(profiler::thread_id_t _thread_id, profiler::timestamp_t _time, profiler::thread_id_t _target_thread_id, const char* _target_process);
+    void endContextSwitch(profiler::thread_id_t _thread_id, processid_t _process_id, profiler::timestamp_t _endtime);
     void startListen(uint16_t _port);
     void stopListen();
     bool isListening() const;
@@ -189,6 +197,7 @@ private:
     void listen(uint16_t _port);
 
     uint32_t dumpBlocksToStream(std::ostream& _outputStream, bool _lockSpin, bool _async);
+    uint32_t writeLiveBlocks(std::ostream& _outputStream, uint32_t& _sentDescriptors, bool _final);
     void setBlockStatus(profiler::block_id_t _id, profiler::EasyBlockStatus _status);
 
     void registerThread();
@@ -204,20 +213,8 @@ private:
     void storeBlockForce(const profiler::BaseBlockDescriptor* _desc, const char* _runtimeName, ::profiler::timestamp_t& _timestamp);
     void storeBlockForce2(const profiler::BaseBlockDescriptor* _desc, const char* _runtimeName, ::profiler::timestamp_t _timestamp);
 
-    ThreadStorage& _threadStorage(profiler::thread_id_t _thread_id);
-    ThreadStorage* _findThreadStorage(profiler::thread_id_t _thread_id);
-
-    ThreadStorage& threadStorage(profiler::thread_id_t _thread_id)
-    {
-        guard_lock_t lock(m_spin);
-        return _threadStorage(_thread_id);
-    }
-
-    ThreadStorage* findThreadStorage(profiler::thread_id_t _thread_id)
-    {
-        guard_lock_t lock(m_spin);
-        return _findThreadStorage(_thread_id);
-    }
+    ThreadStorage& threadStorage(profiler::thread_id_t _thread_id);
+    void releaseThreadStorage(ThreadStorage& _storage, bool& _mainThreadExpired);
 
 }; // END of class ProfileManager.
 
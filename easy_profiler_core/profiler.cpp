@@ -75,6 +75,7 @@
                                           EASY_STRINGIFICATION(EASY_PROFILER_VERSION_PATCH)
 
 extern const uint32_t EASY_PROFILER_SIGNATURE = ('E' << 24) | ('a' << 16) | ('s' << 8) | 'y';
+extern const uint32_t EASY_MULTIPROCESS_SIGNATURE = ('E' << 24) | ('a' << 16) | ('s' << 8) | 'm';
 extern const uint32_t EASY_PROFILER_VERSION = (static_cast<uint32_t>(EASY_PROFILER_VERSION_MAJOR) << 24) |
                                               (static_cast<uint32_t>(EASY_PROFILER_VERSION_MINOR) << 16) |
                                                static_cast<uint32_t>(EASY_PROFILER_VERSION_PATCH);
@@ -218,6 +219,47 @@ PROFILER_API bool isEventTracingEnabled()
     return ProfileManager::instance().isEventTracingEnabled();
 }
 
+PROFILER_API void storeAllocation(const void* _address, size_t _size)
+{
+    ProfileManager::instance().storeAllocation(false, _address, _size);
+}
+
+PROFILER_API void storeDeallocation(const void* _address, size_t _size)
+{
+    ProfileManager::instance().storeAllocation(true, _address, _size);
+}
+
+PROFILER_API void storeLockWait(const char* _lockName, profiler::timestamp_t _beginTime, profiler::timestamp_t _endTime)
+{
+    ProfileManager::instance().storeLock(false, _lockName, _beginTime, _endTime);
+}
+
+PROFILER_API void storeLockHold(const char* _lockName, profiler::timestamp_t _beginTime, profiler::timestamp_t _endTime)
+{
+    ProfileManager::instance().storeLock(true, _lockName, _beginTime, _endTime);
+}
+
+PROFILER_API uint64_t newAsyncSpanId()
+{
+    return ProfileManager::instance().newAsyncSpanId();
+}
+
+PROFILER_API void storeAsyncSegment(const profiler::BaseBlockDescriptor* _desc, const char* _runtimeName, uint64_t _spanId,
+                                    profiler::timestamp_t _beginTime, profiler::timestamp_t _endTime)
+{
+    ProfileManager::instance().storeAsyncSegment(_desc, _runtimeName, _spanId, _beginTime, _endTime);
+}
+
+PROFILER_API void setPerfCounters(uint32_t _counters)
+{
+    ProfileManager::instance().setPerfCounters(_counters);
+}
+
+PROFILER_API uint32_t perfCounters()
+{
+    return ProfileManager::instance().perfCounters();
+}
+
 # ifdef _WIN32
 PROFILER_API void setLowPriorityEventTracing(bool _isLowPriority)
 {
@@ -328,6 +370,14 @@ PROFILER_API const char* registerThreadScoped(const char*, profiler::ThreadGuard
 PROFILER_API const char* registerThread(const char*) { return ""; }
 PROFILER_API void setEventTracingEnabled(bool) { }
 PROFILER_API bool isEventTracingEnabled() { return false; }
+PROFILER_API void storeAllocation(const void*, size_t) { }
+PROFILER_API void storeDeallocation(const void*, size_t) { }
+PROFILER_API void storeLockWait(const char*, profiler::timestamp_t, profiler::timestamp_t) { }
+PROFILER_API void storeLockHold(const char*, profiler::timestamp_t, profiler::timestamp_t) { }
+PROFILER_API uint64_t newAsyncSpanId() { return 0; }
+PROFILER_API void storeAsyncSegment(const profiler::BaseBlockDescriptor*, const char*, uint64_t, profiler::timestamp_t, profiler::timestamp_t) { }
+PROFILER_API void setPerfCounters(uint32_t) { }
+PROFILER_API uint32_t perfCounters() { return 0; }
 PROFILER_API void setLowPriorityEventTracing(bool) { }
 PROFILER_API bool isLowPriorityEventTracing(bool) { return false; }
 PROFILER_API void setContextSwitchLogFilename(const char*) { }
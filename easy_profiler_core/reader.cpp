@@ -51,7 +51,9 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstring>
 #include <deque>
 #include <fstream>
 #include <future>
@@ -59,17 +61,21 @@
 #include <limits>
 #include <map>
 #include <mutex>
+#include <sstream>
 #include <unordered_map>
+#include <unordered_set>
 #include <thread>
 
 #include <easy/reader.h>
 #include <easy/profiler.h>
 
 #include "hashed_cstr.h"
+#include "compact_value.h"
 
 //////////////////////////////////////////////////////////////////////////
 
 extern const uint32_t EASY_PROFILER_SIGNATURE;
+extern const uint32_t EASY_MULTIPROCESS_SIGNATURE;
 extern const uint32_t EASY_PROFILER_VERSION;
 
 # define EASY_VERSION_INT(v_major, v_minor, v_patch) ((static_cast<uint32_t>(v_major) << 24) | \
@@ -81,6 +87,7 @@ EASY_CONSTEXPR uint32_t EASY_V_100 = EASY_VERSION_INT(1, 0, 0); ///< in v1.0.0 s
 EASY_CONSTEXPR uint32_t EASY_V_130 = EASY_VERSION_INT(1, 3, 0); ///< in v1.3.0 changed sizeof(thread_id_t) uint32_t -> uint64_t
 EASY_CONSTEXPR uint32_t EASY_V_200 = EASY_VERSION_INT(2, 0, 0); ///< in v2.0.0 file header was slightly rearranged
 EASY_CONSTEXPR uint32_t EASY_V_210 = EASY_VERSION_INT(2, 1, 0); ///< in v2.1.0 user bookmarks were added
+EASY_CONSTEXPR uint32_t EASY_V_220 = EASY_VERSION_INT(2, 2, 0); ///< in v2.2.0 compact value records, performance counters of blocks and live streams were added
 
 # undef EASY_VERSION_INT
 
@@ -357,7 +364,7 @@ namespace profiler {
 
 //////////////////////////////////////////////////////////////////////////
 
-using IdMap = std::unordered_map<profiler::hashed_stdstring, profiler::block_id_t>;
+using IdMap = profiler::runtime_ids_t;
 using CsStatsMap = std::unordered_map<profiler::string_with_hash, Stats>;
 
 //////////////////////////////////////////////////////////////////////////
@@ -644,6 +651,130 @@ static void update_statistics_recursive(profiler::stats_map_t& _stats_map, profi
 
 //////////////////////////////////////////////////////////////////////////
 
+/** Adds values from root.events (starting from first_event) into root.values_by_id, root.values_by_name and
+root.values_by_block.
+
+Events of a thread are stored in time order, so new entries are simply appended to the end of each list.
+Values stored inside a block are grouped by the block index, so values of one call are found without traversing
+its subtree. */
+template <class TBlockAt>
+static void update_values_index(profiler::BlocksTreeRoot& root, size_t first_event,
+                                const profiler::descriptors_list_t& descriptors, TBlockAt block_at)
+{
+    // Cache lists by descriptor id to avoid constructing std::string key for every value
+    std::unordered_map<profiler::block_id_t, profiler::value_index_t*, estd::hash<profiler::block_id_t> > names;
+
+    for (auto it = root.events.begin() + first_event, end = root.events.end(); it != end; ++it)
+    {
+        const auto& tree = block_at(*it);
+        const auto id = tree.node->id();
+        const auto desc = descriptors[id];
+        if (desc->type() != profiler::BlockType::Value)
+            continue;
+
+        const profiler::ValueIndexEntry entry {tree.value->begin(), *it};
+        root.values_by_id[tree.value->value_id()].push_back(entry);
+
+        auto found = names.find(id);
+        if (found == names.end())
+            found = names.emplace(id, &root.values_by_name[desc->name()]).first;
+        found->second->push_back(entry);
+
+        if (tree.parent != ~0U)
+            root.values_by_block[tree.parent].push_back(entry);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+/** Accounts allocations and deallocations from root.events (starting from first_event) in root.allocations.
+
+Every allocation is accounted to its innermost enclosing block and to all blocks enclosing that one.
+Children are serialized before their parents (blocks are written in close order), so parent's index is always
+greater than child's index and totals are propagated to parents by one pass in ascending index order. */
+template <class TBlockAt>
+static void update_allocations(profiler::BlocksTreeRoot& root, size_t first_event,
+                               const profiler::descriptors_list_t& descriptors, TBlockAt block_at)
+{
+    enum : uint8_t { OTHER_VALUE = 0, ALLOCATION, DEALLOCATION };
+    std::unordered_map<profiler::block_id_t, uint8_t, estd::hash<profiler::block_id_t> > kinds;
+    profiler::allocations_t allocations;
+
+    for (auto it = root.events.begin() + first_event, end = root.events.end(); it != end; ++it)
+    {
+        const auto& tree = block_at(*it);
+        const auto id = tree.node->id();
+
+        auto found = kinds.find(id);
+        if (found == kinds.end())
+        {
+            const auto desc = descriptors[id];
+            uint8_t kind = OTHER_VALUE;
+            if (desc->type() == profiler::BlockType::Value)
+            {
+                if (strcmp(desc->name(), profiler::ALLOCATION_VALUE_NAME) == 0)
+                    kind = ALLOCATION;
+                else if (strcmp(desc->name(), profiler::DEALLOCATION_VALUE_NAME) == 0)
+                    kind = DEALLOCATION;
+            }
+
+            found = kinds.emplace(id, kind).first;
+        }
+
+        if (found->second == OTHER_VALUE)
+            continue;
+
+        auto& stats = allocations[tree.parent];
+        if (found->second == ALLOCATION)
+        {
+            ++stats.allocs;
+            const auto size = tree.value->template toValue<profiler::DataType::Uint64>();
+            if (size != nullptr)
+                stats.bytes += size->value();
+        }
+        else
+        {
+            ++stats.frees;
+        }
+    }
+
+    // Propagate totals to enclosing blocks: parents are inserted after current position and will be visited later
+    for (const auto& it : allocations)
+    {
+        if (it.first == ~0U)
+            continue;
+
+        const auto parent = block_at(it.first).parent;
+        if (parent == ~0U)
+            continue;
+
+        auto& stats = allocations[parent];
+        stats.bytes += it.second.bytes;
+        stats.allocs += it.second.allocs;
+        stats.frees += it.second.frees;
+    }
+
+    for (const auto& it : allocations)
+    {
+        auto& stats = root.allocations[it.first];
+        stats.bytes += it.second.bytes;
+        stats.allocs += it.second.allocs;
+        stats.frees += it.second.frees;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+/** Adds a copy of descriptor with id for blocks with a runtime name (see identification_table) and returns id of the copy. */
+static profiler::block_id_t add_runtime_descriptor(profiler::descriptors_list_t& descriptors, profiler::block_id_t id)
+{
+    const auto new_id = static_cast<profiler::block_id_t>(descriptors.size());
+    if (descriptors.capacity() == descriptors.size())
+        descriptors.reserve((descriptors.size() * 3) >> 1);
+    descriptors.push_back(descriptors[id]);
+    return new_id;
+}
+
 static bool update_progress(std::atomic<int>& progress, int new_value, std::ostream& _log)
 {
     auto oldprogress = progress.exchange(new_value, std::memory_order_release);
@@ -669,6 +800,47 @@ static void read(std::istream& inStream, T& value)
     read(inStream, (char*)&value, sizeof(T));
 }
 
+/** Read one record of blocks list into data.
+
+Compact value records (see CompactValue) are expanded into ArbitraryValue.
+Files older than v2.2.0 have no compact records, so COMPACT_VALUE_FLAG is a part of the record size for them.
+
+\return size of the record in memory or 0 if there is not enough memory or the record is corrupted */
+static uint64_t readBlockRecord(std::istream& inStream, uint16_t sz, char* data, uint64_t available, uint32_t version,
+                                CompactValue::SeriesMap& value_series, std::vector<char>& buffer)
+{
+    if (version < EASY_V_220 || (sz & COMPACT_VALUE_FLAG) == 0)
+    {
+        if (sz > available)
+            return 0;
+
+        read(inStream, data, sz);
+        return sz;
+    }
+
+    sz &= RECORD_SIZE_MASK;
+    buffer.resize(sz);
+    read(inStream, buffer.data(), sz);
+
+    return CompactValue::expand(buffer.data(), sz, value_series, data, available);
+}
+
+/** Returns number of performance counters stored after the block name (0 if there are no counters or they are corrupted).
+
+Counters are stored only by v2.2.0 and newer, so older files must not be checked for them. */
+static uint8_t perf_counters_number(const profiler::SerializedBlock& block, uint64_t size)
+{
+    const auto name_size = sizeof(profiler::BaseBlockData) + strlen(block.name()) + 1;
+    if (size <= name_size)
+        return 0;
+
+    const auto number = static_cast<uint8_t>(block.data()[name_size]);
+    if (number > profiler::MAX_PERF_COUNTERS || size != name_size + profiler::perfCountersDataSize(number))
+        return 0;
+
+    return number;
+}
+
 static bool tryReadMarker(std::istream& inStream, uint32_t& marker)
 {
     read(inStream, marker);
@@ -819,6 +991,449 @@ static bool readHeader_v2_1(EasyFileHeader& _header, std::istream& inStream, std
 
 //////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+class MemoryStreamBuffer EASY_FINAL : public std::streambuf
+{
+public:
+
+    MemoryStreamBuffer(char* data, size_t size)
+    {
+        setg(data, data, data + size);
+    }
+
+}; // END of class MemoryStreamBuffer.
+
+struct ProcessCaptureData EASY_FINAL
+{
+    std::vector<char>                       capture; ///< Capture stream as stored in the container (released after reading)
+    std::string                                name;
+    std::ostringstream                          log;
+    profiler::SerializedData      serialized_blocks;
+    profiler::SerializedData serialized_descriptors;
+    profiler::descriptors_list_t        descriptors;
+    profiler::blocks_t                       blocks;
+    profiler::thread_blocks_tree_t            trees;
+    profiler::bookmarks_t                 bookmarks;
+    profiler::BeginEndTime           begin_end_time;
+    std::atomic<int>                       progress;
+    profiler::processid_t                       pid;
+    int64_t                            clock_offset;
+    uint32_t                      descriptors_count;
+    uint32_t                                version;
+    profiler::block_index_t            blocks_count;
+
+    ProcessCaptureData()
+        : begin_end_time()
+        , progress(0)
+        , pid(0)
+        , clock_offset(0)
+        , descriptors_count(0)
+        , version(0)
+        , blocks_count(0)
+    {
+    }
+
+}; // END of struct ProcessCaptureData.
+
+} // end of namespace <noname>.
+
+static void readProcessCapture(ProcessCaptureData& process, bool gather_statistics)
+{
+    uint32_t signature = 0;
+    if (process.capture.size() >= sizeof(signature))
+        memcpy(&signature, process.capture.data(), sizeof(signature));
+
+    if (signature != EASY_PROFILER_SIGNATURE)
+    {
+        process.log << "Wrong signature " << signature << ".\nThis is not EasyProfiler capture.";
+    }
+    else
+    {
+        MemoryStreamBuffer buffer(process.capture.data(), process.capture.size());
+        std::istream stream(&buffer);
+
+        // pid stored in the container is used (the same as pid of the capture for captures of profiler_aggregator)
+        profiler::processid_t capture_pid = 0;
+
+        process.blocks_count = fillTreesFromStream(process.progress, stream, process.begin_end_time,
+                                                   process.serialized_blocks, process.serialized_descriptors,
+                                                   process.descriptors, process.blocks, process.trees,
+                                                   process.bookmarks, process.descriptors_count, process.version,
+                                                   capture_pid, gather_statistics, process.log);
+    }
+
+    // Blocks are read into own memory, the capture is not needed anymore
+    std::vector<char>().swap(process.capture);
+}
+
+static profiler::block_index_t mergeProcessCaptures(std::atomic<int>& progress,
+                                                    std::vector<ProcessCaptureData>& processes,
+                                                    profiler::BeginEndTime& begin_end_time,
+                                                    profiler::SerializedData& serialized_blocks,
+                                                    profiler::SerializedData& serialized_descriptors,
+                                                    profiler::descriptors_list_t& descriptors,
+                                                    profiler::blocks_t& blocks,
+                                                    profiler::thread_blocks_tree_t& threaded_trees,
+                                                    profiler::bookmarks_t& bookmarks,
+                                                    uint32_t& descriptors_count,
+                                                    std::ostream& _log)
+{
+    EASY_FUNCTION(profiler::colors::Cyan);
+
+    // Real descriptors of all processes go first, then copies made for blocks with runtime names.
+    // So descriptors_count keeps its meaning for the merged capture.
+    uint64_t blocks_memory_size = 0, descriptors_memory_size = 0;
+    size_t total_descriptors = 0, total_blocks = 0;
+    descriptors_count = 0;
+    for (const auto& process : processes)
+    {
+        blocks_memory_size += process.serialized_blocks.size();
+        descriptors_memory_size += process.serialized_descriptors.size();
+        total_descriptors += process.descriptors.size();
+        total_blocks += process.blocks.size();
+        descriptors_count += process.descriptors_count;
+    }
+
+    serialized_blocks.set(blocks_memory_size);
+    serialized_descriptors.set(descriptors_memory_size);
+    descriptors.assign(total_descriptors, nullptr);
+    blocks.reserve(total_blocks);
+    threaded_trees.reserve(threaded_trees.size() + processes.size());
+
+    begin_end_time.beginTime = std::numeric_limits<profiler::timestamp_t>::max();
+    begin_end_time.endTime = 0;
+
+    uint64_t blocks_memory_offset = 0, descriptors_memory_offset = 0;
+    profiler::block_id_t real_offset = 0, copies_offset = descriptors_count;
+    profiler::block_index_t blocks_offset = 0;
+    int j = 0;
+
+    for (auto& process : processes)
+    {
+        const auto count = process.descriptors_count;
+        const auto remap = [&](profiler::block_id_t id) -> profiler::block_id_t {
+            return id < count ? real_offset + id : copies_offset + id - count;
+        };
+
+        // Time is unsigned, so negative offset is applied as modulo 2^64 addition
+        const auto time_shift = static_cast<profiler::timestamp_t>(process.clock_offset);
+
+        // Move descriptors
+        const char* old_base = process.serialized_descriptors.data();
+        char* new_base = serialized_descriptors[descriptors_memory_offset];
+        if (!process.serialized_descriptors.empty())
+            memcpy(new_base, old_base, process.serialized_descriptors.size());
+
+        for (profiler::block_id_t id = 0, size = static_cast<profiler::block_id_t>(process.descriptors.size()); id < size; ++id)
+        {
+            auto desc = process.descriptors[id];
+            if (desc == nullptr)
+                continue;
+
+            auto data = new_base + (desc->data() - old_base);
+            if (id < count)
+            {
+                // BaseBlockDescriptor::m_id is the first member
+                const auto new_id = remap(id);
+                memcpy(data, &new_id, sizeof(new_id));
+            }
+
+            descriptors[remap(id)] = reinterpret_cast<profiler::SerializedBlockDescriptor*>(data);
+        }
+
+        // Move blocks
+        old_base = process.serialized_blocks.data();
+        new_base = serialized_blocks[blocks_memory_offset];
+        if (!process.serialized_blocks.empty())
+            memcpy(new_base, old_base, process.serialized_blocks.size());
+
+        std::vector<char> is_cswitch(process.blocks.size(), 0);
+        for (const auto& it : process.trees)
+        {
+            for (auto index : it.second.sync)
+                is_cswitch[index] = 1;
+        }
+
+        // Statistics are shared between blocks with the same id, so they are collected first
+        // and shifted only once. Per frame statistics of context switches point to indices in root.sync.
+        std::unordered_set<profiler::BlockStatistics*> block_stats, cswitch_frame_stats;
+        const auto add_stats = [&block_stats](profiler::BlockStatistics* stats) {
+            if (stats != nullptr)
+                block_stats.insert(stats);
+        };
+
+        for (size_t i = 0, size = process.blocks.size(); i < size; ++i)
+        {
+            auto& tree = process.blocks[i];
+
+            auto data = new_base + (reinterpret_cast<const char*>(tree.node) - old_base);
+            tree.node = reinterpret_cast<profiler::SerializedBlock*>(data);
+
+            auto t_begin = reinterpret_cast<profiler::timestamp_t*>(data);
+            auto t_end = t_begin + 1;
+            *t_begin += time_shift;
+            *t_end += time_shift;
+
+            for (auto& child : tree.children)
+                child += blocks_offset;
+
+            if (tree.parent != ~0U)
+                tree.parent += blocks_offset;
+
+            add_stats(tree.per_thread_stats);
+            if (is_cswitch[i] != 0)
+            {
+                if (tree.per_frame_stats != nullptr)
+                    cswitch_frame_stats.insert(tree.per_frame_stats);
+            }
+            else
+            {
+                tree.node->setId(remap(tree.node->id()));
+                add_stats(tree.per_parent_stats);
+                add_stats(tree.per_frame_stats);
+            }
+
+            blocks.emplace_back(std::move(tree));
+        }
+
+        for (auto stats : block_stats)
+        {
+            stats->min_duration_block += blocks_offset;
+            stats->max_duration_block += blocks_offset;
+            if (stats->parent_block != ~0U)
+                stats->parent_block += blocks_offset;
+        }
+
+        for (auto stats : cswitch_frame_stats)
+            stats->parent_block += blocks_offset;
+
+        // Move threads
+        for (auto& it : process.trees)
+        {
+            auto& root = it.second;
+
+            for (auto& index : root.children)
+                index += blocks_offset;
+            for (auto& index : root.sync)
+                index += blocks_offset;
+            for (auto& index : root.events)
+                index += blocks_offset;
+
+            for (auto& values : root.values_by_id)
+            {
+                for (auto& entry : values.second)
+                {
+                    entry.time += time_shift;
+                    entry.block += blocks_offset;
+                }
+            }
+
+            for (auto& values : root.values_by_name)
+            {
+                for (auto& entry : values.second)
+                {
+                    entry.time += time_shift;
+                    entry.block += blocks_offset;
+                }
+            }
+
+            std::unordered_map<profiler::block_index_t, profiler::value_index_t> values_by_block;
+            for (auto& values : root.values_by_block)
+            {
+                for (auto& entry : values.second)
+                {
+                    entry.time += time_shift;
+                    entry.block += blocks_offset;
+                }
+
+                values_by_block.emplace(values.first + blocks_offset, std::move(values.second));
+            }
+            root.values_by_block = std::move(values_by_block);
+
+            profiler::allocations_t allocations;
+            for (const auto& stats : root.allocations)
+                allocations.emplace(stats.first != ~0U ? stats.first + blocks_offset : ~0U, stats.second);
+            root.allocations = std::move(allocations);
+
+            // Thread ids wider than 32 bits could collide with a key of another process: take the next free key
+            auto key = profiler::processThreadKey(process.pid, it.first);
+            while (threaded_trees.find(key) != threaded_trees.end())
+                ++key;
+
+            root.thread_id = key;
+            root.system_id = it.first;
+            root.process_id = process.pid;
+            root.process_name = process.name;
+
+            threaded_trees.emplace(root.thread_id, std::move(root));
+        }
+
+        for (auto& bookmark : process.bookmarks)
+        {
+            bookmark.pos += time_shift;
+            bookmarks.push_back(std::move(bookmark));
+        }
+
+        begin_end_time.beginTime = std::min(begin_end_time.beginTime, process.begin_end_time.beginTime + time_shift);
+        begin_end_time.endTime = std::max(begin_end_time.endTime, process.begin_end_time.endTime + time_shift);
+
+        blocks_memory_offset += process.serialized_blocks.size();
+        descriptors_memory_offset += process.serialized_descriptors.size();
+        real_offset += count;
+        copies_offset += static_cast<profiler::block_id_t>(process.descriptors.size()) - count;
+        blocks_offset += process.blocks_count;
+
+        process.serialized_blocks.clear();
+        process.serialized_descriptors.clear();
+
+        progress.store(90 + (10 * ++j) / static_cast<int>(processes.size()), std::memory_order_release);
+    }
+
+    std::sort(bookmarks.begin(), bookmarks.end(), [](const profiler::Bookmark& a, const profiler::Bookmark& b) {
+        return a.pos < b.pos;
+    });
+
+    if (blocks_offset == 0)
+        _log << "Profiled blocks number == 0";
+
+    return blocks_offset;
+}
+
+static profiler::block_index_t fillTreesFromProcessCaptures(std::atomic<int>& progress, std::istream& inStream,
+                                                            profiler::BeginEndTime& begin_end_time,
+                                                            profiler::SerializedData& serialized_blocks,
+                                                            profiler::SerializedData& serialized_descriptors,
+                                                            profiler::descriptors_list_t& descriptors,
+                                                            profiler::blocks_t& blocks,
+                                                            profiler::thread_blocks_tree_t& threaded_trees,
+                                                            profiler::bookmarks_t& bookmarks,
+                                                            uint32_t& descriptors_count,
+                                                            uint32_t& version,
+                                                            profiler::processid_t& pid,
+                                                            bool gather_statistics,
+                                                            std::ostream& _log)
+{
+    // Container layout is described in writer.h (see profiler::ProcessCapture)
+
+    version = 0;
+    read(inStream, version);
+    if (!isCompatibleVersion(version))
+    {
+        _log << "Incompatible version: v"
+             << (version >> 24) << "." << ((version & 0x00ff0000) >> 16) << "." << (version & 0x0000ffff);
+        return 0;
+    }
+
+    uint32_t processes_count = 0;
+    read(inStream, processes_count);
+    if (inStream.eof() || processes_count == 0)
+    {
+        _log << "Processes count == 0.\nNothing to read.";
+        return 0;
+    }
+
+    std::vector<ProcessCaptureData> processes(processes_count);
+    std::unordered_set<profiler::processid_t, estd::hash<profiler::processid_t> > pids;
+    std::vector<char> name;
+
+    uint32_t read_number = 0;
+    for (auto& process : processes)
+    {
+        uint16_t name_size = 0;
+        uint64_t capture_size = 0;
+
+        read(inStream, process.pid);
+        read(inStream, process.clock_offset);
+        read(inStream, name_size);
+        if (name_size != 0)
+        {
+            name.resize(name_size);
+            read(inStream, name.data(), name_size);
+            name.back() = 0;
+            process.name = name.data();
+        }
+
+        read(inStream, capture_size);
+        if (inStream.eof() || capture_size == 0)
+        {
+            _log << "Bad capture of process " << process.pid << ".\nFile corrupted.";
+            return 0;
+        }
+
+        if (!pids.insert(process.pid).second)
+        {
+            _log << "Process " << process.pid << " is stored more than once.\nFile corrupted.";
+            return 0;
+        }
+
+        process.capture.resize(static_cast<size_t>(capture_size));
+        read(inStream, process.capture.data(), process.capture.size());
+        if (inStream.fail())
+        {
+            _log << "File corrupted.\nActual capture size of process " << process.pid << " < size pointed in file.";
+            return 0;
+        }
+
+        if (!update_progress(progress, static_cast<int>(10 * ++read_number / processes_count), _log))
+            return 0; // Loading interrupted
+    }
+
+    // Captures are independent, read all of them at once
+    std::atomic<uint32_t> finished(0);
+    std::vector<std::thread> threads;
+    threads.reserve(processes_count);
+    for (auto& process : processes)
+    {
+        threads.emplace_back([&process, &finished, gather_statistics] {
+            readProcessCapture(process, gather_statistics);
+            finished.fetch_add(1, std::memory_order_release);
+        });
+    }
+
+    bool interrupted = false;
+    while (!interrupted && finished.load(std::memory_order_acquire) < processes_count)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        int processes_progress = 0;
+        for (const auto& process : processes)
+            processes_progress += std::max(process.progress.load(std::memory_order_acquire), 0);
+
+        if (!update_progress(progress, 10 + processes_progress * 80 / (100 * static_cast<int>(processes_count)), _log))
+        {
+            interrupted = true;
+            for (auto& process : processes)
+                process.progress.store(-1, std::memory_order_release);
+        }
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    if (interrupted || !update_progress(progress, 90, _log))
+        return 0; // Loading interrupted
+
+    for (const auto& process : processes)
+    {
+        if (process.blocks_count == 0)
+        {
+            _log << "Can not read capture of process " << process.pid;
+            if (!process.name.empty())
+                _log << " (" << process.name << ")";
+            _log << ":\n" << process.log.str();
+            return 0;
+        }
+    }
+
+    pid = processes.front().pid;
+
+    return mergeProcessCaptures(progress, processes, begin_end_time, serialized_blocks, serialized_descriptors,
+                                descriptors, blocks, threaded_trees, bookmarks, descriptors_count, _log);
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 extern "C" PROFILER_API profiler::block_index_t fillTreesFromFile(std::atomic<int>& progress, const char* filename,
                                                                   profiler::BeginEndTime& begin_end_time,
                                                                   profiler::SerializedData& serialized_blocks,
@@ -879,6 +1494,13 @@ extern "C" PROFILER_API profiler::block_index_t fillTreesFromStream(std::atomic<
     uint32_t signature = 0;
     if (!tryReadMarker(inStream, signature))
     {
+        if (signature == EASY_MULTIPROCESS_SIGNATURE)
+        {
+            return fillTreesFromProcessCaptures(progress, inStream, begin_end_time, serialized_blocks,
+                                                serialized_descriptors, descriptors, blocks, threaded_trees, bookmarks,
+                                                descriptors_count, version, pid, gather_statistics, _log);
+        }
+
         _log << "Wrong signature " << signature << ".\nThis is not EasyProfiler file/stream.";
         return 0;
     }
@@ -981,7 +1603,7 @@ extern "C" PROFILER_API profiler::block_index_t fillTreesFromStream(std::atomic<
     i = 0;
     uint32_t read_number = 0, threads_read_number = 0;
     profiler::block_index_t blocks_counter = 0;
-    std::vector<char> name;
+    std::vector<char> name, record_buffer;
 
     ReaderThreadPool pool;
 
@@ -1087,6 +1709,7 @@ extern "C" PROFILER_API profiler::block_index_t fillTreesFromStream(std::atomic<
             break;
 
         profiler::stats_map_t per_thread_statistics;
+        CompactValue::SeriesMap value_series;
 
         blocks_number_in_thread = 0;
         read(inStream, blocks_number_in_thread);
@@ -1105,15 +1728,15 @@ extern "C" PROFILER_API profiler::block_index_t fillTreesFromStream(std::atomic<
                 return 0;
             }
 
-            if (i + sz > memory_size)
+            char* data = serialized_blocks[i];
+            const auto size = readBlockRecord(inStream, sz, data, memory_size - i, version, value_series, record_buffer);
+            if (size == 0)
             {
-                _log << "File corrupted.\nActual blocks data size > size pointed in file.";
+                _log << "File corrupted.\nActual blocks data size > size pointed in file\nor bad value record.";
                 return 0;
             }
 
-            char* data = serialized_blocks[i];
-            read(inStream, data, sz);
-            i += sz;
+            i += size;
             auto baseData = reinterpret_cast<profiler::SerializedBlock*>(data);
             if (baseData->id() >= descriptors_count)
             {
@@ -1147,28 +1770,25 @@ extern "C" PROFILER_API profiler::block_index_t fillTreesFromStream(std::atomic<
                 tree.node = baseData;
                 const auto block_index = blocks_counter++;
 
+                if (version >= EASY_V_220 && desc->type() != profiler::BlockType::Value)
+                    tree.perf_counters = perf_counters_number(*baseData, size);
+
                 if (*tree.node->name() != 0)
                 {
                     // If block has runtime name then generate new id for such block.
-                    // Blocks with the same name will have same id.
+                    // Blocks with the same name and the same descriptor will have same id
+                    // (the same name could be used by blocks of different descriptors, e.g. waiting for a lock
+                    // and holding the lock, see profiler::mutex).
 
-                    IdMap::key_type key(tree.node->name());
+                    IdMap::key_type key(tree.node->name(), baseData->id());
                     auto it = identification_table.find(key);
-                    if (it != identification_table.end())
-                    {
-                        // There is already block with such name, use it's id
-                        baseData->setId(it->second);
-                    }
-                    else
+                    if (it == identification_table.end())
                     {
                         // There were no blocks with such name, generate new id and save it in the table for further usage.
-                        auto id = static_cast<profiler::block_id_t>(descriptors.size());
-                        identification_table.emplace(key, id);
-                        if (descriptors.capacity() == descriptors.size())
-                            descriptors.reserve((descriptors.size() * 3) >> 1);
-                        descriptors.push_back(descriptors[baseData->id()]);
-                        baseData->setId(id);
+                        it = identification_table.emplace(std::move(key), add_runtime_descriptor(descriptors, baseData->id())).first;
                     }
+
+                    baseData->setId(it->second);
                 }
 
                 if (!root.children.empty())
@@ -1202,6 +1822,7 @@ extern "C" PROFILER_API profiler::block_index_t fillTreesFromStream(std::atomic<
                             for (auto child_block_index : tree.children)
                             {
                                 auto& child = blocks[child_block_index];
+                                child.parent = block_index;
                                 child.per_parent_stats = update_statistics(per_parent_statistics, child, child_block_index, block_index, blocks);
                                 if (tree.depth < child.depth)
                                     tree.depth = child.depth;
@@ -1214,7 +1835,8 @@ extern "C" PROFILER_API profiler::block_index_t fillTreesFromStream(std::atomic<
                         {
                             for (auto child_block_index : tree.children)
                             {
-                                const auto& child = blocks[child_block_index];
+                                auto& child = blocks[child_block_index];
+                                child.parent = block_index;
                                 if (tree.depth < child.depth)
                                     tree.depth = child.depth;
                             }
@@ -1409,6 +2031,13 @@ extern "C" PROFILER_API profiler::block_index_t fillTreesFromStream(std::atomic<
 
                 ++root.depth;
 
+                const auto block_at = [&blocks](profiler::block_index_t index) -> const profiler::BlocksTree& {
+                    return blocks[index];
+                };
+
+                update_values_index(root, 0, descriptors, block_at);
+                update_allocations(root, 0, descriptors, block_at);
+
                 EASY_FINISH_ASYNC; // MSVC 2013 hack
             }));
         }
@@ -1452,6 +2081,13 @@ extern "C" PROFILER_API profiler::block_index_t fillTreesFromStream(std::atomic<
 
             ++root.depth;
 
+            const auto block_at = [&blocks](profiler::block_index_t index) -> const profiler::BlocksTree& {
+                return blocks[index];
+            };
+
+            update_values_index(root, 0, descriptors, block_at);
+            update_allocations(root, 0, descriptors, block_at);
+
             progress.store(90 + (10 * ++j) / n, std::memory_order_release);
         }
     }
@@ -1463,6 +2099,290 @@ extern "C" PROFILER_API profiler::block_index_t fillTreesFromStream(std::atomic<
 
 //////////////////////////////////////////////////////////////////////////
 
+extern "C" PROFILER_API bool appendTreesFromStream(std::istream& inStream,
+                                                    profiler::BeginEndTime& begin_end_time,
+                                                    profiler::SerializedData& serialized_portion,
+                                                    profiler::descriptors_list_t& descriptors,
+                                                    profiler::blocks_t& blocks,
+                                                    profiler::block_index_t blocks_offset,
+                                                    profiler::thread_blocks_tree_t& threaded_trees,
+                                                    profiler::LiveRuntimeIds& runtime_ids,
+                                                    uint32_t& version,
+                                                    profiler::processid_t& pid,
+                                                    std::ostream& _log)
+{
+    EASY_FUNCTION(profiler::colors::Cyan);
+
+    uint32_t signature = 0;
+    if (!tryReadMarker(inStream, signature))
+    {
+        _log << "Wrong signature " << signature << ".\nThis is not EasyProfiler live stream.";
+        return false;
+    }
+
+    version = 0;
+    read(inStream, version);
+    if (!isCompatibleVersion(version) || version < EASY_V_220)
+    {
+        _log << "Incompatible version: v"
+             << (version >> 24) << "." << ((version & 0x00ff0000) >> 16) << "." << (version & 0x0000ffff);
+        return false;
+    }
+
+    int64_t cpu_frequency = 0;
+    profiler::timestamp_t begin_time = 0, end_time = 0;
+    uint64_t memory_size = 0, descriptors_memory_size = 0;
+    uint32_t total_blocks_count = 0, first_descriptor = 0, descriptors_count = 0, threads_count = 0;
+
+    read(inStream, pid);
+    read(inStream, cpu_frequency);
+    read(inStream, begin_time);
+    read(inStream, end_time);
+    read(inStream, memory_size);
+    read(inStream, descriptors_memory_size);
+    read(inStream, total_blocks_count);
+    read(inStream, first_descriptor);
+    read(inStream, descriptors_count);
+    read(inStream, threads_count);
+
+    if (inStream.eof())
+    {
+        _log << "Live portion header is corrupted.";
+        return false;
+    }
+
+    const double conversion_factor = (cpu_frequency != 0 ? static_cast<double>(TIME_FACTOR) / static_cast<double>(cpu_frequency) : 1.);
+    if (cpu_frequency != 0)
+    {
+        EASY_CONVERT_TO_NANO(begin_time, cpu_frequency, conversion_factor);
+        EASY_CONVERT_TO_NANO(end_time, cpu_frequency, conversion_factor);
+    }
+
+    begin_end_time.beginTime = begin_time;
+    if (begin_end_time.endTime < end_time)
+        begin_end_time.endTime = end_time;
+
+    // Descriptors and blocks of one portion are stored in a single buffer which must live as long as blocks do
+    serialized_portion.set(descriptors_memory_size + memory_size);
+
+    const auto static_descriptors_count = first_descriptor + descriptors_count;
+    if (runtime_ids.descriptors_count < static_descriptors_count)
+    {
+        // Copies of descriptors for blocks with runtime names are stored after descriptors of profiled application.
+        // Move them up to free space for new descriptors.
+        const auto old_count = runtime_ids.descriptors_count;
+        const auto diff = static_descriptors_count - old_count;
+
+        if (descriptors.size() < old_count)
+            descriptors.resize(old_count, nullptr);
+        descriptors.insert(descriptors.begin() + old_count, diff, nullptr);
+
+        if (!runtime_ids.table.empty())
+        {
+            for (auto& it : runtime_ids.table)
+                it.second += diff;
+
+            for (auto& block : blocks)
+            {
+                if (block.node->id() >= old_count)
+                    block.node->setId(block.node->id() + diff);
+            }
+        }
+
+        runtime_ids.descriptors_count = static_descriptors_count;
+    }
+
+    uint64_t i = 0;
+    for (uint32_t k = 0; k < descriptors_count && !inStream.eof(); ++k)
+    {
+        uint16_t sz = 0;
+        read(inStream, sz);
+        if (sz == 0)
+            continue;
+
+        if (i + sz > descriptors_memory_size)
+        {
+            _log << "Live portion corrupted.\nActual descriptors data size > size pointed in header.";
+            return false;
+        }
+
+        char* data = serialized_portion[i];
+        read(inStream, data, sz);
+        descriptors[first_descriptor + k] = reinterpret_cast<profiler::SerializedBlockDescriptor*>(data);
+        i += sz;
+    }
+
+    // Blocks are stored right after descriptors
+    i = descriptors_memory_size;
+    const auto memory_end = descriptors_memory_size + memory_size;
+    const auto block_at = [&](profiler::block_index_t index) -> profiler::BlocksTree& {
+        return blocks[index - blocks_offset];
+    };
+
+    blocks.reserve(blocks.size() + total_blocks_count);
+
+    uint32_t read_number = 0, threads_read_number = 0;
+    std::vector<char> name, record_buffer;
+
+    while (!inStream.eof() && threads_read_number++ < threads_count)
+    {
+        profiler::thread_id_t thread_id = 0;
+        read(inStream, thread_id);
+        if (inStream.eof())
+            break;
+
+        auto& root = threaded_trees[thread_id];
+        root.thread_id = thread_id;
+
+        uint16_t name_size = 0;
+        read(inStream, name_size);
+        if (name_size != 0)
+        {
+            name.resize(name_size);
+            read(inStream, name.data(), name_size);
+            if (name.front() != 0)
+                root.thread_name = name.data();
+        }
+
+        // Frames are sent only after they are closed, so blocks of this portion
+        // never become parents for blocks of previous portions.
+        const auto first_new_child = root.children.size();
+        const auto first_new_event = root.events.size();
+        CompactValue::SeriesMap value_series;
+
+        uint32_t blocks_number_in_thread = 0;
+        read(inStream, blocks_number_in_thread);
+        const auto threshold = read_number + blocks_number_in_thread;
+        while (!inStream.eof() && read_number < threshold)
+        {
+            ++read_number;
+
+            uint16_t sz = 0;
+            read(inStream, sz);
+            if (sz == 0)
+            {
+                _log << "Bad block size == 0";
+                return false;
+            }
+
+            char* data = serialized_portion[i];
+            const auto size = readBlockRecord(inStream, sz, data, memory_end - i, version, value_series, record_buffer);
+            if (size == 0)
+            {
+                _log << "Live portion corrupted.\nActual blocks data size > size pointed in header\nor bad value record.";
+                return false;
+            }
+
+            i += size;
+
+            auto baseData = reinterpret_cast<profiler::SerializedBlock*>(data);
+            if (baseData->id() >= runtime_ids.descriptors_count || descriptors[baseData->id()] == nullptr)
+            {
+                _log << "Bad block id == " << baseData->id();
+                return false;
+            }
+
+            const auto desc = descriptors[baseData->id()];
+
+            if (*baseData->name() != 0)
+            {
+                // The same remapping as in fillTreesFromStream (see identification_table)
+                IdMap::key_type key(baseData->name(), baseData->id());
+                auto it = runtime_ids.table.find(key);
+                if (it == runtime_ids.table.end())
+                    it = runtime_ids.table.emplace(std::move(key), add_runtime_descriptor(descriptors, baseData->id())).first;
+
+                baseData->setId(it->second);
+            }
+
+            auto t_begin = reinterpret_cast<profiler::timestamp_t*>(data);
+            auto t_end = t_begin + 1;
+
+            if (cpu_frequency != 0)
+            {
+                EASY_CONVERT_TO_NANO(*t_begin, cpu_frequency, conversion_factor);
+                EASY_CONVERT_TO_NANO(*t_end, cpu_frequency, conversion_factor);
+            }
+
+            if (*t_end < begin_time)
+                continue;
+
+            if (*t_begin < begin_time)
+                *t_begin = begin_time;
+
+            blocks.emplace_back();
+            profiler::BlocksTree& tree = blocks.back();
+            tree.node = baseData;
+            const auto block_index = blocks_offset + static_cast<profiler::block_index_t>(blocks.size() - 1);
+
+            if (version >= EASY_V_220 && desc->type() != profiler::BlockType::Value)
+                tree.perf_counters = perf_counters_number(*baseData, size);
+
+            if (root.children.size() > first_new_child)
+            {
+                const auto mt0 = tree.node->begin();
+                if (mt0 < block_at(root.children.back()).node->end())
+                {
+                    const auto floor = root.children.begin() + first_new_child;
+                    auto lower = root.children.end() - 1;
+                    while (lower != floor && mt0 <= block_at(*(lower - 1)).node->begin())
+                        --lower;
+
+                    std::move(lower, root.children.end(), std::back_inserter(tree.children));
+                    root.children.erase(lower, root.children.end());
+
+                    for (auto child_block_index : tree.children)
+                    {
+                        auto& child = block_at(child_block_index);
+                        child.parent = block_index;
+                        if (tree.depth < child.depth)
+                            tree.depth = child.depth;
+                    }
+
+                    if (tree.depth == 254)
+                    {
+                        _log << "Stack depth exceeded value of 254\nfor block \"" << desc->name() << "\"";
+                        return false;
+                    }
+
+                    ++tree.depth;
+                }
+            }
+
+            ++root.blocks_number;
+            root.children.emplace_back(block_index);
+            if (desc->type() != profiler::BlockType::Block)
+                root.events.emplace_back(block_index);
+        }
+
+        for (auto it = root.children.begin() + first_new_child, end = root.children.end(); it != end; ++it)
+        {
+            const auto& frame = block_at(*it);
+
+            if (descriptors[frame.node->id()]->type() == profiler::BlockType::Block)
+                ++root.frames_number;
+
+            if (root.depth < frame.depth + 1)
+                root.depth = frame.depth + 1;
+
+            root.profiled_time += frame.node->duration();
+        }
+
+        update_values_index(root, first_new_event, descriptors, block_at);
+        update_allocations(root, first_new_event, descriptors, block_at);
+    }
+
+    if (!inStream.eof() && !tryReadMarker(inStream))
+    {
+        _log << "Bad threads section end mark.\nLive portion corrupted.";
+        return false;
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 extern "C" PROFILER_API bool readDescriptionsFromStream(std::atomic<int>& progress, std::istream& inStream,
                                                         profiler::SerializedData& serialized_descriptors,
                                                         profiler::descriptors_list_t& descriptors,
@@ -1546,6 +2466,176 @@ extern "C" PROFILER_API bool readDescriptionsFromStream(std::atomic<int>& progre
 
 //////////////////////////////////////////////////////////////////////////
 
+extern "C" PROFILER_API void collectLockStatistics(const profiler::blocks_t& _blocks,
+                                                   const profiler::thread_blocks_tree_t& threaded_trees,
+                                                   const profiler::descriptors_list_t& descriptors,
+                                                   profiler::lock_statistics_t& lock_statistics)
+{
+    enum : uint8_t { OTHER_BLOCK = 0, LOCK_WAIT, LOCK_HOLD };
+
+    std::vector<uint8_t> kinds(descriptors.size(), OTHER_BLOCK);
+    for (size_t i = 0; i < descriptors.size(); ++i)
+    {
+        const auto desc = descriptors[i];
+        if (desc == nullptr || desc->type() != profiler::BlockType::Block)
+            continue;
+
+        if (strcmp(desc->name(), profiler::LOCK_WAIT_BLOCK_NAME) == 0)
+            kinds[i] = LOCK_WAIT;
+        else if (strcmp(desc->name(), profiler::LOCK_HOLD_BLOCK_NAME) == 0)
+            kinds[i] = LOCK_HOLD;
+    }
+
+    lock_statistics.clear();
+
+    std::unordered_map<std::string, size_t> locks;
+    std::vector<std::unordered_map<profiler::block_id_t, size_t, estd::hash<profiler::block_id_t> > > waiters;
+
+    // Depth-first traversal of every thread: block index and descriptor id of the innermost enclosing
+    // block which is not a lock block (~0U for top-level blocks)
+    std::vector<std::pair<profiler::block_index_t, profiler::block_id_t> > stack;
+
+    for (const auto& it : threaded_trees)
+    {
+        for (auto child : it.second.children)
+            stack.emplace_back(child, ~0U);
+
+        while (!stack.empty())
+        {
+            const auto index = stack.back().first;
+            const auto waiterId = stack.back().second;
+            stack.pop_back();
+
+            const auto& tree = _blocks[index];
+            const auto id = tree.node->id();
+            const auto lockKind = id < kinds.size() ? kinds[id] : static_cast<uint8_t>(OTHER_BLOCK);
+
+            const auto childrenWaiterId = lockKind == OTHER_BLOCK ? id : waiterId;
+            for (auto child : tree.children)
+                stack.emplace_back(child, childrenWaiterId);
+
+            if (lockKind == OTHER_BLOCK)
+                continue;
+
+            auto found = locks.find(tree.node->name());
+            if (found == locks.end())
+            {
+                found = locks.emplace(tree.node->name(), lock_statistics.size()).first;
+                lock_statistics.emplace_back();
+                lock_statistics.back().name = tree.node->name();
+                waiters.emplace_back();
+            }
+
+            auto& stats = lock_statistics[found->second];
+            const auto duration = tree.node->duration();
+
+            if (lockKind == LOCK_HOLD)
+            {
+                stats.hold_time += duration;
+                ++stats.holds;
+                continue;
+            }
+
+            stats.wait_time += duration;
+            stats.max_wait = std::max(stats.max_wait, duration);
+            ++stats.waits;
+
+            auto& lockWaiters = waiters[found->second];
+            auto waiter = lockWaiters.find(waiterId);
+            if (waiter == lockWaiters.end())
+            {
+                waiter = lockWaiters.emplace(waiterId, stats.waiters.size()).first;
+                stats.waiters.push_back(profiler::LockWaiter {0, waiterId, 0});
+            }
+
+            auto& waiterStats = stats.waiters[waiter->second];
+            waiterStats.wait_time += duration;
+            ++waiterStats.waits;
+        }
+    }
+
+    for (auto& stats : lock_statistics)
+    {
+        std::sort(stats.waiters.begin(), stats.waiters.end(), [](const profiler::LockWaiter& a, const profiler::LockWaiter& b) {
+            return a.wait_time > b.wait_time;
+        });
+    }
+
+    std::sort(lock_statistics.begin(), lock_statistics.end(), [](const profiler::LockStatistics& a, const profiler::LockStatistics& b) {
+        return a.wait_time > b.wait_time;
+    });
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+extern "C" PROFILER_API void collectAsyncSpans(const profiler::blocks_t& _blocks,
+                                               const profiler::thread_blocks_tree_t& threaded_trees,
+                                               const profiler::descriptors_list_t& descriptors,
+                                               profiler::async_spans_t& async_spans)
+{
+    std::vector<uint8_t> isSpanValue(descriptors.size(), 0);
+    for (size_t i = 0; i < descriptors.size(); ++i)
+    {
+        const auto desc = descriptors[i];
+        if (desc != nullptr && desc->type() == profiler::BlockType::Value &&
+            strcmp(desc->name(), profiler::ASYNC_SPAN_VALUE_NAME) == 0)
+        {
+            isSpanValue[i] = 1;
+        }
+    }
+
+    async_spans.clear();
+    std::unordered_map<uint64_t, size_t> spans;
+
+    for (const auto& it : threaded_trees)
+    {
+        // Every segment block has a span id value as a child (see ProfileManager::storeAsyncSegment)
+        for (auto index : it.second.events)
+        {
+            const auto& tree = _blocks[index];
+            const auto id = tree.node->id();
+            if (id >= isSpanValue.size() || isSpanValue[id] == 0 || tree.parent == ~0U)
+                continue;
+
+            const auto spanId = tree.value->toValue<profiler::DataType::Uint64>();
+            if (spanId == nullptr)
+                continue;
+
+            auto found = spans.find(spanId->value());
+            if (found == spans.end())
+            {
+                found = spans.emplace(spanId->value(), async_spans.size()).first;
+                async_spans.emplace_back();
+                auto& span = async_spans.back();
+                span.id = spanId->value();
+                span.begin = std::numeric_limits<profiler::timestamp_t>::max();
+                span.end = 0;
+                span.active_time = 0;
+            }
+
+            const auto& segment = *_blocks[tree.parent].node;
+            auto& span = async_spans[found->second];
+            span.segments.push_back(profiler::AsyncSegment {tree.parent, it.first});
+            span.begin = std::min(span.begin, segment.begin());
+            span.end = std::max(span.end, segment.end());
+            span.active_time += segment.duration();
+        }
+    }
+
+    for (auto& span : async_spans)
+    {
+        std::sort(span.segments.begin(), span.segments.end(), [&_blocks](const profiler::AsyncSegment& a, const profiler::AsyncSegment& b) {
+            return _blocks[a.block].node->begin() < _blocks[b.block].node->begin();
+        });
+    }
+
+    std::sort(async_spans.begin(), async_spans.end(), [](const profiler::AsyncSpan& a, const profiler::AsyncSpan& b) {
+        return a.begin < b.begin;
+    });
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 #undef EASY_CONVERT_TO_NANO
 #undef EASY_FINISH_ASYNC
 
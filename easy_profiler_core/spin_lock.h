@@ -62,6 +62,10 @@ namespace profiler {
             EnterCriticalSection(&m_lock);
         }
 
+        bool try_lock() {
+            return TryEnterCriticalSection(&m_lock) != FALSE;
+        }
+
         void unlock() {
             LeaveCriticalSection(&m_lock);
         }
@@ -82,6 +86,10 @@ namespace profiler {
             while (m_lock.test_and_set(::std::memory_order_acquire));
         }
 
+        bool try_lock() {
+            return !m_lock.test_and_set(::std::memory_order_acquire);
+        }
+
         void unlock() {
             m_lock.clear(::std::memory_order_release);
         }
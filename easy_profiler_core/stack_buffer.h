@@ -100,6 +100,11 @@ public:
             destroy_elem(reinterpret_cast<T*>(elem.data + 0));
     }
 
+    bool empty() const
+    {
+        return m_size == 0 && m_overflow.empty();
+    }
+
     template <class ... TArgs>
     T& push(TArgs ... _args)
     {
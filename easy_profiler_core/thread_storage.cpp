@@ -58,7 +58,7 @@ namespace {
 EASY_CONSTEXPR uint16_t BASE_SIZE = static_cast<uint16_t>(sizeof(profiler::BaseBlockData) + 1U);
 
 #if EASY_OPTION_TRUNCATE_LONG_RUNTIME_NAMES != 0
-EASY_CONSTEXPR uint16_t MAX_BLOCK_NAME_LENGTH = BLOCK_CHUNK_SIZE - BASE_SIZE;
+EASY_CONSTEXPR uint16_t MAX_BLOCK_NAME_LENGTH = BLOCK_CHUNK_SIZE - BASE_SIZE - profiler::perfCountersDataSize(profiler::MAX_PERF_COUNTERS);
 #endif
 
 #if EASY_OPTION_CHECK_MAX_VALUE_DATA_SIZE != 0
@@ -78,17 +78,54 @@ profiler::vin_t ptr2vin(const void* ptr)
 
 } // end of namespace <noname>.
 
-ThreadStorage::ThreadStorage()
+ThreadStorage::ThreadStorage(profiler::thread_id_t _id)
     : nonscopedBlocks(16)
+    , liveMemorySize(0)
+    , liveBlocksNumber(0)
+    , valueSeriesEpoch(1)
+    , next(nullptr)
     , frameStartTime(0)
-    , id(getCurrentThreadId())
+    , id(_id)
     , stackSize(0)
     , allowChildren(true)
     , named(false)
     , guarded(false)
     , frameOpened(false)
 {
+    state = ATOMIC_VAR_INIT(THREAD_STORAGE_CLAIMED);
     expired = ATOMIC_VAR_INIT(0);
+    liveRequested = ATOMIC_VAR_INIT(false);
+}
+
+void ThreadStorage::reset(profiler::thread_id_t _id)
+{
+    while (!nonscopedBlocks.empty())
+        nonscopedBlocks.pop();
+
+    blocks.openedList.clear();
+    blocks.closedList.clear();
+    sync.openedList.clear();
+    sync.closedList.clear();
+    clearClosed();
+
+    liveChunks.clear();
+    liveMemorySize = 0;
+    liveBlocksNumber = 0;
+    liveRequested.store(false, std::memory_order_relaxed);
+
+    valueSeries.clear();
+    perfCounters.close();
+    perfCountersStack.clear();
+
+    name.clear();
+    frameStartTime = 0;
+    id = _id;
+    expired.store(0, std::memory_order_relaxed);
+    stackSize = 0;
+    allowChildren = true;
+    named = false;
+    guarded = false;
+    frameOpened = false;
 }
 
 void ThreadStorage::storeValue(
@@ -100,6 +137,12 @@ void ThreadStorage::storeValue(
     bool _isArray,
     profiler::ValueId _vin
 ) {
+    if (CompactValue::isCompact(_type, _isArray, _size))
+    {
+        storeCompactValue(_timestamp, _id, _type, CompactValue::load(_data, _type), ptr2vin(_vin.m_id));
+        return;
+    }
+
 #if EASY_OPTION_CHECK_MAX_VALUE_DATA_SIZE != 0
     if (_size > MAX_VALUE_DATA_SIZE)
     {
@@ -120,7 +163,36 @@ void ThreadStorage::storeValue(
     putMarkIfEmpty();
 }
 
-void ThreadStorage::storeBlock(const profiler::Block& block)
+void ThreadStorage::storeCompactValue(
+    profiler::timestamp_t _timestamp,
+    profiler::block_id_t _id,
+    profiler::DataType _type,
+    uint64_t _value,
+    profiler::vin_t _vin
+) {
+    if (valueSeries.size() <= _id)
+        valueSeries.resize(_id + 1);
+
+    auto& series = valueSeries[_id];
+    const auto previous = (series.epoch == valueSeriesEpoch && series.type == _type && series.vin == _vin) ? &series : nullptr;
+
+    const auto size = CompactValue::recordSize(_id, _timestamp, _value, _type, previous);
+    void* data = blocks.closedList.allocate(size, COMPACT_VALUE_FLAG);
+    CompactValue::write(static_cast<char*>(data), _id, _timestamp, _vin, _value, _type, previous);
+
+    series.time = _timestamp;
+    series.value = _value;
+    series.vin = _vin;
+    series.epoch = valueSeriesEpoch;
+    series.type = _type;
+
+    // Memory size is used by the reader which expands compact records
+    blocks.frameMemorySize += CompactValue::expandedSize(_type);
+
+    putMarkIfEmpty();
+}
+
+void ThreadStorage::storeBlock(const profiler::Block& block, const uint64_t* perfCountersValues)
 {
 #if EASY_OPTION_MEASURE_STORAGE_EXPAND != 0
     EASY_LOCAL_STATIC_PTR(const BaseBlockDescriptor*, desc, \
@@ -140,7 +212,8 @@ void ThreadStorage::storeBlock(const profiler::Block& block)
 #if EASY_OPTION_MEASURE_STORAGE_EXPAND == 0
     const 
 #endif
-    auto serializedDataSize = static_cast<uint16_t>(BASE_SIZE + nameLength);
+    auto serializedDataSize = static_cast<uint16_t>(BASE_SIZE + nameLength +
+        (perfCountersValues != nullptr ? profiler::perfCountersDataSize(perfCounters.number()) : 0));
 
 #if EASY_OPTION_MEASURE_STORAGE_EXPAND != 0
     const bool expanded = (desc->m_status & profiler::ON) && blocks.closedList.need_expand(serializedDataSize);
@@ -156,6 +229,16 @@ void ThreadStorage::storeBlock(const profiler::Block& block)
     ::new (data) profiler::SerializedBlock(block, nameLength);
     blocks.frameMemorySize += serializedDataSize;
 
+    if (perfCountersValues != nullptr)
+    {
+        // See profiler::perfCountersDataSize() for layout
+        const auto number = perfCounters.number();
+        auto counters = static_cast<char*>(data) + BASE_SIZE + nameLength;
+        *counters = static_cast<char>(number);
+        memcpy(counters + 1, perfCounters.ids(), number);
+        memcpy(counters + 1 + number, perfCountersValues, sizeof(uint64_t) * number);
+    }
+
 #if EASY_OPTION_MEASURE_STORAGE_EXPAND != 0
     if (expanded)
     {
@@ -194,6 +277,9 @@ void ThreadStorage::clearClosed()
 {
     blocks.clearClosed();
     sync.clearClosed();
+
+    // Serialized samples are gone, so next samples must not be stored as deltas
+    ++valueSeriesEpoch;
 }
 
 void ThreadStorage::popSilent()
@@ -204,10 +290,45 @@ void ThreadStorage::popSilent()
         top.m_end = top.m_begin;
         if (!top.m_isScoped)
             nonscopedBlocks.pop();
+
+        if (!perfCountersStack.empty() && perfCountersStack.back().depth == blocks.openedList.size())
+            perfCountersStack.pop_back();
+
         blocks.openedList.pop_back();
     }
 }
 
+void ThreadStorage::beginPerfCounters(uint32_t _counters)
+{
+    // Counters set is changed only when there are no measured blocks opened,
+    // so values of every block are always taken from the same counters
+    if (perfCounters.requested() != _counters && perfCountersStack.empty())
+        perfCounters.open(_counters);
+
+    if (perfCounters.number() == 0)
+        return;
+
+    perfCountersStack.emplace_back();
+    auto& sample = perfCountersStack.back();
+    sample.depth = blocks.openedList.size();
+    perfCounters.read(sample.values);
+}
+
+bool ThreadStorage::endPerfCounters(uint64_t* _deltas)
+{
+    if (perfCountersStack.empty() || perfCountersStack.back().depth != blocks.openedList.size())
+        return false;
+
+    perfCounters.read(_deltas);
+
+    const auto& sample = perfCountersStack.back();
+    for (uint8_t i = 0; i < perfCounters.number(); ++i)
+        _deltas[i] -= sample.values[i];
+
+    perfCountersStack.pop_back();
+    return true;
+}
+
 void ThreadStorage::beginFrame()
 {
     if (!frameOpened)
@@ -233,5 +354,199 @@ void ThreadStorage::putMark()
 void ThreadStorage::putMarkIfEmpty()
 {
     if (!frameOpened)
+    {
         putMark();
+        putLive();
+    }
+}
+
+void ThreadStorage::putLive()
+{
+    // Closed blocks are handed off only when there are no opened blocks,
+    // so a live portion never contains a part of an unfinished frame.
+    if (!liveRequested.load(std::memory_order_relaxed) || !blocks.openedList.empty())
+        return;
+
+    if (liveRequested.exchange(false, std::memory_order_acq_rel))
+        storeLive();
+}
+
+void ThreadStorage::storeLive()
+{
+    profiler::guard_lock<profiler::spin_lock> lock(liveSpin);
+
+    if (blocks.closedList.markedEmpty())
+        return;
+
+    // Chunks are handed off to the listening thread as is: serialization is not done by the profiled thread
+    liveBlocksNumber += blocks.closedList.markedSize();
+    liveMemorySize += blocks.usedMemorySize;
+    blocks.closedList.take(liveChunks);
+    blocks.usedMemorySize = 0;
+
+    // Each live portion is read separately
+    ++valueSeriesEpoch;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+ThreadStorageList::ThreadStorageList()
+{
+    for (auto& bucket : m_buckets)
+        bucket = ATOMIC_VAR_INIT(nullptr);
+    m_head = ATOMIC_VAR_INIT(nullptr);
+    m_freeNumber = ATOMIC_VAR_INIT(0);
+}
+
+ThreadStorageList::~ThreadStorageList()
+{
+    auto storage = m_head.load(std::memory_order_acquire);
+    while (storage != nullptr)
+    {
+        auto next = storage->next;
+        delete storage;
+        storage = next;
+    }
+
+    for (auto& bucket : m_buckets)
+    {
+        auto slot = bucket.load(std::memory_order_acquire);
+        while (slot != nullptr)
+        {
+            auto next = slot->next;
+            delete slot;
+            slot = next;
+        }
+    }
+}
+
+uint32_t ThreadStorageList::bucketIndex(profiler::thread_id_t _id)
+{
+    // Fibonacci hashing: thread ids are often sequential or aligned
+    static_assert(BUCKETS_NUMBER == 256, "bucketIndex() takes 8 upper bits of the hash");
+    return static_cast<uint32_t>((static_cast<uint64_t>(_id) * 0x9E3779B97F4A7C15ULL) >> 56);
+}
+
+ThreadStorageSlot* ThreadStorageList::findSlot(profiler::thread_id_t _id) const
+{
+    for (auto slot = m_buckets[bucketIndex(_id)].load(std::memory_order_acquire); slot != nullptr; slot = slot->next)
+    {
+        if (slot->id == _id)
+            return slot;
+    }
+
+    return nullptr;
+}
+
+ThreadStorageSlot& ThreadStorageList::slot(profiler::thread_id_t _id)
+{
+    auto& bucket = m_buckets[bucketIndex(_id)];
+
+    auto head = bucket.load(std::memory_order_acquire);
+    for (auto slot = head; slot != nullptr; slot = slot->next)
+    {
+        if (slot->id == _id)
+            return *slot;
+    }
+
+    auto newSlot = new ThreadStorageSlot(_id);
+    newSlot->next = head;
+    while (!bucket.compare_exchange_weak(newSlot->next, newSlot, std::memory_order_release, std::memory_order_acquire))
+    {
+        // Check only slots which have been published since the previous attempt
+        for (auto slot = newSlot->next; slot != head; slot = slot->next)
+        {
+            if (slot->id == _id)
+            {
+                delete newSlot;
+                return *slot;
+            }
+        }
+
+        head = newSlot->next;
+    }
+
+    return *newSlot;
+}
+
+ThreadStorage* ThreadStorageList::find(profiler::thread_id_t _id) const
+{
+    auto slot = findSlot(_id);
+    return slot != nullptr ? slot->storage.load(std::memory_order_acquire) : nullptr;
+}
+
+ThreadStorage& ThreadStorageList::claim(profiler::thread_id_t _id)
+{
+    if (m_freeNumber.load(std::memory_order_acquire) != 0)
+    {
+        // Recycle storage of an expired thread
+        for (auto storage = head(); storage != nullptr; storage = storage->next)
+        {
+            char state = THREAD_STORAGE_FREE;
+            if (storage->state.load(std::memory_order_relaxed) != THREAD_STORAGE_FREE ||
+                !storage->state.compare_exchange_strong(state, THREAD_STORAGE_CLAIMED, std::memory_order_acquire,
+                                                        std::memory_order_relaxed))
+            {
+                continue;
+            }
+
+            m_freeNumber.fetch_sub(1, std::memory_order_relaxed);
+            storage->reset(_id);
+
+            return *storage;
+        }
+    }
+
+    // Publish new storage: it is visible for iterating threads together with all its fields,
+    // but it is skipped by them until it becomes active
+    auto storage = new ThreadStorage(_id);
+    storage->next = m_head.load(std::memory_order_relaxed);
+    while (!m_head.compare_exchange_weak(storage->next, storage, std::memory_order_release, std::memory_order_relaxed));
+
+    return *storage;
+}
+
+void ThreadStorageList::retire(ThreadStorage& _storage)
+{
+    _storage.state.store(THREAD_STORAGE_FREE, std::memory_order_release);
+    m_freeNumber.fetch_add(1, std::memory_order_release);
+}
+
+ThreadStorage& ThreadStorageList::acquire(profiler::thread_id_t _id)
+{
+    auto& slot = this->slot(_id);
+
+    // Storage could be already claimed for context switch events of this thread
+    auto storage = slot.storage.load(std::memory_order_acquire);
+    if (storage != nullptr && storage->expired.load(std::memory_order_acquire) == 0)
+        return *storage;
+
+    auto& candidate = claim(_id);
+    while (!slot.storage.compare_exchange_weak(storage, &candidate, std::memory_order_acq_rel, std::memory_order_acquire))
+    {
+        if (storage != nullptr && storage->expired.load(std::memory_order_acquire) == 0)
+        {
+            // Another thread has claimed storage for this thread id first
+            retire(candidate);
+            return *storage;
+        }
+    }
+
+    // Storage of an expired thread with the same id (if any) stays active until it is dumped
+    candidate.state.store(THREAD_STORAGE_ACTIVE, std::memory_order_release);
+
+    return candidate;
+}
+
+void ThreadStorageList::release(ThreadStorage& _storage)
+{
+    auto slot = findSlot(_storage.id);
+    if (slot != nullptr)
+    {
+        // Slot could already own a storage of a new thread with the same id
+        auto storage = &_storage;
+        slot->storage.compare_exchange_strong(storage, nullptr, std::memory_order_acq_rel, std::memory_order_relaxed);
+    }
+
+    retire(_storage);
 }
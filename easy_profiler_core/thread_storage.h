@@ -53,6 +53,9 @@ The Apache License, Version 2.0 (the "License");
 #include <easy/serialized_block.h>
 
 #include "chunk_allocator.h"
+#include "compact_value.h"
+#include "perf_counters.h"
+#include "spin_lock.h"
 #include "stack_buffer.h"
 
 //////////////////////////////////////////////////////////////////////////
@@ -93,6 +96,14 @@ public:
 
 //////////////////////////////////////////////////////////////////////////
 
+struct PerfCountersSample
+{
+    uint64_t values[profiler::MAX_PERF_COUNTERS]; ///< Counters values at the beginning of a block
+    size_t                                 depth; ///< Size of blocks.openedList when the block has been opened
+};
+
+//////////////////////////////////////////////////////////////////////////
+
 EASY_CONSTEXPR uint16_t BLOCKS_IN_CHUNK = 128U;
 EASY_CONSTEXPR uint16_t SIZEOF_BLOCK = sizeof(profiler::BaseBlockData) + 1U + sizeof(uint16_t); // SerializedBlock stores BaseBlockData + at least 1 character for name ('\0') + 2 bytes for size of serialized data
 EASY_CONSTEXPR uint16_t SIZEOF_CSWITCH = sizeof(profiler::CSwitchEvent) + 1U + sizeof(uint16_t); // SerializedCSwitch also stores additional 4 bytes to be able to save 64-bit thread_id
@@ -106,8 +117,18 @@ EASY_CONSTEXPR uint16_t CSWITCH_CHUNK_SIZE = get_aligned_size<SIZEOF_BLOCK * BLO
 static_assert((BLOCK_CHUNK_SIZE % EASY_ALIGN_SIZE) == 0, "BLOCK_CHUNK_SIZE not aligned");
 static_assert((CSWITCH_CHUNK_SIZE % EASY_ALIGN_SIZE) == 0, "CSWITCH_CHUNK_SIZE not aligned");
 static_assert(BLOCK_CHUNK_SIZE > 2048, "wrong BLOCK_CHUNK_SIZE");
+static_assert(COMPACT_VALUE_FLAG == CHUNK_ELEMENT_FLAGS, "COMPACT_VALUE_FLAG must be stored in chunk element flags");
 static_assert(CSWITCH_CHUNK_SIZE > 2048, "wrong CSWITCH_CHUNK_SIZE");
 
+//////////////////////////////////////////////////////////////////////////
+
+enum ThreadStorageState : char
+{
+    THREAD_STORAGE_FREE = 0, ///< Storage of an expired thread which could be recycled
+    THREAD_STORAGE_CLAIMED,  ///< Storage is being prepared for a new thread
+    THREAD_STORAGE_ACTIVE    ///< Storage is used by a thread
+};
+
 struct ThreadStorage EASY_FINAL
 {
     using BlocksStorage = BlocksList<std::reference_wrapper<profiler::Block>, BLOCK_CHUNK_SIZE>;
@@ -117,9 +138,25 @@ struct ThreadStorage EASY_FINAL
     BlocksStorage                        blocks;
     ContextSwitchStorage                   sync;
 
+    using LiveChunks = chunk_allocator<BLOCK_CHUNK_SIZE>::taken_chunks;
+
+    profiler::spin_lock            liveSpin; ///< Protects live data which is taken by the listening thread
+    LiveChunks                   liveChunks; ///< Closed blocks for live capture since the last portion was taken (serialized by the listening thread)
+    uint64_t                 liveMemorySize; ///< Memory size of blocks stored in liveChunks
+    uint32_t               liveBlocksNumber; ///< Number of blocks stored in liveChunks
+    std::atomic_bool          liveRequested; ///< True if the listening thread waits for a new live portion
+
+    std::vector<CompactValue::Series> valueSeries; ///< Last samples of scalar values indexed by block id (see CompactValue)
+    uint32_t                    valueSeriesEpoch; ///< Series with another epoch are dropped (their samples were taken or cleared)
+
+    PerfCounters                         perfCounters; ///< Performance counters of this thread (see profiler::setPerfCounters())
+    std::vector<PerfCountersSample> perfCountersStack; ///< Counters values for opened blocks which are measured
+
     std::string                     name; ///< Thread name
+    ThreadStorage*                  next; ///< Next storage in ThreadStorageList (never changes after publication)
     profiler::timestamp_t frameStartTime; ///< Current frame start time. Used to calculate FPS.
-    const profiler::thread_id_t       id; ///< Thread ID
+    profiler::thread_id_t             id; ///< Thread ID (written only while the storage is not active, see ThreadStorageState)
+    std::atomic<char>              state; ///< State of this storage in ThreadStorageList (see ThreadStorageState)
     std::atomic<char>            expired; ///< Is thread expired
     int32_t                    stackSize; ///< Current thread stack depth. Used when switching profiler state to begin collecting blocks only when new frame would be opened.
     bool                   allowChildren; ///< False if one of previously opened blocks has OFF_RECURSIVE or ON_WITHOUT_CHILDREN status
@@ -128,18 +165,27 @@ struct ThreadStorage EASY_FINAL
     bool                     frameOpened; ///< Is new frame opened (this does not depend on profiling status) \sa profiledFrameOpened
 
     void storeValue(profiler::timestamp_t _timestamp, profiler::block_id_t _id, profiler::DataType _type, const void* _data, uint16_t _size, bool _isArray, profiler::ValueId _vin);
-    void storeBlock(const profiler::Block& _block);
+    void storeCompactValue(profiler::timestamp_t _timestamp, profiler::block_id_t _id, profiler::DataType _type, uint64_t _value, profiler::vin_t _vin);
+    void storeBlock(const profiler::Block& _block, const uint64_t* _perfCounters = nullptr);
     void storeBlockForce(const profiler::Block& _block);
     void storeCSwitch(const CSwitchBlock& _block);
     void clearClosed();
     void popSilent();
 
+    void beginPerfCounters(uint32_t _counters);
+    bool endPerfCounters(uint64_t* _deltas);
+
     void beginFrame();
     profiler::timestamp_t endFrame();
     void putMark();
     void putMarkIfEmpty();
+    void putLive();
+    void storeLive();
 
-    ThreadStorage();
+    /** Prepares recycled storage of an expired thread for thread _id. */
+    void reset(profiler::thread_id_t _id);
+
+    explicit ThreadStorage(profiler::thread_id_t _id);
     ThreadStorage(const ThreadStorage&) = delete;
     ThreadStorage(ThreadStorage&&) = delete;
 
@@ -147,4 +193,87 @@ struct ThreadStorage EASY_FINAL
 
 //////////////////////////////////////////////////////////////////////////
 
+/** Slot of thread id in ThreadStorageList hash table.
+
+Slots are never removed because system thread ids are reused. A slot owns the active storage of its thread:
+storage is claimed by compare-and-swap, so there is never more than one active storage for the same thread id. */
+struct ThreadStorageSlot EASY_FINAL
+{
+    ThreadStorageSlot*              next; ///< Next slot in the bucket (never changes after publication)
+    std::atomic<ThreadStorage*>  storage; ///< Active storage of the thread or nullptr
+    const profiler::thread_id_t       id; ///< Thread ID
+
+    explicit ThreadStorageSlot(profiler::thread_id_t _id) : next(nullptr), id(_id)
+    {
+        storage = ATOMIC_VAR_INIT(nullptr);
+    }
+
+    ThreadStorageSlot(const ThreadStorageSlot&) = delete;
+    ThreadStorageSlot(ThreadStorageSlot&&) = delete;
+
+}; // END of struct ThreadStorageSlot.
+
+//////////////////////////////////////////////////////////////////////////
+
+/** Lock-free list of thread storages.
+
+Storages are published through an intrusive singly linked list which only grows (so there is no ABA problem)
+and storages of expired threads are recycled for new threads instead of being freed. Registering a thread
+takes no global lock, so applications spawning a lot of short-lived threads do not contend with each other
+and with dumping thread.
+
+Active storages are also indexed by thread id (see ThreadStorageSlot) for lookups of context switch events.
+
+\note Storages and slots are freed only on destruction of the list. */
+class ThreadStorageList EASY_FINAL
+{
+    static EASY_CONSTEXPR uint32_t BUCKETS_NUMBER = 256;
+
+    std::atomic<ThreadStorageSlot*> m_buckets[BUCKETS_NUMBER]; ///< Hash table of thread ids (lock-free singly linked lists of slots)
+    std::atomic<ThreadStorage*>                        m_head; ///< The most recently allocated storage
+    std::atomic<uint32_t>                        m_freeNumber; ///< Number of storages which could be recycled
+
+public:
+
+    ThreadStorageList(const ThreadStorageList&) = delete;
+    ThreadStorageList& operator = (const ThreadStorageList&) = delete;
+
+    ThreadStorageList();
+    ~ThreadStorageList();
+
+    /** Returns the most recently allocated storage. Use ThreadStorage::next to iterate and skip not active storages. */
+    ThreadStorage* head() const
+    {
+        return m_head.load(std::memory_order_acquire);
+    }
+
+    /** Returns active storage of thread _id or nullptr if there is no one. */
+    ThreadStorage* find(profiler::thread_id_t _id) const;
+
+    /** Returns active storage of thread _id.
+
+    If there is no one (or it belongs to an expired thread) then a recycled storage of an expired thread
+    or a newly allocated one is claimed for thread _id. Concurrent calls for the same thread id return the same storage. */
+    ThreadStorage& acquire(profiler::thread_id_t _id);
+
+    /** Makes storage available for recycling. Nobody must use this storage after this call. */
+    void release(ThreadStorage& _storage);
+
+private:
+
+    static uint32_t bucketIndex(profiler::thread_id_t _id);
+
+    ThreadStorageSlot* findSlot(profiler::thread_id_t _id) const;
+    ThreadStorageSlot& slot(profiler::thread_id_t _id);
+
+    /** Returns storage in THREAD_STORAGE_CLAIMED state: recycled storage of an expired thread or a newly allocated one. */
+    ThreadStorage& claim(profiler::thread_id_t _id);
+
+    /** Returns claimed storage which has not been activated back for recycling. */
+    void retire(ThreadStorage& _storage);
+
+}; // END of class ThreadStorageList.
+
+//////////////////////////////////////////////////////////////////////////
+
 #endif // EASY_PROFILER_THREAD_STORAGE_H
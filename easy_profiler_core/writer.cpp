@@ -50,8 +50,10 @@
 ************************************************************************/
 
 #include <fstream>
+#include <sstream>
 #include <iterator>
 #include <algorithm>
+#include <map>
 
 #include <easy/writer.h>
 #include <easy/profiler.h>
@@ -61,6 +63,7 @@
 //////////////////////////////////////////////////////////////////////////
 
 extern const uint32_t EASY_PROFILER_SIGNATURE;
+extern const uint32_t EASY_MULTIPROCESS_SIGNATURE;
 extern const uint32_t EASY_PROFILER_VERSION;
 
 EASY_CONSTEXPR auto BaseCSwitchSize = sizeof(profiler::SerializedCSwitch) + 1;
@@ -250,9 +253,15 @@ static BlocksMemoryAndCount calculateUsedMemoryAndBlocksCount(const profiler::Bl
             uint64_t usedMemorySize = 0;
 
             if (desc.type() == profiler::BlockType::Value)
+            {
                 usedMemorySize = sizeof(profiler::ArbitraryValue) + child.value->data_size();
+            }
             else
+            {
                 usedMemorySize = sizeof(profiler::SerializedBlock) + strlen(child.node->name()) + 1;
+                if (child.perf_counters != 0)
+                    usedMemorySize += profiler::perfCountersDataSize(child.perf_counters);
+            }
 
             // Calculate children memory consumption
             const BlocksRange childRange(0, static_cast<profiler::block_index_t>(child.children.size()));
@@ -284,7 +293,8 @@ static BlocksMemoryAndCount calculateUsedMemoryAndBlocksCount(const profiler::Bl
 
 static void serializeBlocks(std::ostream& output, std::vector<char>& buffer,
                             const profiler::BlocksTree::children_t& children, const BlocksRange& range,
-                            const profiler::block_getter_fn& getter, const profiler::descriptors_list_t& descriptors)
+                            const profiler::block_getter_fn& getter, const profiler::descriptors_list_t& descriptors,
+                            profiler::block_id_t first_descriptor)
 {
     for (auto i = range.begin; i < range.end; ++i)
     {
@@ -292,7 +302,7 @@ static void serializeBlocks(std::ostream& output, std::vector<char>& buffer,
 
         // Serialize children
         const BlocksRange childRange(0, static_cast<profiler::block_index_t>(child.children.size()));
-        serializeBlocks(output, buffer, child.children, childRange, getter, descriptors);
+        serializeBlocks(output, buffer, child.children, childRange, getter, descriptors, first_descriptor);
 
         // Serialize self
         const auto& desc = *descriptors[child.node->id()];
@@ -304,21 +314,31 @@ static void serializeBlocks(std::ostream& output, std::vector<char>& buffer,
             buffer.resize(usedMemorySize + sizeof(uint16_t));
             unaligned_store16(buffer.data(), usedMemorySize);
             memcpy(buffer.data() + sizeof(uint16_t), child.value, static_cast<size_t>(usedMemorySize));
+
+            if (first_descriptor != 0)
+            {
+                // Value ids are stored at the same place as block ids (see profiler::BaseBlockData)
+                auto block = reinterpret_cast<profiler::SerializedBlock*>(buffer.data() + sizeof(uint16_t));
+                block->setId(desc.id() - first_descriptor);
+            }
         }
         else
         {
             usedMemorySize = static_cast<uint16_t>(sizeof(profiler::SerializedBlock)
                                                    + strlen(child.node->name()) + 1);
+            if (child.perf_counters != 0)
+                usedMemorySize += profiler::perfCountersDataSize(child.perf_counters);
 
             buffer.resize(usedMemorySize + sizeof(uint16_t));
             unaligned_store16(buffer.data(), usedMemorySize);
             memcpy(buffer.data() + sizeof(uint16_t), child.node, static_cast<size_t>(usedMemorySize));
 
-            if (child.node->id() != desc.id())
+            if (child.node->id() != desc.id() || first_descriptor != 0)
             {
-                // This block id is dynamic. Restore it's value like it was before in the input .prof file
+                // This block id is dynamic (or descriptors of the process are written from first_descriptor).
+                // Restore it's value like it was before in the input .prof file
                 auto block = reinterpret_cast<profiler::SerializedBlock*>(buffer.data() + sizeof(uint16_t));
-                block->setId(desc.id());
+                block->setId(desc.id() - first_descriptor);
             }
         }
 
@@ -346,10 +366,10 @@ static void serializeContextSwitches(std::ostream& output, std::vector<char>& bu
 
 static void serializeDescriptors(std::ostream& output, std::vector<char>& buffer,
                                  const profiler::descriptors_list_t& descriptors,
-                                 profiler::block_id_t descriptors_count)
+                                 profiler::block_id_t first_descriptor, profiler::block_id_t descriptors_end)
 {
-    const size_t size = std::min(descriptors.size(), static_cast<size_t>(descriptors_count));
-    for (size_t i = 0; i < size; ++i)
+    const size_t size = std::min(descriptors.size(), static_cast<size_t>(descriptors_end));
+    for (size_t i = first_descriptor; i < size; ++i)
     {
         const auto& desc = *descriptors[i];
         if (desc.id() != i)
@@ -362,10 +382,50 @@ static void serializeDescriptors(std::ostream& output, std::vector<char>& buffer
         unaligned_store16(buffer.data(), usedMemorySize);
         memcpy(buffer.data() + sizeof(uint16_t), &desc, static_cast<size_t>(usedMemorySize));
 
+        if (first_descriptor != 0)
+        {
+            // BaseBlockDescriptor::m_id is the first member
+            const profiler::block_id_t id = desc.id() - first_descriptor;
+            memcpy(buffer.data() + sizeof(uint16_t), &id, sizeof(id));
+        }
+
         write(output, buffer.data(), buffer.size());
     }
 }
 
+static uint64_t calculateDescriptorsMemory(const profiler::descriptors_list_t& descriptors,
+                                           profiler::block_id_t first_descriptor, profiler::block_id_t descriptors_end)
+{
+    uint64_t usedMemorySize = 0;
+
+    const size_t size = std::min(descriptors.size(), static_cast<size_t>(descriptors_end));
+    for (size_t i = first_descriptor; i < size; ++i)
+    {
+        const auto& desc = *descriptors[i];
+        if (desc.id() != i)
+            break;
+
+        usedMemorySize += sizeof(uint16_t) + sizeof(profiler::SerializedBlockDescriptor)
+                          + strlen(desc.name()) + strlen(desc.file()) + 2;
+    }
+
+    return usedMemorySize;
+}
+
+static void findUsedDescriptors(const profiler::BlocksTree::children_t& children, const profiler::block_getter_fn& getter,
+                                const profiler::descriptors_list_t& descriptors, profiler::block_id_t& first_descriptor,
+                                profiler::block_id_t& descriptors_end)
+{
+    for (auto index : children)
+    {
+        const auto& child = getter(index);
+        const auto id = descriptors[child.node->id()]->id();
+        first_descriptor = std::min(first_descriptor, id);
+        descriptors_end = std::max(descriptors_end, id + 1);
+        findUsedDescriptors(child.children, getter, descriptors, first_descriptor, descriptors_end);
+    }
+}
+
 static void serializeBookmarks(std::ostream& output, const profiler::bookmarks_t& bookmarks, const BlocksRange& range)
 {
     for (auto i = range.begin; i < range.end; ++i)
@@ -382,69 +442,37 @@ static void serializeBookmarks(std::ostream& output, const profiler::bookmarks_t
 
 //////////////////////////////////////////////////////////////////////////
 
-extern "C" PROFILER_API profiler::block_index_t writeTreesToFile(std::atomic<int>& progress, const char* filename,
-                                                                 const profiler::SerializedData& serialized_descriptors,
-                                                                 const profiler::descriptors_list_t& descriptors,
-                                                                 profiler::block_id_t descriptors_count,
-                                                                 const profiler::thread_blocks_tree_t& trees,
-                                                                 const profiler::bookmarks_t& bookmarks,
-                                                                 profiler::block_getter_fn block_getter,
-                                                                 profiler::timestamp_t begin_time,
-                                                                 profiler::timestamp_t end_time,
-                                                                 profiler::processid_t pid,
-                                                                 std::ostream& log)
-{
-    if (!update_progress_write(progress, 0, log))
-        return 0;
-
-    std::ofstream outFile(filename, std::fstream::binary);
-    if (!outFile.is_open())
-    {
-        log << "Can not open file " << filename;
-        return 0;
-    }
-
-    // Write data to file
-    auto result = writeTreesToStream(progress, outFile, serialized_descriptors, descriptors, descriptors_count, trees,
-                                     bookmarks, std::move(block_getter), begin_time, end_time, pid, log);
-
-    return result;
-}
-
-//////////////////////////////////////////////////////////////////////////
-
-extern "C" PROFILER_API profiler::block_index_t writeTreesToStream(std::atomic<int>& progress, std::ostream& str,
-                                                                   const profiler::SerializedData& serialized_descriptors,
-                                                                   const profiler::descriptors_list_t& descriptors,
-                                                                   profiler::block_id_t descriptors_count,
-                                                                   const profiler::thread_blocks_tree_t& trees,
-                                                                   const profiler::bookmarks_t& bookmarks,
-                                                                   profiler::block_getter_fn block_getter,
-                                                                   profiler::timestamp_t begin_time,
-                                                                   profiler::timestamp_t end_time,
-                                                                   profiler::processid_t pid,
-                                                                   std::ostream& log)
+using roots_t = std::vector<const profiler::BlocksTreeRoot*>;
+
+/** Writes threads of one process as .prof file contents.
+
+Only descriptors [first_descriptor, descriptors_end) are written, ids of blocks are shifted accordingly.
+Returns 0 if there are no blocks in [begin_time, end_time] or if writing was interrupted (interrupted is set then). */
+static profiler::block_index_t writeThreadsToStream(std::atomic<int>& progress, std::ostream& str,
+                                                    const profiler::descriptors_list_t& descriptors,
+                                                    profiler::block_id_t first_descriptor,
+                                                    profiler::block_id_t descriptors_end,
+                                                    const roots_t& trees,
+                                                    const profiler::bookmarks_t& bookmarks,
+                                                    const profiler::block_getter_fn& block_getter,
+                                                    profiler::timestamp_t begin_time,
+                                                    profiler::timestamp_t end_time,
+                                                    profiler::processid_t pid,
+                                                    bool& interrupted,
+                                                    std::ostream& log)
 {
-    if (trees.empty() || serialized_descriptors.empty() || descriptors_count == 0)
-    {
-        log << "Nothing to save";
-        return 0;
-    }
-
+    interrupted = false;
     BlocksMemoryAndCount total;
 
-    using ranges_t = std::unordered_map<profiler::thread_id_t, BlocksAndCSwitchesRange, estd::hash<profiler::thread_id_t> >;
-    ranges_t block_ranges;
+    std::vector<BlocksAndCSwitchesRange> block_ranges(trees.size());
 
     // Calculate block ranges and used memory (for serialization)
     profiler::timestamp_t beginTime = begin_time, endTime = end_time;
     size_t i = 0;
-    for (const auto& kv : trees)
+    for (auto root : trees)
     {
-        const auto id = kv.first;
-        const auto& tree = kv.second;
-
-        BlocksAndCSwitchesRange range;
+        const auto& tree = *root;
+        auto& range = block_ranges[i];
 
         range.blocks = findRange(tree.children, begin_time, end_time, block_getter);
         range.cswitches = findRange(tree.sync, begin_time, end_time, block_getter);
@@ -469,10 +497,11 @@ extern "C" PROFILER_API profiler::block_index_t writeTreesToStream(std::atomic<i
             endTime = std::max(endTime, block_getter(tree.children[range.cswitches.end - 1]).cs->end());
         }
 
-        block_ranges[id] = range;
-
         if (!update_progress_write(progress, 15 / static_cast<int>(trees.size() - i), log))
+        {
+            interrupted = true;
             return 0;
+        }
 
         ++i;
     }
@@ -491,12 +520,10 @@ extern "C" PROFILER_API profiler::block_index_t writeTreesToStream(std::atomic<i
     }
 
     if (total.blocksCount == 0)
-    {
-        log << "Nothing to save";
         return 0;
-    }
 
-    const uint64_t usedMemorySizeDescriptors = serialized_descriptors.size() + descriptors_count * sizeof(uint16_t);
+    const auto descriptorsCount = descriptors_end - first_descriptor;
+    const uint64_t usedMemorySizeDescriptors = calculateDescriptorsMemory(descriptors, first_descriptor, descriptors_end);
 
     // Write data to stream
     write(str, EASY_PROFILER_SIGNATURE);
@@ -512,7 +539,7 @@ extern "C" PROFILER_API profiler::block_index_t writeTreesToStream(std::atomic<i
     write(str, total.usedMemorySize);
     write(str, usedMemorySizeDescriptors);
     write(str, total.blocksCount);
-    write(str, descriptors_count);
+    write(str, descriptorsCount);
     write(str, static_cast<uint32_t>(trees.size()));
     write(str, bookmarksCount);
     write(str, static_cast<uint16_t>(0)); // padding
@@ -520,18 +547,17 @@ extern "C" PROFILER_API profiler::block_index_t writeTreesToStream(std::atomic<i
     std::vector<char> buffer;
 
     // Serialize all descriptors
-    serializeDescriptors(str, buffer, descriptors, descriptors_count);
+    serializeDescriptors(str, buffer, descriptors, first_descriptor, descriptors_end);
 
     // Serialize all blocks
     i = 0;
-    for (const auto& kv : trees)
+    for (auto root : trees)
     {
-        const auto id = kv.first;
-        const auto& tree = kv.second;
-        const auto& range = block_ranges.at(id);
+        const auto& tree = *root;
+        const auto& range = block_ranges[i];
 
         const auto nameSize = static_cast<uint16_t>(tree.thread_name.size() + 1);
-        write(str, id);
+        write(str, tree.system_thread_id());
         write(str, nameSize);
         write(str, tree.name(), nameSize);
 
@@ -543,10 +569,16 @@ extern "C" PROFILER_API profiler::block_index_t writeTreesToStream(std::atomic<i
         // Serialize blocks
         write(str, range.blocksMemoryAndCount.blocksCount);
         if (range.blocksMemoryAndCount.blocksCount != 0)
-            serializeBlocks(str, buffer, tree.children, range.blocks, block_getter, descriptors);
+            serializeBlocks(str, buffer, tree.children, range.blocks, block_getter, descriptors,
+                            first_descriptor);
 
         if (!update_progress_write(progress, 40 + 57 / static_cast<int>(trees.size() - i), log))
+        {
+            interrupted = true;
             return 0;
+        }
+
+        ++i;
     }
 
     write(str, EASY_PROFILER_SIGNATURE);
@@ -562,3 +594,192 @@ extern "C" PROFILER_API profiler::block_index_t writeTreesToStream(std::atomic<i
 }
 
 //////////////////////////////////////////////////////////////////////////
+
+extern "C" PROFILER_API profiler::block_index_t writeTreesToFile(std::atomic<int>& progress, const char* filename,
+                                                                 const profiler::SerializedData& serialized_descriptors,
+                                                                 const profiler::descriptors_list_t& descriptors,
+                                                                 profiler::block_id_t descriptors_count,
+                                                                 const profiler::thread_blocks_tree_t& trees,
+                                                                 const profiler::bookmarks_t& bookmarks,
+                                                                 profiler::block_getter_fn block_getter,
+                                                                 profiler::timestamp_t begin_time,
+                                                                 profiler::timestamp_t end_time,
+                                                                 profiler::processid_t pid,
+                                                                 std::ostream& log)
+{
+    if (!update_progress_write(progress, 0, log))
+        return 0;
+
+    std::ofstream outFile(filename, std::fstream::binary);
+    if (!outFile.is_open())
+    {
+        log << "Can not open file " << filename;
+        return 0;
+    }
+
+    // Write data to file
+    auto result = writeTreesToStream(progress, outFile, serialized_descriptors, descriptors, descriptors_count, trees,
+                                     bookmarks, std::move(block_getter), begin_time, end_time, pid, log);
+
+    return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+extern "C" PROFILER_API profiler::block_index_t writeTreesToStream(std::atomic<int>& progress, std::ostream& str,
+                                                                   const profiler::SerializedData& serialized_descriptors,
+                                                                   const profiler::descriptors_list_t& descriptors,
+                                                                   profiler::block_id_t descriptors_count,
+                                                                   const profiler::thread_blocks_tree_t& trees,
+                                                                   const profiler::bookmarks_t& bookmarks,
+                                                                   profiler::block_getter_fn block_getter,
+                                                                   profiler::timestamp_t begin_time,
+                                                                   profiler::timestamp_t end_time,
+                                                                   profiler::processid_t pid,
+                                                                   std::ostream& log)
+{
+    if (trees.empty() || serialized_descriptors.empty() || descriptors_count == 0)
+    {
+        log << "Nothing to save";
+        return 0;
+    }
+
+    const bool multiprocess = std::any_of(trees.begin(), trees.end(),
+                                          [](const profiler::thread_blocks_tree_t::value_type& kv) {
+        return kv.second.got_process();
+    });
+
+    if (!multiprocess)
+    {
+        roots_t roots;
+        roots.reserve(trees.size());
+        for (const auto& kv : trees)
+            roots.push_back(&kv.second);
+
+        bool interrupted = false;
+        const auto result = writeThreadsToStream(progress, str, descriptors, 0, descriptors_count, roots, bookmarks,
+                                                 block_getter, begin_time, end_time, pid, interrupted, log);
+        if (result == 0 && !interrupted)
+            log << "Nothing to save";
+
+        return result;
+    }
+
+    // Merged capture of several processes: write each process as a separate capture
+    // into multi-process container, so process ids and names are not lost.
+    // Timestamps are already shifted by clock offsets while merging.
+    std::map<profiler::processid_t, roots_t> processes;
+    for (const auto& kv : trees)
+        processes[kv.second.process_id].push_back(&kv.second);
+
+    std::vector<std::string> captures_data;
+    std::vector<profiler::ProcessCapture> captures;
+    captures_data.reserve(processes.size());
+    captures.reserve(processes.size());
+
+    const profiler::bookmarks_t no_bookmarks;
+    profiler::block_index_t total_blocks = 0;
+    for (const auto& process : processes)
+    {
+        const auto& roots = process.second;
+
+        // Descriptors of each process are contiguous in the merged capture (see mergeProcessCaptures in reader.cpp)
+        profiler::block_id_t first_descriptor = descriptors_count, descriptors_end = 0;
+        for (auto root : roots)
+            findUsedDescriptors(root->children, block_getter, descriptors, first_descriptor, descriptors_end);
+
+        if (first_descriptor >= descriptors_end)
+            continue;
+
+        bool interrupted = false;
+        std::ostringstream capture(std::ios_base::out | std::ios_base::binary);
+        const auto blocks = writeThreadsToStream(progress, capture, descriptors, first_descriptor, descriptors_end,
+                                                 roots, captures.empty() ? bookmarks : no_bookmarks, block_getter,
+                                                 begin_time, end_time, process.first, interrupted, log);
+        if (interrupted)
+            return 0;
+
+        if (blocks == 0)
+            continue;
+
+        total_blocks += blocks;
+        captures_data.emplace_back(capture.str());
+
+        const auto& root = *roots.front();
+        profiler::ProcessCapture c;
+        c.name = root.process_name.c_str();
+        c.data = captures_data.back().data();
+        c.size = captures_data.back().size();
+        c.pid = process.first;
+        c.clock_offset = 0;
+        captures.push_back(c);
+    }
+
+    if (total_blocks == 0)
+    {
+        log << "Nothing to save";
+        return 0;
+    }
+
+    if (!writeProcessCapturesToStream(str, captures.data(), static_cast<uint32_t>(captures.size()), log))
+        return 0;
+
+    return total_blocks;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+extern "C" PROFILER_API bool writeProcessCapturesToFile(const char* filename, const profiler::ProcessCapture* captures,
+                                                        uint32_t captures_count, std::ostream& log)
+{
+    std::ofstream outFile(filename, std::fstream::binary);
+    if (!outFile.is_open())
+    {
+        log << "Can not open file " << filename;
+        return false;
+    }
+
+    return writeProcessCapturesToStream(outFile, captures, captures_count, log);
+}
+
+extern "C" PROFILER_API bool writeProcessCapturesToStream(std::ostream& str, const profiler::ProcessCapture* captures,
+                                                          uint32_t captures_count, std::ostream& log)
+{
+    for (uint32_t i = 0; i < captures_count; ++i)
+    {
+        const auto& capture = captures[i];
+        if (capture.size < sizeof(uint32_t) || unaligned_load32<uint32_t>(capture.data) != EASY_PROFILER_SIGNATURE)
+        {
+            log << "Wrong signature of capture of process " << capture.pid;
+            return false;
+        }
+    }
+
+    write(str, EASY_MULTIPROCESS_SIGNATURE);
+    write(str, EASY_PROFILER_VERSION);
+    write(str, captures_count);
+
+    for (uint32_t i = 0; i < captures_count; ++i)
+    {
+        const auto& capture = captures[i];
+        const auto nameSize = static_cast<uint16_t>(std::min(strlen(capture.name), size_t(65534)) + 1);
+
+        write(str, capture.pid);
+        write(str, capture.clock_offset);
+        write(str, nameSize);
+        write(str, capture.name, nameSize - 1);
+        write(str, '\0');
+        write(str, capture.size);
+        write(str, capture.data, static_cast<std::streamsize>(capture.size));
+    }
+
+    if (!str.good())
+    {
+        log << "Can not write captures";
+        return false;
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
@@ -77,6 +77,7 @@
 #include <cmath>
 #include "arbitrary_value_inspector.h"
 #include "dialog.h"
+#include "downsampling.h"
 #include "globals.h"
 #include "complexity_calculator.h"
 
@@ -390,37 +391,10 @@ void ArbitraryValuesCollection::collectById(profiler::thread_id_t _threadId, pro
 bool ArbitraryValuesCollection::collectByIdForThread(const profiler::BlocksTreeRoot& _threadRoot
     , profiler::vin_t _valueId, bool _calculatePoints, profiler::block_id_t _parentBlockId, int _index)
 {
-    if (profiler_gui::is_max(_parentBlockId))
-    {
-        // All values
-
-        for (auto i : _threadRoot.events)
-        {
-            if (m_bInterrupt.load(std::memory_order_acquire))
-                return false;
-
-            const auto& block = easyBlock(i).tree;
-            const auto& desc = easyDescriptor(block.node->id());
-            if (desc.type() != profiler::BlockType::Value)
-                continue;
-
-            const auto value = block.value;
-            if (value->value_id() != _valueId)
-                continue;
-
-            if (_index >= 0 && (!value->isArray() || profiler_gui::valueArraySize(*value) <= _index))
-                continue;
-
-            m_values.push_back(value);
-            if (_calculatePoints)
-                addPoint(*value, _index);
-        }
-
+    const auto it = _threadRoot.values_by_id.find(_valueId);
+    if (it == _threadRoot.values_by_id.end())
         return true;
-    }
-
-    return depthFirstSearch(_threadRoot, _calculatePoints, _parentBlockId, _index
-        , [=] (profiler::vin_t _id, const char*) -> bool { return _id == _valueId; });
+    return collectFromIndex(it->second, _calculatePoints, _parentBlockId, _index);
 }
 
 void ArbitraryValuesCollection::collectByName(profiler::thread_id_t _threadId, const std::string _valueName
@@ -480,111 +454,62 @@ void ArbitraryValuesCollection::collectByName(profiler::thread_id_t _threadId, c
 bool ArbitraryValuesCollection::collectByNameForThread(const profiler::BlocksTreeRoot& _threadRoot
     , const std::string& _valueName, bool _calculatePoints, profiler::block_id_t _parentBlockId, int _index)
 {
-    if (profiler_gui::is_max(_parentBlockId))
-    {
-        // All values
-
-        for (auto i : _threadRoot.events)
-        {
-            if (m_bInterrupt.load(std::memory_order_acquire))
-                return false;
-
-            const auto& block = easyBlock(i).tree;
-            const auto& desc = easyDescriptor(block.node->id());
-            if (desc.type() != profiler::BlockType::Value || _valueName != desc.name())
-                continue;
-
-            const auto value = block.value;
-            if (_index >= 0 && (!value->isArray() || profiler_gui::valueArraySize(*value) <= _index))
-                continue;
-
-            m_values.push_back(value);
-            if (_calculatePoints)
-                addPoint(*value, _index);
-        }
-
+    const auto it = _threadRoot.values_by_name.find(_valueName);
+    if (it == _threadRoot.values_by_name.end())
         return true;
-    }
-
-    return depthFirstSearch(_threadRoot, _calculatePoints, _parentBlockId, _index
-        , [&_valueName] (profiler::vin_t, const char* _name) -> bool { return _valueName == _name; });
+    return collectFromIndex(it->second, _calculatePoints, _parentBlockId, _index);
 }
 
-bool ArbitraryValuesCollection::depthFirstSearch(const profiler::BlocksTreeRoot& _threadRoot, bool _calculatePoints
-    , profiler::block_id_t _parentBlockId, int _index, std::function<bool(profiler::vin_t, const char*)> _isSuitableValue)
+bool ArbitraryValuesCollection::collectFromIndex(const profiler::value_index_t& _values, bool _calculatePoints
+    , profiler::block_id_t _parentBlockId, int _index)
 {
-    if (_threadRoot.children.empty())
-        return true;
-
-    using StackEntry = std::pair<profiler::block_index_t, profiler::block_index_t>;
-    using Stack = std::vector<StackEntry>;
+    const bool anyParent = profiler_gui::is_max(_parentBlockId);
 
-    Stack stack;
-    for (const auto index : _threadRoot.children)
+    m_values.reserve(m_values.size() + _values.size());
+    for (const auto& entry : _values)
     {
         if (m_bInterrupt.load(std::memory_order_acquire))
             return false;
 
-        stack.clear();
-        stack.emplace_back(index, static_cast<profiler::block_index_t>(0));
+        const auto& block = easyBlocksTree(entry.block);
+        const auto value = block.value;
+        if (_index >= 0 && (!value->isArray() || profiler_gui::valueArraySize(*value) <= _index))
+            continue;
 
-        profiler::timestamp_t lastMatchedParentDuration = 0;
-        size_t matchedParentIdStackDepth = 0;
-        bool matchedParentId = false;
-        while (!stack.empty())
+        if (anyParent)
         {
-            if (m_bInterrupt.load(std::memory_order_acquire))
-                return false;
-
-            auto& top = stack.back();
-            auto& first = top.second;
-            const auto i = top.first;
-
-            const auto& block = easyBlock(i).tree;
-            const auto& desc = easyDescriptor(block.node->id());
+            m_values.push_back(value);
+            if (_calculatePoints)
+                addPoint(*value, _index);
+            continue;
+        }
 
-            if (desc.type() == profiler::BlockType::Value && matchedParentId)
-            {
-                const auto value = block.value;
-                if (_isSuitableValue(value->value_id(), desc.name()))
-                {
-                    if (_index < 0 || (value->isArray() && _index < profiler_gui::valueArraySize(*value)))
-                    {
-                        m_values.push_back(value);
-                        if (_calculatePoints)
-                        {
-                            const auto val = addPoint(*value, _index);
-                            if (m_chartType == ChartType::Complexity)
-                            {
-                                m_complexityMap[val].push_back(lastMatchedParentDuration);
-                                if (lastMatchedParentDuration < m_minDuration)
-                                    m_minDuration = lastMatchedParentDuration;
-                                if (lastMatchedParentDuration > m_maxDuration)
-                                    m_maxDuration = lastMatchedParentDuration;
-                            }
-                        }
-                    }
-                }
-            }
+        // Every value knows the innermost block enclosing it (BlocksTree::parent),
+        // so walk up until the block with required id is found.
+        auto parent = block.parent;
+        while (parent != ~0U)
+        {
+            const auto& parentBlock = easyBlocksTree(parent);
+            if (parentBlock.node->id() == _parentBlockId || easyDescriptor(parentBlock.node->id()).id() == _parentBlockId)
+                break;
+            parent = parentBlock.parent;
+        }
 
-            if (first < block.children.size())
-            {
-                if (block.node->id() == _parentBlockId || desc.id() == _parentBlockId)
-                {
-                    if (!matchedParentId)
-                        matchedParentIdStackDepth = stack.size();
-                    matchedParentId = true;
-                    lastMatchedParentDuration = block.node->duration();
-                }
+        if (parent == ~0U)
+            continue;
 
-                const auto child = block.children[first++];
-                stack.emplace_back(child, static_cast<profiler::block_index_t>(0));
-            }
-            else
+        m_values.push_back(value);
+        if (_calculatePoints)
+        {
+            const auto val = addPoint(*value, _index);
+            if (m_chartType == ChartType::Complexity)
             {
-                if (stack.size() == matchedParentIdStackDepth)
-                    matchedParentId = false;
-                stack.pop_back();
+                const auto duration = easyBlocksTree(parent).node->duration();
+                m_complexityMap[val].push_back(duration);
+                if (duration < m_minDuration)
+                    m_minDuration = duration;
+                if (duration > m_maxDuration)
+                    m_maxDuration = duration;
             }
         }
     }
@@ -987,15 +912,18 @@ void ArbitraryValuesChartItem::updateRegularImageAsync(QRectF _boundingRect, qre
 
             if (_autoAdjust)
             {
-                for (auto it = first; it != points.end() && it->x() < right && !isReady(); ++it)
+                const auto windowBegin = std::lower_bound(first, points.end(), _value, [](const QPointF& point, qreal x)
                 {
-                    if (it->x() < _value)
-                        continue;
+                    return point.x() < x;
+                });
 
-                    const auto value = it->y();
-                    minValue = std::min(minValue, value);
-                    maxValue = std::max(maxValue, value);
-                }
+                const auto windowEnd = std::lower_bound(windowBegin, points.end(), right, [](const QPointF& point, qreal x)
+                {
+                    return point.x() < x;
+                });
+
+                profiler_gui::minMaxY(points.data() + (windowBegin - points.begin()), points.data() + (windowEnd - points.begin())
+                    , minValue, maxValue);
 
                 continue;
             }
@@ -1045,6 +973,17 @@ void ArbitraryValuesChartItem::updateRegularImageAsync(QRectF _boundingRect, qre
         return y;
     };
 
+    const auto lessX = [](const QPointF& point, qreal x)
+    {
+        return point.x() < x;
+    };
+
+    // Charts are painted using at most a few points per pixel column, so the cost of painting
+    // does not depend on the number of points (see downsampling.h)
+    const auto lttbThreshold = static_cast<size_t>(m_workerImage->width()) << 1;
+    profiler_gui::PointsBuckets buckets;
+    Points significantPoints;
+
     size_t i = 0;
     for (const auto& c : m_collections)
     {
@@ -1058,6 +997,17 @@ void ArbitraryValuesChartItem::updateRegularImageAsync(QRectF _boundingRect, qre
             continue;
         }
 
+        const auto first = leftBounds[i];
+        const auto visibleBegin = std::lower_bound(first, points.end(), _minimum, lessX);
+        const auto visibleEnd = std::lower_bound(visibleBegin, points.end(), _maximum, lessX);
+
+        significantPoints.clear();
+        if (c.chartPenStyle == ChartPenStyle::Points || c.selected)
+        {
+            profiler_gui::downsampleLttb(points.data() + (visibleBegin - points.begin())
+                , points.data() + (visibleEnd - points.begin()), lttbThreshold, significantPoints);
+        }
+
         if (c.selected)
         {
             auto pen = p.pen();
@@ -1070,21 +1020,16 @@ void ArbitraryValuesChartItem::updateRegularImageAsync(QRectF _boundingRect, qre
             p.setPen(QColor::fromRgba(c.color));
         }
 
-        const auto first = leftBounds[i];
-
         if (c.chartPenStyle == ChartPenStyle::Points)
         {
             qreal prevX = 1e300, prevY = 1e300;
-            for (auto it = first; it != points.end() && it->x() < _maximum; ++it)
+            for (const auto& point : significantPoints)
             {
-                if (it->x() < _minimum)
-                    continue;
-
                 if (isReady())
                     return;
 
-                const qreal x = it->x() * realScale - offset;
-                const qreal y = gety(it->y());
+                const qreal x = point.x() * realScale - offset;
+                const qreal y = gety(point.y());
                 const auto dx = fabs(x - prevX), dy = fabs(y - prevY);
 
                 if (dx > 1 || dy > 1)
@@ -1097,37 +1042,31 @@ void ArbitraryValuesChartItem::updateRegularImageAsync(QRectF _boundingRect, qre
         }
         else if (first != points.end() && first->x() < _maximum)
         {
-            QPointF p1 = *first;
-            qreal x = p1.x() * realScale - offset;
-            qreal y = gety(p1.y());
-            p1.setX(x);
-            p1.setY(y);
+            // Line ends at the first point behind the right bound
+            const auto last = visibleEnd != points.end() ? visibleEnd + 1 : visibleEnd;
+
+            // Each bucket is one pixel column: line from the previous bucket to the first point,
+            // vertical line between the lowest and the highest points, and the last point
+            profiler_gui::downsampleMinMax(points.data() + (first - points.begin()), points.data() + (last - points.begin())
+                , offset / realScale, 1. / realScale, buckets);
 
-            auto it = first;
-            for (++it; it != points.end(); ++it)
+            QPointF p1;
+            bool firstBucket = true;
+            for (const auto& bucket : buckets)
             {
                 if (isReady())
                     return;
 
-                QPointF p2 = *it;
-                x = p2.x() * realScale - offset;
-                y = gety(p2.y());
-                p2.setX(x);
-                p2.setY(y);
-
-                if (it->x() >= _minimum)
-                {
-                    const auto dx = fabs(x - p1.x()), dy = fabs(y - p1.y());
-                    if (dx > 1 || dy > 1)
-                        p.drawLine(p1, p2);
-                    else
-                        continue;
-                }
+                const QPointF p2(bucket.first.x() * realScale - offset, gety(bucket.first.y()));
+                if (!firstBucket)
+                    p.drawLine(p1, p2);
 
-                if (it->x() >= _maximum)
-                    break;
+                if (bucket.highest > bucket.lowest)
+                    p.drawLine(QPointF(p2.x(), gety(bucket.highest)), QPointF(p2.x(), gety(bucket.lowest)));
 
-                p1 = p2;
+                p1.setX(bucket.last.x() * realScale - offset);
+                p1.setY(gety(bucket.last.y()));
+                firstBucket = false;
             }
         }
 
@@ -1141,16 +1080,13 @@ void ArbitraryValuesChartItem::updateRegularImageAsync(QRectF _boundingRect, qre
             p.setBrush(QColor::fromRgba(0xc8ffffff));
 
             qreal prevX = -offset * 2, prevY = -500;
-            for (auto it = first; it != points.end() && it->x() < _maximum; ++it)
+            for (const auto& point : significantPoints)
             {
-                if (it->x() < _minimum)
-                    continue;
-
                 if (isReady())
                     return;
 
-                const qreal x = it->x() * realScale - offset;
-                const qreal y = gety(it->y());
+                const qreal x = point.x() * realScale - offset;
+                const qreal y = gety(point.y());
 
                 const auto dx = x - prevX, dy = y - prevY;
                 const auto delta = estd::sqr(dx) + estd::sqr(dy);
@@ -1966,6 +1902,8 @@ ArbitraryValuesWidget::ArbitraryValuesWidget(bool _isMainWidget, profiler::threa
     connect(globalEvents, &GlobalSignals::selectedBlockChanged, this, &This::onSelectedBlockChanged);
     connect(globalEvents, &GlobalSignals::selectedBlockIdChanged, this, &This::onSelectedBlockIdChanged);
     connect(globalEvents, &GlobalSignals::allDataGoingToBeDeleted, this, &This::clear);
+    connect(globalEvents, &GlobalSignals::dataGoingToBeChanged, this, &This::onDataGoingToBeChanged);
+    connect(globalEvents, &GlobalSignals::dataChanged, this, &This::onDataChanged);
 
     connect(m_treeWidget->header(), &QHeaderView::sectionResized, this, &This::onHeaderSectionResized);
 
@@ -2250,6 +2188,36 @@ void ArbitraryValuesWidget::onSelectedBlockIdChanged(::profiler::block_id_t)
     // TODO: find item corresponding to selected_block_id and make it bold
 }
 
+void ArbitraryValuesWidget::onDataGoingToBeChanged()
+{
+    if (m_checkedItems.empty())
+        return;
+
+    // Collections are gathered from global blocks in background
+    if (m_collectionsTimer.isActive())
+        m_collectionsTimer.stop();
+
+    m_chart->cancelImageUpdate();
+
+    for (auto item : m_checkedItems)
+    {
+        if (item->collection() != nullptr)
+            item->collection()->interrupt();
+    }
+}
+
+void ArbitraryValuesWidget::onDataChanged()
+{
+    if (m_checkedItems.empty())
+        return;
+
+    for (auto item : m_checkedItems)
+        item->collectValues(EASY_GLOBALS.selected_thread, m_chart->chartType());
+
+    if (!m_collectionsTimer.isActive())
+        m_collectionsTimer.start();
+}
+
 void ArbitraryValuesWidget::onItemDoubleClicked(QTreeWidgetItem* _item, int)
 {
     if (_item == nullptr || _item->type() != ValueItemType || (_item->flags() & Qt::ItemIsUserCheckable) == 0)
@@ -2802,7 +2770,7 @@ QTreeWidgetItem* ArbitraryValuesWidget::buildTreeForThread(const profiler::Block
             auto& first = top.second;
             const auto i = top.first;
 
-            const auto& block = easyBlock(i).tree;
+            const auto& block = easyBlocksTree(i);
             const auto& desc = easyDescriptor(block.node->id());
 
             if (desc.type() == profiler::BlockType::Value && matchedParentId)
@@ -2865,7 +2833,7 @@ QTreeWidgetItem* ArbitraryValuesWidget::buildTreeForThread(const profiler::Block
                         // Enter here only if anyBlockId is true.
                         // matchedParentIdStackDepth is always == 0 in such case.
                         const auto parentBlockIndex = stack[matchedParentIdStackDepth].first;
-                        const auto& parentBlock = easyBlock(parentBlockIndex).tree;
+                        const auto& parentBlock = easyBlocksTree(parentBlockIndex);
                         const auto id = parentBlock.node->id();
                         auto it = blocks.find(id);
                         if (it != blocks.end())
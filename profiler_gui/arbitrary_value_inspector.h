@@ -169,9 +169,8 @@ private:
     bool collectByNameForThread(const profiler::BlocksTreeRoot& _threadRoot, const std::string& _valueName
         , bool _calculatePoints, profiler::block_id_t _parentBlockId, int _index);
 
-    bool depthFirstSearch(const profiler::BlocksTreeRoot& _threadRoot, bool _calculatePoints
-        , profiler::block_id_t _parentBlockId, int _index
-        , std::function<bool(profiler::vin_t, const char*)> _isSuitableValue);
+    bool collectFromIndex(const profiler::value_index_t& _values, bool _calculatePoints
+        , profiler::block_id_t _parentBlockId, int _index);
 
     double addPoint(const profiler::ArbitraryValue& _value, int _index);
     QPointF point(const profiler::ArbitraryValue& _value, int _index) const;
@@ -384,6 +383,8 @@ private slots:
     void onSelectedThreadChanged(profiler::thread_id_t);
     void onSelectedBlockChanged(uint32_t _block_index);
     void onSelectedBlockIdChanged(profiler::block_id_t _id);
+    void onDataGoingToBeChanged();
+    void onDataChanged();
     void onItemDoubleClicked(QTreeWidgetItem* _item, int _column);
     void onItemChanged(QTreeWidgetItem* _item, int _column);
     void onCurrentItemChanged(QTreeWidgetItem*, QTreeWidgetItem*);
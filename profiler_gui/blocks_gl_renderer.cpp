@@ -0,0 +1,396 @@
+/************************************************************************
+* file name         : blocks_gl_renderer.cpp
+* ----------------- :
+* creation time     : 2026/10/19
+* author            : Victor Zarubkin
+* email             : v.s.zarubkin@gmail.com
+* ----------------- :
+* description       : The file contains implementation of BlocksGLRenderer.
+* ----------------- :
+*                   :
+*                   : Licensed under either of
+*                   :     * MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+*                   :     * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+*                   : at your option.
+*                   :
+*                   : The MIT License
+*                   :
+*                   : Permission is hereby granted, free of charge, to any person obtaining a copy
+*                   : of this software and associated documentation files (the "Software"), to deal
+*                   : in the Software without restriction, including without limitation the rights
+*                   : to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+*                   : of the Software, and to permit persons to whom the Software is furnished
+*                   : to do so, subject to the following conditions:
+*                   :
+*                   : The above copyright notice and this permission notice shall be included in all
+*                   : copies or substantial portions of the Software.
+*                   :
+*                   : THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+*                   : INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+*                   : PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+*                   : LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+*                   : TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+*                   : USE OR OTHER DEALINGS IN THE SOFTWARE.
+*                   :
+*                   : The Apache License, Version 2.0 (the "License")
+*                   :
+*                   : You may not use this file except in compliance with the License.
+*                   : You may obtain a copy of the License at
+*                   :
+*                   : http://www.apache.org/licenses/LICENSE-2.0
+*                   :
+*                   : Unless required by applicable law or agreed to in writing, software
+*                   : distributed under the License is distributed on an "AS IS" BASIS,
+*                   : WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*                   : See the License for the specific language governing permissions and
+*                   : limitations under the License.
+************************************************************************/
+
+
+#include "blocks_gl_renderer.h"
+
+#ifdef EASY_GRAPHICS_OPENGL_VIEWPORT
+
+#include <stddef.h>
+#include <algorithm>
+#include <QColor>
+#include <QDebug>
+#include <QOpenGLContext>
+#include <QPaintEngine>
+#include <QPainter>
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////////
+
+enum AttributeLocation : GLuint
+{
+    CORNER_ATTRIBUTE = 0,
+    BLOCK_ATTRIBUTE,
+    COLOR_ATTRIBUTE,
+    EXPANDED_ATTRIBUTE,
+    ATTRIBUTES_NUMBER
+};
+
+const char* const VERTEX_SHADER = R"(
+in vec2 corner;
+in vec4 block;
+in vec4 color;
+in float expanded;
+
+uniform vec2 origin;
+uniform vec2 viewport;
+uniform vec2 offset;
+uniform float scale;
+uniform float top;
+uniform float minWidth;
+uniform float minPixels;
+uniform float narrowSize;
+uniform float rowHeight;
+uniform float rowFullSize;
+uniform int hideNarrow;
+uniform int hideMinSize;
+
+out vec4 vColor;
+out vec2 vLocal;
+out vec2 vSize;
+
+void main()
+{
+    // Subtracting high and low parts separately keeps precision of double for big scene coordinates
+    float x = ((block.x - offset.x) + (block.y - offset.y)) * scale;
+    float w = max(block.z, minWidth) * scale;
+
+    float h = rowHeight;
+    if (expanded < 0.5 || (hideNarrow != 0 && w < narrowSize))
+        h = block.w * rowFullSize + rowHeight; // collapsed block hides its children
+
+    if (hideMinSize != 0 && w < minPixels)
+        h = 0.0; // degenerate quad is not rasterized
+
+    w = max(w, minPixels);
+
+    // Clamp quad to the viewport to avoid huge coordinates on big scales
+    float left = max(x, -origin.x - 2.0);
+    float right = max(left, min(x + w, viewport.x - origin.x + 2.0));
+
+    vec2 position = vec2(left + corner.x * (right - left), top + corner.y * h);
+    vec2 device = origin + position;
+
+    vColor = color;
+    vLocal = vec2(position.x - x, corner.y * h);
+    vSize = vec2(w, h);
+
+    gl_Position = vec4(device.x / viewport.x * 2.0 - 1.0, 1.0 - device.y / viewport.y * 2.0, 0.0, 1.0);
+}
+)";
+
+const char* const FRAGMENT_SHADER = R"(
+in vec4 vColor;
+in vec2 vLocal;
+in vec2 vSize;
+
+uniform int borders;
+uniform vec4 borderColor;
+
+out vec4 fragColor;
+
+void main()
+{
+    if (borders != 0 && (vLocal.x < 1.0 || vLocal.y < 1.0 || vSize.x - vLocal.x < 1.0 || vSize.y - vLocal.y < 1.0))
+        fragColor = borderColor;
+    else
+        fragColor = vColor;
+}
+)";
+
+const GLfloat CORNERS[] = {0, 0, 1, 0, 0, 1, 1, 1};
+
+//////////////////////////////////////////////////////////////////////////
+
+} // end of namespace <noname>.
+
+//////////////////////////////////////////////////////////////////////////
+
+BlocksGLRenderer::BlocksGLRenderer()
+    : m_corners(QOpenGLBuffer::VertexBuffer)
+    , m_topId(-1)
+    , m_hideMinSizeId(-1)
+    , m_generation(1)
+    , m_initialized(false)
+    , m_supported(false)
+{
+}
+
+BlocksGLRenderer::~BlocksGLRenderer()
+{
+    QObject::disconnect(m_contextConnection);
+    release();
+}
+
+void BlocksGLRenderer::release()
+{
+    m_buffers.clear();
+    m_program.reset();
+    m_corners.destroy();
+    m_vao.destroy();
+    m_initialized = false;
+    m_supported = false;
+}
+
+bool BlocksGLRenderer::initialize()
+{
+    if (m_initialized)
+        return m_supported;
+
+    auto context = QOpenGLContext::currentContext();
+    if (context == nullptr)
+        return false;
+
+    m_initialized = true;
+
+    // OpenGL context of QOpenGLWidget is recreated when the widget is moved into another window
+    QObject::disconnect(m_contextConnection);
+    m_contextConnection = QObject::connect(context, &QOpenGLContext::aboutToBeDestroyed, [this] { release(); });
+
+    // Instancing (glVertexAttribDivisor) is a part of OpenGL 3.3 and OpenGL ES 3.0
+    const auto format = context->format();
+    const bool gles = context->isOpenGLES();
+    if (gles ? format.majorVersion() < 3 : format.version() < qMakePair(3, 3))
+    {
+        qWarning().nospace() << "OpenGL viewport: instancing is not supported by OpenGL " << format.majorVersion()
+                             << "." << format.minorVersion() << ", blocks will be painted by QPainter";
+        return false;
+    }
+
+    initializeOpenGLFunctions();
+
+    m_program.reset(new QOpenGLShaderProgram());
+
+    const QByteArray header = gles ? "#version 300 es\nprecision highp float;\nprecision highp int;\n" : "#version 330\n";
+    if (!m_program->addShaderFromSourceCode(QOpenGLShader::Vertex, header + VERTEX_SHADER) ||
+        !m_program->addShaderFromSourceCode(QOpenGLShader::Fragment, header + FRAGMENT_SHADER))
+    {
+        qWarning() << "OpenGL viewport: can not compile shaders:" << m_program->log();
+        return false;
+    }
+
+    m_program->bindAttributeLocation("corner", CORNER_ATTRIBUTE);
+    m_program->bindAttributeLocation("block", BLOCK_ATTRIBUTE);
+    m_program->bindAttributeLocation("color", COLOR_ATTRIBUTE);
+    m_program->bindAttributeLocation("expanded", EXPANDED_ATTRIBUTE);
+
+    if (!m_program->link())
+    {
+        qWarning() << "OpenGL viewport: can not link shaders:" << m_program->log();
+        return false;
+    }
+
+    m_topId = m_program->uniformLocation("top");
+    m_hideMinSizeId = m_program->uniformLocation("hideMinSize");
+
+    if (!m_corners.create())
+        return false;
+
+    m_corners.bind();
+    m_corners.allocate(CORNERS, static_cast<int>(sizeof(CORNERS)));
+    m_corners.release();
+
+    // Vertex array object is required by core profile contexts only
+    m_vao.create();
+
+    m_supported = true;
+    return true;
+}
+
+bool BlocksGLRenderer::begin(QPainter* _painter, const Frame& _frame)
+{
+    const auto engine = _painter->paintEngine();
+    if (engine == nullptr || engine->type() != QPaintEngine::OpenGL2)
+        return false;
+
+    // Shaders support only translation of the item's coordinates
+    if (_painter->deviceTransform().type() > QTransform::TxTranslate)
+        return false;
+
+    if (!initialize())
+        return false;
+
+    m_frame = _frame;
+
+    _painter->beginNativePainting();
+
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_BLEND);
+
+    m_program->bind();
+
+    const auto offsetHigh = static_cast<GLfloat>(_frame.offset);
+    const auto offsetLow = static_cast<GLfloat>(_frame.offset - offsetHigh);
+
+    m_program->setUniformValue("origin", static_cast<GLfloat>(_frame.origin.x()), static_cast<GLfloat>(_frame.origin.y()));
+    m_program->setUniformValue("viewport", static_cast<GLfloat>(_frame.viewport.width()), static_cast<GLfloat>(_frame.viewport.height()));
+    m_program->setUniformValue("offset", offsetHigh, offsetLow);
+    m_program->setUniformValue("scale", static_cast<GLfloat>(_frame.scale));
+    m_program->setUniformValue("minWidth", _frame.minWidth);
+    m_program->setUniformValue("minPixels", _frame.minPixels);
+    m_program->setUniformValue("narrowSize", _frame.narrowSize);
+    m_program->setUniformValue("rowHeight", _frame.rowHeight);
+    m_program->setUniformValue("rowFullSize", _frame.rowFullSize);
+    m_program->setUniformValue("hideNarrow", static_cast<GLint>(_frame.hideNarrow ? 1 : 0));
+    m_program->setUniformValue("borders", static_cast<GLint>(_frame.borders ? 1 : 0));
+    m_program->setUniformValue("borderColor", QColor::fromRgba(_frame.borderColor));
+
+    if (m_vao.isCreated())
+        m_vao.bind();
+
+    m_corners.bind();
+    glEnableVertexAttribArray(CORNER_ATTRIBUTE);
+    glVertexAttribPointer(CORNER_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glVertexAttribDivisor(CORNER_ATTRIBUTE, 0);
+    m_corners.release();
+
+    for (GLuint attribute = BLOCK_ATTRIBUTE; attribute < ATTRIBUTES_NUMBER; ++attribute)
+    {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+
+    return true;
+}
+
+void BlocksGLRenderer::end(QPainter* _painter)
+{
+    // Attribute arrays could belong to the default vertex array object which is used by QPainter too
+    for (GLuint attribute = CORNER_ATTRIBUTE; attribute < ATTRIBUTES_NUMBER; ++attribute)
+    {
+        glVertexAttribDivisor(attribute, 0);
+        glDisableVertexAttribArray(attribute);
+    }
+
+    if (m_vao.isCreated())
+        m_vao.release();
+
+    m_program->release();
+
+    _painter->endNativePainting();
+}
+
+bool BlocksGLRenderer::isUploaded(uint8_t _item, uint8_t _level) const
+{
+    if (_item >= m_buffers.size() || _level >= m_buffers[_item].size())
+        return false;
+
+    const auto& level = m_buffers[_item][_level];
+    return level != nullptr && level->generation == m_generation;
+}
+
+void BlocksGLRenderer::upload(uint8_t _item, uint8_t _level, const Instances& _instances)
+{
+    if (m_buffers.size() <= _item)
+        m_buffers.resize(_item + 1);
+
+    auto& levels = m_buffers[_item];
+    if (levels.size() <= _level)
+        levels.resize(_level + 1);
+
+    auto& level = levels[_level];
+    if (level == nullptr)
+        level.reset(new LevelBuffer());
+
+    if (!level->buffer.isCreated())
+    {
+        if (!level->buffer.create())
+            return;
+        level->buffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    }
+
+    level->buffer.bind();
+    level->buffer.allocate(_instances.data(), static_cast<int>(_instances.size() * sizeof(Instance)));
+    level->buffer.release();
+
+    level->count = static_cast<int>(_instances.size());
+    level->generation = m_generation;
+}
+
+void BlocksGLRenderer::paintLevel(uint8_t _item, uint8_t _level, qreal _top, uint32_t _first, uint32_t _count, bool _topLevel)
+{
+    if (!isUploaded(_item, _level))
+        return;
+
+    auto& level = *m_buffers[_item][_level];
+    if (_first >= static_cast<uint32_t>(level.count))
+        return;
+
+    _count = std::min(_count, static_cast<uint32_t>(level.count) - _first);
+    if (_count == 0)
+        return;
+
+    m_program->setUniformValue(m_topId, static_cast<GLfloat>(_top));
+    m_program->setUniformValue(m_hideMinSizeId, static_cast<GLint>(m_frame.hideMinSize && !_topLevel ? 1 : 0));
+
+    // Instances are addressed by buffer offset to paint only visible blocks
+    const auto base = static_cast<size_t>(_first) * sizeof(Instance);
+    const auto stride = static_cast<GLsizei>(sizeof(Instance));
+
+    level.buffer.bind();
+    glVertexAttribPointer(BLOCK_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, stride,
+                          reinterpret_cast<const void*>(base + offsetof(Instance, leftHigh)));
+    glVertexAttribPointer(COLOR_ATTRIBUTE, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                          reinterpret_cast<const void*>(base + offsetof(Instance, color)));
+    glVertexAttribPointer(EXPANDED_ATTRIBUTE, 1, GL_FLOAT, GL_FALSE, stride,
+                          reinterpret_cast<const void*>(base + offsetof(Instance, expanded)));
+    level.buffer.release();
+
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(_count));
+}
+
+void BlocksGLRenderer::invalidate()
+{
+    ++m_generation;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+#endif // EASY_GRAPHICS_OPENGL_VIEWPORT
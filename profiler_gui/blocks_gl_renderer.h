@@ -0,0 +1,195 @@
+/************************************************************************
+* file name         : blocks_gl_renderer.h
+* ----------------- :
+* creation time     : 2026/10/19
+* author            : Victor Zarubkin
+* email             : v.s.zarubkin@gmail.com
+* ----------------- :
+* description       : The file contains declaration of BlocksGLRenderer - an object
+*                   : used to paint blocks diagram using OpenGL viewport.
+* ----------------- :
+*                   :
+*                   : Licensed under either of
+*                   :     * MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+*                   :     * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+*                   : at your option.
+*                   :
+*                   : The MIT License
+*                   :
+*                   : Permission is hereby granted, free of charge, to any person obtaining a copy
+*                   : of this software and associated documentation files (the "Software"), to deal
+*                   : in the Software without restriction, including without limitation the rights
+*                   : to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+*                   : of the Software, and to permit persons to whom the Software is furnished
+*                   : to do so, subject to the following conditions:
+*                   :
+*                   : The above copyright notice and this permission notice shall be included in all
+*                   : copies or substantial portions of the Software.
+*                   :
+*                   : THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+*                   : INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+*                   : PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+*                   : LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+*                   : TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+*                   : USE OR OTHER DEALINGS IN THE SOFTWARE.
+*                   :
+*                   : The Apache License, Version 2.0 (the "License")
+*                   :
+*                   : You may not use this file except in compliance with the License.
+*                   : You may obtain a copy of the License at
+*                   :
+*                   : http://www.apache.org/licenses/LICENSE-2.0
+*                   :
+*                   : Unless required by applicable law or agreed to in writing, software
+*                   : distributed under the License is distributed on an "AS IS" BASIS,
+*                   : WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*                   : See the License for the specific language governing permissions and
+*                   : limitations under the License.
+************************************************************************/
+
+
+#ifndef EASY_PROFILER_BLOCKS_GL_RENDERER_H
+#define EASY_PROFILER_BLOCKS_GL_RENDERER_H
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include <QtGlobal>
+#include <easy/details/easy_compiler_support.h>
+
+#if !defined(QT_NO_OPENGL) && QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+# define EASY_GRAPHICS_OPENGL_VIEWPORT
+#endif
+
+#ifdef EASY_GRAPHICS_OPENGL_VIEWPORT
+
+#include <QOpenGLBuffer>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLVertexArrayObject>
+#include <QMetaObject>
+#include <QPointF>
+#include <QSizeF>
+
+class QPainter;
+
+//////////////////////////////////////////////////////////////////////////
+
+/** \brief Paints blocks of GraphicsBlockItem as instanced quads when BlocksGraphicsView uses QOpenGLWidget viewport.
+
+Blocks of each level of each GraphicsBlockItem are uploaded into instance buffer once (see upload())
+and then only uniforms change on scrolling or scaling. Requires OpenGL 3.3 or OpenGL ES 3.0
+(works with Mesa llvmpipe as well), otherwise begin() fails and items are painted by QPainter.
+
+All OpenGL objects are destroyed with OpenGL context (e.g. when viewport is moved into another window)
+and created again on next begin().
+
+\note All methods except invalidate() must be called while OpenGL context of the viewport is current. */
+class BlocksGLRenderer EASY_FINAL : protected QOpenGLExtraFunctions
+{
+public:
+
+    /** Block data stored in instance buffer. */
+    struct Instance
+    {
+        float   leftHigh; ///< Left bound of the block in scene coordinates rounded to float
+        float    leftLow; ///< Remainder of the left bound (leftHigh + leftLow gives left bound with double precision)
+        float      width; ///< Width of the block in scene coordinates
+        float      depth; ///< Depth of the block's children tree (used to paint collapsed and narrow blocks)
+        uint8_t color[4]; ///< RGBA color of the block
+        float   expanded; ///< 1 if the block is expanded, 0 otherwise
+    };
+
+    using Instances = std::vector<Instance>;
+
+    /** Parameters of one painting of the diagram. */
+    struct Frame
+    {
+        QPointF          origin; ///< Position of the item's coordinates origin on the viewport
+        QSizeF         viewport; ///< Size of the viewport
+        qreal            offset; ///< Left bound of the visible region in scene coordinates
+        qreal             scale; ///< Current scale (pixels per scene unit)
+        float          minWidth; ///< Minimum width of blocks in scene coordinates
+        float         minPixels; ///< Minimum width of blocks in pixels
+        float        narrowSize; ///< Width in pixels below which children of blocks are hidden (if hideNarrow is true)
+        float         rowHeight; ///< Height of one row in pixels
+        float       rowFullSize; ///< Height of one row with spacing in pixels
+        bool         hideNarrow; ///< Paint narrow blocks as collapsed
+        bool        hideMinSize; ///< Do not paint blocks (except top-level blocks) which width is less than minPixels
+        bool            borders; ///< Paint borders of blocks
+        uint32_t    borderColor; ///< ARGB color of borders
+    };
+
+private:
+
+    struct LevelBuffer
+    {
+        QOpenGLBuffer  buffer; ///< Instance buffer
+        int             count; ///< Number of uploaded instances
+        uint32_t   generation; ///< Value of m_generation at upload time
+
+        LevelBuffer() : buffer(QOpenGLBuffer::VertexBuffer), count(0), generation(0) {}
+    };
+
+    using LevelBuffers = std::vector<std::unique_ptr<LevelBuffer> >;
+    using ItemBuffers = std::vector<LevelBuffers>;
+    using ProgramPtr = std::unique_ptr<QOpenGLShaderProgram>;
+
+    ItemBuffers                       m_buffers; ///< Instance buffers for each level of each item
+    ProgramPtr                        m_program; ///< Shader program (recreated for new OpenGL context)
+    QMetaObject::Connection m_contextConnection; ///< Connection to QOpenGLContext::aboutToBeDestroyed
+    QOpenGLBuffer                     m_corners; ///< Vertices of the unit quad
+    QOpenGLVertexArrayObject              m_vao; ///<
+    Frame                               m_frame; ///< Parameters of current painting (see begin())
+    int                                 m_topId; ///< Location of "top" uniform
+    int                         m_hideMinSizeId; ///< Location of "hideMinSize" uniform
+    uint32_t                       m_generation; ///< Incremented by invalidate()
+    bool                          m_initialized; ///< True if initialize() was called
+    bool                            m_supported; ///< True if OpenGL context supports instancing and shaders are compiled
+
+public:
+
+    BlocksGLRenderer();
+    ~BlocksGLRenderer();
+
+    /** \brief Prepares OpenGL state for painting blocks.
+
+    Returns false if painting with OpenGL is not possible (not an OpenGL paint engine, unsupported OpenGL version
+    or complex transformation). Otherwise QPainter::beginNativePainting() is called and end() must be called
+    after painting. */
+    bool begin(QPainter* _painter, const Frame& _frame);
+
+    /** \brief Restores OpenGL state and calls QPainter::endNativePainting(). */
+    void end(QPainter* _painter);
+
+    ///< Returns true if blocks of specified level of specified item are uploaded and valid.
+    bool isUploaded(uint8_t _item, uint8_t _level) const;
+
+    ///< Uploads blocks of specified level of specified item into instance buffer.
+    void upload(uint8_t _item, uint8_t _level, const Instances& _instances);
+
+    /** \brief Paints blocks [_first, _first + _count) of specified level.
+
+    \param _top Position of the level's top in item's coordinates
+    \param _topLevel True for the first level (its blocks are never hidden by hideMinSize) */
+    void paintLevel(uint8_t _item, uint8_t _level, qreal _top, uint32_t _first, uint32_t _count, bool _topLevel);
+
+    /** \brief Marks all uploaded blocks as invalid.
+
+    Must be called when blocks, their colors or expanded state change. Does not require current OpenGL context. */
+    void invalidate();
+
+private:
+
+    bool initialize();
+
+    ///< Destroys all OpenGL objects. OpenGL context must be current.
+    void release();
+
+}; // END of class BlocksGLRenderer.
+
+//////////////////////////////////////////////////////////////////////////
+
+#endif // EASY_GRAPHICS_OPENGL_VIEWPORT
+
+#endif // EASY_PROFILER_BLOCKS_GL_RENDERER_H
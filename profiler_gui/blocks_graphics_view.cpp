@@ -80,6 +80,10 @@
 #include <QSplitter>
 #include <QWheelEvent>
 
+#ifdef EASY_GRAPHICS_OPENGL_VIEWPORT
+# include <QOpenGLWidget>
+#endif
+
 #include "arbitrary_value_tooltip.h"
 #include "blocks_graphics_view.h"
 #include "bookmarks_editor.h"
@@ -701,6 +705,7 @@ BlocksGraphicsView::BlocksGraphicsView(QWidget* _parent)
     , m_bHovered(false)
 {
     initMode();
+    updateViewportWidget();
     setScene(new QGraphicsScene(this));
     updateVisibleSceneRect();
 }
@@ -708,6 +713,7 @@ BlocksGraphicsView::BlocksGraphicsView(QWidget* _parent)
 BlocksGraphicsView::~BlocksGraphicsView()
 {
     removePopup();
+    releaseGLRenderer();
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -742,6 +748,49 @@ void BlocksGraphicsView::removePopup()
     m_isArbitraryValueTooltip = false;
 }
 
+void BlocksGraphicsView::updateViewportWidget()
+{
+#ifdef EASY_GRAPHICS_OPENGL_VIEWPORT
+    const bool isOpenGL = qobject_cast<QOpenGLWidget*>(viewport()) != nullptr;
+    if (isOpenGL == EASY_GLOBALS.opengl_viewport)
+        return;
+
+    releaseGLRenderer();
+
+    if (EASY_GLOBALS.opengl_viewport)
+    {
+        // Default format is enough: desktop drivers (including Mesa llvmpipe) create the highest
+        // supported compatibility profile context, BlocksGLRenderer checks required version itself
+        setViewport(new QOpenGLWidget());
+        m_glRenderer.reset(new BlocksGLRenderer());
+    }
+    else
+    {
+        setViewport(new QWidget());
+    }
+#endif
+}
+
+void BlocksGraphicsView::releaseGLRenderer()
+{
+#ifdef EASY_GRAPHICS_OPENGL_VIEWPORT
+    if (m_glRenderer == nullptr)
+        return;
+
+    auto widget = qobject_cast<QOpenGLWidget*>(viewport());
+    if (widget != nullptr && widget->context() != nullptr)
+    {
+        widget->makeCurrent();
+        m_glRenderer.reset();
+        widget->doneCurrent();
+    }
+    else
+    {
+        m_glRenderer.reset();
+    }
+#endif
+}
+
 bool BlocksGraphicsView::needToIgnoreMouseEvent() const
 {
     if (!m_isArbitraryValueTooltip)
@@ -804,6 +853,11 @@ void BlocksGraphicsView::clear()
     m_selectedBlocks.clear();
     m_backgroundItem = nullptr;
 
+#ifdef EASY_GRAPHICS_OPENGL_VIEWPORT
+    if (m_glRenderer != nullptr)
+        m_glRenderer->invalidate();
+#endif
+
     profiler_gui::set_max(m_beginTime); // reset begin time
     m_scale = 1; // scale back to initial 100% scale
     m_timelineStep = 1;
@@ -927,12 +981,14 @@ void BlocksGraphicsView::setTree(const profiler::thread_blocks_tree_t& _blocksTr
     m_beginTime -= std::min(m_beginTime, additional_offset);
     EASY_GLOBALS.begin_time = m_beginTime;
 
-    // Sort threads by name
+    // Sort threads by name grouping them by process (for multi-process captures)
     std::vector<std::reference_wrapper<const profiler::BlocksTreeRoot> > sorted_roots;
     sorted_roots.reserve(_blocksTree.size());
     for (const auto& threadTree : _blocksTree)
         sorted_roots.emplace_back(threadTree.second);
     std::sort(sorted_roots.begin(), sorted_roots.end(), [](const profiler::BlocksTreeRoot& _a, const profiler::BlocksTreeRoot& _b) {
+        if (_a.process_id != _b.process_id)
+            return _a.process_id < _b.process_id;
         return _a.thread_name < _b.thread_name;
     });
 
@@ -943,6 +999,7 @@ void BlocksGraphicsView::setTree(const profiler::thread_blocks_tree_t& _blocksTr
     m_items.reserve(_blocksTree.size());
     qreal y = EASY_GLOBALS.size.timeline_height;
     const GraphicsBlockItem *longestItem = nullptr, *mainThreadItem = nullptr;
+    profiler::processid_t process_id = sorted_roots.front().get().process_id;
     for (const profiler::BlocksTreeRoot& t : sorted_roots)
     {
         if (m_items.size() == 0xff)
@@ -951,6 +1008,13 @@ void BlocksGraphicsView::setTree(const profiler::thread_blocks_tree_t& _blocksTr
             break;
         }
 
+        if (t.process_id != process_id)
+        {
+            // Separate threads of different processes
+            process_id = t.process_id;
+            y += threads_spacing * 4;
+        }
+
         // fill scene with new items
         qreal h = 0, x = 0;
         
@@ -970,6 +1034,7 @@ void BlocksGraphicsView::setTree(const profiler::thread_blocks_tree_t& _blocksTr
         {
             uint32_t dummy = 0;
             children_duration = setTree(item, t.children, h, dummy, y, 0);
+            item->buildLevelsOfDetail();
         }
         else
         {
@@ -1108,7 +1173,7 @@ qreal BlocksGraphicsView::setTree(GraphicsBlockItem* _item, const profiler::Bloc
     for (auto child_index : _children)
     {
         auto& gui_block = easyBlock(child_index);
-        const auto& child = gui_block.tree;
+        const auto& child = easyBlocksTree(child_index);
         if (child.depth > maxDepth)
         {
             maxDepth = child.depth;
@@ -1184,7 +1249,6 @@ qreal BlocksGraphicsView::setTree(GraphicsBlockItem* _item, const profiler::Bloc
         b.max_depth_child = maxDepthChild;
 #endif
 
-        b.setPos(xbegin, duration);
         //b.totalHeight = profiler_gui::GRAPHICS_ROW_SIZE + h;
 
         prev_end = xbegin + duration;
@@ -1260,6 +1324,13 @@ void BlocksGraphicsView::updateTimelineStep(qreal _windowWidth)
 }
 
 void BlocksGraphicsView::repaintScene()
+{
+    for (auto item : m_items)
+        item->invalidateTiles();
+    repaintVisibleRegion();
+}
+
+void BlocksGraphicsView::repaintVisibleRegion()
 {
     scene()->update(m_visibleSceneRect);
     emit sceneUpdated();
@@ -1389,7 +1460,7 @@ void BlocksGraphicsView::onWheel(qreal _scenePos, int _wheelDelta)
 
     updateVisibleSceneRect(); // Update scene rect
     updateTimelineStep(m_visibleRegionWidth);
-    repaintScene(); // repaint scene
+    repaintVisibleRegion(); // repaint scene
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -1545,6 +1616,7 @@ void BlocksGraphicsView::mouseReleaseEvent(QMouseEvent* _event)
     }
 
     const profiler_gui::EasyBlock* selectedBlock = nullptr;
+    profiler::block_index_t selectedBlockIndex = ~0U;
     profiler::thread_id_t selectedBlockThread = 0;
     bool jumpToZone = false;
     bool changedSelectionBySelectingItem = false;
@@ -1586,9 +1658,10 @@ void BlocksGraphicsView::mouseReleaseEvent(QMouseEvent* _event)
                 {
                     changedSelectedItem = true;
                     selectedBlock = block;
+                    selectedBlockIndex = i;
                     selectedBlockThread = item->threadId();
                     EASY_GLOBALS.selected_block = i;
-                    EASY_GLOBALS.selected_block_id = block->tree.node->id();
+                    EASY_GLOBALS.selected_block_id = easyBlocksTree(i).node->id();
                     break;
                 }
             }
@@ -1651,8 +1724,9 @@ void BlocksGraphicsView::mouseReleaseEvent(QMouseEvent* _event)
         profiler::timestamp_t left=0, right=0;
         if (changedSelectionBySelectingItem)
         {
-            left = selectedBlock->tree.node->begin() - m_beginTime;
-            right = selectedBlock->tree.node->end() - m_beginTime;
+            const auto& selectedTree = easyBlocksTree(selectedBlockIndex);
+            left = selectedTree.node->begin() - m_beginTime;
+            right = selectedTree.node->end() - m_beginTime;
         }
         else
         {
@@ -1679,15 +1753,15 @@ void BlocksGraphicsView::mouseReleaseEvent(QMouseEvent* _event)
 
         if (selectedBlock != nullptr && isDoubleClick)
         {
-            if (!selectedBlock->tree.children.empty())
+            if (!easyBlocksTree(selectedBlockIndex).children.empty())
             {
                 auto& selected = EASY_GLOBALS.gui_blocks[EASY_GLOBALS.selected_block];
                 selected.expanded = !selected.expanded;
                 emit EASY_GLOBALS.events.itemsExpandStateChanged();
             }
-            else if (easyDescriptor(selectedBlock->tree.node->id()).type() == profiler::BlockType::Value)
+            else if (easyDescriptor(easyBlocksTree(selectedBlockIndex).node->id()).type() == profiler::BlockType::Value)
             {
-                emit EASY_GLOBALS.events.selectValue(selectedBlockThread, EASY_GLOBALS.selected_block, *selectedBlock->tree.value);
+                emit EASY_GLOBALS.events.selectValue(selectedBlockThread, EASY_GLOBALS.selected_block, *easyBlocksTree(selectedBlockIndex).value);
             }
         }
 
@@ -1787,7 +1861,7 @@ void BlocksGraphicsView::onZoomSelection()
 
     updateVisibleSceneRect(); // Update scene rect
     updateTimelineStep(m_visibleRegionWidth);
-    repaintScene(); // repaint scene
+    repaintVisibleRegion(); // repaint scene
 }
 
 void BlocksGraphicsView::onInspectCurrentView(bool strict)
@@ -1996,7 +2070,7 @@ void BlocksGraphicsView::mouseMoveEvent(QMouseEvent* event)
 
     if (needUpdate)
     {
-        repaintScene(); // repaint scene
+        repaintVisibleRegion(); // repaint scene
     }
 
     event->accept();
@@ -2082,7 +2156,7 @@ void BlocksGraphicsView::resizeEvent(QResizeEvent* event)
     notifyVisibleRegionPosChange();
     guard.restore();
 
-    repaintScene(); // repaint scene
+    repaintVisibleRegion(); // repaint scene
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -2117,6 +2191,10 @@ void BlocksGraphicsView::initMode()
         setTree(EASY_GLOBALS.profiler_blocks);
     });
 
+    connect(globalSignals, &GlobalSignals::dataGoingToBeChanged, this, &This::onDataGoingToBeChanged);
+    connect(globalSignals, &GlobalSignals::dataChanged, this, &This::onDataChanged);
+    connect(globalSignals, &GlobalSignals::liveBlocksAppended, this, &This::onLiveBlocksAppended);
+
     connect(globalSignals, &GlobalSignals::selectedBlockIdChanged, [this](profiler::block_id_t)
     {
         if (profiler_gui::is_max(EASY_GLOBALS.selected_block_id))
@@ -2195,13 +2273,45 @@ void BlocksGraphicsView::onGraphicsScrollbarValueChange(qreal value)
         if (!m_bUpdatingRect)
         {
             updateVisibleSceneRect();
-            repaintScene();
+            repaintVisibleRegion();
         }
     }
 }
 
 //////////////////////////////////////////////////////////////////////////
 
+void BlocksGraphicsView::onDataGoingToBeChanged()
+{
+    // Levels of detail are built from global blocks
+    for (auto item : m_items)
+        item->stopLevelsOfDetail();
+}
+
+void BlocksGraphicsView::onDataChanged()
+{
+    for (auto item : m_items)
+        item->resumeLevelsOfDetail();
+}
+
+void BlocksGraphicsView::onLiveBlocksAppended()
+{
+    // Live capture: rebuild scene keeping current scale and follow its right edge,
+    // so the newest frames are always visible (like on an oscilloscope screen).
+    const bool wasEmpty = m_bEmpty;
+    const auto scale = m_scale;
+
+    setTree(EASY_GLOBALS.profiler_blocks);
+    if (m_bEmpty)
+        return;
+
+    if (!wasEmpty)
+        scaleTo(scale);
+
+    notifyVisibleRegionPosChange(m_sceneWidth - m_visibleRegionWidth);
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 void BlocksGraphicsView::onFlickerTimeout()
 {
     ++m_flickerCounterX;
@@ -2232,7 +2342,7 @@ void BlocksGraphicsView::onFlickerTimeout()
         // because if scrollbar does not emit valueChanged signal then viewport does not move
 
         updateVisibleSceneRect(); // Update scene visible rect only once
-        repaintScene(); // repaint scene
+        repaintVisibleRegion(); // repaint scene
 
         const int dx = static_cast<int>(sign(m_flickerSpeedX) * m_flickerCounterX / FLICKER_FACTOR);
         const int dy = static_cast<int>(sign(m_flickerSpeedY) * m_flickerCounterY / FLICKER_FACTOR);
@@ -2303,7 +2413,7 @@ void BlocksGraphicsView::onIdleTimeout()
         auto cse = item->intersectEvent(pos);
         if (cse != nullptr)
         {
-            const auto& itemBlock = cse->tree;
+            const auto& itemBlock = *cse;
 
             auto widget = new QWidget(this, Qt::ToolTip | Qt::WindowTransparentForInput);
             if (widget == nullptr)
@@ -2327,13 +2437,13 @@ void BlocksGraphicsView::onIdleTimeout()
             profiler::thread_id_t tid = 0;
             if (EASY_GLOBALS.version < profiler_gui::V130)
             {
-                tid = cse->tree.node->id();
-                process_name = cse->tree.node->name();
+                tid = cse->node->id();
+                process_name = cse->node->name();
             }
             else
             {
-                tid = cse->tree.cs->tid();
-                process_name = cse->tree.cs->name();
+                tid = cse->cs->tid();
+                process_name = cse->cs->name();
             }
 
             auto it = EASY_GLOBALS.profiler_blocks.find(tid);
@@ -2407,7 +2517,7 @@ void BlocksGraphicsView::onIdleTimeout()
         auto block = item->intersect(pos, i);
         if (block != nullptr)
         {
-            const auto& itemBlock = block->tree;
+            const auto& itemBlock = easyBlocksTree(i);
             const auto& itemDesc = easyDescriptor(itemBlock.node->id());
 
             if (itemDesc.type() == profiler::BlockType::Value)
@@ -2451,7 +2561,7 @@ void BlocksGraphicsView::onIdleTimeout()
 
                     profiler::timestamp_t children_duration = 0;
                     for (auto child : itemBlock.children)
-                        children_duration += easyBlock(child).tree.node->duration();
+                        children_duration += easyBlocksTree(child).node->duration();
 
                     const auto self_duration = duration - children_duration;
                     const auto self_percent =
@@ -2530,7 +2640,7 @@ void BlocksGraphicsView::onIdleTimeout()
                         auto it = std::lower_bound(threadRoot.sync.begin(), threadRoot.sync.end(), itemBlock.node->begin(),
                                                      [](profiler::block_index_t _cs_index, profiler::timestamp_t _val)
                         {
-                            return EASY_GLOBALS.gui_blocks[_cs_index].tree.node->begin() < _val;
+                            return easyBlocksTree(_cs_index).node->begin() < _val;
                         });
 
                         if (it != threadRoot.sync.end())
@@ -2548,7 +2658,7 @@ void BlocksGraphicsView::onIdleTimeout()
                         for (auto ncs = static_cast<profiler::block_index_t>(threadRoot.sync.size()); ind < ncs; ++ind)
                         {
                             auto cs_index = threadRoot.sync[ind];
-                            const auto cs = EASY_GLOBALS.gui_blocks[cs_index].tree.node;
+                            const auto cs = easyBlocksTree(cs_index).node;
 
                             if (cs->begin() > itemBlock.node->end())
                                 break;
@@ -2783,7 +2893,7 @@ void BlocksGraphicsView::onSelectedBlockChange(unsigned int _block_index)
                 emit EASY_GLOBALS.events.unlockCharts();
             }
 
-            m_pScrollbar->setHistogramSource(EASY_GLOBALS.selected_thread, guiblock.tree.node->id());
+            m_pScrollbar->setHistogramSource(EASY_GLOBALS.selected_thread, easyBlocksTree(_block_index).node->id());
         }
         else if (EASY_GLOBALS.selected_thread != 0)
         {
@@ -2810,6 +2920,12 @@ void BlocksGraphicsView::onSelectedBlockChange(unsigned int _block_index)
 
 void BlocksGraphicsView::onRefreshRequired()
 {
+#ifdef EASY_GRAPHICS_OPENGL_VIEWPORT
+    // Expanded state or colors of blocks could be changed
+    if (m_glRenderer != nullptr)
+        m_glRenderer->invalidate();
+#endif
+
     if (!m_bUpdatingRect)
     {
         repaintScene();
@@ -3184,7 +3300,7 @@ void ThreadNamesWidget::onIdleTimeout()
         profiler::timestamp_t duration = 0;
         const auto& root = intersectingItem->root();
         if (!root.children.empty())
-            duration = easyBlock(root.children.back()).tree.node->end() - easyBlock(root.children.front()).tree.node->begin();
+            duration = easyBlocksTree(root.children.back()).node->end() - easyBlocksTree(root.children.front()).node->begin();
 
         lay->addWidget(new QLabel("Time:", widget), row, 0, Qt::AlignRight);
         lay->addWidget(new QLabel(profiler_gui::timeStringRealNs(EASY_GLOBALS.time_units, duration, 3), widget), row, 1, Qt::AlignLeft);
@@ -64,6 +64,7 @@
 #define EASY_GRAPHICS_VIEW_H
 
 #include <stdlib.h>
+#include <memory>
 #include <unordered_set>
 
 #include <QGraphicsView>
@@ -76,6 +77,7 @@
 
 #include <easy/reader.h>
 
+#include "blocks_gl_renderer.h"
 #include "common_functions.h"
 
 //////////////////////////////////////////////////////////////////////////
@@ -213,6 +215,9 @@ private:
     GraphicsRulerItem*              m_rulerItem; ///< Pointer to the GraphicsRulerItem which is displayed when you double click left mouse button and move mouse left or right. This item is used only to measure time.
     BackgroundItem*            m_backgroundItem; ///<
     QWidget*                      m_popupWidget; ///<
+#ifdef EASY_GRAPHICS_OPENGL_VIEWPORT
+    std::unique_ptr<BlocksGLRenderer> m_glRenderer; ///< Paints blocks when QOpenGLWidget is used as viewport (see EASY_GLOBALS.opengl_viewport)
+#endif
     int                         m_flickerSpeedX; ///< Current flicking speed x
     int                         m_flickerSpeedY; ///< Current flicking speed y
     int                       m_flickerCounterX;
@@ -259,6 +264,9 @@ public:
 
     bool getSelectionRegionForSaving(profiler::timestamp_t& _beginTime, profiler::timestamp_t& _endTime) const;
 
+    /** Replaces viewport widget with QOpenGLWidget or QWidget according to EASY_GLOBALS.opengl_viewport. */
+    void updateViewportWidget();
+
     void inspectCurrentView(bool _strict) {
         onInspectCurrentView(_strict);
     }
@@ -266,6 +274,7 @@ public:
 public slots:
     void onWindowActivationChanged();
     void repaintHistogramImage();
+    void repaintScene();
 
 signals:
 
@@ -288,6 +297,9 @@ private:
     void removePopup();
     bool needToIgnoreMouseEvent() const;
 
+    /** Destroys BlocksGLRenderer while OpenGL context of the viewport is current. */
+    void releaseGLRenderer();
+
     GraphicsRulerItem* createRuler(bool _main = true);
     bool moveChrono(GraphicsRulerItem* ruler_item, qreal mouse_x);
     void initMode();
@@ -301,13 +313,17 @@ private:
 
     void revalidateOffset();
 
+    /** Repaints scene after changing visible region only (scrolling, scaling or resizing).
+
+    Unlike repaintScene() this keeps cached tiles of GraphicsBlockItem valid. */
+    void repaintVisibleRegion();
+
     void addSelectionToStatsTree();
 
 private slots:
 
     // Private Slots
 
-    void repaintScene();
     void onGraphicsScrollbarWheel(qreal _scenePos, int _wheelDelta);
     void onScrollbarValueChange(int);
     void onGraphicsScrollbarValueChange(qreal);
@@ -317,6 +333,9 @@ private slots:
     void onSelectedThreadChange(::profiler::thread_id_t id);
     void onSelectedBlockChange(unsigned int _block_index);
     void onRefreshRequired();
+    void onDataGoingToBeChanged();
+    void onDataChanged();
+    void onLiveBlocksAppended();
     void onThreadViewChanged();
     void onZoomSelection();
     void onInspectCurrentView(bool _strict);
@@ -340,6 +359,14 @@ public:
         return m_visibleSceneRect;
     }
 
+#ifdef EASY_GRAPHICS_OPENGL_VIEWPORT
+    ///< Returns renderer for QOpenGLWidget viewport or nullptr if viewport is not an OpenGL widget.
+    BlocksGLRenderer* glRenderer() const
+    {
+        return m_glRenderer.get();
+    }
+#endif
+
     qreal timelineStep() const
     {
         return m_timelineStep;
@@ -61,6 +61,8 @@
 *                   : limitations under the License.
 ************************************************************************/
 
+#include <algorithm>
+#include <unordered_set>
 #include <QAction>
 #include <QActionGroup>
 #include <QApplication>
@@ -79,6 +81,7 @@
 #include <QSettings>
 #include <QSignalBlocker>
 #include <QToolBar>
+#include <QTreeWidgetItemIterator>
 #include <QVBoxLayout>
 
 #include "blocks_tree_widget.h"
@@ -141,6 +144,11 @@ const bool PLAIN_MODE_COLUMNS[COL_COLUMNS_NUMBER] = {
     , true  // COL_AVG_PER_AREA,
     , true  // COL_MEDIAN_PER_AREA,
     , true  // COL_NCALLS_PER_AREA,
+    , true  // COL_IPC,
+    , true  // COL_CACHE_MISSES_PKI,
+    , true  // COL_PAGE_FAULTS,
+    , true  // COL_ALLOCS,
+    , true  // COL_ALLOC_BYTES,
 };
 
 const bool SELECTION_MODE_COLUMNS[COL_COLUMNS_NUMBER] = {
@@ -183,6 +191,11 @@ const bool SELECTION_MODE_COLUMNS[COL_COLUMNS_NUMBER] = {
     , true  // COL_AVG_PER_AREA,
     , true  // COL_MEDIAN_PER_AREA,
     , true  // COL_NCALLS_PER_AREA,
+    , false // COL_IPC,
+    , false // COL_CACHE_MISSES_PKI,
+    , false // COL_PAGE_FAULTS,
+    , false // COL_ALLOCS,
+    , false // COL_ALLOC_BYTES,
 };
 
 } // end of namespace <noname>.
@@ -269,6 +282,18 @@ BlocksTreeWidget::BlocksTreeWidget(QWidget* _parent)
     header_item->setText(COL_MEDIAN_PER_AREA,      "Mdn/area");
     header_item->setText(COL_NCALLS_PER_AREA,      "N/area");
 
+    header_item->setText(COL_IPC,              "IPC");
+    header_item->setText(COL_CACHE_MISSES_PKI, "CacheMiss/Kinstr");
+    header_item->setText(COL_PAGE_FAULTS,      "PageFaults");
+    header_item->setToolTip(COL_IPC, "Instructions per cycle\n(captured with profiler::setPerfCounters)");
+    header_item->setToolTip(COL_CACHE_MISSES_PKI, "Last level cache misses per 1000 instructions\n(captured with profiler::setPerfCounters)");
+    header_item->setToolTip(COL_PAGE_FAULTS, "Page faults\n(captured with profiler::setPerfCounters)");
+
+    header_item->setText(COL_ALLOCS,      "Allocs");
+    header_item->setText(COL_ALLOC_BYTES, "Bytes");
+    header_item->setToolTip(COL_ALLOCS, "Number of memory allocations inside block including its children\n(captured with EASY_ALLOC or easy_profiler_malloc library)");
+    header_item->setToolTip(COL_ALLOC_BYTES, "Allocated memory in bytes inside block including its children\n(captured with EASY_ALLOC or easy_profiler_malloc library)");
+
     auto color = QColor::fromRgb(profiler::colors::DeepOrange900);
     header_item->setForeground(COL_MIN_PER_THREAD, color);
     header_item->setForeground(COL_MAX_PER_THREAD, color);
@@ -314,6 +339,11 @@ BlocksTreeWidget::BlocksTreeWidget(QWidget* _parent)
             this, &This::onSelectedThreadChange, Qt::QueuedConnection);
     connect(&EASY_GLOBALS.events, &profiler_gui::GlobalSignals::selectedBlockChanged,
             this, &This::onSelectedBlockChange, Qt::QueuedConnection);
+    connect(&EASY_GLOBALS.events, &profiler_gui::GlobalSignals::dataGoingToBeChanged, this, [this] {
+        // Tree builder reads global blocks and descriptors: interrupt building
+        if (m_bLocked)
+            clearSilent();
+    });
     connect(&m_fillTimer, &QTimer::timeout, this, &This::onFillTimerTimeout);
     connect(&m_idleTimer, &QTimer::timeout, this, &This::onIdleTimeout);
     m_idleTimer.setInterval(500);
@@ -652,6 +682,7 @@ void BlocksTreeWidget::clearSilent(bool _global)
     const QSignalBlocker b(this);
 
     m_treeBuilder.interrupt();
+    m_treeBuilder.releaseFetchContext();
     destroyProgressDialog();
     m_hintLabel->show();
 
@@ -711,6 +742,7 @@ void BlocksTreeWidget::resetSearch(bool repaint)
 
     m_bCaseSensitiveSearch = false;
     m_lastSearch.clear();
+    m_foundBlocks.clear();
     m_lastFound = nullptr;
     m_lastFoundIndex = 0;
 
@@ -753,8 +785,16 @@ int BlocksTreeWidget::findNext(const QString& _str, Qt::MatchFlags _flags)
         return 0;
     }
 
+    if (m_mode == TreeMode::Full && EASY_GLOBALS.names_index.ready())
+    {
+        // Rows of the full call-stack tree are created on demand, so blocks are searched in the index
+        return findIndexed(_str, _flags.testFlag(Qt::MatchCaseSensitive), true);
+    }
+
     const bool isNewSearch = (m_lastSearch != _str);
-    auto itemsList = findItems(_str, Qt::MatchContains | Qt::MatchRecursive | _flags, COL_NAME);
+    auto itemsList = EASY_GLOBALS.names_index.ready()
+        ? findIndexedItems(_str, _flags.testFlag(Qt::MatchCaseSensitive))
+        : findItems(_str, Qt::MatchContains | Qt::MatchRecursive | _flags, COL_NAME);
 
     m_bCaseSensitiveSearch = _flags.testFlag(Qt::MatchCaseSensitive);
 
@@ -817,8 +857,16 @@ int BlocksTreeWidget::findPrev(const QString& _str, Qt::MatchFlags _flags)
         return 0;
     }
 
+    if (m_mode == TreeMode::Full && EASY_GLOBALS.names_index.ready())
+    {
+        // Rows of the full call-stack tree are created on demand, so blocks are searched in the index
+        return findIndexed(_str, _flags.testFlag(Qt::MatchCaseSensitive), false);
+    }
+
     const bool isNewSearch = (m_lastSearch != _str);
-    auto itemsList = findItems(_str, Qt::MatchContains | Qt::MatchRecursive | _flags, COL_NAME);
+    auto itemsList = EASY_GLOBALS.names_index.ready()
+        ? findIndexedItems(_str, _flags.testFlag(Qt::MatchCaseSensitive))
+        : findItems(_str, Qt::MatchContains | Qt::MatchRecursive | _flags, COL_NAME);
 
     m_bCaseSensitiveSearch = _flags.testFlag(Qt::MatchCaseSensitive);
 
@@ -874,6 +922,138 @@ int BlocksTreeWidget::findPrev(const QString& _str, Qt::MatchFlags _flags)
     return itemsList.size();
 }
 
+void BlocksTreeWidget::findBlocks(const QString& _str, bool _caseSensitive)
+{
+    m_foundBlocks.clear();
+
+    const auto names = EASY_GLOBALS.names_index.find(_str, _caseSensitive);
+    if (names.empty())
+    {
+        return;
+    }
+
+    for (int i = 0, count = topLevelItemCount(); i < count; ++i)
+    {
+        const auto threadId = static_cast<TreeWidgetItem*>(topLevelItem(i))->threadId();
+        const auto first = m_foundBlocks.size();
+
+        for (auto name : names)
+        {
+            const auto& threads = EASY_GLOBALS.names_index.blocks(name);
+            auto it = threads.find(threadId);
+            if (it == threads.end())
+            {
+                continue;
+            }
+
+            for (auto block_index : it->second)
+            {
+                if (m_treeBuilder.inSelection(block_index))
+                {
+                    m_foundBlocks.push_back(block_index);
+                }
+            }
+        }
+
+        if (names.size() > 1)
+        {
+            // Merge blocks with different names in the order of call-stack tree (parents before children)
+            std::sort(m_foundBlocks.begin() + first, m_foundBlocks.end(), [] (profiler::block_index_t _a, profiler::block_index_t _b)
+            {
+                const auto a = easyBlocksTree(_a).node;
+                const auto b = easyBlocksTree(_b).node;
+                return a->begin() < b->begin() || (a->begin() == b->begin() && a->end() > b->end());
+            });
+        }
+    }
+}
+
+QList<QTreeWidgetItem*> BlocksTreeWidget::findIndexedItems(const QString& _str, bool _caseSensitive)
+{
+    // Plain and aggregate trees are built completely (only the full call-stack tree creates rows on demand),
+    // so their rows are matched by names found in the index instead of comparing text of every row
+    QList<QTreeWidgetItem*> items;
+
+    const auto ids = EASY_GLOBALS.names_index.find(_str, _caseSensitive);
+    if (ids.empty())
+    {
+        return items;
+    }
+
+    std::unordered_set<std::string> names;
+    for (auto id : ids)
+    {
+        names.insert(EASY_GLOBALS.names_index.text(id));
+    }
+
+    // The same order as findItems() with Qt::MatchRecursive, thread rows are not blocks and are skipped
+    for (QTreeWidgetItemIterator it(this); *it != nullptr; ++it)
+    {
+        if ((*it)->parent() == nullptr)
+        {
+            continue;
+        }
+
+        const auto& tree = static_cast<TreeWidgetItem*>(*it)->block();
+        const auto name = *tree.node->name() != 0 ? tree.node->name() : easyDescriptor(tree.node->id()).name();
+        if (names.find(name) != names.end())
+        {
+            items.push_back(*it);
+        }
+    }
+
+    return items;
+}
+
+int BlocksTreeWidget::findIndexed(const QString& _str, bool _caseSensitive, bool _forward)
+{
+    const bool isNewSearch = (m_lastSearch != _str);
+    if (isNewSearch || m_bCaseSensitiveSearch != _caseSensitive)
+    {
+        findBlocks(_str, _caseSensitive);
+    }
+
+    m_lastSearch = _str;
+    m_bCaseSensitiveSearch = _caseSensitive;
+    m_lastFound = nullptr;
+
+    const int count = static_cast<int>(m_foundBlocks.size());
+    const int step = _forward ? 1 : count - 1;
+
+    int index = 0;
+    if (count != 0)
+    {
+        if (isNewSearch)
+            index = _forward ? 0 : count - 1;
+        else
+            index = (m_lastFoundIndex + step) % count;
+    }
+
+    // Some blocks could be absent in the tree (partial blocks without visible children), skip them
+    for (int i = 0; i < count && m_lastFound == nullptr; ++i)
+    {
+        const auto block_index = m_foundBlocks[index];
+
+        auto it = m_items.find(block_index);
+        m_lastFound = it != m_items.end() ? it->second : fetchItem(block_index);
+
+        if (m_lastFound == nullptr)
+            index = (index + step) % count;
+    }
+
+    m_lastFoundIndex = m_lastFound != nullptr ? index : 0;
+
+    if (m_lastFound != nullptr)
+    {
+        scrollToItem(m_lastFound, QAbstractItemView::PositionAtCenter);
+        setCurrentItem(m_lastFound);
+    }
+
+    viewport()->update();
+
+    return count;
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 void BlocksTreeWidget::contextMenuEvent(QContextMenuEvent* _event)
@@ -1110,6 +1290,17 @@ void BlocksTreeWidget::contextMenuEvent(QContextMenuEvent* _event)
     ADD_COLUMN_ACTION(COL_MEDIAN_PER_AREA);
     ADD_COLUMN_ACTION(COL_NCALLS_PER_AREA);
 
+    hidemenu->addSeparator();
+
+    ADD_COLUMN_ACTION(COL_IPC);
+    ADD_COLUMN_ACTION(COL_CACHE_MISSES_PKI);
+    ADD_COLUMN_ACTION(COL_PAGE_FAULTS);
+
+    hidemenu->addSeparator();
+
+    ADD_COLUMN_ACTION(COL_ALLOCS);
+    ADD_COLUMN_ACTION(COL_ALLOC_BYTES);
+
 #undef ADD_STATUS_ACTION
 
     menu.exec(QCursor::pos());
@@ -1204,7 +1395,7 @@ void BlocksTreeWidget::onJumpToItemClicked(bool)
     auto block_index = action->data().toUInt();
     EASY_GLOBALS.selected_block = block_index;
     if (block_index < EASY_GLOBALS.gui_blocks.size())
-        EASY_GLOBALS.selected_block_id = easyBlock(block_index).tree.node->id();
+        EASY_GLOBALS.selected_block_id = easyBlocksTree(block_index).node->id();
     else
         profiler_gui::set_max(EASY_GLOBALS.selected_block_id);
     emit EASY_GLOBALS.events.selectedBlockChanged(block_index);
@@ -1226,12 +1417,19 @@ void BlocksTreeWidget::onCollapseAllClicked(bool)
     }
 }
 
+void BlocksTreeWidget::expandAllItems()
+{
+    // QTreeWidget::expandAll() would expand lazy items without creating their children
+    for (int i = 0, count = topLevelItemCount(); i < count; ++i)
+        static_cast<TreeWidgetItem*>(topLevelItem(i))->expandAll();
+}
+
 void BlocksTreeWidget::onExpandAllClicked(bool)
 {
     const QSignalBlocker blocker(this);
 
     m_bSilentExpandCollapse = true;
-    expandAll();
+    expandAllItems();
     resizeColumnsToContents();
     m_bSilentExpandCollapse = false;
 
@@ -1240,7 +1438,7 @@ void BlocksTreeWidget::onExpandAllClicked(bool)
         for (auto& item : m_items)
         {
             auto& b = item.second->guiBlock();
-            b.expanded = !b.tree.children.empty();
+            b.expanded = !item.second->block().children.empty();
         }
 
         emit EASY_GLOBALS.events.itemsExpandStateChanged();
@@ -1302,6 +1500,9 @@ void BlocksTreeWidget::onBlockStatusChangeClicked(bool _checked)
 
 void BlocksTreeWidget::onItemExpand(QTreeWidgetItem* _item)
 {
+    // Create children items for lazy item on first expand
+    m_treeBuilder.fetchChildren(static_cast<TreeWidgetItem*>(_item), m_items);
+
     if (!EASY_GLOBALS.bind_scene_and_tree_expand_status || _item->parent() == nullptr)
     {
         resizeColumnsToContents();
@@ -1345,7 +1546,7 @@ void BlocksTreeWidget::onCurrentItemChange(QTreeWidgetItem* _item, QTreeWidgetIt
 
         EASY_GLOBALS.selected_block = item->block_index();
         if (EASY_GLOBALS.selected_block < EASY_GLOBALS.gui_blocks.size())
-            EASY_GLOBALS.selected_block_id = easyBlock(EASY_GLOBALS.selected_block).tree.node->id();
+            EASY_GLOBALS.selected_block_id = easyBlocksTree(EASY_GLOBALS.selected_block).node->id();
         else
             profiler_gui::set_max(EASY_GLOBALS.selected_block_id);
     }
@@ -1387,7 +1588,12 @@ void BlocksTreeWidget::onSelectedBlockChange(uint32_t _block_index)
         {
             item = it->second;
         }
-        else if (m_mode != TreeMode::Full)
+        else if (m_mode == TreeMode::Full)
+        {
+            // Item may be not created yet if one of it's parents is lazy
+            item = fetchItem(_block_index);
+        }
+        else
         {
             const auto currentThread = EASY_GLOBALS.selected_thread;
             for (auto& itemPair : m_items)
@@ -1441,6 +1647,39 @@ void BlocksTreeWidget::onSelectedBlockChange(uint32_t _block_index)
     connect(this, &Parent::currentItemChanged, this, &This::onCurrentItemChange);
 }
 
+TreeWidgetItem* BlocksTreeWidget::fetchItem(profiler::block_index_t _block_index)
+{
+    const auto& target = easyBlocksTree(_block_index);
+    const auto targetBegin = target.node->begin();
+    const auto targetEnd = target.node->end();
+
+    for (auto& root : m_roots)
+    {
+        // Go down from thread item through blocks which contain target block creating lazy children on the way
+        auto parent = root.second;
+        while (parent != nullptr)
+        {
+            m_treeBuilder.fetchChildren(parent, m_items);
+
+            TreeWidgetItem* next = nullptr;
+            for (int i = 0, count = parent->childCount(); i < count; ++i)
+            {
+                auto child = static_cast<TreeWidgetItem*>(parent->child(i));
+                if (child->block_index() == _block_index)
+                    return child;
+
+                const auto& block = child->block();
+                if (next == nullptr && block.node->begin() <= targetBegin && targetEnd <= block.node->end())
+                    next = child;
+            }
+
+            parent = next;
+        }
+    }
+
+    return nullptr;
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 void BlocksTreeWidget::resizeColumnsToContents()
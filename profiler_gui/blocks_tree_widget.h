@@ -79,6 +79,7 @@ class BlocksTreeWidget : public QTreeWidget
 
     using Parent = QTreeWidget;
     using This = BlocksTreeWidget;
+    using FoundBlocks = ::std::vector<::profiler::block_index_t>;
 
 protected:
 
@@ -86,6 +87,7 @@ protected:
     Items                            m_items;
     RootsMap                         m_roots;
     ::profiler_gui::TreeBlocks m_inputBlocks;
+    FoundBlocks                m_foundBlocks;
     QTimer                       m_fillTimer;
     QTimer                       m_idleTimer;
     QString                     m_lastSearch;
@@ -120,6 +122,7 @@ public:
     int findPrev(const QString& _str, Qt::MatchFlags _flags);
 
     void resetSearch(bool repaint = true);
+    void expandAllItems();
 
     TreeMode mode() const
     {
@@ -184,6 +187,10 @@ private:
 
     void destroyProgressDialog();
     void createProgressDialog();
+    TreeWidgetItem* fetchItem(::profiler::block_index_t _block_index);
+    void findBlocks(const QString& _str, bool _caseSensitive);
+    int findIndexed(const QString& _str, bool _caseSensitive, bool _forward);
+    QList<QTreeWidgetItem*> findIndexedItems(const QString& _str, bool _caseSensitive);
 
 }; // END of class BlocksTreeWidget.
 
@@ -72,8 +72,6 @@ namespace profiler_gui {
 #pragma pack(push, 1)
 struct EasyBlockItem Q_DECL_FINAL
 {
-    qreal                              x; ///< x coordinate of the item (this is made qreal=double to avoid mistakes on very wide scene)
-    float                              w; ///< Width of the item
     ::profiler::block_index_t      block; ///< Index of profiler block
 
 #ifndef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
@@ -85,38 +83,25 @@ struct EasyBlockItem Q_DECL_FINAL
     uint32_t              children_begin; ///< Index of first child item on the next sublevel
 #endif
 
-    // Possible optimizations:
-    // 1) We can save 1 more byte per block if we will use char instead of short + real time calculations for "totalHeight" var;
-    // 2) We can save 12 bytes per block if "x" and "w" vars will be removed (all this information exist inside BlocksTree),
-    //      but this requires runtime x-coodinate calculation because BlocksTree has x value in nanoseconds.
+    // Position and width are not stored: they are calculated from block timestamps (see globals.h)
+    // to keep items of huge captures small.
 
-    inline void setPos(qreal _x, float _w) { x = _x; w = _w; }
-    inline qreal left() const { return x; }
-    inline qreal right() const { return x + w; }
-    inline float width() const { return w; }
+    inline qreal left() const;
+    inline qreal right() const;
+    inline float width() const;
 
 }; // END of struct EasyBlockItem.
 
+/** GUI state of profiler block.
+
+Stored in EASY_GLOBALS.gui_blocks parallel to EASY_GLOBALS.blocks (the same index),
+so profiler::BlocksTree loaded by the reader is not copied. */
 struct EasyBlock Q_DECL_FINAL
 {
-    ::profiler::BlocksTree       tree;
     uint32_t      graphics_item_index;
     uint8_t       graphics_item_level;
     uint8_t             graphics_item;
     bool                     expanded;
-
-    EasyBlock() = default;
-
-    EasyBlock(EasyBlock&& that) EASY_NOEXCEPT
-        : tree(::std::move(that.tree))
-        , graphics_item_index(that.graphics_item_index)
-        , graphics_item_level(that.graphics_item_level)
-        , graphics_item(that.graphics_item)
-        , expanded(that.expanded)
-    {
-    }
-
-    EasyBlock(const EasyBlock&) = delete;
 };
 #pragma pack(pop)
 
@@ -799,6 +799,39 @@ void DescriptorsTreeWidget::saveSettings()
 
 //////////////////////////////////////////////////////////////////////////
 
+QList<QTreeWidgetItem*> DescriptorsTreeWidget::findSearchItems(const QString& _str, Qt::MatchFlags _flags)
+{
+    if (m_searchColumn != DESC_COL_NAME || !EASY_GLOBALS.names_index.ready())
+    {
+        return findItems(_str, Qt::MatchContains | Qt::MatchRecursive | _flags, m_searchColumn);
+    }
+
+    ::std::vector<char> found(EASY_GLOBALS.descriptors.size(), 0);
+    for (auto name : EASY_GLOBALS.names_index.find(_str, _flags.testFlag(Qt::MatchCaseSensitive)))
+    {
+        for (auto id : EASY_GLOBALS.names_index.descriptors(name))
+        {
+            if (id < found.size())
+                found[id] = 1;
+        }
+    }
+
+    // Items are listed in the same order as QTreeWidget::findItems() does (file items have no name)
+    QList<QTreeWidgetItem*> itemsList;
+    for (int i = 0, filesNumber = topLevelItemCount(); i < filesNumber; ++i)
+    {
+        auto fileItem = topLevelItem(i);
+        for (int j = 0, childrenNumber = fileItem->childCount(); j < childrenNumber; ++j)
+        {
+            auto item = static_cast<DescriptorsTreeItem*>(fileItem->child(j));
+            if (item->desc() < found.size() && found[item->desc()] != 0)
+                itemsList.push_back(item);
+        }
+    }
+
+    return itemsList;
+}
+
 int DescriptorsTreeWidget::findNext(const QString& _str, Qt::MatchFlags _flags)
 {
     if (_str.isEmpty())
@@ -808,7 +841,7 @@ int DescriptorsTreeWidget::findNext(const QString& _str, Qt::MatchFlags _flags)
     }
 
     const bool isNewSearch = (m_lastSearchColumn != m_searchColumn || m_lastSearch != _str);
-    auto itemsList = findItems(_str, Qt::MatchContains | Qt::MatchRecursive | _flags, m_searchColumn);
+    auto itemsList = findSearchItems(_str, _flags);
     m_bCaseSensitiveSearch = _flags.testFlag(Qt::MatchCaseSensitive);
 
     if (!isNewSearch)
@@ -867,7 +900,7 @@ int DescriptorsTreeWidget::findPrev(const QString& _str, Qt::MatchFlags _flags)
     }
 
     const bool isNewSearch = (m_lastSearchColumn != m_searchColumn || m_lastSearch != _str);
-    auto itemsList = findItems(_str, Qt::MatchContains | Qt::MatchRecursive | _flags, m_searchColumn);
+    auto itemsList = findSearchItems(_str, _flags);
     m_bCaseSensitiveSearch = _flags.testFlag(Qt::MatchCaseSensitive);
 
     if (!isNewSearch)
@@ -205,6 +205,8 @@ private:
     void loadSettings();
     void saveSettings();
 
+    QList<QTreeWidgetItem*> findSearchItems(const QString& _str, Qt::MatchFlags _flags);
+
 }; // END of class DescriptorsTreeWidget.
 
 //////////////////////////////////////////////////////////////////////////
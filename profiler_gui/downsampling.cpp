@@ -0,0 +1,341 @@
+/************************************************************************
+* file name         : downsampling.cpp
+* ----------------- :
+* creation time     : 2026/10/19
+* author            : Victor Zarubkin
+* email             : v.s.zarubkin@gmail.com
+* ----------------- :
+* description       : The file contains implementation of functions used to reduce
+*                   : large arrays of chart points and durations for painting.
+* ----------------- :
+*                   :
+*                   : Licensed under either of
+*                   :     * MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+*                   :     * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+*                   : at your option.
+*                   :
+*                   : The MIT License
+*                   :
+*                   : Permission is hereby granted, free of charge, to any person obtaining a copy
+*                   : of this software and associated documentation files (the "Software"), to deal
+*                   : in the Software without restriction, including without limitation the rights
+*                   : to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+*                   : of the Software, and to permit persons to whom the Software is furnished
+*                   : to do so, subject to the following conditions:
+*                   :
+*                   : The above copyright notice and this permission notice shall be included in all
+*                   : copies or substantial portions of the Software.
+*                   :
+*                   : THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+*                   : INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+*                   : PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+*                   : LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+*                   : TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+*                   : USE OR OTHER DEALINGS IN THE SOFTWARE.
+*                   :
+*                   : The Apache License, Version 2.0 (the "License")
+*                   :
+*                   : You may not use this file except in compliance with the License.
+*                   : You may obtain a copy of the License at
+*                   :
+*                   : http://www.apache.org/licenses/LICENSE-2.0
+*                   :
+*                   : Unless required by applicable law or agreed to in writing, software
+*                   : distributed under the License is distributed on an "AS IS" BASIS,
+*                   : WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*                   : See the License for the specific language governing permissions and
+*                   : limitations under the License.
+************************************************************************/
+
+
+#include <algorithm>
+#include <cmath>
+#include "downsampling.h"
+
+#if defined(__AVX__)
+# define EASY_DOWNSAMPLING_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define EASY_DOWNSAMPLING_SSE2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+# define EASY_DOWNSAMPLING_NEON
+#endif
+
+#if defined(__AVX2__)
+# define EASY_DOWNSAMPLING_AVX2_INT64
+#elif defined(__SSE4_2__)
+# define EASY_DOWNSAMPLING_SSE42_INT64
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+# define EASY_DOWNSAMPLING_NEON_INT64
+#endif
+
+#if defined(EASY_DOWNSAMPLING_AVX) || defined(EASY_DOWNSAMPLING_AVX2_INT64)
+# include <immintrin.h>
+#elif defined(EASY_DOWNSAMPLING_SSE42_INT64)
+# include <nmmintrin.h>
+#elif defined(EASY_DOWNSAMPLING_SSE2)
+# include <emmintrin.h>
+#endif
+
+#if defined(EASY_DOWNSAMPLING_NEON) || defined(EASY_DOWNSAMPLING_NEON_INT64)
+# include <arm_neon.h>
+#endif
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////////
+
+static_assert(sizeof(QPointF) == 2 * sizeof(qreal), "QPointF is expected to be a pair of qreal (x, y)");
+
+/** Extends [_lowest, _highest] by odd values of interleaved (x, y) array of _size pairs. */
+template <class T>
+void minMaxOdd(const T* _xy, size_t _size, T& _lowest, T& _highest)
+{
+    for (size_t i = 0; i < _size; ++i)
+    {
+        const auto y = _xy[(i << 1) + 1];
+        _lowest = std::min(_lowest, y);
+        _highest = std::max(_highest, y);
+    }
+}
+
+#if defined(EASY_DOWNSAMPLING_AVX)
+
+void minMaxOdd(const double* _xy, size_t _size, double& _lowest, double& _highest)
+{
+    // Each register holds two points: (x0, y0, x1, y1), so odd lanes accumulate y
+    __m256d lo0 = _mm256_set1_pd(_lowest), lo1 = lo0;
+    __m256d hi0 = _mm256_set1_pd(_highest), hi1 = hi0;
+
+    size_t i = 0;
+    for (; i + 4 <= _size; i += 4)
+    {
+        const __m256d a = _mm256_loadu_pd(_xy + (i << 1));
+        const __m256d b = _mm256_loadu_pd(_xy + (i << 1) + 4);
+        lo0 = _mm256_min_pd(lo0, a);
+        hi0 = _mm256_max_pd(hi0, a);
+        lo1 = _mm256_min_pd(lo1, b);
+        hi1 = _mm256_max_pd(hi1, b);
+    }
+
+    lo0 = _mm256_min_pd(lo0, lo1);
+    hi0 = _mm256_max_pd(hi0, hi1);
+
+    const __m128d lo = _mm_min_pd(_mm256_castpd256_pd128(lo0), _mm256_extractf128_pd(lo0, 1));
+    const __m128d hi = _mm_max_pd(_mm256_castpd256_pd128(hi0), _mm256_extractf128_pd(hi0, 1));
+    _lowest = _mm_cvtsd_f64(_mm_unpackhi_pd(lo, lo));
+    _highest = _mm_cvtsd_f64(_mm_unpackhi_pd(hi, hi));
+
+    minMaxOdd<double>(_xy + (i << 1), _size - i, _lowest, _highest);
+}
+
+#elif defined(EASY_DOWNSAMPLING_SSE2)
+
+void minMaxOdd(const double* _xy, size_t _size, double& _lowest, double& _highest)
+{
+    // Each register holds one point: (x, y), so the upper lane accumulates y
+    __m128d lo0 = _mm_set1_pd(_lowest), lo1 = lo0;
+    __m128d hi0 = _mm_set1_pd(_highest), hi1 = hi0;
+
+    size_t i = 0;
+    for (; i + 2 <= _size; i += 2)
+    {
+        const __m128d a = _mm_loadu_pd(_xy + (i << 1));
+        const __m128d b = _mm_loadu_pd(_xy + (i << 1) + 2);
+        lo0 = _mm_min_pd(lo0, a);
+        hi0 = _mm_max_pd(hi0, a);
+        lo1 = _mm_min_pd(lo1, b);
+        hi1 = _mm_max_pd(hi1, b);
+    }
+
+    lo0 = _mm_min_pd(lo0, lo1);
+    hi0 = _mm_max_pd(hi0, hi1);
+    _lowest = _mm_cvtsd_f64(_mm_unpackhi_pd(lo0, lo0));
+    _highest = _mm_cvtsd_f64(_mm_unpackhi_pd(hi0, hi0));
+
+    minMaxOdd<double>(_xy + (i << 1), _size - i, _lowest, _highest);
+}
+
+#elif defined(EASY_DOWNSAMPLING_NEON)
+
+void minMaxOdd(const double* _xy, size_t _size, double& _lowest, double& _highest)
+{
+    // Each register holds one point: (x, y), so the upper lane accumulates y
+    float64x2_t lo0 = vdupq_n_f64(_lowest), lo1 = lo0;
+    float64x2_t hi0 = vdupq_n_f64(_highest), hi1 = hi0;
+
+    size_t i = 0;
+    for (; i + 2 <= _size; i += 2)
+    {
+        const float64x2_t a = vld1q_f64(_xy + (i << 1));
+        const float64x2_t b = vld1q_f64(_xy + (i << 1) + 2);
+        lo0 = vminq_f64(lo0, a);
+        hi0 = vmaxq_f64(hi0, a);
+        lo1 = vminq_f64(lo1, b);
+        hi1 = vmaxq_f64(hi1, b);
+    }
+
+    _lowest = vgetq_lane_f64(vminq_f64(lo0, lo1), 1);
+    _highest = vgetq_lane_f64(vmaxq_f64(hi0, hi1), 1);
+
+    minMaxOdd<double>(_xy + (i << 1), _size - i, _lowest, _highest);
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+
+template <bool MAX>
+inline profiler::timestamp_t pick(profiler::timestamp_t a, profiler::timestamp_t b)
+{
+    return MAX ? std::max(a, b) : std::min(a, b);
+}
+
+template <bool MAX>
+void pairwise(const profiler::timestamp_t* _source, size_t _pairs, profiler::timestamp_t* _destination)
+{
+    size_t i = 0;
+
+#if defined(EASY_DOWNSAMPLING_AVX2_INT64)
+    // There is no unsigned 64-bit comparison, so values are compared as signed with flipped sign bits
+    const __m256i sign = _mm256_set1_epi64x(-0x7fffffffffffffffLL - 1);
+    for (; i + 4 <= _pairs; i += 4)
+    {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_source + (i << 1)));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_source + (i << 1) + 4));
+        const __m256i even = _mm256_unpacklo_epi64(a, b); // (s0, s4, s2, s6)
+        const __m256i odd = _mm256_unpackhi_epi64(a, b);  // (s1, s5, s3, s7)
+        const __m256i greater = _mm256_cmpgt_epi64(_mm256_xor_si256(even, sign), _mm256_xor_si256(odd, sign));
+        const __m256i result = MAX ? _mm256_blendv_epi8(odd, even, greater) : _mm256_blendv_epi8(even, odd, greater);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(_destination + i), _mm256_permute4x64_epi64(result, 0xd8));
+    }
+#elif defined(EASY_DOWNSAMPLING_SSE42_INT64)
+    // There is no unsigned 64-bit comparison, so values are compared as signed with flipped sign bits
+    const __m128i sign = _mm_set1_epi64x(-0x7fffffffffffffffLL - 1);
+    for (; i + 2 <= _pairs; i += 2)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_source + (i << 1)));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_source + (i << 1) + 2));
+        const __m128i even = _mm_unpacklo_epi64(a, b); // (s0, s2)
+        const __m128i odd = _mm_unpackhi_epi64(a, b);  // (s1, s3)
+        const __m128i greater = _mm_cmpgt_epi64(_mm_xor_si128(even, sign), _mm_xor_si128(odd, sign));
+        const __m128i result = MAX ? _mm_blendv_epi8(odd, even, greater) : _mm_blendv_epi8(even, odd, greater);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(_destination + i), result);
+    }
+#elif defined(EASY_DOWNSAMPLING_NEON_INT64)
+    for (; i + 2 <= _pairs; i += 2)
+    {
+        const uint64x2x2_t v = vld2q_u64(reinterpret_cast<const uint64_t*>(_source + (i << 1))); // (s0, s2), (s1, s3)
+        const uint64x2_t greater = vcgtq_u64(v.val[0], v.val[1]);
+        const uint64x2_t result = MAX ? vbslq_u64(greater, v.val[0], v.val[1]) : vbslq_u64(greater, v.val[1], v.val[0]);
+        vst1q_u64(reinterpret_cast<uint64_t*>(_destination + i), result);
+    }
+#endif
+
+    for (; i < _pairs; ++i)
+        _destination[i] = pick<MAX>(_source[i << 1], _source[(i << 1) + 1]);
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+} // end of namespace <noname>.
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace profiler_gui {
+
+void minMaxY(const QPointF* _begin, const QPointF* _end, qreal& _lowest, qreal& _highest)
+{
+    if (_begin < _end)
+        minMaxOdd(reinterpret_cast<const qreal*>(_begin), static_cast<size_t>(_end - _begin), _lowest, _highest);
+}
+
+void downsampleMinMax(const QPointF* _begin, const QPointF* _end, qreal _left, qreal _bucketWidth, PointsBuckets& _buckets)
+{
+    _buckets.clear();
+
+    for (auto first = _begin; first < _end;)
+    {
+        const auto bucket = std::floor((first->x() - _left) / _bucketWidth);
+        const auto right = _left + (bucket + 1) * _bucketWidth;
+
+        auto last = std::lower_bound(first + 1, _end, right, [] (const QPointF& _point, qreal _x) {
+            return _point.x() < _x;
+        });
+
+        PointsBucket b;
+        b.first = *first;
+        b.last = *(last - 1);
+        b.lowest = b.highest = first->y();
+        minMaxY(first + 1, last, b.lowest, b.highest);
+        _buckets.push_back(b);
+
+        first = last;
+    }
+}
+
+void downsampleLttb(const QPointF* _begin, const QPointF* _end, size_t _threshold, std::vector<QPointF>& _result)
+{
+    _result.clear();
+
+    const auto size = static_cast<size_t>(_end - _begin);
+    if (size <= _threshold || _threshold < 3)
+    {
+        _result.assign(_begin, _end);
+        return;
+    }
+
+    _result.reserve(_threshold);
+    _result.push_back(*_begin);
+
+    // Points between the first and the last one are split into (_threshold - 2) buckets.
+    // From each bucket the point which forms the largest triangle with the previously selected point
+    // and the average point of the next bucket is selected.
+    const double every = static_cast<double>(size - 2) / (_threshold - 2);
+    size_t selected = 0;
+    for (size_t i = 0; i < _threshold - 2; ++i)
+    {
+        const auto rangeBegin = static_cast<size_t>(i * every) + 1;
+        const auto rangeEnd = static_cast<size_t>((i + 1) * every) + 1;
+        const auto nextEnd = std::min(static_cast<size_t>((i + 2) * every) + 1, size);
+
+        qreal avgX = 0, avgY = 0;
+        for (auto j = rangeEnd; j < nextEnd; ++j)
+        {
+            avgX += _begin[j].x();
+            avgY += _begin[j].y();
+        }
+
+        const auto nextSize = nextEnd - rangeEnd;
+        avgX /= nextSize;
+        avgY /= nextSize;
+
+        const auto& a = _begin[selected];
+        qreal maxArea = -1;
+        for (auto j = rangeBegin; j < rangeEnd; ++j)
+        {
+            const auto& point = _begin[j];
+            const qreal area = std::fabs((a.x() - avgX) * (point.y() - a.y()) - (a.x() - point.x()) * (avgY - a.y()));
+            if (area > maxArea)
+            {
+                maxArea = area;
+                selected = j;
+            }
+        }
+
+        _result.push_back(_begin[selected]);
+    }
+
+    _result.push_back(*(_end - 1));
+}
+
+void pairwiseMax(const profiler::timestamp_t* _source, size_t _pairs, profiler::timestamp_t* _destination)
+{
+    pairwise<true>(_source, _pairs, _destination);
+}
+
+void pairwiseMin(const profiler::timestamp_t* _source, size_t _pairs, profiler::timestamp_t* _destination)
+{
+    pairwise<false>(_source, _pairs, _destination);
+}
+
+} // END of namespace profiler_gui.
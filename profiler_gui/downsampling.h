@@ -0,0 +1,106 @@
+/************************************************************************
+* file name         : downsampling.h
+* ----------------- :
+* creation time     : 2026/10/19
+* author            : Victor Zarubkin
+* email             : v.s.zarubkin@gmail.com
+* ----------------- :
+* description       : The file contains declaration of functions used to reduce
+*                   : large arrays of chart points and durations for painting.
+* ----------------- :
+*                   :
+*                   : Licensed under either of
+*                   :     * MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+*                   :     * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+*                   : at your option.
+*                   :
+*                   : The MIT License
+*                   :
+*                   : Permission is hereby granted, free of charge, to any person obtaining a copy
+*                   : of this software and associated documentation files (the "Software"), to deal
+*                   : in the Software without restriction, including without limitation the rights
+*                   : to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+*                   : of the Software, and to permit persons to whom the Software is furnished
+*                   : to do so, subject to the following conditions:
+*                   :
+*                   : The above copyright notice and this permission notice shall be included in all
+*                   : copies or substantial portions of the Software.
+*                   :
+*                   : THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+*                   : INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+*                   : PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+*                   : LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+*                   : TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+*                   : USE OR OTHER DEALINGS IN THE SOFTWARE.
+*                   :
+*                   : The Apache License, Version 2.0 (the "License")
+*                   :
+*                   : You may not use this file except in compliance with the License.
+*                   : You may obtain a copy of the License at
+*                   :
+*                   : http://www.apache.org/licenses/LICENSE-2.0
+*                   :
+*                   : Unless required by applicable law or agreed to in writing, software
+*                   : distributed under the License is distributed on an "AS IS" BASIS,
+*                   : WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*                   : See the License for the specific language governing permissions and
+*                   : limitations under the License.
+************************************************************************/
+
+
+#ifndef EASY_PROFILER_GUI_DOWNSAMPLING_H
+#define EASY_PROFILER_GUI_DOWNSAMPLING_H
+
+#include <stddef.h>
+#include <vector>
+#include <QPointF>
+#include <easy/details/profiler_public_types.h>
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace profiler_gui {
+
+/** Summary of chart points which fall into one bucket (usually one pixel column). */
+struct PointsBucket
+{
+    QPointF   first; ///< The first point of the bucket
+    QPointF    last; ///< The last point of the bucket
+    qreal    lowest; ///< Minimum y of points of the bucket
+    qreal   highest; ///< Maximum y of points of the bucket
+};
+
+using PointsBuckets = std::vector<PointsBucket>;
+
+/** \brief Extends [_lowest, _highest] by y of points [_begin, _end).
+
+Uses SSE2/AVX on x86 and NEON on AArch64 when they are enabled for the compiler. */
+void minMaxY(const QPointF* _begin, const QPointF* _end, qreal& _lowest, qreal& _highest);
+
+/** \brief Splits points [_begin, _end) sorted by x into buckets of _bucketWidth starting from _left.
+
+Only non-empty buckets are stored into _buckets (previous contents are removed). Painting the first point,
+vertical line between minimum and maximum and the last point of each bucket gives the same picture
+as painting all points when buckets are one pixel wide (M4 aggregation). */
+void downsampleMinMax(const QPointF* _begin, const QPointF* _end, qreal _left, qreal _bucketWidth, PointsBuckets& _buckets);
+
+/** \brief Selects _threshold visually significant points of [_begin, _end) (Largest-Triangle-Three-Buckets).
+
+The first and the last points are always selected. All points are selected if there are no more than _threshold of them.
+Previous contents of _result are removed. */
+void downsampleLttb(const QPointF* _begin, const QPointF* _end, size_t _threshold, std::vector<QPointF>& _result);
+
+/** \brief Stores maximum of each pair of _source values into _destination: _destination[i] = max(_source[2i], _source[2i+1]).
+
+Uses AVX2/SSE4.2 on x86 and NEON on AArch64 when they are enabled for the compiler.
+
+\param _pairs Number of pairs (_source must contain 2 * _pairs values and _destination must contain _pairs values) */
+void pairwiseMax(const profiler::timestamp_t* _source, size_t _pairs, profiler::timestamp_t* _destination);
+
+/** \brief Stores minimum of each pair of _source values into _destination (see pairwiseMax()). */
+void pairwiseMin(const profiler::timestamp_t* _source, size_t _pairs, profiler::timestamp_t* _destination);
+
+} // END of namespace profiler_gui.
+
+//////////////////////////////////////////////////////////////////////////
+
+#endif // EASY_PROFILER_GUI_DOWNSAMPLING_H
@@ -170,6 +170,41 @@ void FileReader::load(std::stringstream& _stream)
     }, EASY_GLOBALS.enable_statistics);
 }
 
+void FileReader::load(std::unique_ptr<std::streambuf> _streamBuffer)
+{
+    interrupt();
+
+    m_jobType = JobType::Loading;
+    m_isFile = false;
+    m_isSnapshot = false;
+    m_filename.clear();
+    m_streamBuffer = std::move(_streamBuffer);
+
+    m_thread = std::thread([this] (bool _enableStatistics)
+    {
+        std::istream stream(m_streamBuffer.get());
+
+        std::ofstream cache_file(NETWORK_CACHE_FILE, std::fstream::binary);
+        if (cache_file.is_open())
+        {
+            cache_file << stream.rdbuf();
+            cache_file.close();
+
+            stream.clear();
+            stream.seekg(0);
+        }
+
+        const auto size = fillTreesFromStream(m_progress, stream, m_beginEndTime, m_serializedBlocks, m_serializedDescriptors,
+                                              m_descriptors, m_blocks, m_blocksTree, m_bookmarks, m_descriptorsNumberInFile,
+                                              m_version, m_pid, _enableStatistics, m_errorMessage);
+
+        m_size.store(size, std::memory_order_release);
+        m_progress.store(100, std::memory_order_release);
+        m_bDone.store(true, std::memory_order_release);
+
+    }, EASY_GLOBALS.enable_statistics);
+}
+
 void FileReader::save(const QString& _filename, profiler::timestamp_t _beginTime, profiler::timestamp_t _endTime,
                       const profiler::SerializedData& _serializedDescriptors,
                       const profiler::descriptors_list_t& _descriptors, profiler::block_id_t descriptors_count,
@@ -239,6 +274,7 @@ void FileReader::interrupt()
 
     profiler_gui::clear_stream(m_stream);
     profiler_gui::clear_stream(m_errorMessage);
+    m_streamBuffer.reset();
 }
 
 void FileReader::get(profiler::SerializedData& _serializedBlocks, profiler::SerializedData& _serializedDescriptors,
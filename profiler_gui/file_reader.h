@@ -44,7 +44,9 @@ The Apache License, Version 2.0 (the "License");
 #define EASY_PROFILER_FILE_READER_H
 
 #include <atomic>
+#include <memory>
 #include <sstream>
+#include <streambuf>
 #include <thread>
 
 #include <QObject>
@@ -71,6 +73,7 @@ class FileReader Q_DECL_FINAL
     profiler::bookmarks_t                m_bookmarks; ///<
     profiler::BeginEndTime            m_beginEndTime; ///<
     std::stringstream                       m_stream; ///<
+    std::unique_ptr<std::streambuf>   m_streamBuffer; ///< Received data which is read without copying into m_stream
     std::stringstream                 m_errorMessage; ///<
     QString                               m_filename; ///<
     profiler::processid_t                  m_pid = 0; ///<
@@ -101,6 +104,7 @@ public:
 
     void load(const QString& _filename);
     void load(std::stringstream& _stream);
+    void load(std::unique_ptr<std::streambuf> _streamBuffer);
 
     /** \brief Save data to file.
     */
@@ -52,6 +52,7 @@
 *                   : limitations under the License.
 ************************************************************************/
 
+#include <cstring>
 #include "globals.h"
 
 //////////////////////////////////////////////////////////////////////////
@@ -67,6 +68,17 @@ Globals& Globals::instance()
     return globals;
 }
 
+void Globals::updateDescriptorFlags()
+{
+    lock_wait_descriptors.assign(descriptors.size(), 0);
+    for (size_t i = 0, n = descriptors.size(); i < n; ++i)
+    {
+        const auto desc = descriptors[i];
+        if (desc != nullptr && desc->type() == ::profiler::BlockType::Block && strcmp(desc->name(), ::profiler::LOCK_WAIT_BLOCK_NAME) == 0)
+            lock_wait_descriptors[i] = 1;
+    }
+}
+
 Globals::Fonts::Fonts()
     : default_font(::profiler_gui::EFont("DejaVu Sans", 13))
     , background(::profiler_gui::EFont("DejaVu Sans", 13, QFont::Bold))
@@ -84,6 +96,7 @@ Globals::Globals()
     , selected_thread(0U)
     , selected_block(::profiler_gui::numeric_max<decltype(selected_block)>())
     , selected_block_id(::profiler_gui::numeric_max<decltype(selected_block_id)>())
+    , data_generation(0)
     , version(0)
     , max_rows_count(500 * 1000)
     , frame_time(16700)
@@ -112,6 +125,8 @@ Globals::Globals()
     , draw_histogram_borders(true)
     , hide_narrow_children(false)
     , hide_minsize_blocks(false)
+    , tiled_rendering(false)
+    , opengl_viewport(false)
     , hide_stats_for_single_blocks(false)
     , collapse_items_on_tree_close(false)
     , all_items_expanded_by_default(true)
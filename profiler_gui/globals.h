@@ -56,6 +56,7 @@
 #define EASY_PROFILER__GUI_GLOBALS_H
 
 #include <string>
+#include <vector>
 #include <QObject>
 #include <QColor>
 #include <QTextCodec>
@@ -63,6 +64,7 @@
 #include <QFont>
 #include "common_functions.h"
 #include "globals_qobjects.h"
+#include "names_index.h"
 
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
@@ -105,46 +107,32 @@ namespace profiler_gui {
 
     inline QString decoratedThreadName(bool _use_decorated_thread_name, const::profiler::BlocksTreeRoot& _root, const QString& _unicodeThreadWord, bool _hex = false)
     {
+        const auto tid = _root.system_thread_id();
+        const QString process = _root.got_process() ? QString("[%1] ").arg(_root.process_name.empty() ? QString::number(_root.process_id) : toUnicode(_root.process_name.c_str())) : QString();
+
         if (_root.got_name())
         {
             QString rootname(toUnicode(_root.name()));
             if (!_use_decorated_thread_name || rootname.contains(_unicodeThreadWord, Qt::CaseInsensitive))
             {
                 if (_hex)
-                    return QString("%1 0x%2").arg(rootname).arg(_root.thread_id, 0, 16);
-                return QString("%1 %2").arg(rootname).arg(_root.thread_id);
+                    return QString("%1%2 0x%3").arg(process).arg(rootname).arg(tid, 0, 16);
+                return QString("%1%2 %3").arg(process).arg(rootname).arg(tid);
             }
 
             if (_hex)
-                return QString("%1 Thread 0x%2").arg(rootname).arg(_root.thread_id, 0, 16);
-            return QString("%1 Thread %2").arg(rootname).arg(_root.thread_id);
+                return QString("%1%2 Thread 0x%3").arg(process).arg(rootname).arg(tid, 0, 16);
+            return QString("%1%2 Thread %3").arg(process).arg(rootname).arg(tid);
         }
 
         if (_hex)
-            return QString("Thread 0x%1").arg(_root.thread_id, 0, 16);
-        return QString("Thread %1").arg(_root.thread_id);
+            return QString("%1Thread 0x%2").arg(process).arg(tid, 0, 16);
+        return QString("%1Thread %2").arg(process).arg(tid);
     }
 
     inline QString decoratedThreadName(bool _use_decorated_thread_name, const ::profiler::BlocksTreeRoot& _root, bool _hex = false)
     {
-        if (_root.got_name())
-        {
-            QString rootname(toUnicode(_root.name()));
-            if (!_use_decorated_thread_name || rootname.contains(toUnicode("thread"), Qt::CaseInsensitive))
-            {
-                if (_hex)
-                    return QString("%1 0x%2").arg(rootname).arg(_root.thread_id, 0, 16);
-                return QString("%1 %2").arg(rootname).arg(_root.thread_id);
-            }
-
-            if (_hex)
-                return QString("%1 Thread 0x%2").arg(rootname).arg(_root.thread_id, 0, 16);
-            return QString("%1 Thread %2").arg(rootname).arg(_root.thread_id);
-        }
-
-        if (_hex)
-            return QString("Thread 0x%1").arg(_root.thread_id, 0, 16);
-        return QString("Thread %1").arg(_root.thread_id);
+        return decoratedThreadName(_use_decorated_thread_name, _root, toUnicode("thread"), _hex);
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -200,7 +188,10 @@ namespace profiler_gui {
         ::profiler::thread_blocks_tree_t profiler_blocks; ///< Profiler blocks tree loaded from file
         ::profiler::descriptors_list_t       descriptors; ///< Profiler block descriptors list
         ::profiler::bookmarks_t                bookmarks; ///< User bookmarks
-        EasyBlocks                            gui_blocks; ///< Profiler graphics blocks builded by GUI
+        ::profiler::blocks_t                      blocks; ///< Profiler blocks loaded from file
+        EasyBlocks                            gui_blocks; ///< GUI state of profiler blocks (indexed the same as blocks)
+        NamesIndex                           names_index; ///< Full-text search index over names of descriptors and blocks
+        std::vector<uint8_t>       lock_wait_descriptors; ///< Non-zero for "waiting for lock" descriptors (indexed by descriptor id, see profiler::mutex)
 
         QString                                    theme; ///< Current UI theme name
         QString                              lastFileDir;
@@ -213,9 +204,10 @@ namespace profiler_gui {
         ::profiler::thread_id_t          selected_thread; ///< Current selected thread id
         ::profiler::block_index_t         selected_block; ///< Current selected profiler block index
         ::profiler::block_id_t         selected_block_id; ///< Current selected profiler block id
+        uint64_t                         data_generation; ///< Incremented every time blocks or descriptors are changed (load, clear, live append, descriptors merge)
         uint32_t                                 version; ///< Opened file version (files may have different format)
 
-        uint32_t                          max_rows_count; ///< Maximum blocks count for the StatsTree widget for the full call-stack mode
+        uint32_t                          max_rows_count; ///< Number of rows created at once for the StatsTree widget in the full call-stack mode (the rest are created on expand)
 
         float                                 frame_time; ///< Expected frame time value in microseconds to be displayed at minimap on graphics scrollbar
         int                               blocks_spacing; ///< Minimum blocks spacing on diagram
@@ -246,6 +238,8 @@ namespace profiler_gui {
         bool                      draw_histogram_borders; ///< Draw borders for histogram columns or not
         bool                        hide_narrow_children; ///< Hide children for narrow graphics blocks (See blocks_narrow_size)
         bool                         hide_minsize_blocks; ///< Hide blocks which screen size is less than blocks_size_min
+        bool                             tiled_rendering; ///< Rasterize blocks diagram into cached tiles using worker threads
+        bool                             opengl_viewport; ///< Use QOpenGLWidget as viewport of blocks diagram and paint blocks with instanced quads
         bool                hide_stats_for_single_blocks; ///< Hide min, max, avg, median durations in stats tree if there is only 1 call for a block
         bool                collapse_items_on_tree_close; ///< Collapse all items which were displayed in the hierarchy tree after tree close/reset
         bool               all_items_expanded_by_default; ///< Expand all items after file is opened
@@ -260,6 +254,11 @@ namespace profiler_gui {
 
         static Globals& instance();
 
+        /** Updates per-descriptor flags (e.g. lock_wait_descriptors) which are used on painting.
+
+        Must be called every time descriptors are changed. */
+        void updateDescriptorFlags();
+
     private:
 
         Globals();
@@ -284,8 +283,12 @@ inline profiler::SerializedBlockDescriptor& easyDescriptor(const profiler::Block
     return easyDescriptor(block.node->id());
 }
 
+inline bool isLockWaitDescriptor(profiler::block_id_t i) {
+    return i < EASY_GLOBALS.lock_wait_descriptors.size() && EASY_GLOBALS.lock_wait_descriptors[i] != 0;
+}
+
 EASY_FORCE_INLINE const profiler::BlocksTree& easyBlocksTree(profiler::block_index_t i) {
-    return easyBlock(i).tree;
+    return EASY_GLOBALS.blocks[i];
 }
 
 EASY_FORCE_INLINE const char* easyBlockName(const profiler::BlocksTree& block) {
@@ -299,13 +302,25 @@ EASY_FORCE_INLINE const char* easyBlockName(const profiler::BlocksTree& block, c
 }
 
 EASY_FORCE_INLINE const char* easyBlockName(profiler::block_index_t i) {
-    return easyBlockName(easyBlock(i).tree);
+    return easyBlockName(easyBlocksTree(i));
 }
 
 inline qreal sceneX(profiler::timestamp_t time) {
     return PROF_MICROSECONDS(qreal(time - EASY_GLOBALS.begin_time));
 }
 
+inline qreal profiler_gui::EasyBlockItem::left() const {
+    return sceneX(easyBlocksTree(block).node->begin());
+}
+
+inline qreal profiler_gui::EasyBlockItem::right() const {
+    return sceneX(easyBlocksTree(block).node->end());
+}
+
+inline float profiler_gui::EasyBlockItem::width() const {
+    return static_cast<float>(PROF_MICROSECONDS(qreal(easyBlocksTree(block).node->duration())));
+}
+
 inline QString imagePath(const QString& resource_name) {
     return QString(":/images/%1/%2").arg(EASY_GLOBALS.theme).arg(resource_name);
 }
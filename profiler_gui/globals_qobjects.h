@@ -76,6 +76,9 @@ namespace profiler_gui {
         void closeEvent();
         void allDataGoingToBeDeleted();
         void fileOpened();
+        void dataGoingToBeChanged(); ///< Blocks or descriptors are going to be changed: stop background workers reading them
+        void dataChanged(); ///< Blocks or descriptors have been changed: restart background workers stopped by dataGoingToBeChanged()
+        void liveBlocksAppended();
 
         void selectedThreadChanged(::profiler::thread_id_t _id);
         void selectedBlockChanged(uint32_t _block_index);
@@ -51,9 +51,11 @@
 #include <QGraphicsScene>
 #include <QDebug>
 #include <algorithm>
+#include <cmath>
 #include "graphics_block_item.h"
 #include "blocks_graphics_view.h"
 #include "globals.h"
+#include "thread_pool.h"
 
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
@@ -73,6 +75,10 @@ enum BlockItemState : int8_t
 EASY_CONSTEXPR int MIN_SYNC_SPACING = 1;
 EASY_CONSTEXPR int MIN_SYNC_SIZE = 3;
 EASY_CONSTEXPR int EVENT_HEIGHT = 4;
+EASY_CONSTEXPR uint32_t LOD_BASE_SHIFT = 4; ///< Each cell of the lowest layer of level-of-detail pyramid summarizes 16 items
+EASY_CONSTEXPR uint32_t LOD_BASE_SIZE = 1U << LOD_BASE_SHIFT;
+EASY_CONSTEXPR uint8_t MAX_DEPTH = 0xff;
+EASY_CONSTEXPR int TILE_WIDTH = 256; ///< Width of cached tiles in pixels (see GraphicsBlockItem::paintTiles())
 EASY_CONSTEXPR auto BORDERS_COLOR = profiler_gui::BLOCK_BORDER_COLOR;
 
 inline QRgb selectedItemBorderColor(profiler::color_t _color) {
@@ -115,6 +121,11 @@ const QPen HIGHLIGHTER_PEN = ([]() -> QPen {
 GraphicsBlockItem::GraphicsBlockItem(uint8_t _index, const profiler::BlocksTreeRoot& _root)
     : QGraphicsItem(nullptr)
     , m_thread(_root)
+    , m_lodInterrupt(false)
+    , m_lodReady(false)
+    , m_lodStopped(false)
+    , m_tilesScale(0)
+    , m_tilesDevicePixelRatio(0)
     , m_threadName(::profiler_gui::decoratedThreadName(EASY_GLOBALS.use_decorated_thread_name, _root, EASY_GLOBALS.hex_thread_id))
     , m_index(_index)
 {
@@ -122,6 +133,7 @@ GraphicsBlockItem::GraphicsBlockItem(uint8_t _index, const profiler::BlocksTreeR
 
 GraphicsBlockItem::~GraphicsBlockItem()
 {
+    m_lodWorker.dequeue();
 }
 
 void GraphicsBlockItem::validateName()
@@ -159,12 +171,18 @@ struct EasyPainterInformation EASY_FINAL
     Qt::PenStyle previousPenStyle;
     bool is_light;
     bool selectedItemsWasPainted;
+    bool drawLabels;
 
     explicit EasyPainterInformation(const BlocksGraphicsView* sceneView)
-        : visibleSceneRect(sceneView->visibleSceneRect())
+        : EasyPainterInformation(sceneView->visibleSceneRect(), sceneView->scale(), sceneView->offset())
+    {
+    }
+
+    EasyPainterInformation(const QRectF& _visibleSceneRect, qreal _scale, qreal _offset)
+        : visibleSceneRect(_visibleSceneRect)
         , visibleBottom(visibleSceneRect.bottom() - 1)
-        , currentScale(sceneView->scale())
-        , offset(sceneView->offset())
+        , currentScale(_scale)
+        , offset(_offset)
         , sceneLeft(offset)
         , sceneRight(offset + visibleSceneRect.width() / currentScale)
         , dx(offset * currentScale)
@@ -173,6 +191,7 @@ struct EasyPainterInformation EASY_FINAL
         , previousPenStyle(Qt::NoPen)
         , is_light(false)
         , selectedItemsWasPainted(false)
+        , drawLabels(true)
     {
         brush.setStyle(Qt::SolidPattern);
     }
@@ -180,13 +199,22 @@ struct EasyPainterInformation EASY_FINAL
     EasyPainterInformation() = delete;
 };
 
+/** Hatches block rectangle if it is a "waiting for lock" block (see profiler::mutex) to make lock contention
+visible at a glance. */
+EASY_FORCE_INLINE void hatchLockWait(QPainter* _painter, const QRectF& _rect, const profiler::BlocksTree& _tree,
+                                     const profiler::BlockDescriptor& _desc)
+{
+    if (isLockWaitDescriptor(_tree.node->id()))
+        _painter->fillRect(_rect, QBrush(QColor::fromRgb(::profiler_gui::textColorForRgb(_desc.color())), Qt::BDiagPattern));
+}
+
 #ifdef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
 void GraphicsBlockItem::paintChildren(const float _minWidth, const int _narrowSizeHalf, const uint8_t _levelsNumber,
                                        QPainter* _painter, struct EasyPainterInformation& p, profiler_gui::EasyBlockItem& _item,
-                                       const profiler_gui::EasyBlock& _itemBlock, RightBounds& _rightBounds, uint8_t _level,
+                                       const profiler::BlocksTree& _itemTree, RightBounds& _rightBounds, uint8_t _level,
                                        int8_t _mode)
 {
-    if (_level >= _levelsNumber || _itemBlock.tree.children.empty())
+    if (_level >= _levelsNumber || _itemTree.children.empty())
         return;
 
     const auto top = levelY(_level);
@@ -197,7 +225,7 @@ void GraphicsBlockItem::paintChildren(const float _minWidth, const int _narrowSi
     auto& level = m_levels[_level];
     const auto next_level = (short)(_level + 1);
 
-    uint32_t neighbours = (uint32_t)_itemBlock.tree.children.size();
+    uint32_t neighbours = (uint32_t)_itemTree.children.size();
     uint32_t last = neighbours - 1;
     uint32_t neighbour = 0;
 
@@ -207,6 +235,7 @@ void GraphicsBlockItem::paintChildren(const float _minWidth, const int _narrowSi
         neighbours = neighbour + 1;
     }
 
+    const uint32_t end = _item.children_begin + neighbours;
     for (uint32_t i = _item.children_begin + neighbour; neighbour < neighbours; ++i, ++neighbour)
     {
         auto& item = level[i];
@@ -215,10 +244,17 @@ void GraphicsBlockItem::paintChildren(const float _minWidth, const int _narrowSi
             break; // This is first totally invisible item. No need to check other items.
 
         if (item.right() < p.sceneLeft)
-            continue; // This item is not visible
+        {
+            // This item is not visible. Skip all neighbours which are out of screen too.
+            const auto next = skipCoveredItems(_level, i + 1, end, p.sceneLeft, MAX_DEPTH);
+            neighbour += next - i - 1;
+            i = next - 1;
+            continue;
+        }
 
         const auto& itemBlock = easyBlock(item.block);
-        const auto totalHeight = itemBlock.tree.depth * EASY_GLOBALS.size.graphics_row_full + EASY_GLOBALS.size.graphics_row_height;
+        const auto& itemTree = easyBlocksTree(item.block);
+        const auto totalHeight = itemTree.depth * EASY_GLOBALS.size.graphics_row_full + EASY_GLOBALS.size.graphics_row_height;
         if ((top + totalHeight) < p.visibleSceneRect.top())
             continue; // This item is not visible
 
@@ -230,8 +266,14 @@ void GraphicsBlockItem::paintChildren(const float _minWidth, const int _narrowSi
         {
             // This item is not visible
             if (!(EASY_GLOBALS.hide_narrow_children && w < EASY_GLOBALS.blocks_narrow_size))
-                paintChildren(_minWidth, _narrowSizeHalf, _levelsNumber, _painter, p, item, itemBlock, _rightBounds,
+                paintChildren(_minWidth, _narrowSizeHalf, _levelsNumber, _painter, p, item, itemTree, _rightBounds,
                               (uint8_t)next_level, BLOCK_ITEM_DO_PAINT_FIRST);
+
+            // Skip all neighbours which are hidden by previously painted item too
+            const auto depth = coveredDepth(_level, prevRight, _rightBounds);
+            const auto next = skipCoveredItems(_level, i + 1, end, (prevRight + p.dx) / p.currentScale - _minWidth, depth);
+            neighbour += next - i - 1;
+            i = next - 1;
             continue;
         }
 
@@ -244,7 +286,7 @@ void GraphicsBlockItem::paintChildren(const float _minWidth, const int _narrowSi
         if (EASY_GLOBALS.hide_minsize_blocks && w < EASY_GLOBALS.blocks_size_min)
             continue; // Hide blocks (except top-level blocks) which width is less than 1 pixel
 
-        const auto& itemDesc = easyDescriptor(itemBlock.tree.node->id());
+        const auto& itemDesc = easyDescriptor(itemTree.node->id());
 
         int h = 0;
         bool do_paint_children = false;
@@ -273,7 +315,7 @@ void GraphicsBlockItem::paintChildren(const float _minWidth, const int _narrowSi
                 _painter->setBrush(p.brush);
             }
 
-            if (EASY_GLOBALS.highlight_blocks_with_same_id && (EASY_GLOBALS.selected_block_id == itemBlock.tree.node->id()
+            if (EASY_GLOBALS.highlight_blocks_with_same_id && (EASY_GLOBALS.selected_block_id == itemTree.node->id()
                 || (::profiler_gui::is_max(EASY_GLOBALS.selected_block) && EASY_GLOBALS.selected_block_id == itemDesc.id())))
             {
                 if (p.previousPenStyle != Qt::DotLine)
@@ -322,8 +364,10 @@ void GraphicsBlockItem::paintChildren(const float _minWidth, const int _narrowSi
             // Draw rectangle
             p.rect.setRect(x, top, w, h);
             _painter->drawRect(p.rect);
+            hatchLockWait(_painter, p.rect, itemTree, itemDesc);
 
             prevRight = p.rect.right() + EASY_GLOBALS.blocks_spacing;
+            coverSublevels(_level, itemTree.depth, prevRight, _rightBounds);
             //skip_children(next_level, item.children_begin);
             if (wprev < EASY_GLOBALS.blocks_narrow_size)
                 continue;
@@ -351,7 +395,7 @@ void GraphicsBlockItem::paintChildren(const float _minWidth, const int _narrowSi
                 _painter->setBrush(p.brush);
             }
 
-            if (EASY_GLOBALS.highlight_blocks_with_same_id && (EASY_GLOBALS.selected_block_id == itemBlock.tree.node->id()
+            if (EASY_GLOBALS.highlight_blocks_with_same_id && (EASY_GLOBALS.selected_block_id == itemTree.node->id()
                 || (::profiler_gui::is_max(EASY_GLOBALS.selected_block) && EASY_GLOBALS.selected_block_id == itemDesc.id())))
             {
                 if (p.previousPenStyle != Qt::DotLine)
@@ -406,11 +450,12 @@ void GraphicsBlockItem::paintChildren(const float _minWidth, const int _narrowSi
 
             p.rect.setRect(x, top, w, h);
             _painter->drawRect(p.rect);
+            hatchLockWait(_painter, p.rect, itemTree, itemDesc);
 
             prevRight = p.rect.right() + EASY_GLOBALS.blocks_spacing;
             if (wprev < EASY_GLOBALS.blocks_narrow_size)
             {
-                paintChildren(_minWidth, _narrowSizeHalf, _levelsNumber, _painter, p, item, itemBlock, _rightBounds, next_level, wprev < _narrowSizeHalf ? BLOCK_ITEM_DO_PAINT_FIRST : BLOCK_ITEM_DO_PAINT);
+                paintChildren(_minWidth, _narrowSizeHalf, _levelsNumber, _painter, p, item, itemTree, _rightBounds, next_level, wprev < _narrowSizeHalf ? BLOCK_ITEM_DO_PAINT_FIRST : BLOCK_ITEM_DO_PAINT);
                 continue;
             }
 
@@ -434,9 +479,12 @@ void GraphicsBlockItem::paintChildren(const float _minWidth, const int _narrowSi
         if (item.block == EASY_GLOBALS.selected_block)
             setSelectedFont(_painter);
 
-        // drawing text
-        auto name = easyBlockName(itemBlock.tree, itemDesc);
-        _painter->drawText(p.rect, Qt::AlignCenter, ::profiler_gui::toUnicode(name));
+        // drawing text (tiles have no labels, see paintTiles())
+        if (p.drawLabels)
+        {
+            auto name = easyBlockName(itemTree, itemDesc);
+            _painter->drawText(p.rect, Qt::AlignCenter, ::profiler_gui::toUnicode(name));
+        }
 
         // restore previous pen color
         if (p.previousPenStyle == Qt::NoPen)
@@ -454,7 +502,7 @@ void GraphicsBlockItem::paintChildren(const float _minWidth, const int _narrowSi
         // END Draw text~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
         if (do_paint_children)
-            paintChildren(_minWidth, _narrowSizeHalf, _levelsNumber, _painter, p, item, itemBlock, _rightBounds, next_level, _mode);
+            paintChildren(_minWidth, _narrowSizeHalf, _levelsNumber, _painter, p, item, itemTree, _rightBounds, next_level, _mode);
     }
 }
 #endif
@@ -473,38 +521,6 @@ void GraphicsBlockItem::paint(QPainter* _painter, const QStyleOptionGraphicsItem
 
     _painter->save();
     _painter->setFont(EASY_GLOBALS.font.item);
-    
-    // Reset indices of first visible item for each layer
-    const auto levelsNumber = levels();
-    m_rightBounds[0] = -1e100;
-    for (uint8_t i = 1; i < levelsNumber; ++i) {
-        ::profiler_gui::set_max(m_levelsIndexes[i]);
-        m_rightBounds[i] = -1e100;
-    }
-
-
-    // Search for first visible top-level item
-    if (gotItems)
-    {
-        auto& level0 = m_levels.front();
-        auto first = ::std::lower_bound(level0.begin(), level0.end(), p.sceneLeft, [](const ::profiler_gui::EasyBlockItem& _item, qreal _value)
-        {
-            return _item.left() < _value;
-        });
-
-        if (first != level0.end())
-        {
-            m_levelsIndexes[0] = first - level0.begin();
-            if (m_levelsIndexes[0] > 0)
-                m_levelsIndexes[0] -= 1;
-        }
-        else
-        {
-            m_levelsIndexes[0] = static_cast<unsigned int>(level0.size() - 1);
-        }
-    }
-
-
 
     // This is to make _painter->drawText() work properly
     // (it seems there is a bug in Qt5.6 when drawText called for big coordinates,
@@ -516,362 +532,29 @@ void GraphicsBlockItem::paint(QPainter* _painter, const QStyleOptionGraphicsItem
     _painter->setTransform(QTransform::fromTranslate(0, -y()), true);
 
 
-
-    if (EASY_GLOBALS.draw_graphics_items_borders)
-    {
-        p.previousPenStyle = Qt::SolidLine;
-        _painter->setPen(BORDERS_COLOR);
-    }
-    else
-    {
-        _painter->setPen(Qt::NoPen);
-    }
-
-
     const auto MIN_WIDTH = EASY_GLOBALS.enable_zero_length ? 0.f : 0.25f;
 
 
     // Iterate through layers and draw visible items
     if (gotItems)
     {
-        const int narrow_size_half = EASY_GLOBALS.blocks_narrow_size >> 1;
-
-#ifndef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
-        static const auto MAX_CHILD_INDEX = ::profiler_gui::numeric_max<decltype(::profiler_gui::EasyBlockItem::children_begin)>();
-        auto const dont_skip_children = [this, &levelsNumber](short next_level, decltype(::profiler_gui::EasyBlockItem::children_begin) children_begin, int8_t _state)
-        {
-            if (next_level < levelsNumber && children_begin != MAX_CHILD_INDEX)
-            {
-                if (m_levelsIndexes[next_level] == MAX_CHILD_INDEX)
-                {
-                    // Mark first potentially visible child item on next sublevel
-                    m_levelsIndexes[next_level] = children_begin;
-                }
-
-                // Mark children items that we want to draw them
-                m_levels[next_level][children_begin].state = _state;
-            }
-        };
-#endif
-
-        //size_t iterations = 0;
-#ifndef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
-        for (uint8_t l = 0; l < levelsNumber; ++l)
-#else
-        for (uint8_t l = 0; l < 1; ++l)
-#endif
-        {
-            auto& level = m_levels[l];
-            const auto next_level = (short)(l + 1);
-
-            const auto top = levelY(l);
-            if (top > p.visibleBottom)
-                break;
-
-            //qreal& prevRight = m_rightBounds[l];
-            qreal prevRight = -1e100;
-            uint32_t neighbour = 0;
-            for (uint32_t i = m_levelsIndexes[l], end = static_cast<uint32_t>(level.size()); i < end; ++i, ++neighbour)
-            {
-                //++iterations;
-
-                auto& item = level[i];
-
-                if (item.left() > p.sceneRight)
-                    break; // This is first totally invisible item. No need to check other items.
-
-#ifndef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
-                char state = BLOCK_ITEM_DO_PAINT;
-                if (item.state != BLOCK_ITEM_UNCHANGED)
-                {
-                    neighbour = 0; // first block in parent's children list
-                    state = item.state;
-                    item.state = BLOCK_ITEM_DO_NOT_PAINT;
-                }
-#endif
-
-                if (item.right() < p.sceneLeft)
-                    continue; // This item is not visible
-
-#ifndef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
-                if (state == BLOCK_ITEM_DO_NOT_PAINT)
-                {
-                    // This item is not visible
-                    if (neighbour < item.neighbours)
-                        i += item.neighbours - neighbour - 1; // Skip all neighbours
-                    continue;
-                }
-
-                if (state == BLOCK_ITEM_DO_PAINT_FIRST && item.children_begin == MAX_CHILD_INDEX && next_level < levelsNumber && neighbour < (item.neighbours-1))
-                    // Paint only first child which has own children
-                    continue; // This item has no children and would not be painted
-#endif
-
-                const auto& itemBlock = easyBlock(item.block);
-                const auto totalHeight = itemBlock.tree.depth * EASY_GLOBALS.size.graphics_row_full + EASY_GLOBALS.size.graphics_row_height;
-                if ((top + totalHeight) < p.visibleSceneRect.top())
-                    continue; // This item is not visible
-
-                const auto item_width = ::std::max(item.width(), MIN_WIDTH);
-                auto x = item.left() * p.currentScale - p.dx;
-                auto w = item_width * p.currentScale;
-                if ((x + w) <= prevRight)
-                {
-                    // This item is not visible
-#ifdef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
-                    if (!EASY_GLOBALS.hide_narrow_children || w >= EASY_GLOBALS.blocks_narrow_size)
-                        paintChildren(MIN_WIDTH, narrow_size_half, levelsNumber, _painter, p, item, itemBlock,
-                                      m_rightBounds, (uint8_t)next_level, BLOCK_ITEM_DO_PAINT_FIRST);
-#else
-                    if (!(EASY_GLOBALS.hide_narrow_children && w < EASY_GLOBALS.blocks_narrow_size) && l > 0)
-                        dont_skip_children(next_level, item.children_begin, BLOCK_ITEM_DO_PAINT_FIRST);
-#endif
-                    continue;
-                }
-
-                if (x < prevRight)
-                {
-                    w -= prevRight - x;
-                    x = prevRight;
-                }
-
-#ifndef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
-                if (EASY_GLOBALS.hide_minsize_blocks && w < EASY_GLOBALS.blocks_size_min && l > 0)
-                    continue; // Hide blocks (except top-level blocks) which width is less than 1 pixel
-
-                if (state == BLOCK_ITEM_DO_PAINT_FIRST && neighbour < item.neighbours)
-                {
-                    // Paint only first child which has own children
-                    i += item.neighbours - neighbour - 1; // Skip all neighbours
-                }
-#endif
-
-                const auto& itemDesc = easyDescriptor(itemBlock.tree.node->id());
-                int h = 0;
-
-#ifdef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
-                bool do_paint_children = false;
-#endif
-
-                if ((EASY_GLOBALS.hide_narrow_children && w < EASY_GLOBALS.blocks_narrow_size) || !itemBlock.expanded)
-                {
-                    // Items which width is less than 20 will be painted as big rectangles which are hiding it's children
-
-                    //x = item.left() * p.currentScale - p.dx;
-                    h = totalHeight;
-                    const auto dh = top + h - p.visibleBottom;
-                    if (dh > 0)
-                        h -= dh;
-
-                    if (item.block == EASY_GLOBALS.selected_block)
-                        p.selectedItemsWasPainted = true;
-
-                    const bool colorChange = (p.previousColor != itemDesc.color());
-                    if (colorChange)
-                    {
-                        // Set background color brush for rectangle
-                        p.previousColor = itemDesc.color();
-                        //p.inverseColor = 0xffffffff - p.previousColor;
-                        p.is_light = ::profiler_gui::isLightColor(p.previousColor);
-                        p.textColor = ::profiler_gui::textColorForFlag(p.is_light);
-                        p.brush.setColor(QColor::fromRgba(p.previousColor));
-                        _painter->setBrush(p.brush);
-                    }
-
-                    if (EASY_GLOBALS.highlight_blocks_with_same_id && (EASY_GLOBALS.selected_block_id == itemBlock.tree.node->id()
-                        || (::profiler_gui::is_max(EASY_GLOBALS.selected_block) && EASY_GLOBALS.selected_block_id == itemDesc.id())))
-                    {
-                        if (p.previousPenStyle != Qt::DotLine)
-                        {
-                            p.previousPenStyle = Qt::DotLine;
-                            _painter->setPen(HIGHLIGHTER_PEN);
-                        }
-                    }
-                    else if (EASY_GLOBALS.draw_graphics_items_borders)
-                    {
-                        if (p.previousPenStyle != Qt::SolidLine)// || colorChange)
-                        {
-                            // Restore pen for item which is wide enough to paint borders
-                            p.previousPenStyle = Qt::SolidLine;
-                            _painter->setPen(BORDERS_COLOR);//BORDERS_COLOR & inverseColor);
-                        }
-                    }
-                    else if (p.previousPenStyle != Qt::NoPen)
-                    {
-                        p.previousPenStyle = Qt::NoPen;
-                        _painter->setPen(Qt::NoPen);
-                    }
-
-                    const auto wprev = w;
-                    decltype(w) dw = 0;
-                    if (item.left() < p.sceneLeft)
-                    {
-                        // if item left border is out of screen then attach text to the left border of the screen
-                        // to ensure text is always visible for items presenting on the screen.
-                        w += (item.left() - p.sceneLeft) * p.currentScale;
-                        x = p.sceneLeft * p.currentScale - p.dx - 2;
-                        w += 2;
-                        dw = 2;
-                    }
-
-                    if (item.right() > p.sceneRight)
-                    {
-                        w -= (item.right() - p.sceneRight) * p.currentScale;
-                        w += 2;
-                        dw += 2;
-                    }
-
-                    if (w < EASY_GLOBALS.blocks_size_min)
-                        w = EASY_GLOBALS.blocks_size_min;
-
-                    // Draw rectangle
-                    p.rect.setRect(x, top, w, h);
-                    _painter->drawRect(p.rect);
-
-                    prevRight = p.rect.right() + EASY_GLOBALS.blocks_spacing;
-                    //skip_children(next_level, item.children_begin);
-                    if (wprev < EASY_GLOBALS.blocks_narrow_size)
-                        continue;
+        bool painted = false;
 
-                    if (dw > 1) {
-                        w -= dw;
-                        x += 2;
-                    }
-                }
-                else
-                {
-                    if (item.block == EASY_GLOBALS.selected_block)
-                        p.selectedItemsWasPainted = true;
-
-                    const bool colorChange = (p.previousColor != itemDesc.color());
-                    if (colorChange)
-                    {
-                        // Set background color brush for rectangle
-                        p.previousColor = itemDesc.color();
-                        //p.inverseColor = 0xffffffff - p.previousColor;
-                        p.is_light = ::profiler_gui::isLightColor(p.previousColor);
-                        p.textColor = ::profiler_gui::textColorForFlag(p.is_light);
-                        p.brush.setColor(QColor::fromRgba(p.previousColor));
-                        _painter->setBrush(p.brush);
-                    }
-
-                    if (EASY_GLOBALS.highlight_blocks_with_same_id && (EASY_GLOBALS.selected_block_id == itemBlock.tree.node->id()
-                        || (::profiler_gui::is_max(EASY_GLOBALS.selected_block) && EASY_GLOBALS.selected_block_id == itemDesc.id())))
-                    {
-                        if (p.previousPenStyle != Qt::DotLine)
-                        {
-                            p.previousPenStyle = Qt::DotLine;
-                            _painter->setPen(HIGHLIGHTER_PEN);
-                        }
-                    }
-                    else if (EASY_GLOBALS.draw_graphics_items_borders)
-                    {
-                        if (p.previousPenStyle != Qt::SolidLine)// || colorChange)
-                        {
-                            // Restore pen for item which is wide enough to paint borders
-                            p.previousPenStyle = Qt::SolidLine;
-                            _painter->setPen(BORDERS_COLOR);// BORDERS_COLOR & inverseColor);
-                        }
-                    }
-                    else if (p.previousPenStyle != Qt::NoPen)
-                    {
-                        p.previousPenStyle = Qt::NoPen;
-                        _painter->setPen(Qt::NoPen);
-                    }
-
-                    // Draw rectangle
-                    //x = item.left() * currentScale - p.dx;
-                    h = EASY_GLOBALS.size.graphics_row_height;
-                    const auto dh = top + h - p.visibleBottom;
-                    if (dh > 0)
-                        h -= dh;
-
-                    const auto wprev = w;
-                    decltype(w) dw = 0;
-                    if (item.left() < p.sceneLeft)
-                    {
-                        // if item left border is out of screen then attach text to the left border of the screen
-                        // to ensure text is always visible for items presenting on the screen.
-                        w += (item.left() - p.sceneLeft) * p.currentScale;
-                        x = p.sceneLeft * p.currentScale - p.dx - 2;
-                        w += 2;
-                        dw = 2;
-                    }
-
-                    if (item.right() > p.sceneRight)
-                    {
-                        w -= (item.right() - p.sceneRight) * p.currentScale;
-                        w += 2;
-                        dw += 2;
-                    }
-
-                    if (w < EASY_GLOBALS.blocks_size_min)
-                        w = EASY_GLOBALS.blocks_size_min;
-
-                    p.rect.setRect(x, top, w, h);
-                    _painter->drawRect(p.rect);
-
-                    prevRight = p.rect.right() + EASY_GLOBALS.blocks_spacing;
-                    if (wprev < EASY_GLOBALS.blocks_narrow_size)
-                    {
-#ifndef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
-                        dont_skip_children(next_level, item.children_begin, wprev < narrow_size_half ? BLOCK_ITEM_DO_PAINT_FIRST : BLOCK_ITEM_DO_PAINT);
-#else
-                        paintChildren(MIN_WIDTH, narrow_size_half, levelsNumber, _painter, p, item, itemBlock, m_rightBounds, next_level, wprev < narrow_size_half ? BLOCK_ITEM_DO_PAINT_FIRST : BLOCK_ITEM_DO_PAINT);
-#endif
-                        continue;
-                    }
-
-#ifndef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
-                    dont_skip_children(next_level, item.children_begin, BLOCK_ITEM_DO_PAINT);
+#ifdef EASY_GRAPHICS_OPENGL_VIEWPORT
+        if (EASY_GLOBALS.opengl_viewport)
+            painted = paintItemsGL(_painter, p);
 #endif
 
-                    if (dw > 1) {
-                        w -= dw;
-                        x += 2;
-                    }
-
 #ifdef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
-                    do_paint_children = true;
+        if (!painted && EASY_GLOBALS.tiled_rendering)
+        {
+            paintTiles(_painter, p);
+            painted = true;
+        }
 #endif
-                }
-
-                // Draw text-----------------------------------
-                p.rect.setRect(x + 1, top, w - 1, h);
-
-                // text will be painted with inverse color
-                //auto textColor = inverseColor < 0x00808080 ? profiler::colors::Black : profiler::colors::White;
-                //if (textColor == previousColor) textColor = 0;
-                _painter->setPen(p.textColor);
-
-                if (item.block == EASY_GLOBALS.selected_block)
-                    setSelectedFont(_painter);
-
-                // drawing text
-                auto name = easyBlockName(itemBlock.tree, itemDesc);
-                _painter->drawText(p.rect, Qt::AlignCenter, ::profiler_gui::toUnicode(name));
-
-                // restore previous pen color
-                if (p.previousPenStyle == Qt::NoPen)
-                    _painter->setPen(Qt::NoPen);
-                else if (p.previousPenStyle == Qt::DotLine)
-                {
-                    _painter->setPen(HIGHLIGHTER_PEN);
-                }
-                else
-                    _painter->setPen(BORDERS_COLOR);// BORDERS_COLOR & inverseColor); // restore pen for rectangle painting
 
-                // restore font
-                if (item.block == EASY_GLOBALS.selected_block)
-                    restoreItemFont(_painter);
-                // END Draw text~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-
-#ifdef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
-                if (do_paint_children)
-                    paintChildren(MIN_WIDTH, narrow_size_half, levelsNumber, _painter, p, item, itemBlock, m_rightBounds, next_level, BLOCK_ITEM_DO_PAINT);
-#endif
-            }
-        }
+        if (!painted)
+            paintItems(_painter, p, m_rightBounds, m_levelsIndexes);
 
         if (EASY_GLOBALS.selected_block < EASY_GLOBALS.gui_blocks.size())
         {
@@ -882,12 +565,13 @@ void GraphicsBlockItem::paint(QPainter* _painter, const QStyleOptionGraphicsItem
                 if (item.left() < p.sceneRight && item.right() > p.sceneLeft)
                 {
                     const auto& itemBlock = easyBlock(item.block);
+                    const auto& itemTree = easyBlocksTree(item.block);
                     const auto item_width = ::std::max(item.width(), MIN_WIDTH);
                     auto top = levelY(guiblock.graphics_item_level);
                     auto w = ::std::max(item_width * p.currentScale, 1.0);
                     decltype(top) h = (!itemBlock.expanded ||
                                        (w < EASY_GLOBALS.blocks_narrow_size && EASY_GLOBALS.hide_narrow_children))
-                                       ? (itemBlock.tree.depth * EASY_GLOBALS.size.graphics_row_full + EASY_GLOBALS.size.graphics_row_height)
+                                       ? (itemTree.depth * EASY_GLOBALS.size.graphics_row_full + EASY_GLOBALS.size.graphics_row_height)
                                        : EASY_GLOBALS.size.graphics_row_height;
 
                     auto dh = top + h - p.visibleBottom;
@@ -896,7 +580,7 @@ void GraphicsBlockItem::paint(QPainter* _painter, const QStyleOptionGraphicsItem
                         if (dh > 0)
                             h -= dh;
 
-                        const auto& itemDesc = easyDescriptor(itemBlock.tree.node->id());
+                        const auto& itemDesc = easyDescriptor(itemTree.node->id());
 
                         QPen pen(Qt::SolidLine);
                         pen.setJoinStyle(Qt::MiterJoin);
@@ -935,6 +619,7 @@ void GraphicsBlockItem::paint(QPainter* _painter, const QStyleOptionGraphicsItem
 
                         p.rect.setRect(x, top, w, h);
                         _painter->drawRect(p.rect);
+                        hatchLockWait(_painter, p.rect, itemTree, itemDesc);
 
                         if (!p.selectedItemsWasPainted && w > EASY_GLOBALS.blocks_narrow_size)
                         {
@@ -954,7 +639,7 @@ void GraphicsBlockItem::paint(QPainter* _painter, const QStyleOptionGraphicsItem
 
                             // drawing text
                             setSelectedFont(_painter);
-                            auto name = easyBlockName(itemBlock.tree, itemDesc);
+                            auto name = easyBlockName(itemTree, itemDesc);
                             _painter->drawText(p.rect, Qt::AlignCenter, ::profiler_gui::toUnicode(name));
                             restoreItemFont(_painter);
                             // END Draw text~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -1122,75 +807,694 @@ void GraphicsBlockItem::paint(QPainter* _painter, const QStyleOptionGraphicsItem
     _painter->restore();
 }
 
-//////////////////////////////////////////////////////////////////////////
-
-const profiler::BlocksTreeRoot& GraphicsBlockItem::root() const
-{
-    return m_thread;
-}
-
-const QString& GraphicsBlockItem::threadName() const
-{
-    return m_threadName;
-}
-
-//////////////////////////////////////////////////////////////////////////
-
-QRect GraphicsBlockItem::getRect() const
+void GraphicsBlockItem::paintItems(QPainter* _painter, EasyPainterInformation& p, RightBounds& _rightBounds, DrawIndexes& _levelsIndexes)
 {
-    return view()->mapFromScene(m_boundingRect).boundingRect();
-}
+    // Reset indices of first visible item for each layer
+    const auto levelsNumber = levels();
+    _rightBounds[0] = -1e100;
+    for (uint8_t i = 1; i < levelsNumber; ++i) {
+        ::profiler_gui::set_max(_levelsIndexes[i]);
+        _rightBounds[i] = -1e100;
+    }
 
-//////////////////////////////////////////////////////////////////////////
 
-void GraphicsBlockItem::getBlocks(qreal _left, qreal _right, ::profiler_gui::TreeBlocks& _blocks) const
-{
     // Search for first visible top-level item
     auto& level0 = m_levels.front();
-    auto first = ::std::lower_bound(level0.begin(), level0.end(), _left, [](const ::profiler_gui::EasyBlockItem& _item, qreal _value)
-    {
-        return _item.left() < _value;
-    });
+    _levelsIndexes[0] = lowerBound(0, 0, static_cast<uint32_t>(level0.size()), p.sceneLeft);
+    if (_levelsIndexes[0] > 0)
+        _levelsIndexes[0] -= 1;
+
 
-    size_t itemIndex = 0;
-    if (first != level0.end())
+    if (EASY_GLOBALS.draw_graphics_items_borders)
     {
-        itemIndex = static_cast<size_t>(std::distance(level0.begin(), first));
-        if (itemIndex > 0)
-            itemIndex -= 1;
+        p.previousPenStyle = Qt::SolidLine;
+        _painter->setPen(BORDERS_COLOR);
     }
     else
     {
-        itemIndex = level0.size() - 1;
+        _painter->setPen(Qt::NoPen);
     }
 
-    // Add all visible top-level items into array of visible blocks
-    for (size_t i = itemIndex, end = level0.size(); i < end; ++i)
-    {
-        const auto& item = level0[i];
 
-        if (item.left() > _right)
+    const auto MIN_WIDTH = EASY_GLOBALS.enable_zero_length ? 0.f : 0.25f;
+
+
+    // Iterate through layers and draw visible items
+    const int narrow_size_half = EASY_GLOBALS.blocks_narrow_size >> 1;
+
+#ifndef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
+    static const auto MAX_CHILD_INDEX = ::profiler_gui::numeric_max<decltype(::profiler_gui::EasyBlockItem::children_begin)>();
+    auto const dont_skip_children = [this, &levelsNumber, &_levelsIndexes](short next_level, decltype(::profiler_gui::EasyBlockItem::children_begin) children_begin, int8_t _state)
+    {
+        if (next_level < levelsNumber && children_begin != MAX_CHILD_INDEX)
         {
-            // First invisible item. No need to check other items.
-            break;
+            if (_levelsIndexes[next_level] == MAX_CHILD_INDEX)
+            {
+                // Mark first potentially visible child item on next sublevel
+                _levelsIndexes[next_level] = children_begin;
+            }
+
+            // Mark children items that we want to draw them
+            m_levels[next_level][children_begin].state = _state;
         }
+    };
+#endif
 
-        if (item.right() < _left)
+    //size_t iterations = 0;
+#ifndef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
+    for (uint8_t l = 0; l < levelsNumber; ++l)
+#else
+    for (uint8_t l = 0; l < 1; ++l)
+#endif
+    {
+        auto& level = m_levels[l];
+        const auto next_level = (short)(l + 1);
+
+        const auto top = levelY(l);
+        if (top > p.visibleBottom)
+            break;
+
+        //qreal& prevRight = _rightBounds[l];
+        qreal prevRight = -1e100;
+        uint32_t neighbour = 0;
+        for (uint32_t i = _levelsIndexes[l], end = static_cast<uint32_t>(level.size()); i < end; ++i, ++neighbour)
         {
-            // This item is not visible yet
-            // This is just to be sure
-            continue;
-        }
+            //++iterations;
 
-        _blocks.emplace_back(&m_thread, item.block);
-    }
-}
+            auto& item = level[i];
 
-//////////////////////////////////////////////////////////////////////////
+            if (item.left() > p.sceneRight)
+                break; // This is first totally invisible item. No need to check other items.
 
-const ::profiler_gui::EasyBlock* GraphicsBlockItem::intersect(const QPointF& _pos, ::profiler::block_index_t& _blockIndex) const
-{
-    if (m_levels.empty() || m_levels.front().empty())
+#ifndef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
+            char state = BLOCK_ITEM_DO_PAINT;
+            if (item.state != BLOCK_ITEM_UNCHANGED)
+            {
+                neighbour = 0; // first block in parent's children list
+                state = item.state;
+                item.state = BLOCK_ITEM_DO_NOT_PAINT;
+            }
+#endif
+
+            if (item.right() < p.sceneLeft)
+                continue; // This item is not visible
+
+#ifndef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
+            if (state == BLOCK_ITEM_DO_NOT_PAINT)
+            {
+                // This item is not visible
+                if (neighbour < item.neighbours)
+                    i += item.neighbours - neighbour - 1; // Skip all neighbours
+                continue;
+            }
+
+            if (state == BLOCK_ITEM_DO_PAINT_FIRST && item.children_begin == MAX_CHILD_INDEX && next_level < levelsNumber && neighbour < (item.neighbours-1))
+                // Paint only first child which has own children
+                continue; // This item has no children and would not be painted
+#endif
+
+            const auto& itemBlock = easyBlock(item.block);
+            const auto& itemTree = easyBlocksTree(item.block);
+            const auto totalHeight = itemTree.depth * EASY_GLOBALS.size.graphics_row_full + EASY_GLOBALS.size.graphics_row_height;
+            if ((top + totalHeight) < p.visibleSceneRect.top())
+                continue; // This item is not visible
+
+            const auto item_width = ::std::max(item.width(), MIN_WIDTH);
+            auto x = item.left() * p.currentScale - p.dx;
+            auto w = item_width * p.currentScale;
+            if ((x + w) <= prevRight)
+            {
+                // This item is not visible
+#ifdef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
+                if (!EASY_GLOBALS.hide_narrow_children || w >= EASY_GLOBALS.blocks_narrow_size)
+                    paintChildren(MIN_WIDTH, narrow_size_half, levelsNumber, _painter, p, item, itemTree,
+                                  _rightBounds, (uint8_t)next_level, BLOCK_ITEM_DO_PAINT_FIRST);
+
+                // Skip all items which are hidden by previously painted item too
+                const auto depth = coveredDepth(l, prevRight, _rightBounds);
+                i = skipCoveredItems(l, i + 1, end, (prevRight + p.dx) / p.currentScale - MIN_WIDTH, depth) - 1;
+#else
+                if (!(EASY_GLOBALS.hide_narrow_children && w < EASY_GLOBALS.blocks_narrow_size) && l > 0)
+                    dont_skip_children(next_level, item.children_begin, BLOCK_ITEM_DO_PAINT_FIRST);
+#endif
+                continue;
+            }
+
+            if (x < prevRight)
+            {
+                w -= prevRight - x;
+                x = prevRight;
+            }
+
+#ifndef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
+            if (EASY_GLOBALS.hide_minsize_blocks && w < EASY_GLOBALS.blocks_size_min && l > 0)
+                continue; // Hide blocks (except top-level blocks) which width is less than 1 pixel
+
+            if (state == BLOCK_ITEM_DO_PAINT_FIRST && neighbour < item.neighbours)
+            {
+                // Paint only first child which has own children
+                i += item.neighbours - neighbour - 1; // Skip all neighbours
+            }
+#endif
+
+            const auto& itemDesc = easyDescriptor(itemTree.node->id());
+            int h = 0;
+
+#ifdef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
+            bool do_paint_children = false;
+#endif
+
+            if ((EASY_GLOBALS.hide_narrow_children && w < EASY_GLOBALS.blocks_narrow_size) || !itemBlock.expanded)
+            {
+                // Items which width is less than 20 will be painted as big rectangles which are hiding it's children
+
+                //x = item.left() * p.currentScale - p.dx;
+                h = totalHeight;
+                const auto dh = top + h - p.visibleBottom;
+                if (dh > 0)
+                    h -= dh;
+
+                if (item.block == EASY_GLOBALS.selected_block)
+                    p.selectedItemsWasPainted = true;
+
+                const bool colorChange = (p.previousColor != itemDesc.color());
+                if (colorChange)
+                {
+                    // Set background color brush for rectangle
+                    p.previousColor = itemDesc.color();
+                    //p.inverseColor = 0xffffffff - p.previousColor;
+                    p.is_light = ::profiler_gui::isLightColor(p.previousColor);
+                    p.textColor = ::profiler_gui::textColorForFlag(p.is_light);
+                    p.brush.setColor(QColor::fromRgba(p.previousColor));
+                    _painter->setBrush(p.brush);
+                }
+
+                if (EASY_GLOBALS.highlight_blocks_with_same_id && (EASY_GLOBALS.selected_block_id == itemTree.node->id()
+                    || (::profiler_gui::is_max(EASY_GLOBALS.selected_block) && EASY_GLOBALS.selected_block_id == itemDesc.id())))
+                {
+                    if (p.previousPenStyle != Qt::DotLine)
+                    {
+                        p.previousPenStyle = Qt::DotLine;
+                        _painter->setPen(HIGHLIGHTER_PEN);
+                    }
+                }
+                else if (EASY_GLOBALS.draw_graphics_items_borders)
+                {
+                    if (p.previousPenStyle != Qt::SolidLine)// || colorChange)
+                    {
+                        // Restore pen for item which is wide enough to paint borders
+                        p.previousPenStyle = Qt::SolidLine;
+                        _painter->setPen(BORDERS_COLOR);//BORDERS_COLOR & inverseColor);
+                    }
+                }
+                else if (p.previousPenStyle != Qt::NoPen)
+                {
+                    p.previousPenStyle = Qt::NoPen;
+                    _painter->setPen(Qt::NoPen);
+                }
+
+                const auto wprev = w;
+                decltype(w) dw = 0;
+                if (item.left() < p.sceneLeft)
+                {
+                    // if item left border is out of screen then attach text to the left border of the screen
+                    // to ensure text is always visible for items presenting on the screen.
+                    w += (item.left() - p.sceneLeft) * p.currentScale;
+                    x = p.sceneLeft * p.currentScale - p.dx - 2;
+                    w += 2;
+                    dw = 2;
+                }
+
+                if (item.right() > p.sceneRight)
+                {
+                    w -= (item.right() - p.sceneRight) * p.currentScale;
+                    w += 2;
+                    dw += 2;
+                }
+
+                if (w < EASY_GLOBALS.blocks_size_min)
+                    w = EASY_GLOBALS.blocks_size_min;
+
+                // Draw rectangle
+                p.rect.setRect(x, top, w, h);
+                _painter->drawRect(p.rect);
+                hatchLockWait(_painter, p.rect, itemTree, itemDesc);
+
+                prevRight = p.rect.right() + EASY_GLOBALS.blocks_spacing;
+#ifdef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
+                coverSublevels(l, itemTree.depth, prevRight, _rightBounds);
+#endif
+                //skip_children(next_level, item.children_begin);
+                if (wprev < EASY_GLOBALS.blocks_narrow_size)
+                    continue;
+
+                if (dw > 1) {
+                    w -= dw;
+                    x += 2;
+                }
+            }
+            else
+            {
+                if (item.block == EASY_GLOBALS.selected_block)
+                    p.selectedItemsWasPainted = true;
+
+                const bool colorChange = (p.previousColor != itemDesc.color());
+                if (colorChange)
+                {
+                    // Set background color brush for rectangle
+                    p.previousColor = itemDesc.color();
+                    //p.inverseColor = 0xffffffff - p.previousColor;
+                    p.is_light = ::profiler_gui::isLightColor(p.previousColor);
+                    p.textColor = ::profiler_gui::textColorForFlag(p.is_light);
+                    p.brush.setColor(QColor::fromRgba(p.previousColor));
+                    _painter->setBrush(p.brush);
+                }
+
+                if (EASY_GLOBALS.highlight_blocks_with_same_id && (EASY_GLOBALS.selected_block_id == itemTree.node->id()
+                    || (::profiler_gui::is_max(EASY_GLOBALS.selected_block) && EASY_GLOBALS.selected_block_id == itemDesc.id())))
+                {
+                    if (p.previousPenStyle != Qt::DotLine)
+                    {
+                        p.previousPenStyle = Qt::DotLine;
+                        _painter->setPen(HIGHLIGHTER_PEN);
+                    }
+                }
+                else if (EASY_GLOBALS.draw_graphics_items_borders)
+                {
+                    if (p.previousPenStyle != Qt::SolidLine)// || colorChange)
+                    {
+                        // Restore pen for item which is wide enough to paint borders
+                        p.previousPenStyle = Qt::SolidLine;
+                        _painter->setPen(BORDERS_COLOR);// BORDERS_COLOR & inverseColor);
+                    }
+                }
+                else if (p.previousPenStyle != Qt::NoPen)
+                {
+                    p.previousPenStyle = Qt::NoPen;
+                    _painter->setPen(Qt::NoPen);
+                }
+
+                // Draw rectangle
+                //x = item.left() * currentScale - p.dx;
+                h = EASY_GLOBALS.size.graphics_row_height;
+                const auto dh = top + h - p.visibleBottom;
+                if (dh > 0)
+                    h -= dh;
+
+                const auto wprev = w;
+                decltype(w) dw = 0;
+                if (item.left() < p.sceneLeft)
+                {
+                    // if item left border is out of screen then attach text to the left border of the screen
+                    // to ensure text is always visible for items presenting on the screen.
+                    w += (item.left() - p.sceneLeft) * p.currentScale;
+                    x = p.sceneLeft * p.currentScale - p.dx - 2;
+                    w += 2;
+                    dw = 2;
+                }
+
+                if (item.right() > p.sceneRight)
+                {
+                    w -= (item.right() - p.sceneRight) * p.currentScale;
+                    w += 2;
+                    dw += 2;
+                }
+
+                if (w < EASY_GLOBALS.blocks_size_min)
+                    w = EASY_GLOBALS.blocks_size_min;
+
+                p.rect.setRect(x, top, w, h);
+                _painter->drawRect(p.rect);
+                hatchLockWait(_painter, p.rect, itemTree, itemDesc);
+
+                prevRight = p.rect.right() + EASY_GLOBALS.blocks_spacing;
+                if (wprev < EASY_GLOBALS.blocks_narrow_size)
+                {
+#ifndef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
+                    dont_skip_children(next_level, item.children_begin, wprev < narrow_size_half ? BLOCK_ITEM_DO_PAINT_FIRST : BLOCK_ITEM_DO_PAINT);
+#else
+                    paintChildren(MIN_WIDTH, narrow_size_half, levelsNumber, _painter, p, item, itemTree, _rightBounds, next_level, wprev < narrow_size_half ? BLOCK_ITEM_DO_PAINT_FIRST : BLOCK_ITEM_DO_PAINT);
+#endif
+                    continue;
+                }
+
+#ifndef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
+                dont_skip_children(next_level, item.children_begin, BLOCK_ITEM_DO_PAINT);
+#endif
+
+                if (dw > 1) {
+                    w -= dw;
+                    x += 2;
+                }
+
+#ifdef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
+                do_paint_children = true;
+#endif
+            }
+
+            // Draw text-----------------------------------
+            p.rect.setRect(x + 1, top, w - 1, h);
+
+            // text will be painted with inverse color
+            //auto textColor = inverseColor < 0x00808080 ? profiler::colors::Black : profiler::colors::White;
+            //if (textColor == previousColor) textColor = 0;
+            _painter->setPen(p.textColor);
+
+            if (item.block == EASY_GLOBALS.selected_block)
+                setSelectedFont(_painter);
+
+            // drawing text (tiles have no labels, see paintTiles())
+            if (p.drawLabels)
+            {
+                auto name = easyBlockName(itemTree, itemDesc);
+                _painter->drawText(p.rect, Qt::AlignCenter, ::profiler_gui::toUnicode(name));
+            }
+
+            // restore previous pen color
+            if (p.previousPenStyle == Qt::NoPen)
+                _painter->setPen(Qt::NoPen);
+            else if (p.previousPenStyle == Qt::DotLine)
+            {
+                _painter->setPen(HIGHLIGHTER_PEN);
+            }
+            else
+                _painter->setPen(BORDERS_COLOR);// BORDERS_COLOR & inverseColor); // restore pen for rectangle painting
+
+            // restore font
+            if (item.block == EASY_GLOBALS.selected_block)
+                restoreItemFont(_painter);
+            // END Draw text~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifdef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
+            if (do_paint_children)
+                paintChildren(MIN_WIDTH, narrow_size_half, levelsNumber, _painter, p, item, itemTree, _rightBounds, next_level, BLOCK_ITEM_DO_PAINT);
+#endif
+        }
+    }
+}
+
+#ifdef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
+void GraphicsBlockItem::paintTiles(QPainter* _painter, EasyPainterInformation& p)
+{
+    const auto ratio = _painter->device()->devicePixelRatioF();
+    if (m_tilesScale != p.currentScale || m_tilesDevicePixelRatio != ratio)
+    {
+        // Tiles are cached for current scale only
+        invalidateTiles();
+        m_tilesScale = p.currentScale;
+        m_tilesDevicePixelRatio = ratio;
+    }
+
+    const auto first = static_cast<int64_t>(::std::floor(p.dx / TILE_WIDTH));
+    const auto last = static_cast<int64_t>(::std::floor((p.dx + p.visibleSceneRect.width()) / TILE_WIDTH));
+
+    // Remove tiles which are too far from the visible region
+    const auto margin = last - first + 1;
+    for (auto it = m_tiles.begin(); it != m_tiles.end();)
+    {
+        if (it->first < first - margin || it->first > last + margin)
+            it = m_tiles.erase(it);
+        else
+            ++it;
+    }
+
+    ::std::vector<int64_t> missing;
+    for (auto column = first; column <= last; ++column)
+    {
+        if (m_tiles.find(column) == m_tiles.end())
+            missing.push_back(column);
+    }
+
+    if (!missing.empty())
+    {
+        // Each tile is painted by paintItems() as if it was the whole visible region,
+        // so tiles have their own painting state and could be rasterized in parallel.
+        // Labels are not cached: a label is centered in the visible part of its block, so a tile
+        // would repeat labels of blocks crossing its borders. They are painted over all tiles below.
+        const QRectF tileRect(0, y(), TILE_WIDTH, m_boundingRect.height());
+        const auto imageWidth = static_cast<int>(::std::ceil(tileRect.width() * ratio));
+        const auto imageHeight = static_cast<int>(::std::ceil(tileRect.height() * ratio));
+
+        ::std::vector<Tile> tiles(missing.size());
+        ThreadPool::instance().parallelFor(missing.size(), [&](size_t i)
+        {
+            auto& tile = tiles[i];
+            tile.image = QImage(imageWidth, imageHeight, QImage::Format_ARGB32_Premultiplied);
+            tile.image.setDevicePixelRatio(ratio);
+            tile.image.fill(Qt::transparent);
+
+            QPainter painter(&tile.image);
+            painter.setFont(EASY_GLOBALS.font.item);
+            painter.setTransform(QTransform::fromTranslate(0, -tileRect.top()), true);
+
+            EasyPainterInformation info(tileRect, p.currentScale, missing[i] * TILE_WIDTH / p.currentScale);
+            info.drawLabels = false;
+            RightBounds rightBounds(m_rightBounds.size());
+            DrawIndexes levelsIndexes(m_levelsIndexes.size());
+            paintItems(&painter, info, rightBounds, levelsIndexes);
+
+            tile.selectedItemPainted = info.selectedItemsWasPainted;
+        });
+
+        for (size_t i = 0; i < missing.size(); ++i)
+            m_tiles[missing[i]] = ::std::move(tiles[i]);
+    }
+
+    for (auto column = first; column <= last; ++column)
+    {
+        const auto& tile = m_tiles[column];
+        _painter->drawImage(QPointF(column * TILE_WIDTH - p.dx, y()), tile.image);
+        p.selectedItemsWasPainted = p.selectedItemsWasPainted || tile.selectedItemPainted;
+    }
+
+    paintLabels(_painter, p, 0, 0, static_cast<uint32_t>(m_levels.front().size()));
+}
+#endif
+
+#ifdef EASY_GRAPHICS_OPENGL_VIEWPORT
+bool GraphicsBlockItem::paintItemsGL(QPainter* _painter, EasyPainterInformation& p)
+{
+    auto renderer = view()->glRenderer();
+    if (renderer == nullptr)
+        return false;
+
+    const auto transform = _painter->deviceTransform();
+    const auto device = _painter->device();
+
+    BlocksGLRenderer::Frame frame;
+    frame.origin = QPointF(transform.dx(), transform.dy());
+    frame.viewport = QSizeF(device->width(), device->height());
+    frame.offset = p.offset;
+    frame.scale = p.currentScale;
+    frame.minWidth = EASY_GLOBALS.enable_zero_length ? 0.f : 0.25f;
+    frame.minPixels = static_cast<float>(EASY_GLOBALS.blocks_size_min);
+    frame.narrowSize = static_cast<float>(EASY_GLOBALS.blocks_narrow_size);
+    frame.rowHeight = static_cast<float>(EASY_GLOBALS.size.graphics_row_height);
+    frame.rowFullSize = static_cast<float>(EASY_GLOBALS.size.graphics_row_full);
+    frame.hideNarrow = EASY_GLOBALS.hide_narrow_children;
+    frame.hideMinSize = EASY_GLOBALS.hide_minsize_blocks;
+    frame.borders = EASY_GLOBALS.draw_graphics_items_borders;
+    frame.borderColor = BORDERS_COLOR;
+
+    if (!renderer->begin(_painter, frame))
+        return false;
+
+    BlocksGLRenderer::Instances instances;
+
+    // Levels are painted from the deepest one, so collapsed and narrow blocks
+    // (painted as big rectangles) are hiding their children
+    for (auto l = static_cast<int>(levels()) - 1; l >= 0; --l)
+    {
+        const auto levelIndex = static_cast<uint8_t>(l);
+        const auto top = levelY(levelIndex);
+        if (top > p.visibleBottom)
+            continue;
+
+        const auto& level = m_levels[levelIndex];
+        const auto size = static_cast<uint32_t>(level.size());
+
+        if (!renderer->isUploaded(m_index, levelIndex))
+        {
+            instances.resize(level.size());
+            for (uint32_t i = 0; i < size; ++i)
+            {
+                const auto& item = level[i];
+                const auto& itemTree = easyBlocksTree(item.block);
+                const auto color = easyDescriptor(itemTree.node->id()).color();
+                const auto left = item.left();
+
+                auto& instance = instances[i];
+                instance.leftHigh = static_cast<float>(left);
+                instance.leftLow = static_cast<float>(left - instance.leftHigh);
+                instance.width = static_cast<float>(item.width());
+                instance.depth = static_cast<float>(itemTree.depth);
+                instance.color[0] = static_cast<uint8_t>(qRed(color));
+                instance.color[1] = static_cast<uint8_t>(qGreen(color));
+                instance.color[2] = static_cast<uint8_t>(qBlue(color));
+                instance.color[3] = 0xff;
+                instance.expanded = easyBlock(item.block).expanded ? 1.f : 0.f;
+            }
+
+            renderer->upload(m_index, levelIndex, instances);
+        }
+
+        // Items of one level do not intersect, so only one item before sceneLeft could be visible
+        auto first = lowerBound(levelIndex, 0, size, p.sceneLeft);
+        if (first > 0)
+            --first;
+
+        const auto last = lowerBound(levelIndex, first, size, p.sceneRight);
+        renderer->paintLevel(m_index, levelIndex, top, first, last - first, levelIndex == 0);
+    }
+
+    renderer->end(_painter);
+
+    paintLabels(_painter, p, 0, 0, static_cast<uint32_t>(m_levels.front().size()));
+
+    return true;
+}
+
+#endif
+
+#if defined(EASY_GRAPHICS_OPENGL_VIEWPORT) || defined(EASY_GRAPHICS_ITEM_RECURSIVE_PAINT)
+void GraphicsBlockItem::paintLabels(QPainter* _painter, EasyPainterInformation& p, uint8_t _level, uint32_t _begin, uint32_t _end)
+{
+    const auto top = levelY(_level);
+    if (top > p.visibleBottom)
+        return;
+
+    const auto MIN_WIDTH = EASY_GLOBALS.enable_zero_length ? 0.f : 0.25f;
+    const auto next_level = static_cast<short>(_level + 1);
+    const auto& level = m_levels[_level];
+
+    auto first = lowerBound(_level, _begin, _end, p.sceneLeft);
+    if (first > _begin)
+        --first;
+
+    for (uint32_t i = first; i < _end; ++i)
+    {
+        const auto& item = level[i];
+
+        if (item.left() > p.sceneRight)
+            break; // This is first totally invisible item. No need to check other items.
+
+        if (item.right() < p.sceneLeft)
+            continue; // This item is not visible
+
+        auto w = ::std::max(item.width(), MIN_WIDTH) * p.currentScale;
+        if (w < EASY_GLOBALS.blocks_narrow_size)
+            continue; // Narrow items have no labels and their children are narrow too
+
+        const auto& itemBlock = easyBlock(item.block);
+        const auto& itemTree = easyBlocksTree(item.block);
+        const auto& itemDesc = easyDescriptor(itemTree.node->id());
+
+        qreal h = EASY_GLOBALS.size.graphics_row_height;
+        if (!itemBlock.expanded)
+        {
+            h = itemTree.depth * EASY_GLOBALS.size.graphics_row_full + EASY_GLOBALS.size.graphics_row_height;
+            const auto dh = top + h - p.visibleBottom;
+            if (dh > 0)
+                h -= dh;
+        }
+
+        auto x = item.left() * p.currentScale - p.dx;
+        if (item.left() < p.sceneLeft)
+        {
+            // if item left border is out of screen then attach text to the left border of the screen
+            // to ensure text is always visible for items presenting on the screen.
+            w += (item.left() - p.sceneLeft) * p.currentScale;
+            x = p.sceneLeft * p.currentScale - p.dx;
+        }
+
+        if (item.right() > p.sceneRight)
+            w -= (item.right() - p.sceneRight) * p.currentScale;
+
+        // Draw text-----------------------------------
+        p.rect.setRect(x + 1, top, w - 1, h);
+        _painter->setPen(::profiler_gui::textColorForRgb(itemDesc.color()));
+
+        if (item.block == EASY_GLOBALS.selected_block)
+            setSelectedFont(_painter);
+
+        auto name = easyBlockName(itemTree, itemDesc);
+        _painter->drawText(p.rect, Qt::AlignCenter, ::profiler_gui::toUnicode(name));
+
+        if (item.block == EASY_GLOBALS.selected_block)
+            restoreItemFont(_painter);
+        // END Draw text~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+        if (itemBlock.expanded && next_level < levels() && !itemTree.children.empty() &&
+            !::profiler_gui::is_max(item.children_begin))
+        {
+            paintLabels(_painter, p, static_cast<uint8_t>(next_level), item.children_begin,
+                        item.children_begin + static_cast<uint32_t>(itemTree.children.size()));
+        }
+    }
+}
+#endif
+
+void GraphicsBlockItem::invalidateTiles()
+{
+    m_tiles.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+const profiler::BlocksTreeRoot& GraphicsBlockItem::root() const
+{
+    return m_thread;
+}
+
+const QString& GraphicsBlockItem::threadName() const
+{
+    return m_threadName;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+QRect GraphicsBlockItem::getRect() const
+{
+    return view()->mapFromScene(m_boundingRect).boundingRect();
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+void GraphicsBlockItem::getBlocks(qreal _left, qreal _right, ::profiler_gui::TreeBlocks& _blocks) const
+{
+    // Search for first visible top-level item
+    auto& level0 = m_levels.front();
+    size_t itemIndex = lowerBound(0, 0, static_cast<uint32_t>(level0.size()), _left);
+    if (itemIndex > 0)
+        itemIndex -= 1;
+
+    // Add all visible top-level items into array of visible blocks
+    for (size_t i = itemIndex, end = level0.size(); i < end; ++i)
+    {
+        const auto& item = level0[i];
+
+        if (item.left() > _right)
+        {
+            // First invisible item. No need to check other items.
+            break;
+        }
+
+        if (item.right() < _left)
+        {
+            // This item is not visible yet
+            // This is just to be sure
+            continue;
+        }
+
+        _blocks.emplace_back(&m_thread, item.block);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+const ::profiler_gui::EasyBlock* GraphicsBlockItem::intersect(const QPointF& _pos, ::profiler::block_index_t& _blockIndex) const
+{
+    if (m_levels.empty() || m_levels.front().empty())
     {
         return nullptr;
     }
@@ -1243,7 +1547,7 @@ const ::profiler_gui::EasyBlock* GraphicsBlockItem::intersect(const QPointF& _po
             {
                 _blockIndex = *it;
                 const auto& item = easyBlock(_blockIndex);
-                auto left = sceneView->time2position(item.tree.node->begin());
+                auto left = sceneView->time2position(easyBlocksTree(_blockIndex).node->begin());
 
                 if (left - dw > _pos.x())
                     break; // This is first totally invisible item. No need to check other items.
@@ -1265,51 +1569,24 @@ const ::profiler_gui::EasyBlock* GraphicsBlockItem::intersect(const QPointF& _po
 
     const auto currentScale = view()->scale();
     const auto dw = 5. / currentScale;
-    unsigned int i = 0;
-    size_t itemIndex = ::std::numeric_limits<size_t>::max();
-    size_t firstItem = 0, lastItem = static_cast<unsigned int>(level0.size());
-    while (i <= levelIndex)
+    static const auto MAX_CHILD_INDEX = ::profiler_gui::numeric_max<decltype(::profiler_gui::EasyBlockItem::children_begin)>();
+
+    // Children of each item are stored contiguously on the next level,
+    // so the search range of the next level is known without scanning neighbours
+    uint32_t firstItem = 0, lastItem = static_cast<uint32_t>(level0.size());
+    for (unsigned int i = 0; i <= levelIndex; ++i)
     {
         const auto& level = m_levels[i];
-        size_t levelSize = level.size();
-
-        auto firstItemIterator = level.begin();
-        auto lastItemIterator = level.begin();
-
-        // Ensure that firstItem and lastItem are within the permissible range
-        if (firstItem < levelSize) {
-            std::advance(firstItemIterator, firstItem);
-        } else {
-            firstItemIterator = level.end();
-        }
-
-        if (lastItem <= levelSize) {
-            std::advance(lastItemIterator, lastItem);
-        } else {
-            lastItemIterator = level.end();
-        }
 
         // Search for first visible item
-        auto first = ::std::lower_bound(firstItemIterator, lastItemIterator, _pos.x(), [](const ::profiler_gui::EasyBlockItem& _item, qreal _value)
-        {
-            return _item.left() < _value;
-        });
+        auto itemIndex = lowerBound(static_cast<uint8_t>(i), firstItem, lastItem, _pos.x());
+        if (itemIndex > firstItem)
+            --itemIndex;
 
-        if (first != level.end())
-        {
-            itemIndex = first - level.begin();
-            if (itemIndex != 0)
-                --itemIndex;
-        }
-        else
-        {
-            itemIndex = level.size() - 1;
-        }
-
-        for (auto size = level.size(); itemIndex < size; ++itemIndex)
+        bool found = false;
+        for (; itemIndex < lastItem; ++itemIndex)
         {
             const auto& item = level[itemIndex];
-            static const auto MAX_CHILD_INDEX = ::profiler_gui::numeric_max(item.children_begin);
 
             if (item.left() - dw > _pos.x())
             {
@@ -1332,53 +1609,30 @@ const ::profiler_gui::EasyBlock* GraphicsBlockItem::intersect(const QPointF& _po
 
             if (item.children_begin == MAX_CHILD_INDEX)
             {
-                if (itemIndex != 0)
-                {
-                    auto j = itemIndex;
-                    firstItem = 0;
-                    do {
-
-                        --j;
-                        const auto& item2 = level[j];
-                        if (item2.children_begin != MAX_CHILD_INDEX)
-                        {
-                            firstItem = item2.children_begin;
-                            break;
-                        }
-
-                    } while (j != 0);
-                }
-                else
-                {
-                    firstItem = 0;
-                }
+                // Item has no children but the position may be close to children of neighbour items
+                firstItem = 0;
+                lastItem = static_cast<uint32_t>(m_levels[i + 1].size());
             }
             else
             {
                 firstItem = item.children_begin;
+                lastItem = firstItem + static_cast<uint32_t>(easyBlocksTree(item.block).children.size());
             }
 
-            lastItem = m_levels[i + 1].size();
-            for (auto j = itemIndex + 1; j < size; ++j)
-            {
-                const auto& item2 = level[j];
-                if (item2.children_begin != MAX_CHILD_INDEX)
-                {
-                    lastItem = item2.children_begin;
-                    break;
-                }
-            }
-
+            found = true;
             break;
         }
 
-        ++i;
+        if (!found)
+        {
+            return nullptr;
+        }
     }
 
     return nullptr;
 }
 
-const ::profiler_gui::EasyBlock* GraphicsBlockItem::intersectEvent(const QPointF& _pos) const
+const ::profiler::BlocksTree* GraphicsBlockItem::intersectEvent(const QPointF& _pos) const
 {
     if (m_thread.sync.empty())
     {
@@ -1411,13 +1665,13 @@ const ::profiler_gui::EasyBlock* GraphicsBlockItem::intersectEvent(const QPointF
     const auto dw = 4. / view()->scale();
     for (auto it = firstSync, end = m_thread.sync.end(); it != end; ++it)
     {
-        const auto& item = easyBlock(*it);
+        const auto& item = easyBlocksTree(*it);
 
-        const auto left = sceneView->time2position(item.tree.node->begin()) - dw;
+        const auto left = sceneView->time2position(item.node->begin()) - dw;
         if (left > _pos.x())
             break;
         
-        const auto right = sceneView->time2position(item.tree.node->end()) + dw;
+        const auto right = sceneView->time2position(item.node->end()) + dw;
         if (right < _pos.x())
             continue;
 
@@ -1496,6 +1750,212 @@ unsigned int GraphicsBlockItem::addItem(uint8_t _level)
     return static_cast<unsigned int>(m_levels[_level].size() - 1);
 }
 
+//////////////////////////////////////////////////////////////////////////
+
+void GraphicsBlockItem::buildLevelsOfDetail()
+{
+    m_lodWorker.dequeue();
+    m_lodReady.store(false, std::memory_order_release);
+
+    m_lodWorker.enqueue([this]
+    {
+        LodLevels lods(m_levels.size());
+        SearchIndex searchIndex(m_levels.size());
+        std::vector<size_t> stack;
+
+        for (size_t l = 0; l < m_levels.size(); ++l)
+        {
+            const auto& level = m_levels[l];
+            if (level.size() <= LOD_BASE_SIZE)
+                continue; // It is faster to check all items of this level one by one
+
+            auto& pyramid = lods[l];
+            const auto cellsNumber = (level.size() + LOD_BASE_SIZE - 1) >> LOD_BASE_SHIFT;
+
+            // Fill search tree in Eytzinger order (node k has children 2k and 2k+1, node 0 is unused)
+            // by in-order traversal, so in-order sequence of nodes is sorted by left bound
+            auto& nodes = searchIndex[l];
+            nodes.resize(cellsNumber + 1);
+            uint32_t cell = 0;
+            for (size_t k = 1; k <= cellsNumber || !stack.empty();)
+            {
+                for (; k <= cellsNumber; k <<= 1)
+                    stack.push_back(k);
+
+                k = stack.back();
+                stack.pop_back();
+
+                nodes[k] = SearchNode {level[static_cast<size_t>(cell) << LOD_BASE_SHIFT].left(), cell};
+                ++cell;
+
+                k = (k << 1) + 1;
+            }
+
+            LodCells cells(cellsNumber, LodCell {-1e100, 0});
+            for (size_t i = 0, size = level.size(); i < size; ++i)
+            {
+                const auto& item = level[i];
+                auto& cell = cells[i >> LOD_BASE_SHIFT];
+                cell.right = std::max(cell.right, item.right());
+                cell.depth = std::max(cell.depth, easyBlocksTree(item.block).depth);
+            }
+
+            if (m_lodInterrupt.load(std::memory_order_acquire))
+                return;
+
+            pyramid.emplace_back(std::move(cells));
+
+            while (pyramid.back().size() > 1)
+            {
+                const auto& prev = pyramid.back();
+
+                LodCells next((prev.size() + 1) >> 1);
+                for (size_t i = 0, size = prev.size(); i < size; ++i)
+                {
+                    auto& cell = next[i >> 1];
+                    if ((i & 1) == 0)
+                    {
+                        cell = prev[i];
+                    }
+                    else
+                    {
+                        cell.right = std::max(cell.right, prev[i].right);
+                        cell.depth = std::max(cell.depth, prev[i].depth);
+                    }
+                }
+
+                pyramid.emplace_back(std::move(next));
+            }
+        }
+
+        m_lods.swap(lods);
+        m_searchIndex.swap(searchIndex);
+        m_lodReady.store(true, std::memory_order_release);
+    }, m_lodInterrupt);
+}
+
+void GraphicsBlockItem::stopLevelsOfDetail()
+{
+    if (m_lodReady.load(std::memory_order_acquire))
+        return;
+
+    m_lodWorker.dequeue();
+    m_lodStopped = true;
+}
+
+void GraphicsBlockItem::resumeLevelsOfDetail()
+{
+    if (!m_lodStopped)
+        return;
+
+    m_lodStopped = false;
+    buildLevelsOfDetail();
+}
+
+uint32_t GraphicsBlockItem::skipCoveredItems(uint8_t _level, uint32_t _begin, uint32_t _end, qreal _right, uint8_t _depth) const
+{
+    const auto& level = m_levels[_level];
+
+    const LodPyramid* pyramid = nullptr;
+    if (m_lodReady.load(std::memory_order_acquire) && !m_lods[_level].empty())
+        pyramid = &m_lods[_level];
+
+    auto i = _begin;
+    while (i < _end)
+    {
+        if (pyramid != nullptr && (i & (LOD_BASE_SIZE - 1)) == 0)
+        {
+            // Try to skip the biggest cell starting from i-th item
+            bool skipped = false;
+            for (auto k = static_cast<uint32_t>(pyramid->size()); k-- > 0;)
+            {
+                const auto shift = LOD_BASE_SHIFT + k;
+                const auto cellSize = 1U << shift;
+                if ((i & (cellSize - 1)) != 0 || (_end - i) < cellSize)
+                    continue;
+
+                const auto& cell = (*pyramid)[k][i >> shift];
+                if (cell.right < _right && cell.depth <= _depth)
+                {
+                    i += cellSize;
+                    skipped = true;
+                    break;
+                }
+            }
+
+            if (skipped)
+                continue;
+        }
+
+        const auto& item = level[i];
+        if (item.right() >= _right || easyBlocksTree(item.block).depth > _depth)
+            break;
+
+        ++i;
+    }
+
+    return i;
+}
+
+uint32_t GraphicsBlockItem::lowerBound(uint8_t _level, uint32_t _begin, uint32_t _end, qreal _x) const
+{
+    const auto& level = m_levels[_level];
+
+    if (m_lodReady.load(std::memory_order_acquire) && !m_searchIndex[_level].empty())
+    {
+        const auto& nodes = m_searchIndex[_level];
+        const auto cellsNumber = nodes.size() - 1;
+
+        size_t k = 1;
+        while (k <= cellsNumber)
+            k = (k << 1) + (nodes[k].left < _x ? 1 : 0);
+
+        // Cancel trailing right turns and the last left turn: k becomes the first node which is not less than _x
+        while ((k & 1) != 0)
+            k >>= 1;
+        k >>= 1;
+
+        // First items of all cells before found one are less than _x,
+        // so the result is inside previous cell (or it is the first item of found cell)
+        const auto cell = k != 0 ? nodes[k].cell : static_cast<uint32_t>(cellsNumber);
+        const auto first = std::max(cell != 0 ? ((cell - 1) << LOD_BASE_SHIFT) + 1 : 0U, _begin);
+        const auto last = std::min(std::min(cell << LOD_BASE_SHIFT, static_cast<uint32_t>(level.size())), _end);
+
+        if (first >= _end)
+            return _end;
+
+        if (last <= _begin)
+            return _begin;
+
+        _begin = first;
+        _end = last;
+    }
+
+    auto it = std::lower_bound(level.begin() + _begin, level.begin() + _end, _x, [](const ::profiler_gui::EasyBlockItem& _item, qreal _value)
+    {
+        return _item.left() < _value;
+    });
+
+    return static_cast<uint32_t>(std::distance(level.begin(), it));
+}
+
+uint8_t GraphicsBlockItem::coveredDepth(uint8_t _level, qreal _right, const RightBounds& _rightBounds) const
+{
+    uint8_t depth = 0;
+    for (size_t l = _level + 1, size = m_levels.size(); l < size && _rightBounds[l] >= _right; ++l)
+        ++depth;
+    return depth;
+}
+
+void GraphicsBlockItem::coverSublevels(uint8_t _level, uint8_t _depth, qreal _right, RightBounds& _rightBounds) const
+{
+    for (size_t l = _level + 1, last = std::min(static_cast<size_t>(_level) + _depth, m_levels.size() - 1); l <= last; ++l)
+    {
+        if (_rightBounds[l] < _right)
+            _rightBounds[l] = _right;
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 
@@ -53,14 +53,19 @@
 #define GRAPHICS_BLOCK_ITEM_H
 
 #include <stdlib.h>
+#include <atomic>
+#include <unordered_map>
 
 #include <QGraphicsItem>
+#include <QImage>
 #include <QRectF>
 #include <QString>
 
 #include <easy/reader.h>
 
+#include "blocks_gl_renderer.h"
 #include "common_types.h"
+#include "thread_pool_task.h"
 
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
@@ -69,16 +74,52 @@ class BlocksGraphicsView;
 
 class GraphicsBlockItem : public QGraphicsItem
 {
+    /** Summary of consecutive items of one level (see m_lods). */
+    struct LodCell
+    {
+        qreal   right; ///< Maximum right bound of summarized items
+        uint8_t depth; ///< Maximum depth of summarized items
+    };
+
+    /** Node of implicit search tree over left bounds of items of one level (see m_searchIndex). */
+    struct SearchNode
+    {
+        qreal    left; ///< Left bound of the first item of the cell
+        uint32_t cell; ///< Index of the lowest layer cell of level-of-detail pyramid
+    };
+
+    /** Rasterized part of the diagram (see paintTiles()). */
+    struct Tile
+    {
+        QImage                 image; ///< Painted items
+        bool     selectedItemPainted; ///< True if the selected block has been painted on this tile
+    };
+
     using Children    = profiler_gui::EasyItems;
     using DrawIndexes = std::vector<uint32_t>;
     using RightBounds = std::vector<qreal>;
     using Sublevels   = std::vector<Children>;
+    using LodCells    = std::vector<LodCell>;
+    using LodPyramid  = std::vector<LodCells>;
+    using LodLevels   = std::vector<LodPyramid>;
+    using SearchNodes = std::vector<SearchNode>;
+    using SearchIndex = std::vector<SearchNodes>;
+    using Tiles       = std::unordered_map<int64_t, Tile>;
 
     const profiler::BlocksTreeRoot&  m_thread; ///< Reference to the root profiler block (thread block). Used by ProfTreeWidget to restore hierarchy.
 
     DrawIndexes               m_levelsIndexes; ///< Indexes of first item on each level from which we must start painting
     RightBounds                 m_rightBounds; ///<
     Sublevels                        m_levels; ///< Arrays of items for each level
+    LodLevels                          m_lods; ///< Level-of-detail pyramid for each level (see buildLevelsOfDetail())
+    SearchIndex                 m_searchIndex; ///< Eytzinger layout of cells of the lowest pyramid layer for each level (see lowerBound())
+    ThreadPoolTask                m_lodWorker; ///< Builds m_lods and m_searchIndex in background
+    std::atomic_bool           m_lodInterrupt; ///<
+    std::atomic_bool               m_lodReady; ///< True when m_lods and m_searchIndex are built and could be used
+    bool                         m_lodStopped; ///< True if building of m_lods has been stopped by stopLevelsOfDetail()
+    Tiles                             m_tiles; ///< Cached tiles for current scale indexed by column (see paintTiles())
+    qreal                        m_tilesScale; ///< Scale of cached tiles
+    qreal             m_tilesDevicePixelRatio; ///< Device pixel ratio of cached tiles
 
     QRectF                     m_boundingRect; ///< boundingRect (see QGraphicsItem)
     QString                      m_threadName; ///<
@@ -153,6 +194,28 @@ public:
     \retval Index of the new created item */
     unsigned int addItem(uint8_t _level);
 
+    /** \brief Starts building level-of-detail pyramid and search index for all levels in background.
+
+    Pyramid lets paint() skip runs of items hidden behind previously painted (sub-pixel) items in O(log n)
+    instead of walking them one by one, so each repaint of zoomed out diagram touches O(pixels) items.
+    Search index is used by lowerBound().
+
+    \note Must be called after all items have been added. */
+    void buildLevelsOfDetail();
+
+    /** \brief Stops building of level-of-detail pyramid if it is not ready yet (see resumeLevelsOfDetail()).
+
+    \note Must be called before global blocks are changed because background worker reads them. */
+    void stopLevelsOfDetail();
+
+    /** \brief Restarts building of level-of-detail pyramid if it has been stopped by stopLevelsOfDetail(). */
+    void resumeLevelsOfDetail();
+
+    /** \brief Drops cached tiles of the diagram.
+
+    \note Must be called when anything but scale or visible region changes appearance of items. */
+    void invalidateTiles();
+
     /** \brief Finds top-level blocks which are intersects with required selection zone.
 
     \note Found blocks will be added into the array of selected blocks.
@@ -163,15 +226,72 @@ public:
     void getBlocks(qreal _left, qreal _right, ::profiler_gui::TreeBlocks& _blocks) const;
 
     const ::profiler_gui::EasyBlock* intersect(const QPointF& _pos, ::profiler::block_index_t& _blockIndex) const;
-    const ::profiler_gui::EasyBlock* intersectEvent(const QPointF& _pos) const;
+    const ::profiler::BlocksTree* intersectEvent(const QPointF& _pos) const;
 
 private:
 
     ///< Returns pointer to the BlocksGraphicsView widget.
     const BlocksGraphicsView* view() const;
 
+    /** \brief Paints all visible items.
+
+    \param _rightBounds Right bounds of painted items for each level
+    \param _levelsIndexes Indexes of first item on each level from which painting starts */
+    void paintItems(QPainter* _painter, struct EasyPainterInformation& p, RightBounds& _rightBounds, DrawIndexes& _levelsIndexes);
+
+    /** \brief Returns index of the first item in [_begin, _end) of specified level which is not covered.
+
+    Item is covered if its right bound is less than _right and its depth is not greater than _depth.
+
+    \param _level Index of the level
+    \param _begin Index of the first item to check
+    \param _end Index of the item after the last item to check
+    \param _right Right bound of covering area
+    \param _depth Number of sublevels which are covered too */
+    uint32_t skipCoveredItems(uint8_t _level, uint32_t _begin, uint32_t _end, qreal _right, uint8_t _depth) const;
+
+    /** \brief Returns index of the first item in [_begin, _end) of specified level which left bound is not less than _x.
+
+    Returns _end if there is no such item. Items of each level are sorted by left bound, so the search
+    descends implicit search tree (Eytzinger layout of every 16th item) which is small enough
+    to stay in cache and then checks only one cell of items. Falls back to std::lower_bound until
+    the index is built.
+
+    \param _level Index of the level
+    \param _begin Index of the first item to check
+    \param _end Index of the item after the last item to check
+    \param _x Required left bound */
+    uint32_t lowerBound(uint8_t _level, uint32_t _begin, uint32_t _end, qreal _x) const;
+
+    ///< Returns number of sublevels below _level which right bound is not less than _right.
+    uint8_t coveredDepth(uint8_t _level, qreal _right, const RightBounds& _rightBounds) const;
+
+    ///< Marks sublevels of collapsed item (painted as a big rectangle hiding its children) as covered up to _right.
+    void coverSublevels(uint8_t _level, uint8_t _depth, qreal _right, RightBounds& _rightBounds) const;
+
 #ifdef EASY_GRAPHICS_ITEM_RECURSIVE_PAINT
-    void paintChildren(const float _minWidth, const int _narrowSizeHalf, const uint8_t _levelsNumber, QPainter* _painter, struct EasyPainterInformation& p, ::profiler_gui::EasyBlockItem& _item, const ::profiler_gui::EasyBlock& _itemBlock, RightBounds& _rightBounds, uint8_t _level, int8_t _mode);
+    /** \brief Paints all visible items using cached tiles.
+
+    Diagram is split into columns of TILE_WIDTH pixels each rasterized into an image using worker threads.
+    Tiles are reused while only visible region changes, so scrolling at a fixed scale becomes a blit.
+    Labels depend on the visible region, so they are painted over the tiles by paintLabels() every time. */
+    void paintTiles(QPainter* _painter, struct EasyPainterInformation& p);
+
+    void paintChildren(const float _minWidth, const int _narrowSizeHalf, const uint8_t _levelsNumber, QPainter* _painter, struct EasyPainterInformation& p, ::profiler_gui::EasyBlockItem& _item, const ::profiler::BlocksTree& _itemTree, RightBounds& _rightBounds, uint8_t _level, int8_t _mode);
+#endif
+
+#ifdef EASY_GRAPHICS_OPENGL_VIEWPORT
+    /** \brief Paints all visible items using BlocksGLRenderer of the view.
+
+    Returns false if the view has no OpenGL viewport or OpenGL can not be used for painting.
+    Blocks of each level are uploaded into instance buffer once and painted with instanced quads,
+    labels are painted by QPainter for blocks which are wider than EASY_GLOBALS.blocks_narrow_size only. */
+    bool paintItemsGL(QPainter* _painter, struct EasyPainterInformation& p);
+#endif
+
+#if defined(EASY_GRAPHICS_OPENGL_VIEWPORT) || defined(EASY_GRAPHICS_ITEM_RECURSIVE_PAINT)
+    ///< Paints labels of visible items in [_begin, _end) of specified level and labels of their children.
+    void paintLabels(QPainter* _painter, struct EasyPainterInformation& p, uint8_t _level, uint32_t _begin, uint32_t _end);
 #endif
 
 public:
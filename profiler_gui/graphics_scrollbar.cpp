@@ -59,6 +59,7 @@
 #include <QResizeEvent>
 #include <easy/utility.h>
 #include "graphics_scrollbar.h"
+#include "downsampling.h"
 #include "globals.h"
 
 namespace {
@@ -80,14 +81,112 @@ inline qreal calculate_color2(qreal, qreal duration, qreal k)
     return std::min(sqr(sqr(duration)) * k, 0.9999999);
 }
 
+//////////////////////////////////////////////////////////////////////////
+
+using Durations = std::vector<profiler::timestamp_t>;
+
+/** Reduces durations [_begin, _end) using reduction pyramid built by the same operation.
+
+On each layer at most two boundary values are taken, then the range is halved and the next layer is used. */
+template <class TOperation>
+profiler::timestamp_t reduceDurations(const Durations& _durations, const std::vector<Durations>& _pyramid,
+                                      size_t _begin, size_t _end, profiler::timestamp_t _result, TOperation _operation)
+{
+    const Durations* layer = &_durations;
+    for (size_t k = 0; _begin < _end; ++k)
+    {
+        if ((_begin & 1) != 0)
+            _result = _operation(_result, (*layer)[_begin++]);
+
+        if ((_end & 1) != 0)
+            _result = _operation(_result, (*layer)[--_end]);
+
+        _begin >>= 1;
+        _end >>= 1;
+
+        if (_begin < _end)
+            layer = &_pyramid[k];
+    }
+
+    return _result;
+}
+
+/** Returns median of durations (the order of _durations is changed). */
+profiler::timestamp_t medianDuration(Durations& _durations)
+{
+    if (_durations.empty())
+        return 0;
+
+    const auto middle = _durations.begin() + (_durations.size() >> 1);
+    std::nth_element(_durations.begin(), middle, _durations.end());
+
+    if ((_durations.size() & 1) != 0)
+        return *middle;
+
+    const auto lower = *std::max_element(_durations.begin(), middle);
+    return (lower + *middle) >> 1;
+}
+
 } // end of namespace <noname>.
 
 //////////////////////////////////////////////////////////////////////////
 
+void GraphicsHistogramItem::Series::build()
+{
+    const auto n = durations.size();
+
+    sums.resize(n + 1);
+    sums[0] = 0;
+    for (size_t i = 0; i < n; ++i)
+        sums[i + 1] = sums[i] + durations[i];
+
+    maxPyramid.clear();
+    minPyramid.clear();
+    for (size_t size = n >> 1; size != 0; size >>= 1)
+    {
+        // Previous layers are addressed by index because emplace_back() may reallocate pyramids
+        const auto k = maxPyramid.size();
+        Durations maxLayer(size), minLayer(size);
+        profiler_gui::pairwiseMax(k == 0 ? durations.data() : maxPyramid[k - 1].data(), size, maxLayer.data());
+        profiler_gui::pairwiseMin(k == 0 ? durations.data() : minPyramid[k - 1].data(), size, minLayer.data());
+
+        maxPyramid.emplace_back(std::move(maxLayer));
+        minPyramid.emplace_back(std::move(minLayer));
+    }
+
+    if (n == 0)
+    {
+        minDuration = maxDuration = medianDuration = 0;
+        return;
+    }
+
+    maxDuration = highest(0, n);
+    minDuration = lowest(0, n);
+
+    Durations sorted(durations);
+    medianDuration = ::medianDuration(sorted);
+}
+
+profiler::timestamp_t GraphicsHistogramItem::Series::highest(size_t _begin, size_t _end) const
+{
+    return reduceDurations(durations, maxPyramid, _begin, _end, 0, [] (profiler::timestamp_t a, profiler::timestamp_t b) {
+        return std::max(a, b);
+    });
+}
+
+profiler::timestamp_t GraphicsHistogramItem::Series::lowest(size_t _begin, size_t _end) const
+{
+    return reduceDurations(durations, minPyramid, _begin, _end, profiler_gui::numeric_max<profiler::timestamp_t>(),
+                           [] (profiler::timestamp_t a, profiler::timestamp_t b) { return std::min(a, b); });
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 GraphicsHistogramItem::GraphicsHistogramItem() : Parent()
     , m_workerTopDuration(0)
     , m_workerBottomDuration(0)
     , m_blockTotalDuraion(0)
+    , m_seriesCacheGeneration(0)
     , m_threadDuration(0)
     , m_threadProfiledTime(0)
     , m_threadWaitTime(0)
@@ -103,6 +202,7 @@ GraphicsHistogramItem::GraphicsHistogramItem() : Parent()
     , m_blockId(profiler_gui::numeric_max<decltype(m_blockId)>())
     , m_timeUnits(profiler_gui::TimeUnits_auto)
     , m_regime(Hist_Pointer)
+    , m_bWorkerStopped(false)
 {
 
 }
@@ -313,8 +413,7 @@ void GraphicsHistogramItem::paintById(QPainter* _painter)
     _painter->save();
     _painter->setTransform(QTransform::fromScale(1.0 / currentScale, 1), true);
 
-    const auto& items = m_selectedBlocks;
-    if (!items.empty())
+    if (m_series != nullptr && !m_series->empty())
     {
         if (!bindMode)
             paintImage(_painter);
@@ -479,11 +578,26 @@ void GraphicsHistogramItem::rebuildSource()
     }
 }
 
+void GraphicsHistogramItem::stopWorker()
+{
+    cancelAnyJob();
+    m_bWorkerStopped = true;
+}
+
+void GraphicsHistogramItem::resumeWorker()
+{
+    // Source could have been already changed after stopWorker() (it restarts the worker)
+    if (m_bWorkerStopped)
+        rebuildSource();
+}
+
 void GraphicsHistogramItem::setSource(profiler::thread_id_t _thread_id, const profiler_gui::EasyItems* _items)
 {
     if (m_regime == Hist_Pointer && m_threadId == _thread_id && m_pSource == _items)
         return;
 
+    m_bWorkerStopped = false;
+
     cancelAnyJob();
 
     m_boundaryTimer.stop();
@@ -499,9 +613,8 @@ void GraphicsHistogramItem::setSource(profiler::thread_id_t _thread_id, const pr
     m_imageOriginUpdate = m_imageOrigin = 0;
     m_imageScaleUpdate = m_imageScale = 1;
 
-    m_selectedBlocks.clear();
+    m_series.reset();
     setEmpty(true);
-    { profiler::BlocksTree::children_t().swap(m_selectedBlocks); }
 
     m_topDurationStr.clear();
     m_bottomDurationStr.clear();
@@ -528,7 +641,7 @@ void GraphicsHistogramItem::setSource(profiler::thread_id_t _thread_id, const pr
             if (root.children.empty())
                 m_threadDuration = 0;
             else
-                m_threadDuration = easyBlock(root.children.back()).tree.node->end() - easyBlock(root.children.front()).tree.node->begin();
+                m_threadDuration = easyBlocksTree(root.children.back()).node->end() - easyBlocksTree(root.children.front()).node->begin();
 
             m_threadProfiledTime = root.profiled_time;
             m_threadWaitTime = root.wait_time;
@@ -543,23 +656,30 @@ void GraphicsHistogramItem::setSource(profiler::thread_id_t _thread_id, const pr
                 m_maxValue = 0;
                 m_minValue = 1e30;
 
+                auto series = std::make_shared<Series>();
+                series->begins.reserve(source->size());
+                series->durations.reserve(source->size());
+
                 size_t totalCount = 0;
-                profiler_gui::DurationsCountMap durations;
+                Durations durations;
                 bool empty = true;
                 for (const auto& item : *source)
                 {
                     if (isReady())
                         return;
 
-                    auto& block = easyBlock(item.block).tree;
+                    auto& block = easyBlocksTree(item.block);
+                    const auto duration = block.node->duration();
+
+                    series->begins.push_back(block.node->begin());
+                    series->durations.push_back(duration);
+
                     auto& desc = easyDescriptor(block.node->id());
                     if (desc.type() != profiler::BlockType::Block)
                         continue;
 
-                    const auto duration = block.node->duration();
-
                     ++totalCount;
-                    ++durations[duration].count;
+                    durations.push_back(duration);
                     m_avgDuration += duration;
 
                     const auto w = item.width();
@@ -573,10 +693,13 @@ void GraphicsHistogramItem::setSource(profiler::thread_id_t _thread_id, const pr
                     empty = false;
                 }
 
+                series->build();
+                m_series = std::move(series);
+
                 if (!empty)
                 {
                     m_avgDuration /= totalCount;
-                    m_medianDuration = profiler_gui::calculateMedian(durations);
+                    m_medianDuration = medianDuration(durations);
                 }
 
                 if ((m_maxValue - m_minValue) < 1e-3)
@@ -632,6 +755,8 @@ void GraphicsHistogramItem::setSource(profiler::thread_id_t _thread_id, profiler
     if (m_regime == Hist_Id && m_threadId == _thread_id && m_blockId == _block_id)
         return;
 
+    m_bWorkerStopped = false;
+
     cancelAnyJob();
 
     setImageUpdatePermitted(false); // Set to false because m_workerThread have to parse input data first. This will be set to true when m_workerThread finish - see onTimeout()
@@ -655,9 +780,8 @@ void GraphicsHistogramItem::setSource(profiler::thread_id_t _thread_id, profiler
     m_imageOriginUpdate = m_imageOrigin = 0;
     m_imageScaleUpdate = m_imageScale = 1;
 
-    m_selectedBlocks.clear();
+    m_series.reset();
     setEmpty(true);
-    { profiler::BlocksTree::children_t().swap(m_selectedBlocks); }
 
     m_threadId = _thread_id;
     m_blockId = _block_id;
@@ -709,7 +833,7 @@ void GraphicsHistogramItem::setSource(profiler::thread_id_t _thread_id, profiler
         }
         else
         {
-            m_threadDuration = easyBlock(root.children.back()).tree.node->end() - easyBlock(root.children.front()).tree.node->begin();
+            m_threadDuration = easyBlocksTree(root.children.back()).node->end() - easyBlocksTree(root.children.front()).node->begin();
             m_threadProfiledTime = root.profiled_time;
             m_threadWaitTime = root.wait_time;
 
@@ -718,93 +842,93 @@ void GraphicsHistogramItem::setSource(profiler::thread_id_t _thread_id, profiler
             const auto selected_thread = std::ref(root);
             const auto selected_block = EASY_GLOBALS.selected_block;
             const bool showOnlyTopLevelBlocks = EASY_GLOBALS.display_only_frames_on_histogram;
-            m_worker.enqueue([this, selected_thread, selected_block, showOnlyTopLevelBlocks]
-            {
-                using Stack = std::vector<std::pair<profiler::block_index_t, profiler::block_index_t> >;
+            const bool has_selected_block = !profiler_gui::is_max(selected_block);
 
-                const auto& profiler_thread = selected_thread.get();
+            // Worker job has been canceled by cancelAnyJob() above, so m_seriesCache could be accessed here
+            if (m_seriesCacheGeneration != EASY_GLOBALS.data_generation)
+            {
+                m_seriesCache.clear();
+                m_seriesCacheGeneration = EASY_GLOBALS.data_generation;
+            }
 
-                m_maxValue = 0;
-                m_minValue = 1e30;
-                //const auto& profiler_thread = EASY_GLOBALS.profiler_blocks[m_threadId];
-                Stack stack;
-                stack.reserve(profiler_thread.depth);
+            const SeriesKey key(_thread_id, m_blockId, showOnlyTopLevelBlocks, has_selected_block);
+            const auto cached = m_seriesCache.find(key);
+            const SeriesPtr cachedSeries = cached != m_seriesCache.end() ? cached->second : nullptr;
 
-                const bool has_selected_block = !profiler_gui::is_max(selected_block);
+            m_worker.enqueue([this, selected_thread, selected_block, has_selected_block, showOnlyTopLevelBlocks, key, cachedSeries]
+            {
+                using Stack = std::vector<std::pair<profiler::block_index_t, profiler::block_index_t> >;
 
-                size_t totalCount = 0;
-                profiler_gui::DurationsCountMap durations;
-                for (auto frame : profiler_thread.children)
+                auto series = cachedSeries;
+                if (series == nullptr)
                 {
-                    const auto& frame_block = easyBlock(frame).tree;
-                    if (frame_block.node->id() == m_blockId || (!has_selected_block && m_blockId == easyDescriptor(frame_block.node->id()).id()))
-                    {
-                        m_selectedBlocks.push_back(frame);
-
-                        const auto w = frame_block.node->duration();
-                        if (w > m_maxValue)
-                            m_maxValue = w;
+                    const auto& profiler_thread = selected_thread.get();
+                    auto newSeries = std::make_shared<Series>();
 
-                        if (w < m_minValue)
-                            m_minValue = w;
+                    Stack stack;
+                    stack.reserve(profiler_thread.depth);
 
-                        ++totalCount;
-                        ++durations[w].count;
-                        m_blockTotalDuraion += w;
-                    }
-
-                    if (showOnlyTopLevelBlocks)
-                        continue;
-
-                    stack.emplace_back(frame, 0U);
-                    while (!stack.empty())
+                    for (auto frame : profiler_thread.children)
                     {
-                        if (isReady())
-                            return;
+                        const auto& frame_block = easyBlocksTree(frame);
+                        if (frame_block.node->id() == m_blockId || (!has_selected_block && m_blockId == easyDescriptor(frame_block.node->id()).id()))
+                        {
+                            newSeries->begins.push_back(frame_block.node->begin());
+                            newSeries->durations.push_back(frame_block.node->duration());
+                        }
+
+                        if (showOnlyTopLevelBlocks)
+                            continue;
 
-                        auto& top = stack.back();
-                        const auto& top_children = easyBlock(top.first).tree.children;
-                        const auto stack_size = stack.size();
-                        for (auto end = top_children.size(); top.second < end; ++top.second)
+                        stack.emplace_back(frame, 0U);
+                        while (!stack.empty())
                         {
                             if (isReady())
                                 return;
 
-                            const auto child_index = top_children[top.second];
-                            const auto& child = easyBlock(child_index).tree;
-                            if (child.node->id() == m_blockId || (!has_selected_block && m_blockId == easyDescriptor(child.node->id()).id()))
+                            auto& top = stack.back();
+                            const auto& top_children = easyBlocksTree(top.first).children;
+                            const auto stack_size = stack.size();
+                            for (auto end = top_children.size(); top.second < end; ++top.second)
                             {
-                                m_selectedBlocks.push_back(child_index);
-
-                                const auto w = child.node->duration();
-                                if (w > m_maxValue)
-                                    m_maxValue = w;
-
-                                if (w < m_minValue)
-                                    m_minValue = w;
-
-                                ++totalCount;
-                                ++durations[w].count;
-                                m_blockTotalDuraion += w;
+                                if (isReady())
+                                    return;
+
+                                const auto child_index = top_children[top.second];
+                                const auto& child = easyBlocksTree(child_index);
+                                if (child.node->id() == m_blockId || (!has_selected_block && m_blockId == easyDescriptor(child.node->id()).id()))
+                                {
+                                    newSeries->begins.push_back(child.node->begin());
+                                    newSeries->durations.push_back(child.node->duration());
+                                }
+
+                                if (!child.children.empty())
+                                {
+                                    ++top.second;
+                                    stack.emplace_back(child_index, 0U);
+                                    break;
+                                }
                             }
 
-                            if (!child.children.empty())
+                            if (stack_size == stack.size())
                             {
-                                ++top.second;
-                                stack.emplace_back(child_index, 0U);
-                                break;
+                                stack.pop_back();
                             }
                         }
-
-                        if (stack_size == stack.size())
-                        {
-                            stack.pop_back();
-                        }
                     }
+
+                    newSeries->build();
+                    series = std::move(newSeries);
+                    m_seriesCache.emplace(key, series);
                 }
 
-                if (m_selectedBlocks.empty())
+                m_series = series;
+
+                if (series->empty())
                 {
+                    m_maxValue = 0;
+                    m_minValue = 1e30;
+
                     m_topDurationStr.clear();
                     m_bottomDurationStr.clear();
                     m_medianDurationStr.clear();
@@ -814,13 +938,13 @@ void GraphicsHistogramItem::setSource(profiler::thread_id_t _thread_id, profiler
                 {
                     if (has_selected_block)
                     {
-                        const auto& item = easyBlock(selected_block).tree;
+                        const auto& item = easyBlocksTree(selected_block);
                         if (*item.node->name() != 0)
                             m_blockName = profiler_gui::toUnicode(item.node->name());
                     }
 
-                    m_maxValue *= 1e-3;
-                    m_minValue *= 1e-3;
+                    m_maxValue = series->maxDuration * 1e-3;
+                    m_minValue = series->minDuration * 1e-3;
 
                     if ((m_maxValue - m_minValue) < 1e-3)
                     {
@@ -835,11 +959,9 @@ void GraphicsHistogramItem::setSource(profiler::thread_id_t _thread_id, profiler
                         }
                     }
 
-                    if (totalCount != 0)
-                    {
-                        m_avgDuration = m_blockTotalDuraion / totalCount;
-                        m_medianDuration = profiler_gui::calculateMedian(durations);
-                    }
+                    m_blockTotalDuraion = series->total();
+                    m_avgDuration = m_blockTotalDuraion / series->size();
+                    m_medianDuration = series->medianDuration;
 
                     m_medianDurationFull = m_medianDuration;
                     m_avgDurationFull = m_avgDuration;
@@ -857,7 +979,7 @@ void GraphicsHistogramItem::setSource(profiler::thread_id_t _thread_id, profiler
                 m_topValue = m_maxValue;
                 m_bottomValue = m_minValue;
 
-                setEmpty(m_selectedBlocks.empty());
+                setEmpty(series->empty());
                 setReady(true);
 
             }, m_bReady);
@@ -1010,7 +1132,6 @@ bool GraphicsHistogramItem::updateImage()
 
     // Ugly, but doesn't use exceeded count of threads
     const auto rect = m_boundingRect;
-    const auto regime = m_regime;
     const auto scale = widget->getWindowScale();
     const auto left = widget->minimum();
     const auto right = widget->maximum();
@@ -1025,7 +1146,7 @@ bool GraphicsHistogramItem::updateImage()
     const auto drawBorders = EASY_GLOBALS.draw_histogram_borders;
     const auto minColumnWidth = EASY_GLOBALS.histogram_column_width_min;
     m_worker.enqueue([=] {
-        updateImageAsync(rect, regime, scale, left, right, right - left, value, window, top, bottom,
+        updateImageAsync(rect, scale, left, right, right - left, value, window, top, bottom,
                          minColumnWidth, bindMode, frameTime, beginTime, autoHeight, drawBorders);
     }, m_bReady);
 
@@ -1061,7 +1182,7 @@ void GraphicsHistogramItem::onImageUpdated()
     }
 }
 
-void GraphicsHistogramItem::updateImageAsync(QRectF _boundingRect, HistRegime _regime, qreal _current_scale,
+void GraphicsHistogramItem::updateImageAsync(QRectF _boundingRect, qreal _current_scale,
     qreal _minimum, qreal _maximum, qreal _range, qreal _value, qreal _width, qreal _top_duration, qreal _bottom_duration,
     int _min_column_width, bool _bindMode, float _frame_time, profiler::timestamp_t _begin_time, bool _autoAdjustHist, bool _drawBorders)
 {
@@ -1108,433 +1229,170 @@ void GraphicsHistogramItem::updateImageAsync(QRectF _boundingRect, HistRegime _r
     auto const calculate_color = gotFrame ? calculate_color2 : calculate_color1;
     auto const k = gotFrame ? sqr(sqr(frameCoeff)) : 1.0 / _boundingRect.height();
 
-    size_t totalCount = 0;
     m_workerMedianDuration = 0;
     m_workerAvgDuration = 0;
-    profiler_gui::DurationsCountMap durations;
 
-    if (_regime == Hist_Pointer)
+    const auto series = m_series;
+    if (series == nullptr || series->empty())
     {
-        const auto& items = *m_pSource;
-        if (items.empty())
-            return;
-
-        auto first = items.begin();
-
-        if (_bindMode)
-        {
-            _minimum = m_workerImageOrigin;
-            _maximum = m_workerImageOrigin + _width * 7;
-            realScale *= viewScale;
-            offset = _minimum * realScale;
-
-            first = std::lower_bound(items.begin(), items.end(), _minimum, [] (const profiler_gui::EasyBlockItem& _item, qreal _value)
-            {
-                return _item.left() < _value;
-            });
-
-            if (first != items.end())
-            {
-                if (first != items.begin())
-                    --first;
-            }
-            else
-            {
-                first = items.begin() + items.size() - 1;
-            }
-
-            if (_autoAdjustHist)
-            {
-                const auto maxVal = _value + _width;
-                decltype(_top_duration) maxDuration = 0;
-                decltype(_bottom_duration) minDuration = 1e30;
-                size_t iterations = 0;
-                for (auto it = first, end = items.end(); it != end; ++it)
-                {
-                    // Draw rectangle
-                    if (it->left() > maxVal)
-                        break;
+        m_workerTopDuration = _top_duration;
+        m_workerBottomDuration = _bottom_duration;
+        setReady(true);
+        return;
+    }
 
-                    if (it->right() < _value)
-                        continue;
+    const auto& begins = series->begins;
+    const auto& durations = series->durations;
 
-                    if (maxDuration < it->width())
-                        maxDuration = it->width();
+    const auto sceneLeft = [&] (size_t _index) -> qreal {
+        return PROF_MICROSECONDS(qreal(begins[_index] - _begin_time));
+    };
 
-                    if (minDuration > it->width())
-                        minDuration = it->width();
+    const auto sceneWidth = [] (profiler::timestamp_t _duration) -> qreal {
+        return PROF_MICROSECONDS(qreal(_duration));
+    };
 
-                    ++iterations;
-                }
+    // Returns index of the first column in [_first, size) which begins after _x
+    const auto upperBound = [&] (size_t _first, qreal _x) -> size_t {
+        return static_cast<size_t>(std::upper_bound(begins.begin() + _first, begins.end(), _x,
+            [_begin_time] (qreal _value, profiler::timestamp_t _begin) {
+                return _value < PROF_MICROSECONDS(qreal(_begin - _begin_time));
+            }) - begins.begin());
+    };
 
-                if (iterations != 0)
-                {
-                    _top_duration = maxDuration;
-                    _bottom_duration = minDuration;
+    size_t first = 0;
 
-                    if ((_top_duration - _bottom_duration) < 1e-3)
-                    {
-                        if (_bottom_duration > 0.1)
-                        {
-                            _bottom_duration -= 0.1;
-                        }
-                        else
-                        {
-                            _top_duration = 0.1;
-                            _bottom_duration = 0;
-                        }
-                    }
-                }
-            }
-        }
-
-        const auto dtime = _top_duration - _bottom_duration;
-        const auto coeff = _boundingRect.height() / (dtime > 1e-3 ? dtime : 1.);
+    if (_bindMode)
+    {
+        _minimum = m_workerImageOrigin;
+        _maximum = m_workerImageOrigin + _width * 7;
+        realScale *= viewScale;
+        offset = _minimum * realScale;
 
-        const qreal minWidth = _drawBorders ? _min_column_width : 1;
-        if (_drawBorders)
-            p.setPen(profiler_gui::BLOCK_BORDER_COLOR);
+        first = upperBound(0, _minimum);
+        if (first != 0)
+            --first;
 
-        for (auto it = first, end = items.end(); it != end; ++it)
+        if (_autoAdjustHist)
         {
-            // Draw rectangle
-            if (it->left() > _maximum)
-                break;
+            const auto maxVal = _value + _width;
 
-            if (it->right() < _minimum)
-                continue;
+            auto windowBegin = upperBound(first, _value);
+            if (windowBegin != 0 && sceneLeft(windowBegin - 1) + sceneWidth(durations[windowBegin - 1]) >= _value)
+                --windowBegin;
 
-            if (_bindMode)
+            const auto windowEnd = upperBound(windowBegin, maxVal);
+            if (windowBegin < windowEnd)
             {
-                // calculate avg and median
-                const auto duration = easyBlock(it->block).tree.node->duration();
-                m_workerAvgDuration += duration;
-                ++totalCount;
-                ++durations[duration].count;
-            }
-
-            auto maxItemWidth = it->width();
+                _top_duration = sceneWidth(series->highest(windowBegin, windowEnd));
+                _bottom_duration = sceneWidth(series->lowest(windowBegin, windowEnd));
 
-            // calculate column width and height
-            qreal item_x = it->left() * realScale - offset;
-            qreal item_w = it->width() * realScale;
-            qreal item_r = item_x + item_w;
-            const auto width = it->width();
-            qreal h = width <= _bottom_duration ? HIST_COLUMN_MIN_HEIGHT :
-                (width > _top_duration ? maxColumnHeight : (width - _bottom_duration) * coeff);
-
-            if (_drawBorders)
-            {
-                if (item_r < previous_x)
+                if ((_top_duration - _bottom_duration) < 1e-3)
                 {
-                    item_w -= previous_x - item_r;
-                    item_x = previous_x;
-                    item_r = item_x + item_w;
-                }
-
-                // if column width < minWidth then try to merge several columns together
-                auto jt = it;
-                while (item_w < minWidth && jt != end)
-                {
-                    if (jt->left() > _maximum)
-                        break;
-
-                    const qreal jx = jt->left() * realScale - offset;
-                    auto dx = jx - item_r;
-                    if (dx > std::max(item_w, minWidth))
+                    if (_bottom_duration > 0.1)
                     {
-                        item_w = minWidth;
-                        break;
+                        _bottom_duration -= 0.1;
                     }
-
-                    const qreal jw = jt->width() * realScale;
-                    if (jw > (minWidth + item_w))
-                    {
-                        item_w = minWidth;
-                        break;
-                    }
-
-                    const auto jwidth = jt->width();
-                    const qreal jh = jwidth <= _bottom_duration ? HIST_COLUMN_MIN_HEIGHT :
-                        (jwidth > _top_duration ? maxColumnHeight : (jwidth - _bottom_duration) * coeff);
-
-                    item_w += jw;
-                    h = std::max(h, jh);
-                    maxItemWidth = std::max(maxItemWidth, jwidth);
-                    ++jt;
-                }
-
-                item_r = item_x + item_w;
-
-                if (_bindMode)
-                {
-                    // if merged several columns then avg and median should be calculated for these columns too
-                    for (auto it2 = it; it2 != jt; ++it2)
+                    else
                     {
-                        const auto duration = easyBlock(it2->block).tree.node->duration();
-                        m_workerAvgDuration += duration;
-                        ++totalCount;
-                        ++durations[duration].count;
+                        _top_duration = 0.1;
+                        _bottom_duration = 0;
                     }
                 }
-
-                if (jt != it)
-                {
-                    // bypass merged columns
-                    it = jt;
-                    --it;
-                }
-            }
-            else if (item_w < 1)
-            {
-                item_w = 1;
-                item_r = item_x + 1;
             }
-
-            if (h < previous_h && item_r < previous_x)
-                continue;
-
-            const auto col = calculate_color(h, maxItemWidth, k);
-            const auto color = 0x00ffffff & QColor::fromHsvF((1.0 - col) * 0.375, 0.85, 0.85).rgb();
-
-            if (previousColor != color)
-            {
-                // Set background color brush for rectangle
-                previousColor = color;
-                brush.setColor(QColor::fromRgba(0xc0000000 | color));
-                p.setBrush(brush);
-            }
-
-            rect.setRect(item_x, bottom - h, item_w, h);
-            p.drawRect(rect);
-
-            previous_x = item_r;
-            previous_h = h;
         }
     }
-    else
-    {
-        auto first = m_selectedBlocks.begin();
-
-        if (_bindMode)
-        {
-            _minimum = m_workerImageOrigin;
-            _maximum = m_workerImageOrigin + _width * 7;
-            realScale *= viewScale;
-            offset = _minimum * 1e3 * realScale;
-
-            first = std::lower_bound(m_selectedBlocks.begin(), m_selectedBlocks.end(), _minimum * 1e3 + _begin_time, [](profiler::block_index_t _item, qreal _value)
-            {
-                return easyBlock(_item).tree.node->begin() < _value;
-            });
-
-            if (first != m_selectedBlocks.end())
-            {
-                if (first != m_selectedBlocks.begin())
-                    --first;
-            }
-            else
-            {
-                first = m_selectedBlocks.begin() + m_selectedBlocks.size() - 1;
-            }
-
-            _minimum *= 1e3;
-            _maximum *= 1e3;
-
-            if (_autoAdjustHist)
-            {
-                const auto minVal = _value * 1e3, maxVal = (_value + _width) * 1e3;
-                decltype(_top_duration) maxDuration = 0;
-                decltype(_bottom_duration) minDuration = 1e30;
-                size_t iterations = 0;
-                for (auto it = first, end = m_selectedBlocks.end(); it != end; ++it)
-                {
-                    const auto item = easyBlock(*it).tree.node;
 
-                    const auto beginTime = item->begin() - _begin_time;
-                    if (beginTime > maxVal)
-                        break;
-
-                    const auto endTime = item->end() - _begin_time;
-                    if (endTime < minVal)
-                        continue;
+    const auto dtime = _top_duration - _bottom_duration;
+    const auto coeff = _boundingRect.height() / (dtime > 1e-3 ? dtime : 1.);
 
-                    const qreal duration = item->duration() * 1e-3;
+    const qreal minWidth = _drawBorders ? _min_column_width : 1;
+    if (_drawBorders)
+        p.setPen(profiler_gui::BLOCK_BORDER_COLOR);
 
-                    if (maxDuration < duration)
-                        maxDuration = duration;
-
-                    if (minDuration > duration)
-                        minDuration = duration;
-
-                    ++iterations;
-                }
+    if (first < durations.size() && sceneLeft(first) + sceneWidth(durations[first]) < _minimum)
+        ++first;
 
-                if (iterations != 0)
-                {
-                    _top_duration = maxDuration;
-                    _bottom_duration = minDuration;
+    const auto last = upperBound(first, _maximum);
+    for (auto i = first; i < last; ++i)
+    {
+        // calculate column width and height
+        auto maxItemDuration = sceneWidth(durations[i]);
+        qreal item_x = sceneLeft(i) * realScale - offset;
+        qreal item_w = maxItemDuration * realScale;
+        qreal item_r = item_x + item_w;
 
-                    if ((_top_duration - _bottom_duration) < 1e-3)
-                    {
-                        if (_bottom_duration > 0.1)
-                        {
-                            _bottom_duration -= 0.1;
-                        }
-                        else
-                        {
-                            _top_duration = 0.1;
-                            _bottom_duration = 0;
-                        }
-                    }
-                }
-            }
-        }
-        else
+        if (_drawBorders && item_r < previous_x)
         {
-            _minimum *= 1e3;
-            _maximum *= 1e3;
+            item_w -= previous_x - item_r;
+            item_x = previous_x;
         }
 
-        const auto dtime = _top_duration - _bottom_duration;
-        const auto coeff = _boundingRect.height() / (dtime > 1e-3 ? dtime : 1.);
-
-        const qreal minWidth = _drawBorders ? _min_column_width : 1;
-        if (_drawBorders)
-            p.setPen(profiler_gui::BLOCK_BORDER_COLOR);
-
-        for (auto it = first, end = m_selectedBlocks.end(); it != end; ++it)
+        if (item_w < minWidth)
         {
-            // Draw rectangle
-            const auto item = easyBlock(*it).tree.node;
-
-            const auto beginTime = item->begin() - _begin_time;
-            if (beginTime > _maximum)
-                break;
-
-            const auto endTime = item->end() - _begin_time;
-            if (endTime < _minimum)
-                continue;
-
-            if (_bindMode)
-            {
-                // calculate avg and median
-                const auto duration = item->duration();
-                m_workerAvgDuration += duration;
-                ++totalCount;
-                ++durations[duration].count;
-            }
-
-            const qreal duration = item->duration() * 1e-3;
-            auto maxItemDuration = duration;
-
-            // calculate column width and height
-            qreal item_x = (beginTime * realScale - offset) * 1e-3;
-            qreal item_w = duration * realScale;
-            qreal item_r = item_x + item_w;
-            auto h = duration <= _bottom_duration ? HIST_COLUMN_MIN_HEIGHT :
-                (duration > _top_duration ? maxColumnHeight : (duration - _bottom_duration) * coeff);
-
-            if (_drawBorders)
+            // merge narrow columns which begin inside this one into a single column of minimal width
+            auto merged = upperBound(i + 1, (item_x + minWidth + offset) / realScale);
+            if (merged > i + 1 && sceneWidth(series->highest(i, merged)) * realScale >= minWidth)
             {
-                if (item_r < previous_x)
-                {
-                    item_w -= previous_x - item_r;
-                    item_x = previous_x;
-                    item_r = item_x + item_w;
-                }
-
-                // if column width < minWidth then try to merge several columns together
-                auto jt = it;
-                while (item_w < minWidth && jt != end)
-                {
-                    const auto jtem = easyBlock(*jt).tree.node;
-                    const auto jbeginTime = jtem->begin() - _begin_time;
-                    if (jbeginTime > _maximum)
-                        break;
-
-                    const qreal jduration = jtem->duration() * 1e-3;
-
-                    const qreal jx = ((jtem->begin() - _begin_time) * realScale - offset) * 1e-3;
-                    auto dx = jx - item_r;
-                    if (dx > std::max(item_w, minWidth))
-                    {
-                        item_w = minWidth;
-                        break;
-                    }
-
-                    const qreal jw = jduration * realScale;
-                    if (jw > (minWidth + item_w))
-                    {
-                        item_w = minWidth;
-                        break;
-                    }
-
-                    const qreal jh = jduration <= _bottom_duration ? HIST_COLUMN_MIN_HEIGHT :
-                        (jduration > _top_duration ? maxColumnHeight : (jduration - _bottom_duration) * coeff);
-
-                    item_w += jw;
-                    h = std::max(h, jh);
-                    maxItemDuration = std::max(maxItemDuration, jduration);
-                    ++jt;
-                }
-
-                item_r = item_x + item_w;
-
-                if (_bindMode)
+                // wide columns are painted on their own: find the first one
+                auto narrow = i + 1;
+                while (merged - narrow > 1)
                 {
-                    // if merged several columns then avg and median should be calculated for these columns too
-                    for (auto it2 = it; it2 != jt; ++it2)
-                    {
-                        const auto duration = easyBlock(*it2).tree.node->duration();
-                        m_workerAvgDuration += duration;
-                        ++totalCount;
-                        ++durations[duration].count;
-                    }
+                    const auto middle = narrow + ((merged - narrow) >> 1);
+                    if (sceneWidth(series->highest(i, middle)) * realScale < minWidth)
+                        narrow = middle;
+                    else
+                        merged = middle;
                 }
 
-                if (jt != it)
-                {
-                    // bypass merged columns
-                    it = jt;
-                    --it;
-                }
+                merged = narrow;
             }
-            else if (item_w < 1)
+
+            if (merged > i + 1)
             {
-                item_w = 1;
-                item_r = item_x + 1;
+                maxItemDuration = sceneWidth(series->highest(i, merged));
+                i = merged - 1; // bypass merged columns
             }
 
-            if (h < previous_h && item_r < previous_x)
-                continue;
+            item_w = minWidth;
+        }
 
-            const auto col = calculate_color(h, maxItemDuration, k);
-            const auto color = 0x00ffffff & QColor::fromHsvF((1.0 - col) * 0.375, 0.85, 0.85).rgb();
+        item_r = item_x + item_w;
 
-            if (previousColor != color)
-            {
-                // Set background color brush for rectangle
-                previousColor = color;
-                brush.setColor(QColor::fromRgba(0xc0000000 | color));
-                p.setBrush(brush);
-            }
+        const qreal h = maxItemDuration <= _bottom_duration ? HIST_COLUMN_MIN_HEIGHT :
+            (maxItemDuration > _top_duration ? maxColumnHeight : (maxItemDuration - _bottom_duration) * coeff);
 
-            rect.setRect(item_x, bottom - h, item_w, h);
-            p.drawRect(rect);
+        if (h < previous_h && item_r < previous_x)
+            continue;
 
-            previous_x = item_r;
-            previous_h = h;
+        const auto col = calculate_color(h, maxItemDuration, k);
+        const auto color = 0x00ffffff & QColor::fromHsvF((1.0 - col) * 0.375, 0.85, 0.85).rgb();
+
+        if (previousColor != color)
+        {
+            // Set background color brush for rectangle
+            previousColor = color;
+            brush.setColor(QColor::fromRgba(0xc0000000 | color));
+            p.setBrush(brush);
         }
+
+        rect.setRect(item_x, bottom - h, item_w, h);
+        p.drawRect(rect);
+
+        previous_x = item_r;
+        previous_h = h;
     }
 
     m_workerTopDuration = _top_duration;
     m_workerBottomDuration = _bottom_duration;
 
-    if (_bindMode && totalCount != 0)
+    if (_bindMode && first < last)
     {
-        m_workerAvgDuration /= totalCount;
-        m_workerMedianDuration = profiler_gui::calculateMedian(durations);
+        // calculate avg and median of visible columns
+        m_workerAvgDuration = (series->sums[last] - series->sums[first]) / (last - first);
+
+        Durations visibleDurations(durations.begin() + first, durations.begin() + last);
+        m_workerMedianDuration = medianDuration(visibleDurations);
     }
 
     setReady(true);
@@ -1570,6 +1428,14 @@ GraphicsScrollbar::GraphicsScrollbar(int _initialHeight, QWidget* _parent)
     connect(&EASY_GLOBALS.events, &profiler_gui::GlobalSignals::hexThreadIdChanged, this, &This::onThreadViewChanged);
 
     connect(&EASY_GLOBALS.events, &profiler_gui::GlobalSignals::allDataGoingToBeDeleted, this, &This::clear);
+
+    connect(&EASY_GLOBALS.events, &profiler_gui::GlobalSignals::dataGoingToBeChanged, this, [this] {
+        m_histogramItem->stopWorker();
+    });
+
+    connect(&EASY_GLOBALS.events, &profiler_gui::GlobalSignals::dataChanged, this, [this] {
+        m_histogramItem->resumeWorker();
+    });
 }
 
 GraphicsScrollbar::~GraphicsScrollbar()
@@ -58,6 +58,10 @@
 #include <stdlib.h>
 #include <thread>
 #include <atomic>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
 #include <QImage>
 #include "timer.h"
 #include "graphics_slider_area.h"
@@ -75,6 +79,44 @@ public:
 
 private:
 
+    using Durations = std::vector<profiler::timestamp_t>;
+
+    /** Histogram columns sorted by begin time.
+
+    Reduction pyramids and prefix sums let updateImageAsync() find the highest column among any number
+    of merged blocks and average duration of visible blocks in O(log n), so each image update costs
+    O(pixels * log n) instead of walking all visible blocks. */
+    struct Series
+    {
+        Durations                     begins; ///< Begin time of each column
+        Durations                  durations; ///< Duration of each column
+        std::vector<Durations>    maxPyramid; ///< maxPyramid[k][i] is maximum of (2 << k) durations starting from (i << (k + 1))
+        std::vector<Durations>    minPyramid; ///< minPyramid[k][i] is minimum of (2 << k) durations starting from (i << (k + 1))
+        std::vector<uint64_t>           sums; ///< sums[i] is total duration of the first i columns
+        profiler::timestamp_t    minDuration; ///< Minimum duration of all columns
+        profiler::timestamp_t    maxDuration; ///< Maximum duration of all columns
+        profiler::timestamp_t medianDuration; ///< Median duration of all columns
+
+        Series() : minDuration(0), maxDuration(0), medianDuration(0) {}
+
+        ///< Builds pyramids, prefix sums and statistics. Must be called after all columns have been added.
+        void build();
+
+        ///< Returns maximum duration of columns [_begin, _end) in O(log n).
+        profiler::timestamp_t highest(size_t _begin, size_t _end) const;
+
+        ///< Returns minimum duration of columns [_begin, _end) in O(log n).
+        profiler::timestamp_t lowest(size_t _begin, size_t _end) const;
+
+        bool empty() const { return durations.empty(); }
+        size_t size() const { return durations.size(); }
+        uint64_t total() const { return sums.empty() ? 0 : sums.back(); }
+    };
+
+    using SeriesPtr = std::shared_ptr<const Series>;
+    using SeriesKey = std::tuple<profiler::thread_id_t, profiler::block_id_t, bool, bool>;
+    using SeriesCache = std::map<SeriesKey, SeriesPtr>;
+
     qreal                         m_workerTopDuration;
     qreal                      m_workerBottomDuration;
     profiler::timestamp_t         m_blockTotalDuraion;
@@ -85,7 +127,9 @@ private:
     QString                              m_threadName;
     QString                               m_blockName;
     QString                               m_blockType;
-    profiler::BlocksTree::children_t m_selectedBlocks;
+    SeriesPtr                                m_series; ///< Columns of current histogram
+    SeriesCache                         m_seriesCache; ///< Columns of already shown histograms by id (thread, block id, top-level only, runtime id only)
+    uint64_t                  m_seriesCacheGeneration; ///< EASY_GLOBALS.data_generation for which m_seriesCache is valid
     profiler::timestamp_t            m_threadDuration;
     profiler::timestamp_t        m_threadProfiledTime;
     profiler::timestamp_t            m_threadWaitTime;
@@ -101,6 +145,7 @@ private:
     profiler::block_index_t                 m_blockId;
     profiler_gui::TimeUnits               m_timeUnits;
     HistRegime                               m_regime;
+    bool                             m_bWorkerStopped; ///< True if the worker has been stopped by stopWorker() and must be restarted
 
 public:
 
@@ -132,6 +177,8 @@ public:
     void setSource(profiler::thread_id_t _thread_id, profiler::block_id_t _block_id);
     void rebuildSource(HistRegime _regime);
     void rebuildSource();
+    void stopWorker();
+    void resumeWorker();
     void validateName();
 
     void pickFrameTime(qreal _y) const;
@@ -142,7 +189,7 @@ private:
     void paintByPtr(QPainter* _painter);
     void paintById(QPainter* _painter);
 
-    void updateImageAsync(QRectF _boundingRect, HistRegime _regime, qreal _current_scale,
+    void updateImageAsync(QRectF _boundingRect, qreal _current_scale,
         qreal _minimum, qreal _maximum, qreal _range, qreal _value, qreal _width,
         qreal _top_duration, qreal _bottom_duration, int _min_column_width, bool _bindMode,
         float _frame_time, profiler::timestamp_t _begin_time, bool _autoAdjustHist, bool _drawBorders);
@@ -124,6 +124,7 @@
 namespace {
 
 const int LOADER_TIMER_INTERVAL = 40;
+const int LIVE_CAPTURE_INTERVAL = 100; ///< Interval between live capture portions (ms)
 
 } // end of namespace <noname>.
 
@@ -417,6 +418,9 @@ MainWindow::MainWindow() : Parent(), m_theme("default"), m_lastAddress("localhos
     toolbar->addAction(QIcon(imagePath("list")), tr("Blocks"), this, SLOT(onEditBlocksClicked(bool)));
     m_captureAction = toolbar->addAction(QIcon(imagePath("start")), tr("Capture"), this, SLOT(onCaptureClicked(bool)));
     m_captureAction->setEnabled(false);
+    m_liveCaptureAction = toolbar->addAction(QIcon(imagePath("play")), tr("Live capture"), this, SLOT(onLiveCaptureClicked(bool)));
+    m_liveCaptureAction->setToolTip("Capture frames and show them while capturing is in progress");
+    m_liveCaptureAction->setEnabled(false);
 
     toolbar->addSeparator();
     m_connectAction = toolbar->addAction(QIcon(imagePath("connect")), tr("Connect"), this, SLOT(onConnectClicked(bool)));
@@ -501,6 +505,23 @@ MainWindow::MainWindow() : Parent(), m_theme("default"), m_lastAddress("localhos
     action->setChecked(EASY_GLOBALS.hide_minsize_blocks);
     connect(action, &QAction::triggered, [this] (bool _checked) { EASY_GLOBALS.hide_minsize_blocks = _checked; refreshDiagram(); });
 
+    action = submenu->addAction("Tiled rendering");
+    action->setToolTip("Rasterizes diagram into cached tiles\nusing several threads. Scrolling becomes much faster,\nbut labels of long blocks are repeated on each tile.");
+    action->setCheckable(true);
+    action->setChecked(EASY_GLOBALS.tiled_rendering);
+    connect(action, &QAction::triggered, [this] (bool _checked) { EASY_GLOBALS.tiled_rendering = _checked; refreshDiagram(); });
+
+    action = submenu->addAction("OpenGL viewport");
+    action->setToolTip("Paints blocks with OpenGL instanced quads\n(requires OpenGL 3.3 or OpenGL ES 3.0).\nLabels are painted only for blocks wider than\n\'Blocks narrow size\'. Overrides tiled rendering.");
+    action->setCheckable(true);
+    action->setChecked(EASY_GLOBALS.opengl_viewport);
+    connect(action, &QAction::triggered, [this] (bool _checked)
+    {
+        EASY_GLOBALS.opengl_viewport = _checked;
+        static_cast<DiagramWidget*>(m_graphicsView->widget())->view()->updateViewportWidget();
+        refreshDiagram();
+    });
+
     action = submenu->addAction("Enable zero duration blocks on diagram");
     action->setToolTip("If checked then allows diagram to paint zero duration blocks\nwith 1px width on each scale. Otherwise, such blocks will be resized\nto 250ns duration.");
     action->setCheckable(true);
@@ -722,7 +743,9 @@ MainWindow::MainWindow() : Parent(), m_theme("default"), m_lastAddress("localhos
     w = new QWidget(submenu);
     l = new QHBoxLayout(w);
     l->setContentsMargins(26, 1, 16, 1);
-    l->addWidget(new QLabel("Max rows in tree", w), 0, Qt::AlignLeft);
+    auto label = new QLabel("Preloaded rows in tree", w);
+    label->setToolTip("Number of rows created at once for the call-stack tree.\nChildren of other rows are created when they are expanded\nor found by search. Plain and aggregate trees are always complete.");
+    l->addWidget(label, 0, Qt::AlignLeft);
     spinbox = new QSpinBox(w);
     spinbox->setRange(0, std::numeric_limits<int>::max());
     spinbox->setValue(static_cast<int>(EASY_GLOBALS.max_rows_count));
@@ -997,6 +1020,7 @@ MainWindow::MainWindow() : Parent(), m_theme("default"), m_lastAddress("localhos
 
 MainWindow::~MainWindow()
 {
+    EASY_GLOBALS.names_index.clear();
 }
 
 void MainWindow::validateLastDir()
@@ -1186,18 +1210,23 @@ void MainWindow::loadFile(const QString& filename)
     m_reader.load(filename);
 }
 
-void MainWindow::readStream(std::stringstream& _data)
+void MainWindow::readStream(SocketListener& _listener)
 {
     createProgressDialog(tr("Reading from stream..."));
     m_readerTimer.start();
-    m_reader.load(_data);
+
+    auto sharedData = _listener.takeSharedData();
+    if (sharedData != nullptr)
+        m_reader.load(std::move(sharedData));
+    else
+        m_reader.load(_listener.data());
 }
 
 //////////////////////////////////////////////////////////////////////////
 
 void MainWindow::onSaveFileClicked(bool)
 {
-    if (m_serializedBlocks.empty())
+    if (m_serializedBlocks.empty() && m_liveData.empty())
         return;
 
     QString lastFile = m_lastFiles.empty() ? QString() : m_lastFiles.front();
@@ -1350,15 +1379,21 @@ void MainWindow::clear()
 {
     emit EASY_GLOBALS.events.allDataGoingToBeDeleted();
 
+    EASY_GLOBALS.names_index.clear();
     EASY_GLOBALS.selected_thread = 0;
     profiler_gui::set_max(EASY_GLOBALS.selected_block);
     profiler_gui::set_max(EASY_GLOBALS.selected_block_id);
     EASY_GLOBALS.profiler_blocks.clear();
     EASY_GLOBALS.descriptors.clear();
+    EASY_GLOBALS.updateDescriptorFlags();
+    ++EASY_GLOBALS.data_generation;
+    EASY_GLOBALS.blocks.clear();
     EASY_GLOBALS.gui_blocks.clear();
 
     m_serializedBlocks.clear();
     m_serializedDescriptors.clear();
+    m_liveData.clear();
+    m_liveRuntimeIds = profiler::LiveRuntimeIds();
 
     m_saveAction->setEnabled(false);
     m_deleteAction->setEnabled(false);
@@ -1376,7 +1411,7 @@ void MainWindow::clear()
 
 void MainWindow::refreshDiagram()
 {
-    static_cast<DiagramWidget*>(m_graphicsView->widget())->view()->scene()->update();
+    static_cast<DiagramWidget*>(m_graphicsView->widget())->view()->repaintScene();
 }
 
 void MainWindow::refreshHistogramImage()
@@ -1493,7 +1528,7 @@ void MainWindow::onExpandAllClicked(bool)
 
     auto tree = static_cast<StatsWidget*>(m_treeWidget->widget())->tree();
     const QSignalBlocker b(tree);
-    tree->expandAll();
+    tree->expandAllItems();
 }
 
 void MainWindow::onCollapseAllClicked(bool)
@@ -1780,6 +1815,14 @@ void MainWindow::loadSettings()
     if (!flag.isNull())
         EASY_GLOBALS.hide_minsize_blocks = flag.toBool();
 
+    flag = settings.value("tiled_rendering");
+    if (!flag.isNull())
+        EASY_GLOBALS.tiled_rendering = flag.toBool();
+
+    flag = settings.value("opengl_viewport");
+    if (!flag.isNull())
+        EASY_GLOBALS.opengl_viewport = flag.toBool();
+
     flag = settings.value("collapse_items_on_tree_close");
     if (!flag.isNull())
         EASY_GLOBALS.collapse_items_on_tree_close = flag.toBool();
@@ -1941,6 +1984,8 @@ void MainWindow::saveSettingsAndGeometry()
     settings.setValue("draw_histogram_borders", EASY_GLOBALS.draw_histogram_borders);
     settings.setValue("hide_narrow_children", EASY_GLOBALS.hide_narrow_children);
     settings.setValue("hide_minsize_blocks", EASY_GLOBALS.hide_minsize_blocks);
+    settings.setValue("tiled_rendering", EASY_GLOBALS.tiled_rendering);
+    settings.setValue("opengl_viewport", EASY_GLOBALS.opengl_viewport);
     settings.setValue("collapse_items_on_tree_close", EASY_GLOBALS.collapse_items_on_tree_close);
     settings.setValue("all_items_expanded_by_default", EASY_GLOBALS.all_items_expanded_by_default);
     settings.setValue("only_current_thread_hierarchy", EASY_GLOBALS.only_current_thread_hierarchy);
@@ -2004,6 +2049,7 @@ void MainWindow::setDisconnected(bool _showMessage)
 
     EASY_GLOBALS.connected = false;
     m_captureAction->setEnabled(false);
+    m_liveCaptureAction->setEnabled(false);
     m_connectAction->setIcon(QIcon(imagePath("connect")));
     m_connectAction->setText(tr("Connect"));
 
@@ -2075,16 +2121,28 @@ void MainWindow::onListenerTimerTimeout()
             break;
         }
 
+        case ListenerRegime::Capture_Live:
+        {
+            m_listenerDialog->setTitle(QString("Live capturing... %1s").arg(seconds, 0, 'f', 1));
+            break;
+        }
+
         default:
         {
             break;
         }
     }
 
+    if (m_bLiveCapture)
+        appendLiveBlocks();
+
     if (!m_listener.connected())
     {
-        if (m_listener.regime() == ListenerRegime::Capture_Receive)
+        if (m_listener.regime() == ListenerRegime::Capture_Receive || m_listener.regime() == ListenerRegime::Capture_Live)
+        {
             m_listener.finalizeCapture();
+            finishLiveCapture();
+        }
         if (m_listenerDialog)
             m_listenerDialog->reject();
     }
@@ -2096,13 +2154,14 @@ void MainWindow::onListenerTimerTimeout()
                 m_listenerTimer.stop();
 
             m_listener.finalizeCapture();
+            finishLiveCapture();
 
             m_listenerDialog->accept();
             m_listenerDialog = nullptr;
 
             if (m_listener.size() != 0)
             {
-                readStream(m_listener.data());
+                readStream(m_listener);
                 m_listener.clearData();
             }
         }
@@ -2123,6 +2182,7 @@ void MainWindow::onListenerDialogClose(int _result)
     switch (m_listener.regime())
     {
         case ListenerRegime::Capture:
+        case ListenerRegime::Capture_Live:
         {
             m_listenStartTime = std::chrono::system_clock::now();
             m_listenerDialog = new RoundProgressDialog(
@@ -2175,6 +2235,7 @@ void MainWindow::onListenerDialogClose(int _result)
                 {
                     m_listener.finalizeCapture();
                     m_listener.clearData();
+                    finishLiveCapture();
 
                     if (m_listener.connected())
                     {
@@ -2211,10 +2272,11 @@ void MainWindow::onListenerDialogClose(int _result)
                 m_listenerTimer.stop();
 
             m_listener.finalizeCapture();
+            finishLiveCapture();
 
             if (m_listener.size() != 0)
             {
-                readStream(m_listener.data());
+                readStream(m_listener);
                 m_listener.clearData();
             }
 
@@ -2247,6 +2309,135 @@ void MainWindow::closeProgressDialogAndClearReader()
     destroyProgressDialog();
 }
 
+void MainWindow::appendLiveBlocks()
+{
+    std::vector<std::string> portions;
+    if (!m_listener.takeLivePortions(portions))
+        return;
+
+    const auto firstBlock = static_cast<profiler::block_index_t>(EASY_GLOBALS.gui_blocks.size());
+    const auto descriptorsCount = m_liveRuntimeIds.descriptors_count;
+    profiler::blocks_t blocks;
+
+    // Appended portions change descriptors and blocks trees which are read by background workers
+    emit EASY_GLOBALS.events.dataGoingToBeChanged();
+    EASY_GLOBALS.names_index.clear();
+
+    for (const auto& portion : portions)
+    {
+        std::stringstream stream(portion);
+        std::stringstream errorMessage;
+        profiler::SerializedData data;
+        uint32_t version = 0;
+        profiler::processid_t pid = 0;
+
+        const bool ok = appendTreesFromStream(stream, m_beginEndTime, data, EASY_GLOBALS.descriptors, blocks, firstBlock,
+                                              EASY_GLOBALS.profiler_blocks, m_liveRuntimeIds, version, pid, errorMessage);
+
+        // Keep memory even for a corrupted portion: some of its blocks may have been already appended
+        m_liveData.emplace_back(std::move(data));
+
+        if (!ok)
+        {
+            qWarning() << "Cannot read live blocks: " << errorMessage.str().c_str();
+            continue;
+        }
+
+        EASY_GLOBALS.version = version;
+        EASY_GLOBALS.pid = pid;
+    }
+
+    EASY_GLOBALS.updateDescriptorFlags();
+    ++EASY_GLOBALS.data_generation;
+
+    if (descriptorsCount < m_liveRuntimeIds.descriptors_count && !m_liveRuntimeIds.table.empty())
+    {
+        // New descriptors have moved up copies of descriptors for blocks with runtime names
+        const auto diff = m_liveRuntimeIds.descriptors_count - descriptorsCount;
+        for (auto& b : EASY_GLOBALS.blocks)
+        {
+            if (b.node->id() >= descriptorsCount)
+                b.node->setId(b.node->id() + diff);
+        }
+    }
+
+    const auto nblocks = static_cast<profiler::block_index_t>(blocks.size());
+    EASY_GLOBALS.blocks.reserve(firstBlock + nblocks);
+    for (auto& block : blocks)
+        EASY_GLOBALS.blocks.emplace_back(std::move(block));
+
+    EASY_GLOBALS.gui_blocks.resize(firstBlock + nblocks);
+    memset(EASY_GLOBALS.gui_blocks.data() + firstBlock, 0, sizeof(profiler_gui::EasyBlock) * nblocks);
+
+    EASY_GLOBALS.names_index.build();
+
+    emit EASY_GLOBALS.events.liveBlocksAppended();
+    emit EASY_GLOBALS.events.dataChanged();
+}
+
+void MainWindow::finishLiveCapture()
+{
+    if (!m_bLiveCapture)
+        return;
+
+    appendLiveBlocks();
+    m_bLiveCapture = false;
+
+    if (EASY_GLOBALS.gui_blocks.empty())
+        return;
+
+    // Descriptors of live capture are spread among portions.
+    // Gather them into one buffer which is required for saving.
+    // Copies for blocks with runtime names are stored after them and point to the same memory (as for a file).
+    emit EASY_GLOBALS.events.dataGoingToBeChanged();
+
+    auto& descriptors = EASY_GLOBALS.descriptors;
+    const auto descriptorsCount = std::min(m_liveRuntimeIds.descriptors_count, static_cast<uint32_t>(descriptors.size()));
+
+    uint64_t descriptorsMemorySize = 0;
+    for (uint32_t i = 0; i < descriptorsCount; ++i)
+    {
+        const auto descriptor = descriptors[i];
+        if (descriptor != nullptr)
+            descriptorsMemorySize += sizeof(profiler::SerializedBlockDescriptor) + strlen(descriptor->name()) + strlen(descriptor->file()) + 2;
+    }
+
+    EASY_GLOBALS.names_index.clear();
+
+    m_serializedDescriptors.set(descriptorsMemorySize);
+    uint64_t offset = 0;
+    for (uint32_t i = 0; i < descriptorsCount; ++i)
+    {
+        auto& descriptor = descriptors[i];
+        if (descriptor == nullptr)
+            continue;
+
+        const auto size = sizeof(profiler::SerializedBlockDescriptor) + strlen(descriptor->name()) + strlen(descriptor->file()) + 2;
+        auto data = m_serializedDescriptors[offset];
+        memcpy(data, descriptor, size);
+        descriptor = reinterpret_cast<profiler::SerializedBlockDescriptor*>(data);
+        offset += size;
+    }
+
+    for (auto i = static_cast<size_t>(descriptorsCount), n = descriptors.size(); i < n; ++i)
+    {
+        if (descriptors[i] != nullptr)
+            descriptors[i] = descriptors[descriptors[i]->id()];
+    }
+
+    EASY_GLOBALS.names_index.build();
+
+    m_descriptorsNumberInFile = descriptorsCount;
+    EASY_GLOBALS.has_local_changes = true; // Live session can be saved only by serializing blocks trees
+    setWindowTitle(QString("%1 - UNSAVED live capture").arg(profiler_gui::DEFAULT_WINDOW_TITLE));
+
+    m_saveAction->setEnabled(true);
+    m_deleteAction->setEnabled(true);
+
+    emit EASY_GLOBALS.events.fileOpened();
+    emit EASY_GLOBALS.events.dataChanged();
+}
+
 void MainWindow::onLoadingFinish(profiler::block_index_t& _nblocks)
 {
     _nblocks = m_reader.size();
@@ -2304,19 +2495,18 @@ void MainWindow::onLoadingFinish(profiler::block_index_t& _nblocks)
         EASY_GLOBALS.pid = pid;
         profiler_gui::set_max(EASY_GLOBALS.selected_block);
         profiler_gui::set_max(EASY_GLOBALS.selected_block_id);
+        EASY_GLOBALS.names_index.clear();
         EASY_GLOBALS.profiler_blocks.swap(threads_map);
         EASY_GLOBALS.descriptors.swap(descriptors);
+        EASY_GLOBALS.updateDescriptorFlags();
+        ++EASY_GLOBALS.data_generation;
         EASY_GLOBALS.bookmarks.swap(bookmarks);
 
+        EASY_GLOBALS.blocks.swap(blocks);
         EASY_GLOBALS.gui_blocks.clear();
         EASY_GLOBALS.gui_blocks.resize(_nblocks);
         memset(EASY_GLOBALS.gui_blocks.data(), 0, sizeof(profiler_gui::EasyBlock) * _nblocks);
-
-        for (std::remove_reference<decltype(_nblocks)>::type i = 0; i < _nblocks; ++i)
-        {
-            auto& guiblock = EASY_GLOBALS.gui_blocks[i];
-            guiblock.tree = std::move(blocks[i]);
-        }
+        EASY_GLOBALS.names_index.build();
 
         m_saveAction->setEnabled(true);
         m_deleteAction->setEnabled(true);
@@ -2537,6 +2727,7 @@ void MainWindow::onConnectClicked(bool)
     qInfo() << "Connected successfully";
     EASY_GLOBALS.connected = true;
     m_captureAction->setEnabled(true);
+    m_liveCaptureAction->setEnabled(true);
     m_connectAction->setIcon(QIcon(imagePath("connected")));
     m_connectAction->setText(tr("Disconnect"));
 
@@ -2572,6 +2763,16 @@ void MainWindow::onConnectClicked(bool)
 }
 
 void MainWindow::onCaptureClicked(bool)
+{
+    startCapture(false);
+}
+
+void MainWindow::onLiveCaptureClicked(bool)
+{
+    startCapture(true);
+}
+
+void MainWindow::startCapture(bool _live)
 {
     if (!EASY_GLOBALS.connected)
     {
@@ -2581,7 +2782,8 @@ void MainWindow::onCaptureClicked(bool)
 
     if (m_listener.regime() != ListenerRegime::Idle)
     {
-        if (m_listener.regime() == ListenerRegime::Capture || m_listener.regime() == ListenerRegime::Capture_Receive)
+        if (m_listener.regime() == ListenerRegime::Capture || m_listener.regime() == ListenerRegime::Capture_Receive ||
+            m_listener.regime() == ListenerRegime::Capture_Live)
         {
             Dialog::warning(this, "Warning",
                 "Already capturing frames.\nFinish old capturing session first.", QMessageBox::Close);
@@ -2595,7 +2797,11 @@ void MainWindow::onCaptureClicked(bool)
         return;
     }
 
-    if (!m_listener.startCapture())
+    const auto start = [this, _live] {
+        return _live ? m_listener.startLiveCapture(LIVE_CAPTURE_INTERVAL) : m_listener.startCapture();
+    };
+
+    if (!start())
     {
         // Connection lost. Try to restore connection.
 
@@ -2607,7 +2813,7 @@ void MainWindow::onCaptureClicked(bool)
             return;
         }
 
-        if (!m_listener.startCapture())
+        if (!start())
         {
             m_listener.closeSocket();
             setDisconnected();
@@ -2615,11 +2821,22 @@ void MainWindow::onCaptureClicked(bool)
         }
     }
 
-    m_listenerTimer.start(250);
+    if (_live)
+    {
+        // Live blocks are appended to an empty session
+        clear();
+        m_bLiveCapture = true;
+        m_beginEndTime.beginTime = m_beginEndTime.endTime = 0;
+        m_listenerTimer.start(LIVE_CAPTURE_INTERVAL);
+    }
+    else
+    {
+        m_listenerTimer.start(250);
+    }
 
     m_listenStartTime = std::chrono::system_clock::now();
     m_listenerDialog = new RoundProgressDialog(
-        QStringLiteral("Capturing frames..."),
+        _live ? QStringLiteral("Live capturing...") : QStringLiteral("Capturing frames..."),
         RoundProgressIndicator::Stop,
         QDialog::Accepted,
         this
@@ -2697,6 +2914,9 @@ void MainWindow::onGetBlockDescriptionsClicked(bool)
 
             if (!cancel)
             {
+                // Merge changes descriptors and ids of blocks which are read by background workers
+                emit EASY_GLOBALS.events.dataGoingToBeChanged();
+
                 if (!doFlush && m_descriptorsNumberInFile < EASY_GLOBALS.descriptors.size())
                 {
                     // There are dynamically added descriptors, add them to the new list too
@@ -2736,10 +2956,11 @@ void MainWindow::onGetBlockDescriptionsClicked(bool)
 
                     if (!cancel && diff != 0)
                     {
-                        for (auto& b : EASY_GLOBALS.gui_blocks)
+                        EASY_GLOBALS.names_index.clear();
+                        for (auto& b : EASY_GLOBALS.blocks)
                         {
-                            if (b.tree.node->id() >= m_descriptorsNumberInFile)
-                                b.tree.node->setId(b.tree.node->id() + diff);
+                            if (b.node->id() >= m_descriptorsNumberInFile)
+                                b.node->setId(b.node->id() + diff);
                         }
 
                         m_descriptorsNumberInFile = newnumber;
@@ -2748,9 +2969,13 @@ void MainWindow::onGetBlockDescriptionsClicked(bool)
 
                 if (!cancel)
                 {
+                    EASY_GLOBALS.names_index.clear();
                     EASY_GLOBALS.descriptors.swap(descriptors);
+                    EASY_GLOBALS.updateDescriptorFlags();
+                    ++EASY_GLOBALS.data_generation;
                     m_serializedDescriptors.swap(serializedDescriptors);
                     m_descriptorsNumberInFile = static_cast<uint32_t>(EASY_GLOBALS.descriptors.size());
+                    EASY_GLOBALS.names_index.build();
 
                     if (m_descTreeDialog.ptr != nullptr)
                     {
@@ -2766,6 +2991,8 @@ void MainWindow::onGetBlockDescriptionsClicked(bool)
                         onEditBlocksClicked(true);
                     }
                 }
+
+                emit EASY_GLOBALS.events.dataChanged();
             }
         }
         else
@@ -59,6 +59,7 @@
 #include <sstream>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include <QMainWindow>
 #include <QDockWidget>
@@ -140,6 +141,8 @@ protected:
     QTimer                           m_fpsRequestTimer;
     profiler::SerializedData        m_serializedBlocks;
     profiler::SerializedData   m_serializedDescriptors;
+    std::vector<profiler::SerializedData>     m_liveData;
+    profiler::LiveRuntimeIds            m_liveRuntimeIds;
     profiler::BeginEndTime              m_beginEndTime;
     FileReader                                m_reader;
     SocketListener                          m_listener;
@@ -154,6 +157,7 @@ protected:
     class QAction*   m_deleteAction = nullptr;
 
     class QAction*              m_captureAction = nullptr;
+    class QAction*          m_liveCaptureAction = nullptr;
     class QAction*              m_connectAction = nullptr;
     class QAction*   m_eventTracingEnableAction = nullptr;
     class QAction* m_eventTracingPriorityAction = nullptr;
@@ -163,6 +167,7 @@ protected:
     bool      m_bNetworkFileRegime = false;
     bool        m_bOpenedCacheFile = false;
     bool         m_bCloseAfterSave = false;
+    bool            m_bLiveCapture = false;
 
 public:
 
@@ -219,6 +224,7 @@ protected slots:
     void onDescTreeDialogClose(int);
     void onListenerDialogClose(int);
     void onCaptureClicked(bool);
+    void onLiveCaptureClicked(bool);
     void onGetBlockDescriptionsClicked(bool);
     void onConnectClicked(bool);
     void onEventTracingPriorityChange(bool _checked);
@@ -257,7 +263,11 @@ private:
 
     void addFileToList(const QString& filename, bool changeWindowTitle = true);
     void loadFile(const QString& filename);
-    void readStream(std::stringstream& data);
+    void readStream(SocketListener& _listener);
+
+    void startCapture(bool _live);
+    void appendLiveBlocks();
+    void finishLiveCapture();
 
     void loadSettings();
     void loadGeometry();
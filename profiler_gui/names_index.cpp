@@ -0,0 +1,290 @@
+/************************************************************************
+* file name         : names_index.cpp
+* ----------------- :
+* creation time     : 2026/10/19
+* author            : Victor Zarubkin
+* email             : v.s.zarubkin@gmail.com
+* ----------------- :
+* description       : The file contains implementation of NamesIndex - full-text search index
+*                   : over names of block descriptors and blocks.
+* ----------------- :
+*                   :
+*                   : Licensed under either of
+*                   :     * MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+*                   :     * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+*                   : at your option.
+*                   :
+*                   : The MIT License
+*                   :
+*                   : Permission is hereby granted, free of charge, to any person obtaining a copy
+*                   : of this software and associated documentation files (the "Software"), to deal
+*                   : in the Software without restriction, including without limitation the rights
+*                   : to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+*                   : of the Software, and to permit persons to whom the Software is furnished
+*                   : to do so, subject to the following conditions:
+*                   :
+*                   : The above copyright notice and this permission notice shall be included in all
+*                   : copies or substantial portions of the Software.
+*                   :
+*                   : THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+*                   : INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+*                   : PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+*                   : LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+*                   : TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+*                   : USE OR OTHER DEALINGS IN THE SOFTWARE.
+*                   :
+*                   : The Apache License, Version 2.0 (the "License")
+*                   :
+*                   : You may not use this file except in compliance with the License.
+*                   : You may obtain a copy of the License at
+*                   :
+*                   : http://www.apache.org/licenses/LICENSE-2.0
+*                   :
+*                   : Unless required by applicable law or agreed to in writing, software
+*                   : distributed under the License is distributed on an "AS IS" BASIS,
+*                   : WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*                   : See the License for the specific language governing permissions and
+*                   : limitations under the License.
+************************************************************************/
+
+#include <algorithm>
+#include <iterator>
+#include "names_index.h"
+#include "globals.h"
+
+namespace {
+
+EASY_CONSTEXPR uint32_t INVALID_NAME = ~0U;
+
+inline char toLowerAscii(char c)
+{
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+inline uint32_t trigram(char a, char b, char c)
+{
+    return (static_cast<uint32_t>(static_cast<uint8_t>(toLowerAscii(a))) << 16)
+         | (static_cast<uint32_t>(static_cast<uint8_t>(toLowerAscii(b))) << 8)
+         |  static_cast<uint32_t>(static_cast<uint8_t>(toLowerAscii(c)));
+}
+
+bool isAscii(const QString& _str)
+{
+    for (auto ch : _str)
+    {
+        if (ch.unicode() > 127)
+            return false;
+    }
+
+    return true;
+}
+
+} // end of namespace <noname>.
+
+//////////////////////////////////////////////////////////////////////////
+
+NamesIndex::NamesIndex()
+    : m_worker(false)
+    , m_interrupt(false)
+    , m_ready(false)
+{
+
+}
+
+NamesIndex::~NamesIndex()
+{
+    clear();
+}
+
+void NamesIndex::build()
+{
+    clear();
+    m_worker.enqueue([this] { buildInternal(); }, m_interrupt);
+}
+
+void NamesIndex::clear()
+{
+    m_worker.dequeue();
+    m_ready.store(false, std::memory_order_release);
+
+    Names().swap(m_names);
+    Trigrams().swap(m_trigrams);
+}
+
+bool NamesIndex::ready() const
+{
+    return m_ready.load(std::memory_order_acquire);
+}
+
+const std::string& NamesIndex::text(uint32_t _nameId) const
+{
+    return m_names[_nameId].text;
+}
+
+const NamesIndex::Descriptors& NamesIndex::descriptors(uint32_t _nameId) const
+{
+    return m_names[_nameId].descriptors;
+}
+
+const NamesIndex::ThreadsBlocks& NamesIndex::blocks(uint32_t _nameId) const
+{
+    return m_names[_nameId].blocks;
+}
+
+NamesIndex::NameIds NamesIndex::find(const QString& _str, bool _caseSensitive) const
+{
+    NameIds result;
+    if (_str.isEmpty() || !ready())
+        return result;
+
+    const auto caseSensitivity = _caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    const auto matches = [&] (uint32_t _nameId) -> bool
+    {
+        return profiler_gui::toUnicode(m_names[_nameId].text.c_str()).contains(_str, caseSensitivity);
+    };
+
+    // Names are stored in locale encoding, so their bytes could be compared with ASCII strings only
+    if (_str.size() < 3 || !isAscii(_str))
+    {
+        for (uint32_t id = 0, size = static_cast<uint32_t>(m_names.size()); id < size; ++id)
+        {
+            if (matches(id))
+                result.push_back(id);
+        }
+
+        return result;
+    }
+
+    const auto bytes = _str.toLatin1();
+    std::vector<const NameIds*> lists;
+    for (int i = 2; i < bytes.size(); ++i)
+    {
+        auto it = m_trigrams.find(trigram(bytes[i - 2], bytes[i - 1], bytes[i]));
+        if (it == m_trigrams.end())
+            return result; // There is no name containing this trigram
+
+        lists.push_back(&it->second);
+    }
+
+    // Intersection is started from the shortest list
+    std::sort(lists.begin(), lists.end(), [] (const NameIds* _a, const NameIds* _b) { return _a->size() < _b->size(); });
+
+    NameIds candidates(*lists.front()), intersection;
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i)
+    {
+        intersection.clear();
+        std::set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(),
+                              std::back_inserter(intersection));
+        candidates.swap(intersection);
+    }
+
+    for (auto id : candidates)
+    {
+        if (matches(id))
+            result.push_back(id);
+    }
+
+    return result;
+}
+
+void NamesIndex::buildInternal()
+{
+    Names names;
+    std::unordered_map<std::string, uint32_t> ids;
+
+    const auto nameId = [&] (const char* _text) -> uint32_t
+    {
+        auto it = ids.find(_text);
+        if (it != ids.end())
+            return it->second;
+
+        const auto id = static_cast<uint32_t>(names.size());
+        ids.emplace(_text, id);
+        names.emplace_back();
+        names.back().text = _text;
+        return id;
+    };
+
+    // Descriptor names
+    const auto& descriptors = EASY_GLOBALS.descriptors;
+    std::vector<uint32_t> descriptorNames(descriptors.size(), INVALID_NAME);
+    for (size_t i = 0; i < descriptors.size(); ++i)
+    {
+        const auto desc = descriptors[i];
+        if (desc == nullptr)
+            continue;
+
+        const auto id = nameId(desc->name());
+        descriptorNames[i] = id;
+        names[id].descriptors.push_back(static_cast<profiler::block_id_t>(i));
+    }
+
+    // Blocks of each thread are traversed in depth-first order which is the order of call-stack tree
+    std::vector<BlockIndices> threadBlocks;
+    BlockIndices stack;
+    for (const auto& it : EASY_GLOBALS.profiler_blocks)
+    {
+        const auto& root = it.second;
+
+        stack.assign(root.children.rbegin(), root.children.rend());
+        while (!stack.empty())
+        {
+            if (m_interrupt.load(std::memory_order_acquire))
+                return;
+
+            const auto block_index = stack.back();
+            stack.pop_back();
+
+            const auto& tree = easyBlocksTree(block_index);
+            const auto descriptorId = tree.node->id();
+
+            auto id = *tree.node->name() != 0 ? nameId(tree.node->name()) : INVALID_NAME;
+            if (id == INVALID_NAME && descriptorId < descriptorNames.size())
+                id = descriptorNames[descriptorId];
+
+            if (id != INVALID_NAME)
+            {
+                if (threadBlocks.size() <= id)
+                    threadBlocks.resize(names.size());
+                threadBlocks[id].push_back(block_index);
+            }
+
+            stack.insert(stack.end(), tree.children.rbegin(), tree.children.rend());
+        }
+
+        for (size_t i = 0; i < threadBlocks.size(); ++i)
+        {
+            if (!threadBlocks[i].empty())
+            {
+                names[i].blocks.emplace(root.thread_id, std::move(threadBlocks[i]));
+                threadBlocks[i] = BlockIndices();
+            }
+        }
+    }
+
+    // Trigrams
+    Trigrams trigrams;
+    std::vector<uint32_t> nameTrigrams;
+    for (uint32_t id = 0, size = static_cast<uint32_t>(names.size()); id < size; ++id)
+    {
+        if (m_interrupt.load(std::memory_order_acquire))
+            return;
+
+        const auto& text = names[id].text;
+
+        nameTrigrams.clear();
+        for (size_t i = 2; i < text.size(); ++i)
+            nameTrigrams.push_back(trigram(text[i - 2], text[i - 1], text[i]));
+
+        std::sort(nameTrigrams.begin(), nameTrigrams.end());
+        nameTrigrams.erase(std::unique(nameTrigrams.begin(), nameTrigrams.end()), nameTrigrams.end());
+
+        // Name ids are increasing, so lists of names stay sorted
+        for (auto key : nameTrigrams)
+            trigrams[key].push_back(id);
+    }
+
+    m_names.swap(names);
+    m_trigrams.swap(trigrams);
+    m_ready.store(true, std::memory_order_release);
+}
@@ -0,0 +1,129 @@
+/************************************************************************
+* file name         : names_index.h
+* ----------------- :
+* creation time     : 2026/10/19
+* author            : Victor Zarubkin
+* email             : v.s.zarubkin@gmail.com
+* ----------------- :
+* description       : The file contains declaration of NamesIndex - full-text search index
+*                   : over names of block descriptors and blocks.
+* ----------------- :
+*                   :
+*                   : Licensed under either of
+*                   :     * MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+*                   :     * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+*                   : at your option.
+*                   :
+*                   : The MIT License
+*                   :
+*                   : Permission is hereby granted, free of charge, to any person obtaining a copy
+*                   : of this software and associated documentation files (the "Software"), to deal
+*                   : in the Software without restriction, including without limitation the rights
+*                   : to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+*                   : of the Software, and to permit persons to whom the Software is furnished
+*                   : to do so, subject to the following conditions:
+*                   :
+*                   : The above copyright notice and this permission notice shall be included in all
+*                   : copies or substantial portions of the Software.
+*                   :
+*                   : THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+*                   : INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+*                   : PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+*                   : LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+*                   : TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+*                   : USE OR OTHER DEALINGS IN THE SOFTWARE.
+*                   :
+*                   : The Apache License, Version 2.0 (the "License")
+*                   :
+*                   : You may not use this file except in compliance with the License.
+*                   : You may obtain a copy of the License at
+*                   :
+*                   : http://www.apache.org/licenses/LICENSE-2.0
+*                   :
+*                   : Unless required by applicable law or agreed to in writing, software
+*                   : distributed under the License is distributed on an "AS IS" BASIS,
+*                   : WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*                   : See the License for the specific language governing permissions and
+*                   : limitations under the License.
+************************************************************************/
+
+#ifndef EASY_PROFILER_GUI_NAMES_INDEX_H
+#define EASY_PROFILER_GUI_NAMES_INDEX_H
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <QString>
+#include <easy/reader.h>
+#include "thread_pool_task.h"
+
+//////////////////////////////////////////////////////////////////////////
+
+/** \brief Trigram index over unique names of descriptors and blocks (including runtime names).
+
+Each unique name refers to descriptors with this name and to blocks with this name for each thread.
+Index is built in background by build() and could be used only when ready() returns true.
+Must be cleared by clear() before EASY_GLOBALS.descriptors or EASY_GLOBALS.profiler_blocks are changed.
+*/
+class NamesIndex Q_DECL_FINAL
+{
+public:
+
+    using NameIds = std::vector<uint32_t>;
+    using Descriptors = std::vector<profiler::block_id_t>;
+    using BlockIndices = std::vector<profiler::block_index_t>;
+    using ThreadsBlocks = std::unordered_map<profiler::thread_id_t, BlockIndices, estd::hash<profiler::thread_id_t> >;
+
+private:
+
+    struct Name
+    {
+        std::string          text; ///< Name as it is stored in file
+        Descriptors   descriptors; ///< Ids of descriptors with this name
+        ThreadsBlocks      blocks; ///< Indices of blocks with this name in the order of call-stack tree for each thread
+    };
+
+    using Names = std::vector<Name>;
+    using Trigrams = std::unordered_map<uint32_t, NameIds>;
+
+    Names                m_names; ///< Unique names
+    Trigrams          m_trigrams; ///< Sorted ids of names containing each trigram (ASCII letters in lower case)
+    ThreadPoolTask      m_worker; ///< Builds the index in background
+    std::atomic_bool m_interrupt; ///< Interrupts building
+    std::atomic_bool     m_ready; ///< True when the index is built and could be used
+
+public:
+
+    NamesIndex();
+    ~NamesIndex();
+
+    /** \brief Starts building the index for current EASY_GLOBALS.descriptors and EASY_GLOBALS.profiler_blocks. */
+    void build();
+
+    /** \brief Interrupts building (waits for the worker) and removes the index. */
+    void clear();
+
+    bool ready() const;
+
+    /** \brief Returns sorted ids of names which contain _str.
+
+    Trigrams of _str are used to select candidates, then each candidate is checked by QString::contains().
+    Short and non-ASCII strings are checked against all names. */
+    NameIds find(const QString& _str, bool _caseSensitive) const;
+
+    ///< Returns name as it is stored in file.
+    const std::string& text(uint32_t _nameId) const;
+
+    const Descriptors& descriptors(uint32_t _nameId) const;
+    const ThreadsBlocks& blocks(uint32_t _nameId) const;
+
+private:
+
+    void buildInternal();
+
+}; // END of class NamesIndex.
+
+//////////////////////////////////////////////////////////////////////////
+
+#endif // EASY_PROFILER_GUI_NAMES_INDEX_H
@@ -47,6 +47,11 @@ The Apache License, Version 2.0 (the "License");
 #include "common_functions.h"
 #include "socket_listener.h"
 
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+# include <string.h>
+# include <sys/mman.h>
+#endif
+
 #ifdef min
 #undef min
 #endif
@@ -55,6 +60,59 @@ The Apache License, Version 2.0 (the "License");
 #undef max
 #endif
 
+//////////////////////////////////////////////////////////////////////////
+
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+
+SharedMemoryStreamBuffer::SharedMemoryStreamBuffer(int _fd, uint64_t _size) : m_data(nullptr), m_size(0)
+{
+    auto memory = mmap(nullptr, static_cast<size_t>(_size), PROT_READ, MAP_PRIVATE, _fd, 0);
+    if (memory == MAP_FAILED)
+        return;
+
+    // Get area is never written: std::streambuf requires non-const pointers only
+    m_data = static_cast<char*>(memory);
+    m_size = static_cast<size_t>(_size);
+    setg(m_data, m_data, m_data + m_size);
+}
+
+SharedMemoryStreamBuffer::~SharedMemoryStreamBuffer()
+{
+    if (m_data != nullptr)
+        munmap(m_data, m_size);
+}
+
+bool SharedMemoryStreamBuffer::isValid() const
+{
+    return m_data != nullptr;
+}
+
+SharedMemoryStreamBuffer::pos_type SharedMemoryStreamBuffer::seekoff(off_type _offset, std::ios_base::seekdir _dir,
+                                                                     std::ios_base::openmode _which)
+{
+    if (m_data == nullptr || (_which & std::ios_base::in) == 0)
+        return pos_type(off_type(-1));
+
+    off_type position = _offset;
+    if (_dir == std::ios_base::cur)
+        position += static_cast<off_type>(gptr() - eback());
+    else if (_dir == std::ios_base::end)
+        position += static_cast<off_type>(m_size);
+
+    if (position < 0 || position > static_cast<off_type>(m_size))
+        return pos_type(off_type(-1));
+
+    setg(m_data, m_data + position, m_data + m_size);
+    return pos_type(position);
+}
+
+SharedMemoryStreamBuffer::pos_type SharedMemoryStreamBuffer::seekpos(pos_type _position, std::ios_base::openmode _which)
+{
+    return seekoff(off_type(_position), std::ios_base::beg, _which);
+}
+
+#endif // EASY_LOCAL_SOCKET_ENABLED
+
 SocketListener::SocketListener() : m_receivedSize(0), m_port(0), m_regime(ListenerRegime::Idle)
 {
     m_bInterrupt = false;
@@ -100,6 +158,11 @@ std::stringstream& SocketListener::data()
     return m_receivedData;
 }
 
+std::unique_ptr<std::streambuf> SocketListener::takeSharedData()
+{
+    return std::move(m_sharedData);
+}
+
 const std::string& SocketListener::address() const
 {
     return m_address;
@@ -113,6 +176,7 @@ uint16_t SocketListener::port() const
 void SocketListener::clearData()
 {
     profiler_gui::clear_stream(m_receivedData);
+    m_sharedData.reset();
     m_receivedSize = 0;
 }
 
@@ -172,8 +236,26 @@ bool SocketListener::connect(
         closeSocket();
     }
 
-    int res = m_easySocket.setAddress(_ipaddress, _port);
-    res = m_easySocket.connect();
+    int res = -1;
+
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+    if (m_easySocket.isLocal())
+    {
+        closeSocket();
+    }
+
+    // Profiler on the same host is connected by Unix domain socket: captured blocks are passed by shared memory
+    if (strcmp(_ipaddress, "127.0.0.1") == 0 || strcmp(_ipaddress, "localhost") == 0)
+    {
+        res = m_easySocket.connectLocal(_port);
+    }
+
+    if (res != 0)
+#endif
+    {
+        m_easySocket.setAddress(_ipaddress, _port);
+        res = m_easySocket.connect();
+    }
 
     const bool isConnected = res == 0;
     if (isConnected)
@@ -228,7 +310,14 @@ bool SocketListener::connect(
         }
 
         auto message = reinterpret_cast<const profiler::net::EasyProfilerStatus*>(buffer);
-        if (message->isEasyNetMessage() && message->type == profiler::net::MessageType::Connection_Accepted)
+        if (!message->isEasyNetMessage())
+        {
+            // Messages of another protocol version can not be parsed correctly
+            qWarning() << "Profiled application uses incompatible version of network protocol";
+            return false;
+        }
+
+        if (message->type == profiler::net::MessageType::Connection_Accepted)
         {
             _reply = *message;
         }
@@ -274,11 +363,71 @@ bool SocketListener::startCapture()
     return true;
 }
 
+bool SocketListener::startLiveCapture(uint32_t _interval)
+{
+    if (m_thread.joinable())
+    {
+        m_bInterrupt.store(true, std::memory_order_release);
+        m_thread.join();
+        m_bInterrupt.store(false, std::memory_order_release);
+    }
+
+    clearData();
+    {
+        std::lock_guard<std::mutex> lock(m_liveMutex);
+        m_livePortions.clear();
+    }
+
+    profiler::net::LiveCaptureMessage request(_interval);
+    m_easySocket.send(&request, sizeof(request));
+
+    if (m_easySocket.isDisconnected())
+    {
+        m_bConnected.store(false, std::memory_order_release);
+        return false;
+    }
+
+    m_regime = ListenerRegime::Capture_Live;
+    m_bCaptureReady.store(false, std::memory_order_release);
+    m_thread = std::thread(&SocketListener::listenLive, this);
+
+    return true;
+}
+
+bool SocketListener::takeLivePortions(std::vector<std::string>& _portions)
+{
+    std::lock_guard<std::mutex> lock(m_liveMutex);
+    if (m_livePortions.empty())
+    {
+        return false;
+    }
+
+    _portions.swap(m_livePortions);
+    m_livePortions.clear();
+
+    return true;
+}
+
 void SocketListener::stopCapture()
 {
     //if (!m_thread.joinable() || m_regime != ListenerRegime::Capture)
     //    return;
 
+    if (m_regime == ListenerRegime::Capture_Live)
+    {
+        // Live listening thread continues receiving until the last portion and Reply_Blocks_End
+        profiler::net::Message request(profiler::net::MessageType::Request_Stop_Capture);
+        m_easySocket.send(&request, sizeof(request));
+
+        if (m_easySocket.isDisconnected())
+        {
+            m_bConnected.store(false, std::memory_order_release);
+        }
+
+        m_regime = ListenerRegime::Capture_Receive;
+        return;
+    }
+
     if (m_regime != ListenerRegime::Capture)
     {
         return;
@@ -522,7 +671,7 @@ void SocketListener::listenCapture()
                 bytes -= sizeof(profiler::net::Message);
 
                 const auto dt = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - timeBegin);
-                const auto bytesNumber = m_receivedData.str().size();
+                const auto bytesNumber = m_receivedSize;
                 qInfo() << "received " << bytesNumber << " bytes, " << dt.count() << " ms, average speed = "
                         << double(bytesNumber) * 1e3 / double(dt.count()) / 1024. << " kBytes/sec";
 
@@ -533,7 +682,12 @@ void SocketListener::listenCapture()
 
             case profiler::net::MessageType::Reply_Blocks:
             {
-                qInfo() << "Receive MessageType::Reply_Blocks";
+                // Blocks are sent by several frames, each of them is a separate Reply_Blocks message
+                if (m_receivedSize == 0)
+                {
+                    qInfo() << "Receive MessageType::Reply_Blocks";
+                    timeBegin = std::chrono::system_clock::now();
+                }
 
                 while (bytes < sizeof(profiler::net::DataMessage))
                 {
@@ -572,10 +726,8 @@ void SocketListener::listenCapture()
                 bytes -= sizeof(profiler::net::DataMessage);
                 auto dm = reinterpret_cast<const profiler::net::DataMessage*>(message);
 
-                timeBegin = std::chrono::system_clock::now();
-
-                int neededSize = dm->size;
-                const int bytesNumber = std::min(neededSize, bytes);
+                uint64_t neededSize = dm->size;
+                const int bytesNumber = static_cast<int>(std::min(neededSize, static_cast<uint64_t>(bytes)));
                 if (bytesNumber > 0)
                 {
                     char* buf = buffer + seek;
@@ -603,7 +755,7 @@ void SocketListener::listenCapture()
                         break;
                     }
 
-                    const int toWrite = std::min(bytes, neededSize);
+                    const int toWrite = static_cast<int>(std::min(static_cast<uint64_t>(bytes), neededSize));
                     m_receivedSize += toWrite;
                     m_receivedData.write(buffer, toWrite);
 
@@ -645,6 +797,70 @@ void SocketListener::listenCapture()
                 break;
             }
 
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+            case profiler::net::MessageType::Reply_Blocks_Shared:
+            {
+                // Blocks are in shared memory which file descriptor is received with this message
+                qInfo() << "Receive MessageType::Reply_Blocks_Shared";
+
+                while (bytes < sizeof(profiler::net::DataMessage))
+                {
+                    int receivedBytes = m_easySocket.receive(buffer + seek + bytes, buffer_size);
+                    if (receivedBytes < 1)
+                    {
+                        bytes = receivedBytes;
+                        break;
+                    }
+                    bytes += receivedBytes;
+                }
+
+                if (bytes < 1)
+                {
+                    if (bytes == -1 && m_easySocket.isDisconnected())
+                    {
+                        m_bConnected.store(false, std::memory_order_release);
+                        disconnected = true;
+                    }
+
+                    isListen = false;
+                    bytes = 0;
+                    seek = 0;
+
+                    continue;
+                }
+
+                const auto size = reinterpret_cast<const profiler::net::DataMessage*>(message)->size;
+                seek += sizeof(profiler::net::DataMessage);
+                bytes -= sizeof(profiler::net::DataMessage);
+
+                const int fd = m_easySocket.takeReceivedFile();
+                if (fd < 0)
+                {
+                    qWarning() << "Shared memory descriptor has not been received";
+                    break;
+                }
+
+                if (size != 0)
+                {
+                    // Mapped memory is passed to the reader as is (see takeSharedData())
+                    std::unique_ptr<SharedMemoryStreamBuffer> memory(new SharedMemoryStreamBuffer(fd, size));
+                    if (memory->isValid())
+                    {
+                        m_receivedSize += size;
+                        m_sharedData = std::move(memory);
+                    }
+                    else
+                    {
+                        qWarning() << "Can not map shared memory of size " << size;
+                    }
+                }
+
+                ::close(fd);
+
+                break;
+            }
+#endif
+
             default:
             {
                 //qInfo() << "Receive unknown " << message->type;
@@ -663,6 +879,113 @@ void SocketListener::listenCapture()
     m_bCaptureReady.store(true, std::memory_order_release);
 }
 
+bool SocketListener::receiveAll(void* _buffer, uint64_t _size)
+{
+    auto buffer = static_cast<char*>(_buffer);
+    while (_size != 0)
+    {
+        if (m_bInterrupt.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        const auto size = static_cast<size_t>(std::min(_size, static_cast<uint64_t>(1 << 30)));
+        const int bytes = m_easySocket.receive(buffer, size);
+        if (bytes < 1)
+        {
+            if (bytes == 0 || m_easySocket.isDisconnected())
+            {
+                m_bConnected.store(false, std::memory_order_release);
+                return false;
+            }
+
+            continue;
+        }
+
+        buffer += bytes;
+        _size -= static_cast<uint64_t>(bytes);
+    }
+
+    return true;
+}
+
+void SocketListener::listenLive()
+{
+    std::string portion;
+    uint64_t receivedSize = 0;
+    auto timeBegin = std::chrono::system_clock::now();
+
+    bool isListen = true;
+    while (isListen && !m_bInterrupt.load(std::memory_order_acquire))
+    {
+        profiler::net::Message message;
+        if (!receiveAll(&message, sizeof(message)))
+        {
+            break;
+        }
+
+        if (!message.isEasyNetMessage())
+        {
+            continue;
+        }
+
+        switch (message.type)
+        {
+            case profiler::net::MessageType::Reply_Capturing_Started:
+            {
+                qInfo() << "Receive MessageType::Reply_Capturing_Started";
+                break;
+            }
+
+            case profiler::net::MessageType::Reply_Live_Blocks:
+            {
+                uint64_t size = 0;
+                if (!receiveAll(&size, sizeof(size)))
+                {
+                    isListen = false;
+                    break;
+                }
+
+                const auto offset = portion.size();
+                portion.resize(offset + static_cast<size_t>(size));
+                if (!receiveAll(&portion[offset], size))
+                {
+                    isListen = false;
+                    break;
+                }
+
+                receivedSize += size;
+                break;
+            }
+
+            case profiler::net::MessageType::Reply_Live_Blocks_End:
+            {
+                std::lock_guard<std::mutex> lock(m_liveMutex);
+                m_livePortions.emplace_back(std::move(portion));
+                portion.clear();
+                break;
+            }
+
+            case profiler::net::MessageType::Reply_Blocks_End:
+            {
+                const auto dt = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - timeBegin);
+                qInfo() << "Receive MessageType::Reply_Blocks_End: received " << receivedSize << " bytes of live blocks during "
+                        << dt.count() << " ms";
+
+                isListen = false;
+                break;
+            }
+
+            default:
+            {
+                break;
+            }
+        }
+    }
+
+    m_bCaptureReady.store(true, std::memory_order_release);
+}
+
 void SocketListener::listenDescription()
 {
     EASY_CONSTEXPR int buffer_size = 8 * 1024 * 1024;
@@ -819,8 +1142,8 @@ void SocketListener::listenDescription()
                 bytes -= sizeof(profiler::net::DataMessage);
                 auto dm = reinterpret_cast<const profiler::net::DataMessage*>(message);
 
-                int neededSize = dm->size;
-                const int bytesNumber = std::min(neededSize, bytes);
+                uint64_t neededSize = dm->size;
+                const int bytesNumber = static_cast<int>(std::min(neededSize, static_cast<uint64_t>(bytes)));
                 if (bytesNumber > 0)
                 {
                     char* buf = buffer + seek;
@@ -848,7 +1171,7 @@ void SocketListener::listenDescription()
                         break;
                     }
 
-                    const int toWrite = std::min(bytes, neededSize);
+                    const int toWrite = static_cast<int>(std::min(static_cast<uint64_t>(bytes), neededSize));
                     m_receivedSize += toWrite;
                     m_receivedData.write(buffer, toWrite);
 
@@ -44,9 +44,13 @@ The Apache License, Version 2.0 (the "License");
 #define EASY_PROFILER_SOCKET_LISTENER_H
 
 #include <atomic>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <streambuf>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include <QObject>
 
@@ -61,14 +65,49 @@ enum class ListenerRegime : uint8_t
     Idle = 0,
     Capture,
     Capture_Receive,
+    Capture_Live,
     Descriptors
 };
 
+#if EASY_LOCAL_SOCKET_ENABLED != 0
+
+/** Read-only input stream buffer over shared memory which has been received by local socket.
+
+Blocks are read directly from mapped pages without copying them into std::stringstream.
+The memory is unmapped on destruction.
+*/
+class SharedMemoryStreamBuffer Q_DECL_FINAL : public std::streambuf
+{
+    char*    m_data; ///< Mapped memory (read-only)
+    size_t   m_size; ///< Size of mapped memory
+
+public:
+
+    SharedMemoryStreamBuffer(int _fd, uint64_t _size);
+    ~SharedMemoryStreamBuffer() override;
+
+    SharedMemoryStreamBuffer(const SharedMemoryStreamBuffer&) = delete;
+    SharedMemoryStreamBuffer& operator = (const SharedMemoryStreamBuffer&) = delete;
+
+    bool isValid() const;
+
+protected:
+
+    pos_type seekoff(off_type _offset, std::ios_base::seekdir _dir, std::ios_base::openmode _which) override;
+    pos_type seekpos(pos_type _position, std::ios_base::openmode _which) override;
+
+}; // END of class SharedMemoryStreamBuffer.
+
+#endif // EASY_LOCAL_SOCKET_ENABLED
+
 class SocketListener Q_DECL_FINAL
 {
     EasySocket            m_easySocket; ///<
     std::string              m_address; ///<
     std::stringstream   m_receivedData; ///<
+    std::unique_ptr<std::streambuf> m_sharedData; ///< Received blocks in shared memory (local connection only, used instead of m_receivedData)
+    std::vector<std::string> m_livePortions; ///< Live capture portions received but not yet taken by GUI
+    std::mutex             m_liveMutex; ///<
     std::thread               m_thread; ///<
     uint64_t            m_receivedSize; ///<
     uint16_t                    m_port; ///<
@@ -94,6 +133,10 @@ public:
     uint16_t port() const;
 
     std::stringstream& data();
+
+    /** Take received blocks which are in shared memory (nullptr if they have been received into data()). */
+    std::unique_ptr<std::streambuf> takeSharedData();
+
     void clearData();
 
     void disconnect();
@@ -102,6 +145,8 @@ public:
     bool reconnect(const char* _ipaddress, uint16_t _port, profiler::net::EasyProfilerStatus& _reply);
 
     bool startCapture();
+    bool startLiveCapture(uint32_t _interval);
+    bool takeLivePortions(std::vector<std::string>& _portions);
     void stopCapture();
     void finalizeCapture();
     void requestBlocksDescription();
@@ -117,6 +162,8 @@ public:
 private:
 
     void listenCapture();
+    void listenLive();
+    bool receiveAll(void* _buffer, uint64_t _size);
     void listenDescription();
     void listenFrameTime();
 
@@ -50,6 +50,7 @@
 
 #include "thread_pool.h"
 #include <algorithm>
+#include <memory>
 
 #ifdef _MSC_VER
 // std::back_inserter is defined in <iterator> for Visual C++ ...
@@ -145,6 +146,58 @@ void ThreadPool::backgroundJob(std::function<void()>&& func)
     m_backgroundJobs.cv.notify_one();
 }
 
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& func)
+{
+    if (count == 0)
+        return;
+
+    struct State
+    {
+        std::atomic<size_t>        next;
+        std::atomic<size_t>        done;
+        std::mutex                mutex;
+        std::condition_variable      cv;
+    };
+
+    // Helpers which have not started until all work is done are still in the queue,
+    // so they must keep the state alive and must not touch func.
+    auto state = std::make_shared<State>();
+    state->next = 0;
+    state->done = 0;
+
+    auto work = [state, &func, count]
+    {
+        for (auto i = state->next.fetch_add(1, std::memory_order_relaxed); i < count;
+             i = state->next.fetch_add(1, std::memory_order_relaxed))
+        {
+            func(i);
+
+            if (state->done.fetch_add(1, std::memory_order_acq_rel) + 1 == count)
+            {
+                const std::lock_guard<std::mutex> lock(state->mutex);
+                state->cv.notify_all();
+            }
+        }
+    };
+
+    const auto helpers = std::min(count - 1, m_threads.size());
+    if (helpers != 0)
+    {
+        m_tasks.mutex.lock();
+        for (size_t i = 0; i < helpers; ++i)
+            m_tasks.helpers.emplace_back(work);
+        m_tasks.mutex.unlock();
+        m_tasks.cv.notify_all();
+    }
+
+    work();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&state, count] {
+        return state->done.load(std::memory_order_acquire) == count;
+    });
+}
+
 void ThreadPool::enqueue(ThreadPoolTask& task)
 {
 #ifdef EASY_THREADPOOL_SEPARATE_QT_THREAD
@@ -190,17 +243,30 @@ void ThreadPool::dequeue(ThreadPoolTask& task, TaskJobs& tasks)
     }
 }
 
-void ThreadPool::tasksWorker(Jobs<std::reference_wrapper<ThreadPoolTask> >& tasks)
+void ThreadPool::tasksWorker(TaskJobs& tasks)
 {
     while (!m_interrupt.load(std::memory_order_acquire))
     {
         std::unique_lock<std::mutex> lock(tasks.mutex);
         tasks.cv.wait(lock, [this, &tasks] {
-            return !tasks.queue.empty() || m_interrupt.load(std::memory_order_acquire);
+            return !tasks.queue.empty() || !tasks.helpers.empty() || m_interrupt.load(std::memory_order_acquire);
         });
 
-        while (!tasks.queue.empty() && !m_interrupt.load(std::memory_order_acquire)) // execute all available tasks
+        while ((!tasks.queue.empty() || !tasks.helpers.empty()) && !m_interrupt.load(std::memory_order_acquire)) // execute all available tasks
         {
+            if (!tasks.helpers.empty())
+            {
+                // someone is waiting for helpers of parallelFor(), execute them first
+                auto helper = std::move(tasks.helpers.front());
+                tasks.helpers.pop_front();
+
+                lock.unlock();
+                helper();
+                lock.lock();
+
+                continue;
+            }
+
             auto& task = tasks.queue.front().get();
             task.setStatus(TaskStatus::Processing);
             tasks.queue.pop_front();
@@ -82,7 +82,11 @@ class ThreadPool EASY_FINAL
         std::condition_variable cv;
     };
 
-    using TaskJobs = Jobs<std::reference_wrapper<ThreadPoolTask> >;
+    struct TaskJobs : public Jobs<std::reference_wrapper<ThreadPoolTask> >
+    {
+        std::deque<std::function<void()> > helpers; ///< Helper jobs of parallelFor() which have priority over tasks
+    };
+
     using BackgroundJobs = Jobs<std::function<void()> >;
 
     TaskJobs m_tasks;
@@ -103,6 +107,12 @@ public:
 
     void backgroundJob(std::function<void()>&& func);
 
+    /** Calls func(i) for each i in [0, count) using worker threads and the calling thread.
+
+    Returns when all calls are finished. The calling thread takes part in the work, so it is safe
+    to call parallelFor() from a task running on this pool. */
+    void parallelFor(size_t count, const std::function<void(size_t)>& func);
+
 private:
 
     void enqueue(ThreadPoolTask& task);
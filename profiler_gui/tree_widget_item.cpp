@@ -113,6 +113,11 @@ EASY_CONSTEXPR bool HasToolTip[COL_COLUMNS_NUMBER] = {
     , true  // COL_AVG_PER_AREA,
     , true  // COL_MEDIAN_PER_AREA,
     , false // COL_NCALLS_PER_AREA,
+    , false // COL_IPC,
+    , false // COL_CACHE_MISSES_PKI,
+    , false // COL_PAGE_FAULTS,
+    , false // COL_ALLOCS,
+    , false // COL_ALLOC_BYTES,
 };
 
 } // end of namespace <noname>.
@@ -125,6 +130,7 @@ TreeWidgetItem::TreeWidgetItem(profiler::block_index_t _treeBlock, Parent* _pare
     , m_customBGColor(0)
     , m_bMain(false)
     , m_partial(false)
+    , m_lazy(false)
 {
 
 }
@@ -168,6 +174,8 @@ bool TreeWidgetItem::operator < (const Parent& _other) const
         }
 
         case COL_ACTIVE_PERCENT:
+        case COL_IPC:
+        case COL_CACHE_MISSES_PKI:
         {
             return data(col, Qt::UserRole).toDouble() < _other.data(col, Qt::UserRole).toDouble();
         }
@@ -185,6 +193,11 @@ bool TreeWidgetItem::isPartial() const
     return m_partial;
 }
 
+bool TreeWidgetItem::isLazy() const
+{
+    return m_lazy;
+}
+
 QVariant TreeWidgetItem::data(int _column, int _role) const
 {
     if (_column == COL_NAME)
@@ -262,6 +275,11 @@ QVariant TreeWidgetItem::relevantData(int _column, int _role) const
         case COL_PERCENT_PER_FRAME:
         case COL_PERCENT_PER_AREA:
         case COL_PERCENT_SUM_PER_THREAD:
+        case COL_IPC:
+        case COL_CACHE_MISSES_PKI:
+        case COL_PAGE_FAULTS:
+        case COL_ALLOCS:
+        case COL_ALLOC_BYTES:
         {
             return QVariant();
         }
@@ -415,6 +433,48 @@ void TreeWidgetItem::setTimeMs(int _column, const profiler::timestamp_t& _time,
     setText(_column, QString("%1%2").arg(_prefix).arg(double(nanosecondsTime) * 1e-6, 0, 'g', 9));
 }
 
+void TreeWidgetItem::setPerfCounters(const profiler::BlocksTree& _block)
+{
+    if (_block.perf_counters == 0)
+        return;
+
+    uint64_t cycles = 0, instructions = 0, cacheMisses = 0, pageFaults = 0;
+    const bool hasInstructions = _block.perfCounter(profiler::PERF_INSTRUCTIONS, instructions) && instructions != 0;
+
+    if (hasInstructions && _block.perfCounter(profiler::PERF_CYCLES, cycles) && cycles != 0)
+    {
+        const auto ipc = static_cast<double>(instructions) / static_cast<double>(cycles);
+        setData(COL_IPC, Qt::UserRole, ipc);
+        setText(COL_IPC, QString::number(ipc, 'f', 2));
+    }
+
+    if (hasInstructions && _block.perfCounter(profiler::PERF_CACHE_MISSES, cacheMisses))
+    {
+        const auto missesPerKilo = 1000. * static_cast<double>(cacheMisses) / static_cast<double>(instructions);
+        setData(COL_CACHE_MISSES_PKI, Qt::UserRole, missesPerKilo);
+        setText(COL_CACHE_MISSES_PKI, QString::number(missesPerKilo, 'f', 2));
+    }
+
+    if (_block.perfCounter(profiler::PERF_PAGE_FAULTS, pageFaults))
+    {
+        setData(COL_PAGE_FAULTS, Qt::UserRole, (quint64)pageFaults);
+        setText(COL_PAGE_FAULTS, QString::number(pageFaults));
+    }
+}
+
+void TreeWidgetItem::setAllocations(const profiler::BlocksTreeRoot& _threadRoot, profiler::block_index_t _block)
+{
+    const auto it = _threadRoot.allocations.find(_block);
+    if (it == _threadRoot.allocations.end() || it->second.allocs == 0)
+        return;
+
+    const auto& stats = it->second;
+    setData(COL_ALLOCS, Qt::UserRole, (quint64)stats.allocs);
+    setText(COL_ALLOCS, QString::number(stats.allocs));
+    setData(COL_ALLOC_BYTES, Qt::UserRole, (quint64)stats.bytes);
+    setText(COL_ALLOC_BYTES, QString::number(stats.bytes));
+}
+
 void TreeWidgetItem::setBackgroundColor(QRgb _color)
 {
     m_customBGColor = _color;
@@ -430,6 +490,14 @@ void TreeWidgetItem::setPartial(bool partial)
     m_partial = partial;
 }
 
+void TreeWidgetItem::setLazy(bool lazy)
+{
+    m_lazy = lazy;
+
+    // Lazy item has no children items yet, but it must be expandable
+    setChildIndicatorPolicy(lazy ? QTreeWidgetItem::ShowIndicator : QTreeWidgetItem::DontShowIndicatorWhenChildless);
+}
+
 void TreeWidgetItem::collapseAll()
 {
     for (int i = 0, childrenNumber = childCount(); i < childrenNumber; ++i)
@@ -444,6 +512,9 @@ void TreeWidgetItem::collapseAll()
 
 void TreeWidgetItem::expandAll()
 {
+    if (m_lazy)
+        return; // Children are created on demand only (see BlocksTreeWidget::onItemExpand())
+
     for (int i = 0, childrenNumber = childCount(); i < childrenNumber; ++i)
     {
         static_cast<TreeWidgetItem*>(child(i))->expandAll();
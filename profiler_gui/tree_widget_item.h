@@ -68,7 +68,7 @@ class BlocksTreeWidget;
 
 //////////////////////////////////////////////////////////////////////////
 
-EASY_CONSTEXPR int COLUMNS_VERSION = 3;
+EASY_CONSTEXPR int COLUMNS_VERSION = 5;
 EASY_CONSTEXPR int BlockColorRole = Qt::UserRole + 1;
 EASY_CONSTEXPR int MinMaxBlockIndexRole = Qt::UserRole + 2;
 
@@ -124,6 +124,13 @@ enum EasyColumnsIndexes
     COL_MEDIAN_PER_AREA,
     COL_NCALLS_PER_AREA,
 
+    COL_IPC,
+    COL_CACHE_MISSES_PKI,
+    COL_PAGE_FAULTS,
+
+    COL_ALLOCS,
+    COL_ALLOC_BYTES,
+
     COL_COLUMNS_NUMBER
 };
 
@@ -138,6 +145,7 @@ class TreeWidgetItem : public QTreeWidgetItem
     QRgb                            m_customBGColor;
     bool                                    m_bMain;
     bool                                  m_partial;
+    bool                                     m_lazy;
 
 public:
 
@@ -152,6 +160,7 @@ public:
 public:
 
     bool isPartial() const;
+    bool isLazy() const;
     profiler::block_index_t block_index() const;
     profiler_gui::EasyBlock& guiBlock();
     const profiler::BlocksTree& block() const;
@@ -164,10 +173,14 @@ public:
     void setTimeMs(int _column, const profiler::timestamp_t& _time);
     void setTimeMs(int _column, const profiler::timestamp_t& _time, const QString& _prefix);
 
+    void setPerfCounters(const profiler::BlocksTree& _block);
+    void setAllocations(const profiler::BlocksTreeRoot& _threadRoot, profiler::block_index_t _block);
+
     void setBackgroundColor(QRgb _color);
 
     void setMain(bool _main);
     void setPartial(bool partial);
+    void setLazy(bool lazy);
 
     void collapseAll();
 
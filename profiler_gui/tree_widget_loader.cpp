@@ -106,6 +106,49 @@ void calculateMedians(StatsMap::iterator begin, StatsMap::iterator end)
     }
 }
 
+void mergeStats(StatsMap& to, StatsMap& from)
+{
+    if (to.empty())
+    {
+        to.swap(from);
+        return;
+    }
+
+    for (auto& it : from)
+    {
+        auto to_it = to.find(it.first);
+        if (to_it == to.end())
+        {
+            to.emplace(it.first, std::move(it.second));
+            continue;
+        }
+
+        auto& stat = to_it->second.stats;
+        const auto& other = it.second.stats;
+
+        stat.calls_number += other.calls_number;
+        stat.total_duration += other.total_duration;
+        stat.total_children_duration += other.total_children_duration;
+
+        // Strict comparison keeps the first block of equal duration as for sequential updateStats() calls
+        if (easyBlocksTree(other.max_duration_block).node->duration() > easyBlocksTree(stat.max_duration_block).node->duration())
+        {
+            stat.max_duration_block = other.max_duration_block;
+        }
+
+        if (easyBlocksTree(other.min_duration_block).node->duration() < easyBlocksTree(stat.min_duration_block).node->duration())
+        {
+            stat.min_duration_block = other.min_duration_block;
+        }
+
+        auto& durations = to_it->second.durations;
+        for (const auto& duration : it.second.durations)
+        {
+            durations[duration.first].count += duration.second.count;
+        }
+    }
+}
+
 } // end of namespace <noname>.
 
 static void fillStatsColumns(
@@ -133,8 +176,8 @@ static void fillStatsColumns(
         return;
     }
 
-    const auto min_duration = easyBlock(stats->min_duration_block).tree.node->duration();
-    const auto max_duration = easyBlock(stats->max_duration_block).tree.node->duration();
+    const auto min_duration = easyBlocksTree(stats->min_duration_block).node->duration();
+    const auto max_duration = easyBlocksTree(stats->max_duration_block).node->duration();
     const auto avg_duration = stats->average_duration();
     const auto tot_duration = stats->total_duration;
     const auto median_duration = stats->median_duration;
@@ -218,11 +261,56 @@ inline void fillStatsColumnsSelection(TreeWidgetItem* item, const profiler::Bloc
     );
 }
 
+static void fillStatsColumnsArea(
+    TreeWidgetItem* item,
+    const StatsMap& stats,
+    profiler_gui::TimeUnits units,
+    profiler::timestamp_t selectionDuration
+) {
+    auto stat_it = stats.find(item->block().node->id());
+    if (stat_it == stats.end())
+    {
+        return;
+    }
+
+    auto& stat = stat_it->second;
+
+    fillStatsColumnsSelection(item, &stat.stats, units);
+
+    auto percent_per_selection = std::min(100, profiler_gui::percent(stat.stats.total_duration, selectionDuration));
+    item->setData(COL_PERCENT_SUM_PER_AREA, Qt::UserRole, percent_per_selection);
+    item->setText(COL_PERCENT_SUM_PER_AREA, QString::number(percent_per_selection));
+
+    percent_per_selection = std::min(100, profiler_gui::percent(item->block().node->duration(), selectionDuration));
+    item->setData(COL_PERCENT_PER_AREA, Qt::UserRole, percent_per_selection);
+    item->setText(COL_PERCENT_PER_AREA, QString::number(percent_per_selection));
+}
+
+static void fillSelfTimeColumns(
+    TreeWidgetItem* item,
+    profiler::timestamp_t duration,
+    profiler::timestamp_t children_duration,
+    profiler_gui::TimeUnits units
+) {
+    int percentage = 100;
+    auto self_duration = duration - children_duration;
+    if (children_duration > 0 && duration > 0)
+    {
+        percentage = profiler_gui::percent(self_duration, duration);
+    }
+
+    item->setTimeSmart(COL_SELF_TIME, units, self_duration);
+    item->setData(COL_SELF_TIME_PERCENT, Qt::UserRole, percentage);
+    item->setText(COL_SELF_TIME_PERCENT, QString::number(percentage));
+}
+
 TreeWidgetLoader::TreeWidgetLoader()
-    : m_worker(true)
+    : m_fetchContext()
+    , m_worker(true)
     , m_bDone(EASY_INIT_ATOMIC(false))
     , m_bInterrupt(EASY_INIT_ATOMIC(false))
     , m_progress(EASY_INIT_ATOMIC(0))
+    , m_itemsBudget(0)
     , m_mode(TreeMode::Full)
 {
 }
@@ -315,6 +403,108 @@ void TreeWidgetLoader::interrupt(bool _wait)
     m_error.clear();
 }
 
+void TreeWidgetLoader::releaseFetchContext()
+{
+    decltype(m_fetchContext.stats) dummy;
+    dummy.swap(m_fetchContext.stats);
+}
+
+size_t TreeWidgetLoader::fetchChildren(TreeWidgetItem* _item, Items& _items)
+{
+    if (!_item->isLazy())
+        return 0;
+
+    _item->setLazy(false);
+
+    const auto threadId = _item->threadId();
+    const auto root_it = EASY_GLOBALS.profiler_blocks.find(threadId);
+    if (root_it == EASY_GLOBALS.profiler_blocks.end())
+        return 0;
+
+    const auto& threadRoot = root_it->second;
+    const auto& context = m_fetchContext;
+    const auto stats_it = context.stats.find(threadId);
+
+    // Frame is the top-level block item (direct child of the thread item)
+    auto frame = _item;
+    while (frame->parent() != nullptr && frame->parent()->parent() != nullptr)
+        frame = static_cast<TreeWidgetItem*>(frame->parent());
+
+    const auto& parent = _item->block();
+    const bool partial_parent = _item->isPartial();
+
+    profiler::block_index_t firstCswitch = 0;
+    auto it = std::lower_bound(threadRoot.sync.begin(), threadRoot.sync.end(), parent.node->begin(), [](profiler::block_index_t ind, profiler::timestamp_t _val)
+    {
+        return easyBlocksTree(ind).node->begin() < _val;
+    });
+
+    if (it != threadRoot.sync.end())
+    {
+        firstCswitch = static_cast<profiler::block_index_t>(std::distance(threadRoot.sync.begin(), it));
+        if (firstCswitch > 0)
+            --firstCswitch;
+    }
+    else
+    {
+        firstCswitch = static_cast<profiler::block_index_t>(threadRoot.sync.size());
+    }
+
+    QList<QTreeWidgetItem*> children;
+    for (auto child_index : parent.children)
+    {
+        const auto& child = easyBlocksTree(child_index);
+        const auto startTime = child.node->begin();
+        const auto endTime = child.node->end();
+        const auto duration = endTime - startTime;
+
+        if (startTime > context.right || endTime < context.left)
+            continue;
+
+        const bool partial = context.strict && (startTime < context.left || endTime > context.right);
+        if (partial && partial_parent && duration != 0 && (startTime == context.right || endTime == context.left))
+            continue;
+
+        if (duration == 0 && !context.addZeroBlocks && easyDescriptor(child.node->id()).type() == profiler::BlockType::Block)
+            continue;
+
+        size_t children_items_number = 0;
+        const auto children_duration = calculateVisibleChildrenDuration(child.children, partial, children_items_number);
+        if (partial && !child.children.empty() && children_items_number == 0)
+            continue;
+
+        const auto idleTime = calculateIdleTime(threadRoot, firstCswitch, startTime, endTime);
+        auto item = createItem(threadRoot, child_index, _item, frame, context.beginTime, idleTime, context.units);
+        item->setPartial(partial);
+        item->setLazy(children_items_number != 0);
+        fillSelfTimeColumns(item, duration, children_duration, context.units);
+
+        if (stats_it != context.stats.end())
+            fillStatsColumnsArea(item, stats_it->second, context.units, context.right - context.left);
+
+        children.push_back(item);
+        _items.insert(std::make_pair(child_index, item));
+    }
+
+    // Adding all children at once is much faster for items of a visible tree
+    _item->addChildren(children);
+
+    return static_cast<size_t>(children.size());
+}
+
+bool TreeWidgetLoader::inSelection(profiler::block_index_t _blockIndex) const
+{
+    const auto& context = m_fetchContext;
+    const auto& tree = easyBlocksTree(_blockIndex);
+    const auto startTime = tree.node->begin();
+    const auto endTime = tree.node->end();
+
+    if (startTime > context.right || endTime < context.left)
+        return false;
+
+    return startTime != endTime || context.addZeroBlocks || easyDescriptor(tree.node->id()).type() != profiler::BlockType::Block;
+}
+
 void TreeWidgetLoader::fillTreeBlocks(
     const profiler_gui::TreeBlocks& _blocks,
     profiler::timestamp_t _beginTime,
@@ -324,6 +514,7 @@ void TreeWidgetLoader::fillTreeBlocks(
     TreeMode _mode
 ) {
     interrupt();
+    releaseFetchContext();
     m_mode = _mode;
 
     const auto zeroBlocks = EASY_GLOBALS.add_zero_blocks_to_hierarchy;
@@ -408,71 +599,32 @@ void TreeWidgetLoader::setTreeInternalTop(
 
     auto total = static_cast<int>(_blocks.size());
 
-    uint32_t total_count = 0;
-    int i = 0;
-    for (const auto& block : _blocks)
-    {
-        if (interrupted())
-        {
-            setDone();
-            return;
-        }
-
-        const auto& gui_block = easyBlock(block.tree);
-        const auto& tree = gui_block.tree;
-        const auto startTime = tree.node->begin();
-        const auto endTime = tree.node->end();
-
-        if (startTime > _right || endTime < _left)
-        {
-            setProgress((3 * ++i) / total);
-            continue;
-        }
-
-        const profiler::timestamp_t duration = endTime - startTime;
-        const bool partial = _strict && (startTime < _left || endTime > _right);
-        if (partial && duration != 0 && (startTime == _right || endTime == _left))
-        {
-            setProgress((3 * ++i) / total);
-            continue;
-        }
-
-        total_count += calculateChildrenCountRecursive(tree.children, startTime, endTime, _strict, partial, _addZeroBlocks) + 1;
-
-        setProgress((3 * ++i) / total);
-    }
-
-    if (total_count > _maxCount)
-    {
-        m_error = QString(
-            "Exceeded maximum rows count = %1.\n"
-            "Actual rows count: %2 (%3%).\n"
-            "Please, reduce selected area width\n"
-            "or increase maximum count in settings\n"
-            "or change the tree mode."
-        ).arg(profiler_gui::shortenCountString(static_cast<uint64_t>(_maxCount)))
-            .arg(profiler_gui::shortenCountString(total_count))
-            .arg(profiler_gui::percent(total_count, _maxCount));
-        setDone();
-        return;
-    }
+    // Items are not limited by count: when _maxCount items have been created,
+    // children of remaining items are created on demand (see fetchChildren())
+    m_itemsBudget = _maxCount;
+    m_fetchContext.beginTime = _beginTime;
+    m_fetchContext.left = _left;
+    m_fetchContext.right = _right;
+    m_fetchContext.units = _units;
+    m_fetchContext.strict = _strict;
+    m_fetchContext.addZeroBlocks = _addZeroBlocks;
 
     const auto u_thread = profiler_gui::toUnicode("thread");
 
-    i = 0;
+    int i = 0;
     for (const auto& block : _blocks)
     {
         if (interrupted())
             break;
 
         auto& gui_block = easyBlock(block.tree);
-        auto& tree = gui_block.tree;
+        const auto& tree = easyBlocksTree(block.tree);
         const auto startTime = tree.node->begin();
         const auto endTime = tree.node->end();
 
         if (startTime > _right || endTime < _left)
         {
-            setProgress(3 + (92 * ++i) / total);
+            setProgress((95 * ++i) / total);
             continue;
         }
 
@@ -481,7 +633,7 @@ void TreeWidgetLoader::setTreeInternalTop(
         const bool partial = _strict && (startTime < _left || endTime > _right);
         if (partial && duration != 0 && (startTime == _right || endTime == _left))
         {
-            setProgress(3 + (92 * ++i) / total);
+            setProgress((95 * ++i) / total);
             continue;
         }
 
@@ -513,7 +665,7 @@ void TreeWidgetLoader::setTreeInternalTop(
             firstCswitch = 0;
             auto it = std::lower_bound(block.root->sync.begin(), block.root->sync.end(), _left, [](profiler::block_index_t ind, decltype(_left) _val)
             {
-                return EASY_GLOBALS.gui_blocks[ind].tree.node->begin() < _val;
+                return easyBlocksTree(ind).node->begin() < _val;
             });
 
             if (it != block.root->sync.end())
@@ -535,9 +687,14 @@ void TreeWidgetLoader::setTreeInternalTop(
         auto item = new TreeWidgetItem(block.tree, thread_item);
         item->setPartial(partial);
 
+        if (m_itemsBudget != 0)
+            --m_itemsBudget;
+
         auto name = *tree.node->name() != 0 ? tree.node->name() : easyDescriptor(tree.node->id()).name();
         item->setText(COL_NAME, profiler_gui::toUnicode(name));
         item->setTimeSmart(COL_TIME, _units, duration);
+        item->setPerfCounters(tree);
+        item->setAllocations(*block.root, block.tree);
 
         auto active_time = duration - idleTime;
         auto active_percent = duration == 0 ? 100. : profiler_gui::percentReal(active_time, duration);
@@ -574,17 +731,19 @@ void TreeWidgetLoader::setTreeInternalTop(
             item->setText(COL_PERCENT_SUM_PER_THREAD, "");
         }
 
-        const auto color = easyDescriptor(gui_block.tree.node->id()).color();
+        const auto color = easyDescriptor(tree.node->id()).color();
         item->setBackgroundColor(color);
 
         size_t children_items_number = 0;
         profiler::timestamp_t children_duration = 0;
-        if (!gui_block.tree.children.empty())
+        if (!tree.children.empty())
         {
             iditems.clear();
 
+            // Only statistics are gathered for children of lazy item
+            const bool lazy = m_itemsBudget < tree.children.size();
             children_items_number = setTreeInternal(*block.root, iditems, stats, firstCswitch, _beginTime, tree.children,
-                item, item, _left, _right, _strict, partial, children_duration, _addZeroBlocks, _units, 1);
+                lazy ? nullptr : item, item, _left, _right, _strict, partial, children_duration, _addZeroBlocks, _units, 1);
 
             if (interrupted())
                 break;
@@ -592,9 +751,12 @@ void TreeWidgetLoader::setTreeInternalTop(
             if (partial && children_items_number == 0)
             {
                 delete item;
-                setProgress(3 + (92 * ++i) / total);
+                setProgress((95 * ++i) / total);
                 continue;
             }
+
+            if (lazy && children_items_number != 0)
+                item->setLazy(true);
         }
 
         int percentage = 100;
@@ -610,12 +772,12 @@ void TreeWidgetLoader::setTreeInternalTop(
 
         updateStats(stats, tree.node->id(), block.tree, duration, children_duration);
 
-        if (gui_block.expanded)
+        if (gui_block.expanded && !item->isLazy())
             item->setExpanded(true);
 
         m_items.insert(std::make_pair(block.tree, item));
 
-        setProgress(3 + (92 * ++i) / total);
+        setProgress((95 * ++i) / total);
     }
 
     i = 0;
@@ -629,6 +791,7 @@ void TreeWidgetLoader::setTreeInternalTop(
         {
             m_topLevelItems.emplace_back(it.first, item);
             fillStatsForTree(item, thread_data.stats, _units, _right - _left);
+            m_fetchContext.stats[it.first] = std::move(thread_data.stats);
         }
         else
         {
@@ -657,6 +820,10 @@ void TreeWidgetLoader::setTreeInternalPlainTop(
     BeginEndIndicesMap beginEndMap;
     ThreadDataMap threadsMap;
 
+    // Statistics for the selected area do not depend on items, so they are calculated in parallel beforehand
+    ThreadsStatsMap threadsStats;
+    calculateStats(threadsStats, _blocks, _left, _right, _strict);
+
     const auto u_thread = profiler_gui::toUnicode("thread");
     int i = 0, total = static_cast<int>(_blocks.size());
     for (const auto& block : _blocks)
@@ -666,7 +833,7 @@ void TreeWidgetLoader::setTreeInternalPlainTop(
 
         const auto block_index = block.tree;
         auto& gui_block = easyBlock(block_index);
-        auto& tree = gui_block.tree;
+        const auto& tree = easyBlocksTree(block_index);
         const auto startTime = tree.node->begin();
         const auto endTime = tree.node->end();
 
@@ -688,7 +855,6 @@ void TreeWidgetLoader::setTreeInternalPlainTop(
         auto& thread_data = threadsMap[block.root->thread_id];
         auto thread_item = thread_data.item;
         profiler::block_index_t& firstCswitch = beginEndMap[block.root->thread_id];
-        StatsMap& stats = thread_data.stats;
         IdItems& iditems = thread_data.iditems;
 
         if (thread_item == nullptr)
@@ -713,7 +879,7 @@ void TreeWidgetLoader::setTreeInternalPlainTop(
             firstCswitch = 0;
             auto it = std::lower_bound(block.root->sync.begin(), block.root->sync.end(), _left, [] (profiler::block_index_t ind, decltype(_left) _val)
             {
-                return EASY_GLOBALS.gui_blocks[ind].tree.node->begin() < _val;
+                return easyBlocksTree(ind).node->begin() < _val;
             });
 
             if (it != block.root->sync.end())
@@ -741,7 +907,7 @@ void TreeWidgetLoader::setTreeInternalPlainTop(
 
             if (!tree.children.empty())
             {
-                children_items_count = setTreeInternalPlain(*block.root, iditems, stats, firstCswitch, _beginTime, tree.children,
+                children_items_count = setTreeInternalPlain(*block.root, iditems, firstCswitch, _beginTime, tree.children,
                     item, item, _left, _right, _strict, partial, children_duration, _addZeroBlocks, _units, 1);
 
                 if (interrupted())
@@ -756,9 +922,6 @@ void TreeWidgetLoader::setTreeInternalPlainTop(
 
             if (tree.per_thread_stats != nullptr)
             {
-                // stats for current selection
-                updateStats(stats, tree.node->id(), block_index, duration, children_duration);
-
                 // stats
                 if (children_duration != 0)
                 {
@@ -800,6 +963,8 @@ void TreeWidgetLoader::setTreeInternalPlainTop(
         auto name = *tree.node->name() != 0 ? tree.node->name() : easyDescriptor(tree.node->id()).name();
         item->setText(COL_NAME, profiler_gui::toUnicode(name));
         item->setTimeSmart(COL_TIME, _units, duration);
+        item->setPerfCounters(tree);
+        item->setAllocations(*block.root, block.tree);
 
         auto active_time = duration - idleTime;
         auto active_percent = duration == 0 ? 100. : profiler_gui::percentReal(active_time, duration);
@@ -843,7 +1008,7 @@ void TreeWidgetLoader::setTreeInternalPlainTop(
         profiler::timestamp_t children_duration = 0;
         if (!tree.children.empty())
         {
-            children_items_number = setTreeInternalPlain(*block.root, iditems, stats, firstCswitch, _beginTime,
+            children_items_number = setTreeInternalPlain(*block.root, iditems, firstCswitch, _beginTime,
                 tree.children, item, item, _left, _right, _strict, partial, children_duration, _addZeroBlocks, _units, 1);
 
             if (interrupted())
@@ -871,8 +1036,6 @@ void TreeWidgetLoader::setTreeInternalPlainTop(
         item->setData(COL_SELF_TIME_PERCENT, Qt::UserRole, percentage);
         item->setText(COL_SELF_TIME_PERCENT, QString::number(percentage));
 
-        updateStats(stats, tree.node->id(), block_index, duration, children_duration);
-
         if (gui_block.expanded)
             item->setExpanded(true);
 
@@ -891,7 +1054,7 @@ void TreeWidgetLoader::setTreeInternalPlainTop(
         if (item->childCount() > 0)
         {
             m_topLevelItems.emplace_back(it.first, item);
-            fillStatsForTree(item, thread_data.stats, _units, _right - _left);
+            fillStatsForTree(item, threadsStats[it.first], _units, _right - _left);
         }
         else
         {
@@ -920,6 +1083,10 @@ void TreeWidgetLoader::setTreeInternalAggregateTop(
     BeginEndIndicesMap beginEndMap;
     ThreadDataMap threadsMap;
 
+    // Statistics for the selected area do not depend on items, so they are calculated in parallel beforehand
+    ThreadsStatsMap threadsStats;
+    calculateStats(threadsStats, _blocks, _left, _right, _strict);
+
     const auto u_thread = profiler_gui::toUnicode("thread");
     int i = 0, total = static_cast<int>(_blocks.size());
     for (const auto& block : _blocks)
@@ -929,7 +1096,7 @@ void TreeWidgetLoader::setTreeInternalAggregateTop(
 
         const auto block_index = block.tree;
         auto& gui_block = easyBlock(block_index);
-        auto& tree = gui_block.tree;
+        const auto& tree = easyBlocksTree(block_index);
         const auto startTime = tree.node->begin();
         const auto endTime = tree.node->end();
 
@@ -951,7 +1118,6 @@ void TreeWidgetLoader::setTreeInternalAggregateTop(
         auto& thread_data = threadsMap[block.root->thread_id];
         auto thread_item = thread_data.item;
         profiler::block_index_t& firstCswitch = beginEndMap[block.root->thread_id];
-        StatsMap& stats = thread_data.stats;
         IdItems& iditems = thread_data.iditems;
 
         if (thread_item == nullptr)
@@ -976,7 +1142,7 @@ void TreeWidgetLoader::setTreeInternalAggregateTop(
             firstCswitch = 0;
             auto it = std::lower_bound(block.root->sync.begin(), block.root->sync.end(), _left, [] (profiler::block_index_t ind, decltype(_left) _val)
             {
-                return EASY_GLOBALS.gui_blocks[ind].tree.node->begin() < _val;
+                return easyBlocksTree(ind).node->begin() < _val;
             });
 
             if (it != block.root->sync.end())
@@ -1004,7 +1170,7 @@ void TreeWidgetLoader::setTreeInternalAggregateTop(
 
             if (!tree.children.empty())
             {
-                children_items_count = setTreeInternalAggregate(*block.root, iditems, stats, firstCswitch, _beginTime,
+                children_items_count = setTreeInternalAggregate(*block.root, iditems, firstCswitch, _beginTime,
                     tree.children, thread_item, _left, _right, _strict, partial, children_duration, _addZeroBlocks, _units, 1);
 
                 if (interrupted())
@@ -1020,12 +1186,6 @@ void TreeWidgetLoader::setTreeInternalAggregateTop(
             const auto total_duration = item->data(COL_TIME, Qt::UserRole).toULongLong() + duration;
             item->setTimeSmart(COL_TIME, _units, total_duration);
 
-            if (tree.per_thread_stats != nullptr)
-            {
-                // stats for current selection
-                updateStats(stats, tree.node->id(), block_index, duration, children_duration);
-            }
-
             // stats
             if (children_duration != 0)
             {
@@ -1061,6 +1221,8 @@ void TreeWidgetLoader::setTreeInternalAggregateTop(
         auto name = *tree.node->name() != 0 ? tree.node->name() : easyDescriptor(tree.node->id()).name();
         item->setText(COL_NAME, profiler_gui::toUnicode(name));
         item->setTimeSmart(COL_TIME, _units, duration);
+        item->setPerfCounters(tree);
+        item->setAllocations(*block.root, block.tree);
 
         auto active_time = duration - idleTime;
         auto active_percent = duration == 0 ? 100. : profiler_gui::percentReal(active_time, duration);
@@ -1068,7 +1230,7 @@ void TreeWidgetLoader::setTreeInternalAggregateTop(
         item->setText(COL_ACTIVE_PERCENT, QString::number(active_percent, 'g', 3));
         item->setData(COL_ACTIVE_PERCENT, Qt::UserRole, active_percent);
 
-        const auto per_thread_stats = gui_block.tree.per_thread_stats;
+        const auto per_thread_stats = tree.per_thread_stats;
         if (per_thread_stats != nullptr)
         {
             fillStatsColumnsThread(item, per_thread_stats, _units);
@@ -1081,15 +1243,15 @@ void TreeWidgetLoader::setTreeInternalAggregateTop(
             item->setData(COL_PERCENT_SUM_PER_THREAD, Qt::UserRole, 0);
         }
 
-        const auto color = easyDescriptor(gui_block.tree.node->id()).color();
+        const auto color = easyDescriptor(tree.node->id()).color();
         item->setBackgroundColor(color);
 
         size_t children_items_number = 0;
         profiler::timestamp_t children_duration = 0;
         if (!tree.children.empty())
         {
-            children_items_number = setTreeInternalAggregate(*block.root, iditems, stats, firstCswitch, _beginTime,
-                gui_block.tree.children, thread_item, _left, _right, _strict, partial, children_duration, _addZeroBlocks, _units, 1);
+            children_items_number = setTreeInternalAggregate(*block.root, iditems, firstCswitch, _beginTime,
+                tree.children, thread_item, _left, _right, _strict, partial, children_duration, _addZeroBlocks, _units, 1);
 
             if (interrupted())
                 break;
@@ -1114,8 +1276,6 @@ void TreeWidgetLoader::setTreeInternalAggregateTop(
         item->setData(COL_SELF_TIME_PERCENT, Qt::UserRole, percent_value);
         item->setText(COL_SELF_TIME_PERCENT, QString::number(percent_value));
 
-        updateStats(stats, tree.node->id(), block_index, duration, children_duration);
-
         if (gui_block.expanded)
             item->setExpanded(true);
 
@@ -1134,7 +1294,7 @@ void TreeWidgetLoader::setTreeInternalAggregateTop(
         if (item->childCount() > 0)
         {
             m_topLevelItems.emplace_back(it.first, item);
-            fillStatsForTree(item, thread_data.stats, _units, _right - _left);
+            fillStatsForTree(item, threadsStats[it.first], _units, _right - _left);
         }
         else
         {
@@ -1149,6 +1309,107 @@ void TreeWidgetLoader::setTreeInternalAggregateTop(
 
 //////////////////////////////////////////////////////////////////////////
 
+TreeWidgetItem* TreeWidgetLoader::createItem(
+    const profiler::BlocksTreeRoot& _threadRoot,
+    profiler::block_index_t _blockIndex,
+    TreeWidgetItem* _parent,
+    TreeWidgetItem* _frame,
+    profiler::timestamp_t _beginTime,
+    profiler::timestamp_t _idleTime,
+    profiler_gui::TimeUnits _units
+) const {
+    const auto& child = easyBlocksTree(_blockIndex);
+    const auto& desc = easyDescriptor(child.node->id());
+    const auto startTime = child.node->begin();
+    const auto endTime = child.node->end();
+    const auto duration = endTime - startTime;
+
+    auto item = new TreeWidgetItem(_blockIndex);
+
+    auto name = *child.node->name() != 0 ? child.node->name() : desc.name();
+    item->setText(COL_NAME, profiler_gui::toUnicode(name));
+    item->setTimeSmart(COL_TIME, _units, duration);
+    item->setPerfCounters(child);
+    item->setAllocations(_threadRoot, _blockIndex);
+
+    auto active_time = duration - _idleTime;
+    auto active_percent = duration == 0 ? 100. : profiler_gui::percentReal(active_time, duration);
+    item->setTimeSmart(COL_ACTIVE_TIME, _units, active_time);
+    item->setText(COL_ACTIVE_PERCENT, QString::number(active_percent, 'g', 3));
+    item->setData(COL_ACTIVE_PERCENT, Qt::UserRole, active_percent);
+
+    item->setTimeMs(COL_BEGIN, startTime - _beginTime);
+    item->setTimeMs(COL_END, endTime - _beginTime);
+    item->setData(COL_PERCENT_SUM_PER_THREAD, Qt::UserRole, 0);
+
+    if (child.per_thread_stats != nullptr) // if there is per_thread_stats then there are other stats also
+    {
+        const auto per_thread_stats = child.per_thread_stats;
+        const auto per_parent_stats = child.per_parent_stats;
+        const auto per_frame_stats  = child.per_frame_stats;
+
+        auto parent_duration = _parent->data(COL_TIME, Qt::UserRole).toULongLong();
+        auto percentage = duration == 0 ? 0 : profiler_gui::percent(duration, parent_duration);
+        auto percentage_sum = profiler_gui::percent(per_parent_stats->total_duration, parent_duration);
+        item->setData(COL_PERCENT_PER_PARENT, Qt::UserRole, percentage);
+        item->setText(COL_PERCENT_PER_PARENT, QString::number(percentage));
+        item->setData(COL_PERCENT_SUM_PER_PARENT, Qt::UserRole, percentage_sum);
+        item->setText(COL_PERCENT_SUM_PER_PARENT, QString::number(percentage_sum));
+
+        if (_frame != nullptr)
+        {
+            if (_parent != _frame)
+            {
+                parent_duration = _frame->data(COL_TIME, Qt::UserRole).toULongLong();
+                percentage = duration == 0 ? 0 : profiler_gui::percent(duration, parent_duration);
+                percentage_sum = profiler_gui::percent(per_frame_stats->total_duration, parent_duration);
+            }
+
+            item->setData(COL_PERCENT_PER_FRAME, Qt::UserRole, percentage);
+            item->setText(COL_PERCENT_PER_FRAME, QString::number(percentage));
+            item->setData(COL_PERCENT_SUM_PER_FRAME, Qt::UserRole, percentage_sum);
+            item->setText(COL_PERCENT_SUM_PER_FRAME, QString::number(percentage_sum));
+        }
+        else
+        {
+            item->setData(COL_PERCENT_PER_FRAME, Qt::UserRole, 0);
+            item->setData(COL_PERCENT_SUM_PER_FRAME, Qt::UserRole, 0);
+
+            auto percentage_per_thread = profiler_gui::percent(duration, _threadRoot.profiled_time);
+            item->setData(COL_PERCENT_PER_PARENT, Qt::UserRole, percentage_per_thread);
+            item->setText(COL_PERCENT_PER_PARENT, QString::number(percentage_per_thread));
+        }
+
+        fillStatsColumnsThread(item, per_thread_stats, _units);
+        fillStatsColumnsParent(item, per_parent_stats, _units);
+        fillStatsColumnsFrame(item, per_frame_stats, _units);
+
+        auto percentage_per_thread = profiler_gui::percent(per_thread_stats->total_duration, _threadRoot.profiled_time);
+        item->setData(COL_PERCENT_SUM_PER_THREAD, Qt::UserRole, percentage_per_thread);
+        item->setText(COL_PERCENT_SUM_PER_THREAD, QString::number(percentage_per_thread));
+    }
+    else
+    {
+        if (_frame == nullptr)
+        {
+            auto percentage_per_thread = profiler_gui::percent(duration, _threadRoot.profiled_time);
+            item->setData(COL_PERCENT_PER_PARENT, Qt::UserRole, percentage_per_thread);
+            item->setText(COL_PERCENT_PER_PARENT, QString::number(percentage_per_thread));
+        }
+        else
+        {
+            item->setData(COL_PERCENT_PER_PARENT, Qt::UserRole, 0);
+        }
+
+        item->setData(COL_PERCENT_SUM_PER_PARENT, Qt::UserRole, 0);
+        item->setData(COL_PERCENT_SUM_PER_THREAD, Qt::UserRole, 0);
+    }
+
+    item->setBackgroundColor(desc.color());
+
+    return item;
+}
+
 size_t TreeWidgetLoader::setTreeInternal(
     const profiler::BlocksTreeRoot& _threadRoot,
     IdItems& _iditems,
@@ -1167,6 +1428,8 @@ size_t TreeWidgetLoader::setTreeInternal(
     profiler_gui::TimeUnits _units,
     int _depth
 ) {
+    // Items are not created if _parent is nullptr (children of lazy item), only statistics are gathered
+
     size_t total_items = 0;
     for (auto child_index : _children)
     {
@@ -1174,7 +1437,7 @@ size_t TreeWidgetLoader::setTreeInternal(
             break;
 
         auto& gui_block = easyBlock(child_index);
-        const auto& child = gui_block.tree;
+        const auto& child = easyBlocksTree(child_index);
         const auto startTime = child.node->begin();
         const auto endTime = child.node->end();
         const auto duration = endTime - startTime;
@@ -1191,97 +1454,26 @@ size_t TreeWidgetLoader::setTreeInternal(
         if (duration == 0 && !_addZeroBlocks && desc.type() == profiler::BlockType::Block)
             continue;
 
-        const auto idleTime = calculateIdleTime(_threadRoot, _firstCswitch, startTime, endTime);
-
-        auto item = new TreeWidgetItem(child_index, _parent);
-
-        auto name = *child.node->name() != 0 ? child.node->name() : desc.name();
-        item->setText(COL_NAME, profiler_gui::toUnicode(name));
-        item->setTimeSmart(COL_TIME, _units, duration);
-
-        auto active_time = duration - idleTime;
-        auto active_percent = duration == 0 ? 100. : profiler_gui::percentReal(active_time, duration);
-        item->setTimeSmart(COL_ACTIVE_TIME, _units, active_time);
-        item->setText(COL_ACTIVE_PERCENT, QString::number(active_percent, 'g', 3));
-        item->setData(COL_ACTIVE_PERCENT, Qt::UserRole, active_percent);
-
-        item->setTimeMs(COL_BEGIN, startTime - _beginTime);
-        item->setTimeMs(COL_END, endTime - _beginTime);
-        item->setData(COL_PERCENT_SUM_PER_THREAD, Qt::UserRole, 0);
-
-        if (child.per_thread_stats != nullptr) // if there is per_thread_stats then there are other stats also
+        TreeWidgetItem* item = nullptr;
+        if (_parent != nullptr)
         {
-            const auto per_thread_stats = child.per_thread_stats;
-            const auto per_parent_stats = child.per_parent_stats;
-            const auto per_frame_stats  = child.per_frame_stats;
-
-            auto parent_duration = _parent->data(COL_TIME, Qt::UserRole).toULongLong();
-            auto percentage = duration == 0 ? 0 : profiler_gui::percent(duration, parent_duration);
-            auto percentage_sum = profiler_gui::percent(per_parent_stats->total_duration, parent_duration);
-            item->setData(COL_PERCENT_PER_PARENT, Qt::UserRole, percentage);
-            item->setText(COL_PERCENT_PER_PARENT, QString::number(percentage));
-            item->setData(COL_PERCENT_SUM_PER_PARENT, Qt::UserRole, percentage_sum);
-            item->setText(COL_PERCENT_SUM_PER_PARENT, QString::number(percentage_sum));
-
-            if (_frame != nullptr)
-            {
-                if (_parent != _frame)
-                {
-                    parent_duration = _frame->data(COL_TIME, Qt::UserRole).toULongLong();
-                    percentage = duration == 0 ? 0 : profiler_gui::percent(duration, parent_duration);
-                    percentage_sum = profiler_gui::percent(per_frame_stats->total_duration, parent_duration);
-                }
+            const auto idleTime = calculateIdleTime(_threadRoot, _firstCswitch, startTime, endTime);
+            item = createItem(_threadRoot, child_index, _parent, _frame, _beginTime, idleTime, _units);
+            _parent->addChild(item);
 
-                item->setData(COL_PERCENT_PER_FRAME, Qt::UserRole, percentage);
-                item->setText(COL_PERCENT_PER_FRAME, QString::number(percentage));
-                item->setData(COL_PERCENT_SUM_PER_FRAME, Qt::UserRole, percentage_sum);
-                item->setText(COL_PERCENT_SUM_PER_FRAME, QString::number(percentage_sum));
-            }
-            else
-            {
-                item->setData(COL_PERCENT_PER_FRAME, Qt::UserRole, 0);
-                item->setData(COL_PERCENT_SUM_PER_FRAME, Qt::UserRole, 0);
-
-                auto percentage_per_thread = profiler_gui::percent(duration, _threadRoot.profiled_time);
-                item->setData(COL_PERCENT_PER_PARENT, Qt::UserRole, percentage_per_thread);
-                item->setText(COL_PERCENT_PER_PARENT, QString::number(percentage_per_thread));
-            }
-
-            fillStatsColumnsThread(item, per_thread_stats, _units);
-            fillStatsColumnsParent(item, per_parent_stats, _units);
-            fillStatsColumnsFrame(item, per_frame_stats, _units);
-
-            auto percentage_per_thread = profiler_gui::percent(per_thread_stats->total_duration, _threadRoot.profiled_time);
-            item->setData(COL_PERCENT_SUM_PER_THREAD, Qt::UserRole, percentage_per_thread);
-            item->setText(COL_PERCENT_SUM_PER_THREAD, QString::number(percentage_per_thread));
-        }
-        else
-        {
-            if (_frame == nullptr)
-            {
-                auto percentage_per_thread = profiler_gui::percent(duration, _threadRoot.profiled_time);
-                item->setData(COL_PERCENT_PER_PARENT, Qt::UserRole, percentage_per_thread);
-                item->setText(COL_PERCENT_PER_PARENT, QString::number(percentage_per_thread));
-            }
-            else
-            {
-                item->setData(COL_PERCENT_PER_PARENT, Qt::UserRole, 0);
-            }
-
-            item->setData(COL_PERCENT_SUM_PER_PARENT, Qt::UserRole, 0);
-            item->setData(COL_PERCENT_SUM_PER_THREAD, Qt::UserRole, 0);
+            if (m_itemsBudget != 0)
+                --m_itemsBudget;
         }
 
-        item->setBackgroundColor(desc.color());
-
         size_t children_items_number = 0;
         profiler::timestamp_t children_duration = 0;
         if (!child.children.empty())
         {
             _iditems.clear();
 
+            const bool lazy = item == nullptr || m_itemsBudget < child.children.size();
             children_items_number = setTreeInternal(_threadRoot, _iditems, _statsMap, _firstCswitch, _beginTime, child.children,
-                item, _frame ? _frame : item, left, right, strict, partial, children_duration, _addZeroBlocks, _units, _depth + 1);
+                lazy ? nullptr : item, _frame ? _frame : item, left, right, strict, partial, children_duration, _addZeroBlocks, _units, _depth + 1);
 
             if (interrupted())
                 break;
@@ -1291,27 +1483,23 @@ size_t TreeWidgetLoader::setTreeInternal(
                 delete item;
                 continue;
             }
+
+            if (item != nullptr && lazy && children_items_number != 0)
+                item->setLazy(true);
         }
 
         _duration += duration;
+        total_items += children_items_number + 1;
 
-        int percentage = 100;
-        auto self_duration = duration - children_duration;
-        if (children_duration > 0 && duration > 0)
+        if (item != nullptr)
         {
-            percentage = profiler_gui::percent(self_duration, duration);
-        }
-
-        item->setTimeSmart(COL_SELF_TIME, _units, self_duration);
-        item->setData(COL_SELF_TIME_PERCENT, Qt::UserRole, percentage);
-        item->setText(COL_SELF_TIME_PERCENT, QString::number(percentage));
+            fillSelfTimeColumns(item, duration, children_duration, _units);
 
-        total_items += children_items_number + 1;
+            if (gui_block.expanded && !item->isLazy())
+                item->setExpanded(true);
 
-        if (gui_block.expanded)
-            item->setExpanded(true);
-
-        m_items.insert(std::make_pair(child_index, item));
+            m_items.insert(std::make_pair(child_index, item));
+        }
 
         updateStats(_statsMap, child.node->id(), child_index, duration, children_duration);
     }
@@ -1332,10 +1520,10 @@ profiler::timestamp_t TreeWidgetLoader::calculateChildrenDurationRecursive(
         if (interrupted())
             break;
 
-        const auto& gui_block = easyBlock(child_index);
-        total_duration += gui_block.tree.node->duration();
-        if (gui_block.tree.node->id() == _id)
-            total_duration += calculateChildrenDurationRecursive(gui_block.tree.children, _id);
+        const auto& child = easyBlocksTree(child_index);
+        total_duration += child.node->duration();
+        if (child.node->id() == _id)
+            total_duration += calculateChildrenDurationRecursive(child.children, _id);
     }
 
     return total_duration;
@@ -1356,8 +1544,7 @@ uint32_t TreeWidgetLoader::calculateChildrenCountRecursive(
         if (interrupted())
             break;
 
-        const auto& gui_block = easyBlock(child_index);
-        const auto& child = gui_block.tree;
+        const auto& child = easyBlocksTree(child_index);
         const auto startTime = child.node->begin();
         const auto endTime = child.node->end();
         const auto duration = endTime - startTime;
@@ -1374,16 +1561,52 @@ uint32_t TreeWidgetLoader::calculateChildrenCountRecursive(
         if (duration == 0 && !addZeroBlocks && desc.type() == profiler::BlockType::Block)
             continue;
 
-        count += calculateChildrenCountRecursive(gui_block.tree.children, left, right, strict, partial, addZeroBlocks) + 1;
+        count += calculateChildrenCountRecursive(child.children, left, right, strict, partial, addZeroBlocks) + 1;
     }
 
     return count;
 }
 
+profiler::timestamp_t TreeWidgetLoader::calculateVisibleChildrenDuration(
+    const profiler::BlocksTree::children_t& _children,
+    bool _partialParent,
+    size_t& _count
+) const {
+    // The same filtering as in setTreeInternal() but for one level of children only
+    const auto& context = m_fetchContext;
+
+    profiler::timestamp_t total_duration = 0;
+    for (auto child_index : _children)
+    {
+        const auto& child = easyBlocksTree(child_index);
+        const auto startTime = child.node->begin();
+        const auto endTime = child.node->end();
+        const auto duration = endTime - startTime;
+
+        if (startTime > context.right || endTime < context.left)
+            continue;
+
+        const bool partial = context.strict && (startTime < context.left || endTime > context.right);
+        if (partial && _partialParent && duration != 0 && (startTime == context.right || endTime == context.left))
+            continue;
+
+        if (duration == 0 && !context.addZeroBlocks && easyDescriptor(child.node->id()).type() == profiler::BlockType::Block)
+            continue;
+
+        if (partial && calculateChildrenCountRecursive(child.children, context.left, context.right, context.strict, partial,
+                                                       context.addZeroBlocks) == 0 && !child.children.empty())
+            continue;
+
+        total_duration += duration;
+        ++_count;
+    }
+
+    return total_duration;
+}
+
 size_t TreeWidgetLoader::setTreeInternalPlain(
     const profiler::BlocksTreeRoot& threadRoot,
     IdItems& iditems,
-    StatsMap& statsMap,
     profiler::block_index_t firstCswitch,
     profiler::timestamp_t beginTime,
     const profiler::BlocksTree::children_t& children,
@@ -1406,7 +1629,7 @@ size_t TreeWidgetLoader::setTreeInternalPlain(
             break;
 
         const auto& gui_block = easyBlock(child_index);
-        const auto& child = gui_block.tree;
+        const auto& child = easyBlocksTree(child_index);
         const auto startTime = child.node->begin();
         const auto endTime = child.node->end();
         const auto duration = endTime - startTime;
@@ -1427,7 +1650,7 @@ size_t TreeWidgetLoader::setTreeInternalPlain(
             profiler::timestamp_t children_duration = 0;
             if (!child.children.empty())
             {
-                children_items_number = setTreeInternalPlain(threadRoot, iditems, statsMap, firstCswitch, beginTime,
+                children_items_number = setTreeInternalPlain(threadRoot, iditems, firstCswitch, beginTime,
                     child.children, root, frame, left, right, strict, partial, children_duration, addZeroBlocks, units, depth + 1);
 
                 if (interrupted())
@@ -1440,8 +1663,6 @@ size_t TreeWidgetLoader::setTreeInternalPlain(
             total_duration += duration;
             ++total_items;
 
-            updateStats(statsMap, child.node->id(), child_index, duration, children_duration);
-
             if (it->second.first != nullptr && child.per_frame_stats != nullptr)
             {
                 auto item = it->second.first;
@@ -1511,7 +1732,7 @@ size_t TreeWidgetLoader::setTreeInternalPlain(
         profiler::timestamp_t children_duration = 0;
         if (!child.children.empty())
         {
-            children_items_number = setTreeInternalPlain(threadRoot, iditems, statsMap, firstCswitch, beginTime, child.children, root,
+            children_items_number = setTreeInternalPlain(threadRoot, iditems, firstCswitch, beginTime, child.children, root,
                                                          frame, left, right, strict, partial, children_duration,
                                                          addZeroBlocks, units, depth + 1);
 
@@ -1553,8 +1774,6 @@ size_t TreeWidgetLoader::setTreeInternalPlain(
             item->setExpanded(true);
 
         m_items.insert(std::make_pair(child_index, item));
-
-        updateStats(statsMap, child.node->id(), child_index, duration, children_duration);
     }
 
     return total_items;
@@ -1565,7 +1784,6 @@ size_t TreeWidgetLoader::setTreeInternalPlain(
 size_t TreeWidgetLoader::setTreeInternalAggregate(
     const profiler::BlocksTreeRoot& threadRoot,
     IdItems& iditems,
-    StatsMap& statsMap,
     profiler::block_index_t firstCswitch,
     profiler::timestamp_t beginTime,
     const profiler::BlocksTree::children_t& children,
@@ -1587,7 +1805,7 @@ size_t TreeWidgetLoader::setTreeInternalAggregate(
             break;
 
         const auto& gui_block = easyBlock(child_index);
-        const auto& child = gui_block.tree;
+        const auto& child = easyBlocksTree(child_index);
         const auto startTime = child.node->begin();
         const auto endTime = child.node->end();
         const auto duration = endTime - startTime;
@@ -1608,7 +1826,7 @@ size_t TreeWidgetLoader::setTreeInternalAggregate(
             profiler::timestamp_t children_duration = 0;
             if (!child.children.empty())
             {
-                children_items_number = setTreeInternalAggregate(threadRoot, iditems, statsMap, firstCswitch, beginTime,
+                children_items_number = setTreeInternalAggregate(threadRoot, iditems, firstCswitch, beginTime,
                     child.children, root, left, right, strict, partial, children_duration, addZeroBlocks, units, depth + 1);
 
                 if (interrupted())
@@ -1623,8 +1841,6 @@ size_t TreeWidgetLoader::setTreeInternalAggregate(
             total_duration += duration;
             ++total_items;
 
-            updateStats(statsMap, child.node->id(), child_index, duration, children_duration);
-
             const auto total_block_duration = duration + item->data(COL_TIME, Qt::UserRole).toULongLong();
 
             int percentage = 100;
@@ -1680,7 +1896,7 @@ size_t TreeWidgetLoader::setTreeInternalAggregate(
         profiler::timestamp_t children_duration = 0;
         if (!child.children.empty())
         {
-            children_items_number = setTreeInternalAggregate(threadRoot, iditems, statsMap, firstCswitch, beginTime,
+            children_items_number = setTreeInternalAggregate(threadRoot, iditems, firstCswitch, beginTime,
                 child.children, root, left, right, strict, partial, children_duration, addZeroBlocks, units, depth + 1);
 
             if (interrupted())
@@ -1717,8 +1933,149 @@ size_t TreeWidgetLoader::setTreeInternalAggregate(
             item->setExpanded(true);
 
         m_items.insert(std::make_pair(child_index, item));
+    }
+
+    return total_items;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+void TreeWidgetLoader::calculateStats(
+    ThreadsStatsMap& _threadsStats,
+    const profiler_gui::TreeBlocks& _blocks,
+    profiler::timestamp_t _left,
+    profiler::timestamp_t _right,
+    bool _strict
+) const {
+    // Map: statistics are calculated separately for ranges of consecutive top-level blocks (frames) of one thread
+    struct BlocksRange
+    {
+        const profiler::BlocksTreeRoot* root;
+        size_t                         begin;
+        size_t                           end;
+    };
+
+    const size_t workers = std::max(std::thread::hardware_concurrency(), 1U);
+    const size_t rangeSize = std::max(_blocks.size() / (workers * 4), static_cast<size_t>(1));
+
+    std::vector<BlocksRange> ranges;
+    for (size_t begin = 0; begin < _blocks.size();)
+    {
+        const auto root = _blocks[begin].root;
+
+        auto end = begin + 1;
+        while (end < _blocks.size() && end - begin < rangeSize && _blocks[end].root == root)
+            ++end;
+
+        ranges.push_back(BlocksRange {root, begin, end});
+        begin = end;
+    }
+
+    std::vector<StatsMap> partialStats(ranges.size());
+    ThreadPool::instance().parallelFor(ranges.size(), [&] (size_t index)
+    {
+        const auto& range = ranges[index];
+        auto& stats = partialStats[index];
+
+        for (auto i = range.begin; i < range.end && !interrupted(); ++i)
+        {
+            const auto block_index = _blocks[i].tree;
+            const auto& tree = easyBlocksTree(block_index);
+            const auto startTime = tree.node->begin();
+            const auto endTime = tree.node->end();
+
+            if (startTime > _right || endTime < _left)
+                continue;
+
+            const profiler::timestamp_t duration = endTime - startTime;
+
+            const bool partial = _strict && (startTime < _left || endTime > _right);
+            if (partial && duration != 0 && (startTime == _right || endTime == _left))
+                continue;
+
+            profiler::timestamp_t children_duration = 0;
+            if (!tree.children.empty())
+            {
+                const auto children_count = calculateStatsRecursive(stats, tree.children, _left, _right, _strict,
+                                                                    partial, children_duration);
+                if (partial && children_count == 0)
+                    continue;
+            }
+
+            updateStats(stats, tree.node->id(), block_index, duration, children_duration);
+        }
+    });
+
+    if (interrupted())
+        return;
+
+    // Reduce: partial statistics are merged in the order of blocks, each thread separately
+    std::vector<std::pair<profiler::thread_id_t, StatsMap*> > threads;
+    for (const auto& range : ranges)
+    {
+        const auto id = range.root->thread_id;
+        if (_threadsStats.find(id) == _threadsStats.end())
+            threads.emplace_back(id, &_threadsStats[id]);
+    }
+
+    ThreadPool::instance().parallelFor(threads.size(), [&] (size_t index)
+    {
+        const auto id = threads[index].first;
+        auto& stats = *threads[index].second;
 
-        updateStats(statsMap, child.node->id(), child_index, duration, children_duration);
+        for (size_t i = 0; i < ranges.size(); ++i)
+        {
+            if (ranges[i].root->thread_id == id)
+                mergeStats(stats, partialStats[i]);
+        }
+
+        calculateMedians(stats.begin(), stats.end());
+    });
+}
+
+size_t TreeWidgetLoader::calculateStatsRecursive(
+    StatsMap& _statsMap,
+    const profiler::BlocksTree::children_t& _children,
+    profiler::timestamp_t _left,
+    profiler::timestamp_t _right,
+    bool _strict,
+    bool _partialParent,
+    profiler::timestamp_t& _duration
+) const {
+    // The same filtering as in setTreeInternalPlain() and setTreeInternalAggregate()
+    size_t total_items = 0;
+
+    for (auto child_index : _children)
+    {
+        if (interrupted())
+            break;
+
+        const auto& child = easyBlocksTree(child_index);
+        const auto startTime = child.node->begin();
+        const auto endTime = child.node->end();
+        const auto duration = endTime - startTime;
+
+        if (startTime > _right || endTime < _left)
+            continue;
+
+        const bool partial = _strict && (startTime < _left || endTime > _right);
+        if (partial && _partialParent && duration != 0 && (startTime == _right || endTime == _left))
+            continue;
+
+        size_t children_items_number = 0;
+        profiler::timestamp_t children_duration = 0;
+        if (!child.children.empty())
+        {
+            children_items_number = calculateStatsRecursive(_statsMap, child.children, _left, _right, _strict,
+                                                            partial, children_duration);
+            if (partial && children_items_number == 0)
+                continue;
+        }
+
+        _duration += duration;
+        total_items += children_items_number + 1;
+
+        updateStats(_statsMap, child.node->id(), child_index, duration, children_duration);
     }
 
     return total_items;
@@ -1737,7 +2094,7 @@ profiler::timestamp_t TreeWidgetLoader::calculateIdleTime(
     for (profiler::block_index_t ind = _firstCSwitch, ncs = static_cast<profiler::block_index_t>(_threadRoot.sync.size()); ind < ncs; ++ind)
     {
         auto cs_index = _threadRoot.sync[ind];
-        const auto cs = EASY_GLOBALS.gui_blocks[cs_index].tree.node;
+        const auto cs = easyBlocksTree(cs_index).node;
 
         if (cs->begin() > _end)
         {
@@ -1785,12 +2142,12 @@ void TreeWidgetLoader::updateStats(
         stat.total_duration += duration;
         stat.total_children_duration += children_duration;
 
-        if (duration > easyBlock(stat.max_duration_block).tree.node->duration())
+        if (duration > easyBlocksTree(stat.max_duration_block).node->duration())
         {
             stat.max_duration_block = index;
         }
 
-        if (duration < easyBlock(stat.min_duration_block).tree.node->duration())
+        if (duration < easyBlocksTree(stat.min_duration_block).node->duration())
         {
             stat.min_duration_block = index;
         }
@@ -1833,21 +2190,7 @@ void TreeWidgetLoader::fillStatsForTree(TreeWidgetItem* root, StatsMap& stats, p
             queue.push_back(static_cast<TreeWidgetItem*>(item->child(i)));
         }
 
-        auto stat_it = stats.find(item->block().node->id());
-        if (stat_it != stats.end())
-        {
-            auto& stat = stat_it->second;
-
-            fillStatsColumnsSelection(item, &stat.stats, _units);
-
-            auto percent_per_selection = std::min(100, profiler_gui::percent(stat.stats.total_duration, selectionDuration));
-            item->setData(COL_PERCENT_SUM_PER_AREA, Qt::UserRole, percent_per_selection);
-            item->setText(COL_PERCENT_SUM_PER_AREA, QString::number(percent_per_selection));
-
-            percent_per_selection = std::min(100, profiler_gui::percent(item->block().node->duration(), selectionDuration));
-            item->setData(COL_PERCENT_PER_AREA, Qt::UserRole, percent_per_selection);
-            item->setText(COL_PERCENT_PER_AREA, QString::number(percent_per_selection));
-        }
+        fillStatsColumnsArea(item, stats, _units, selectionDuration);
 
         queue.pop_front();
     }
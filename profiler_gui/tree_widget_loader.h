@@ -89,6 +89,7 @@ using ThreadedItems = std::vector<std::pair<profiler::thread_id_t, TreeWidgetIte
 using RootsMap = std::unordered_map<profiler::thread_id_t, TreeWidgetItem*, estd::hash<profiler::thread_id_t> >;
 using IdItems = std::unordered_map<profiler::block_id_t, std::pair<TreeWidgetItem*, int>, estd::hash<profiler::block_index_t> >;
 using StatsMap = std::unordered_map<profiler::block_id_t, loader::Stats, estd::hash<profiler::block_id_t> >;
+using ThreadsStatsMap = std::unordered_map<profiler::thread_id_t, StatsMap, estd::hash<profiler::thread_id_t> >;
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -103,13 +104,27 @@ enum class TreeMode : uint8_t
 
 class TreeWidgetLoader Q_DECL_FINAL
 {
+    /** Parameters of the last full call-stack tree which are used to create children of lazy items (see fetchChildren()). */
+    struct FetchContext
+    {
+        ThreadsStatsMap                stats; ///< Statistics of selected area for each thread
+        profiler::timestamp_t      beginTime; ///<
+        profiler::timestamp_t           left; ///<
+        profiler::timestamp_t          right; ///<
+        ::profiler_gui::TimeUnits      units; ///<
+        bool                          strict; ///<
+        bool                   addZeroBlocks; ///<
+    };
+
     ThreadedItems   m_topLevelItems; ///< 
     Items                   m_items; ///< 
+    FetchContext     m_fetchContext; ///<
     ThreadPoolTask         m_worker; ///<
     QString                 m_error; ///<
     std::atomic_bool        m_bDone; ///<
     std::atomic_bool   m_bInterrupt; ///<
     std::atomic<int>     m_progress; ///<
+    size_t            m_itemsBudget; ///< Number of items which could be created before children of items become lazy
     TreeMode                 m_mode; ///<
 
 public:
@@ -126,6 +141,23 @@ public:
     QString error() const;
 
     void interrupt(bool _wait = false);
+
+    /** \brief Creates items for children of lazy item of the full call-stack tree.
+
+    Full call-stack tree creates up to EASY_GLOBALS.max_rows_count items, children of other items
+    are created on demand when the item is expanded. Created items are added into _items.
+
+    \retval Number of created items */
+    size_t fetchChildren(TreeWidgetItem* _item, Items& _items);
+
+    /** Releases statistics used by fetchChildren(). Must be called when the tree is cleared. */
+    void releaseFetchContext();
+
+    /** \brief Returns true if block is inside the area of the last full call-stack tree.
+
+    Only the block itself is checked, so it still could be missing in the tree (if it's partial and has no visible children). */
+    bool inSelection(profiler::block_index_t _blockIndex) const;
+
     void fillTreeBlocks(
         const::profiler_gui::TreeBlocks& _blocks,
         profiler::timestamp_t _beginTime,
@@ -153,6 +185,16 @@ private:
         size_t _maxCount
     );
 
+    TreeWidgetItem* createItem(
+        const profiler::BlocksTreeRoot& _threadRoot,
+        profiler::block_index_t _blockIndex,
+        TreeWidgetItem* _parent,
+        TreeWidgetItem* _frame,
+        profiler::timestamp_t _beginTime,
+        profiler::timestamp_t _idleTime,
+        ::profiler_gui::TimeUnits _units
+    ) const;
+
     size_t setTreeInternal(
         const profiler::BlocksTreeRoot& _threadRoot,
         IdItems& iditems,
@@ -187,7 +229,6 @@ private:
     size_t setTreeInternalPlain(
         const profiler::BlocksTreeRoot& threadRoot,
         IdItems& iditems,
-        StatsMap& statsMap,
         profiler::block_index_t firstCswitch,
         profiler::timestamp_t beginTime,
         const profiler::BlocksTree::children_t& children,
@@ -218,7 +259,6 @@ private:
     size_t setTreeInternalAggregate(
         const profiler::BlocksTreeRoot& threadRoot,
         IdItems& iditems,
-        StatsMap& statsMap,
         profiler::block_index_t firstCswitch,
         profiler::timestamp_t beginTime,
         const profiler::BlocksTree::children_t& children,
@@ -247,6 +287,30 @@ private:
         bool addZeroBlocks
     ) const;
 
+    profiler::timestamp_t calculateVisibleChildrenDuration(
+        const profiler::BlocksTree::children_t& _children,
+        bool _partialParent,
+        size_t& _count
+    ) const;
+
+    void calculateStats(
+        ThreadsStatsMap& _threadsStats,
+        const ::profiler_gui::TreeBlocks& _blocks,
+        profiler::timestamp_t _left,
+        profiler::timestamp_t _right,
+        bool _strict
+    ) const;
+
+    size_t calculateStatsRecursive(
+        StatsMap& _statsMap,
+        const profiler::BlocksTree::children_t& _children,
+        profiler::timestamp_t _left,
+        profiler::timestamp_t _right,
+        bool _strict,
+        bool _partialParent,
+        profiler::timestamp_t& _duration
+    ) const;
+
     profiler::timestamp_t calculateIdleTime(const profiler::BlocksTreeRoot& _threadRoot, profiler::block_index_t& _firstCSwitch, profiler::timestamp_t _begin, profiler::timestamp_t _end) const;
     void updateStats(StatsMap& stats, profiler::block_id_t id, profiler::block_index_t index, profiler::timestamp_t duration, profiler::timestamp_t children_duration) const;
     void fillStatsForTree(TreeWidgetItem* root, StatsMap& stats, profiler_gui::TimeUnits _units, profiler::timestamp_t selectionDuration) const;
@@ -0,0 +1,372 @@
+/**
+Lightweight profiler library for c++
+Copyright(C) 2016-2019  Sergey Yagovtsev, Victor Zarubkin
+
+Licensed under either of
+	* MIT license (LICENSE.MIT or http://opensource.org/licenses/MIT)
+    * Apache License, Version 2.0, (LICENSE.APACHE or http://www.apache.org/licenses/LICENSE-2.0)
+at your option.
+
+The MIT License
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+	of the Software, and to permit persons to whom the Software is furnished
+	to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+	INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+	PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+	LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+	TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+	USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+The Apache License, Version 2.0 (the "License");
+	You may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+**/
+
+/* Checks of reader passes over a capture made by this process.
+
+Usage: profiler_reader_test locks|async|values OUTPUT_FILE
+
+locks: two waiters contend for profiler::mutex and collectLockStatistics must rank them by wait time;
+async: one asynchronous span is suspended on one thread and resumed on another one and collectAsyncSpans
+must link both segments;
+values: values stored inside nested calls must be found by the index of their innermost enclosing block.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <easy/arbitrary_value.h>
+#include <easy/mutex.h>
+#include <easy/reader.h>
+
+//////////////////////////////////////////////////////////////////////////
+
+EASY_CONSTEXPR int LONG_HOLD = 50; ///< Time in milliseconds the lock is held while the first waiter is waiting for it
+EASY_CONSTEXPR int SHORT_HOLD = 10; ///< Time in milliseconds the lock is held while the second waiter is waiting for it
+EASY_CONSTEXPR int SEGMENT_DURATION = 5; ///< Duration of one segment of asynchronous span in milliseconds
+EASY_CONSTEXPR uint32_t CALLS_NUMBER = 10; ///< Number of calls storing a value
+EASY_CONSTEXPR profiler::timestamp_t MILLISECOND = 1000000; ///< Reader converts all times to nanoseconds
+
+static int fail(const std::string& _message)
+{
+    std::cerr << "FAILED: " << _message << "\n";
+    return 1;
+}
+
+static void sleepFor(int _milliseconds)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(_milliseconds));
+}
+
+struct Capture EASY_FINAL
+{
+    profiler::SerializedData    serialized_blocks;
+    profiler::SerializedData    serialized_descriptors;
+    profiler::descriptors_list_t           descriptors;
+    profiler::blocks_t                          blocks;
+    profiler::thread_blocks_tree_t               trees;
+    profiler::bookmarks_t                    bookmarks;
+    profiler::BeginEndTime                beginEndTime;
+    uint32_t                      descriptorsCount = 0;
+    uint32_t                               version = 0;
+    profiler::processid_t                      pid = 0;
+};
+
+/** Dump blocks of this process to a file and read them back. */
+static bool dumpAndRead(const std::string& _filename, Capture& _capture, std::string& _error)
+{
+    EASY_PROFILER_DISABLE;
+
+    if (profiler::dumpBlocksToFile(_filename.c_str()) == 0)
+    {
+        _error = "can not dump blocks to " + _filename;
+        return false;
+    }
+
+    std::ostringstream log;
+    const auto total = fillTreesFromFile(_filename.c_str(), _capture.beginEndTime, _capture.serialized_blocks,
+                                         _capture.serialized_descriptors, _capture.descriptors, _capture.blocks,
+                                         _capture.trees, _capture.bookmarks, _capture.descriptorsCount,
+                                         _capture.version, _capture.pid, false, log);
+    if (total == 0)
+    {
+        _error = "can not read " + _filename + ": " + log.str();
+        return false;
+    }
+
+    return true;
+}
+
+static profiler::block_id_t findDescriptor(const Capture& _capture, const char* _name)
+{
+    for (size_t i = 0; i < _capture.descriptors.size(); ++i)
+    {
+        const auto desc = _capture.descriptors[i];
+        if (desc != nullptr && strcmp(desc->name(), _name) == 0)
+            return static_cast<profiler::block_id_t>(i);
+    }
+
+    return ~0U;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+/** The holder locks the mutex and keeps it for _holdTime while the waiter is blocked on it. */
+template <class TWaiter>
+static void contend(profiler::mutex& _lock, int _holdTime, TWaiter _waiter)
+{
+    std::atomic<bool> locked(false);
+
+    std::thread holder([&] {
+        EASY_BLOCK("Holder");
+        std::lock_guard<profiler::mutex> guard(_lock);
+        locked.store(true, std::memory_order_release);
+        sleepFor(_holdTime);
+    });
+
+    std::thread waiter([&] {
+        while (!locked.load(std::memory_order_acquire))
+            std::this_thread::yield();
+        _waiter();
+    });
+
+    holder.join();
+    waiter.join();
+}
+
+static int checkLockStatistics(const std::string& _filename)
+{
+    profiler::mutex lock("Test lock");
+
+    EASY_PROFILER_ENABLE;
+
+    contend(lock, LONG_HOLD, [&lock] {
+        EASY_BLOCK("Long wait");
+        std::lock_guard<profiler::mutex> guard(lock);
+    });
+
+    contend(lock, SHORT_HOLD, [&lock] {
+        EASY_BLOCK("Short wait");
+        std::lock_guard<profiler::mutex> guard(lock);
+    });
+
+    Capture capture;
+    std::string error;
+    if (!dumpAndRead(_filename, capture, error))
+        return fail(error);
+
+    profiler::lock_statistics_t locks;
+    collectLockStatistics(capture.blocks, capture.trees, capture.descriptors, locks);
+
+    if (locks.size() != 1)
+        return fail(std::to_string(locks.size()) + " locks have been found instead of 1");
+
+    const auto& stats = locks.front();
+    if (stats.name != "Test lock")
+        return fail("unexpected lock name \"" + stats.name + "\"");
+
+    // Each holder and each waiter has held the lock once, only waiters had to wait for it
+    if (stats.holds != 4 || stats.waits != 2)
+        return fail(std::to_string(stats.holds) + " holds and " + std::to_string(stats.waits) + " waits instead of 4 and 2");
+
+    if (stats.hold_time < (LONG_HOLD + SHORT_HOLD) * MILLISECOND)
+        return fail("hold time " + std::to_string(stats.hold_time) + " ns is less than holders were sleeping");
+
+    if (stats.waiters.size() != 2)
+        return fail(std::to_string(stats.waiters.size()) + " waiters have been found instead of 2");
+
+    const auto longWait = findDescriptor(capture, "Long wait");
+    const auto shortWait = findDescriptor(capture, "Short wait");
+    const auto& first = stats.waiters[0];
+    const auto& second = stats.waiters[1];
+    if (first.id != longWait || second.id != shortWait)
+        return fail("waiters are not ranked by wait time");
+
+    if (first.waits != 1 || second.waits != 1)
+        return fail("each waiter must wait once");
+
+    if (stats.wait_time != first.wait_time + second.wait_time || stats.max_wait != first.wait_time)
+        return fail("total wait time does not match wait times of waiters");
+
+    // Waiters start waiting right after holders lock the mutex
+    if (first.wait_time < (LONG_HOLD - SHORT_HOLD) * MILLISECOND || first.wait_time <= second.wait_time)
+        return fail("wait time " + std::to_string(first.wait_time) + " ns of the long waiter is too short");
+
+    std::cout << "OK: waits " << stats.wait_time << " ns, holds " << stats.hold_time << " ns\n";
+
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+static void storeSegment(const profiler::BaseBlockDescriptor* _desc, uint64_t _spanId)
+{
+    const auto begin = profiler::now();
+    sleepFor(SEGMENT_DURATION);
+    profiler::storeAsyncSegment(_desc, "", _spanId, begin, profiler::now());
+}
+
+static int checkAsyncSpans(const std::string& _filename)
+{
+    const auto desc = profiler::registerDescription(profiler::ON, "reader_test_async_segment", "Async segment",
+                                                    __FILE__, __LINE__, profiler::BlockType::Block,
+                                                    profiler::colors::Default);
+
+    EASY_PROFILER_ENABLE;
+
+    const auto spanId = profiler::newAsyncSpanId();
+
+    // The span is suspended at the end of the first thread and resumed by the second one
+    std::thread suspended([&] { storeSegment(desc, spanId); });
+    suspended.join();
+
+    std::thread resumed([&] { storeSegment(desc, spanId); });
+    resumed.join();
+
+    Capture capture;
+    std::string error;
+    if (!dumpAndRead(_filename, capture, error))
+        return fail(error);
+
+    profiler::async_spans_t spans;
+    collectAsyncSpans(capture.blocks, capture.trees, capture.descriptors, spans);
+
+    if (spans.size() != 1)
+        return fail(std::to_string(spans.size()) + " spans have been found instead of 1");
+
+    const auto& span = spans.front();
+    if (span.id != spanId)
+        return fail("unexpected span id " + std::to_string(span.id));
+
+    if (span.segments.size() != 2)
+        return fail(std::to_string(span.segments.size()) + " segments have been found instead of 2");
+
+    const auto& first = *capture.blocks[span.segments[0].block].node;
+    const auto& second = *capture.blocks[span.segments[1].block].node;
+    if (span.segments[0].thread_id == span.segments[1].thread_id)
+        return fail("both segments belong to the same thread");
+
+    if (first.end() > second.begin())
+        return fail("segments are not ordered by begin time");
+
+    if (span.begin != first.begin() || span.end != second.end() || span.active_time != first.duration() + second.duration())
+        return fail("span times do not match its segments");
+
+    if (span.end - span.begin < 2 * SEGMENT_DURATION * MILLISECOND)
+        return fail("span duration " + std::to_string(span.end - span.begin) + " ns is too short");
+
+    std::cout << "OK: span " << span.id << ", " << span.segments.size() << " segments\n";
+
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+static void call(uint32_t _n)
+{
+    EASY_BLOCK("Call");
+    {
+        EASY_BLOCK("Nested");
+    }
+    EASY_VALUE("N", _n);
+}
+
+static int checkValuesByBlock(const std::string& _filename)
+{
+    EASY_PROFILER_ENABLE;
+
+    {
+        EASY_BLOCK("Frame");
+        for (uint32_t n = 0; n < CALLS_NUMBER; ++n)
+            call(n);
+    }
+
+    Capture capture;
+    std::string error;
+    if (!dumpAndRead(_filename, capture, error))
+        return fail(error);
+
+    const auto callId = findDescriptor(capture, "Call");
+
+    uint32_t calls = 0;
+    for (const auto& it : capture.trees)
+    {
+        const auto& root = it.second;
+        for (profiler::block_index_t i = 0; i < capture.blocks.size(); ++i)
+        {
+            const auto& tree = capture.blocks[i];
+            if (tree.node->id() != callId)
+                continue;
+
+            const auto found = root.values_by_block.find(i);
+            if (found == root.values_by_block.end())
+                continue;
+
+            if (found->second.size() != 1)
+                return fail("call " + std::to_string(i) + " has " + std::to_string(found->second.size()) + " values instead of 1");
+
+            const auto& value = capture.blocks[found->second.front().block];
+            const auto n = value.value->toValue<uint32_t>();
+            if (value.parent != i || n == nullptr || n->value() != calls)
+                return fail("call " + std::to_string(i) + " has unexpected value");
+
+            ++calls;
+        }
+    }
+
+    if (calls != CALLS_NUMBER)
+        return fail(std::to_string(calls) + " calls with values have been found instead of " + std::to_string(CALLS_NUMBER));
+
+    std::cout << "OK: " << calls << " calls with values\n";
+
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        std::cout << "Usage: " << argv[0] << " locks|async|values OUTPUT_FILE\n";
+        return 1;
+    }
+
+    const std::string check = argv[1];
+    const std::string filename = argv[2];
+
+    if (check == "locks")
+        return checkLockStatistics(filename);
+
+    if (check == "async")
+        return checkAsyncSpans(filename);
+
+    if (check == "values")
+        return checkValuesByBlock(filename);
+
+    return fail("unknown check \"" + check + "\"");
+}
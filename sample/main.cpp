@@ -19,6 +19,7 @@ int OBJECTS = 500;
 int MODELLING_STEPS = 1500;
 int RENDER_STEPS = 1500;
 int RESOURCE_LOADING_COUNT = 50;
+int LISTEN_PORT = profiler::DEFAULT_PORT;
 
 //#define SAMPLE_NETWORK_TEST
 
@@ -231,6 +232,9 @@ int main(int argc, char* argv[])
     if (argc > 4 && argv[4]){
         RESOURCE_LOADING_COUNT = std::atoi(argv[4]);
     }
+    if (argc > 5 && argv[5]){
+        LISTEN_PORT = std::atoi(argv[5]);
+    }
 
     std::cout << "Objects count: " << OBJECTS << std::endl;
     std::cout << "Render steps: " << MODELLING_STEPS << std::endl;
@@ -244,7 +248,7 @@ int main(int argc, char* argv[])
 #endif
 
     EASY_MAIN_THREAD;
-    profiler::startListen();
+    profiler::startListen(static_cast<uint16_t>(LISTEN_PORT));
 
 #ifdef EASY_CONSTEXPR_AVAILABLE
     constexpr int grrr[] {2, -3, 4};